@@ -1,47 +1,72 @@
 #include "audio/AudioAnalyzer.hpp"
-#include "pffft/pffft.h"
 #include "core/Logger.hpp"
 
-#include <array>
-#include <complex>
-
 namespace vc {
 
-static PFFFT_Setup* g_pffft_setup = nullptr;
+namespace {
+// Tempo confidence above which beatDetected follows the beat grid
+constexpr f32 BEAT_LOCK_CONFIDENCE = 0.2f;
+} // namespace
 
 AudioAnalyzer::AudioAnalyzer() {
-	energyHistory_.resize(60, 0.0f);
-	if (!g_pffft_setup) {
-		g_pffft_setup = pffft_new_setup(FFT_SIZE, PFFFT_REAL);
-		if (!g_pffft_setup) {
-			LOG_ERROR("Failed to initialize PFFFT setup for FFT_SIZE={}", FFT_SIZE);
-		}
+	if (auto result = configure(settings_); !result) {
+		LOG_ERROR("AudioAnalyzer: {}", result.error().message);
 	}
 }
 
+Result<void> AudioAnalyzer::configure(const AnalyzerSettings& settings) {
+    if (settings.hopSize == 0)
+        return Result<void>::err("Analyzer hop size must be positive");
+    if (auto result = fft_.configure(settings.fftSize, settings.window); !result)
+        return result;
+    if (settings.bassFftSize == 0) {
+        bassFft_.release();
+    } else if (auto result = bassFft_.configure(settings.bassFftSize, settings.window);
+               !result) {
+        return result;
+    }
+
+    settings_ = settings;
+    reset();
+    return Result<void>::ok();
+}
+
 void AudioAnalyzer::reset() {
     pcmBuffer_.clear();
-    std::fill(energyHistory_.begin(), energyHistory_.end(), 0.0f);
-    energyHistoryPos_ = 0;
-    avgEnergy_ = 0.0f;
-    runningEnergySum_ = 0.0f;
-    std::fill(smoothedMagnitudes_.begin(), smoothedMagnitudes_.end(), 0.0f);
+    sinceHop_ = 0;
+    beatTracker_.reset();
+    beatIntensity_ = 0.0f;
+    beatSinceReport_ = false;
+    onsetSinceReport_ = false;
+    bandOnsetsSinceReport_ = {};
+    sampleRate_ = 0;
+    bassBins_ = 0;
+    smoothedMagnitudes_.fill(0.0f);
+    smoothedBass_.fill(0.0f);
 }
 
-AudioSpectrum AudioAnalyzer::analyze(std::span<const vc::f32> samples,
-                                     u32 sampleRate,
-                                     u32 channels) {
-    AudioSpectrum spectrum;
-
-    if (samples.empty())
-        return spectrum;
+void AudioAnalyzer::analyze(std::span<const vc::f32> samples,
+                            u32 sampleRate,
+                            u32 channels,
+                            AudioSpectrum& spectrum) {
+    if (sampleRate != sampleRate_) {
+        sampleRate_ = sampleRate;
+        bassBins_ = 0;
+        if (bassFft_.ready() && sampleRate > 0) {
+            f32 bassBinHz = static_cast<f32>(sampleRate) / bassFft_.size();
+            bassBins_ = std::min<u32>(static_cast<u32>(BASS_CUTOFF_HZ / bassBinHz) + 1,
+                                      MAX_BASS_BINS);
+        }
+        if (sampleRate > 0) {
+            beatTracker_.configure(static_cast<f32>(sampleRate) / settings_.hopSize,
+                                   fft_.bins(),
+                                   static_cast<f32>(sampleRate) / fft_.size());
+        }
+    }
 
     // 1. Calculate RMS levels for left/right
     f32 leftSum = 0, rightSum = 0;
-    usize totalFrames = samples.size() / channels;
-
-    if (totalFrames == 0)
-        return spectrum;
+    usize totalFrames = channels ? samples.size() / channels : 0;
 
     for (usize i = 0; i < totalFrames; ++i) {
         if (channels >= 2) {
@@ -53,10 +78,10 @@ AudioSpectrum AudioAnalyzer::analyze(std::span<const vc::f32> samples,
         }
     }
 
-    spectrum.leftLevel = std::sqrt(leftSum / totalFrames);
-    spectrum.rightLevel = std::sqrt(rightSum / totalFrames);
+    spectrum.leftLevel = totalFrames ? std::sqrt(leftSum / totalFrames) : 0.0f;
+    spectrum.rightLevel = totalFrames ? std::sqrt(rightSum / totalFrames) : 0.0f;
 
-    // 2. Prepare mono data for FFT (using circular buffer for O(1) push)
+    // 2. Push mono samples, analyzing every hopSize of them
     for (usize i = 0; i < totalFrames; ++i) {
         f32 mono;
         if (channels >= 2) {
@@ -66,75 +91,74 @@ AudioSpectrum AudioAnalyzer::analyze(std::span<const vc::f32> samples,
         }
 
         pcmBuffer_.push_back(mono);  // O(1) - no erase needed!
+        if (++sinceHop_ >= settings_.hopSize && pcmBuffer_.size() >= fft_.size()) {
+            sinceHop_ = 0;
+            analyzeHop();
+        }
     }
 
-    if (pcmBuffer_.size() < FFT_SIZE)
-        return spectrum;
+    // 3. Report the latest hop
+    const u32 bins = fft_.bins();
+    std::copy_n(smoothedMagnitudes_.begin(), bins, spectrum.magnitudes.begin());
+    spectrum.bins = bins;
+    spectrum.binHz = fft_.size() ? static_cast<f32>(sampleRate) / fft_.size() : 0.0f;
+
+    spectrum.bassBinHz =
+            bassBins_ ? static_cast<f32>(sampleRate) / bassFft_.size() : 0.0f;
+    std::copy_n(smoothedBass_.begin(), bassBins_, spectrum.bassMagnitudes.begin());
+    spectrum.bassBins = bassBins_;
+
+    spectrum.beatIntensity = beatIntensity_;
+    spectrum.beatDetected = beatSinceReport_;
+    spectrum.onset = onsetSinceReport_;
+    spectrum.bandOnsets = bandOnsetsSinceReport_;
+    spectrum.bpm = beatTracker_.bpm();
+    spectrum.beatPhase = beatTracker_.beatPhase();
+    spectrum.tempoConfidence = beatTracker_.tempoConfidence();
+    beatSinceReport_ = false;
+    onsetSinceReport_ = false;
+    bandOnsetsSinceReport_ = {};
+}
 
-    // 3. Perform FFT
-    std::array<f32, SPECTRUM_SIZE> currentMagnitudes;
-	performFFT(pcmBuffer_, currentMagnitudes);
+void AudioAnalyzer::analyzeHop() {
+    const u32 bins = fft_.bins();
+    auto [first, second] = pcmBuffer_.getSpans(fft_.size());
+    fft_.magnitudes(first, second, std::span(currentMagnitudes_.data(), bins));
 
-    // 4. Smoothing and normalization
-    f32 currentEnergy = 0.0f;
-    for (usize i = 0; i < SPECTRUM_SIZE; ++i) {
+    // Smoothing and normalization
+    for (u32 i = 0; i < bins; ++i) {
         // Simple smoothing
         smoothedMagnitudes_[i] =
                 smoothedMagnitudes_[i] * smoothingFactor_ +
-                currentMagnitudes[i] * (1.0f - smoothingFactor_);
-        spectrum.magnitudes[i] = smoothedMagnitudes_[i];
-        currentEnergy += currentMagnitudes[i];
+                currentMagnitudes_[i] * (1.0f - smoothingFactor_);
     }
 
-    // 5. Beat detection
-    spectrum.beatIntensity = detectBeat(currentEnergy / SPECTRUM_SIZE);
-    spectrum.beatDetected =
-            spectrum.beatIntensity > 1.1f; // Adjust threshold as needed
-
-    return spectrum;
-}
-
-void AudioAnalyzer::performFFT(const CircularBuffer<vc::f32, FFT_SIZE>& input,
-		std::span<vc::f32> magnitudes) {
-	if (!g_pffft_setup)
-		return;
-
-	static std::array<f32, FFT_SIZE> work;
-	static std::array<f32, FFT_SIZE> output;
-
-	std::array<f32, FFT_SIZE> contiguous;
-	for (usize i = 0; i < FFT_SIZE; ++i) {
-		contiguous[i] = input[i];
-	}
-
-	pffft_transform_ordered(g_pffft_setup, contiguous.data(), output.data(), work.data(), PFFFT_FORWARD);
+    if (bassFft_.ready() && bassBins_ > 0) {
+        auto [bassFirst, bassSecond] = pcmBuffer_.getSpans(bassFft_.size());
+        bassFft_.magnitudes(bassFirst, bassSecond, std::span(bassMagnitudes_.data(), bassBins_));
+        for (u32 i = 0; i < bassBins_; ++i) {
+            smoothedBass_[i] = smoothedBass_[i] * smoothingFactor_ +
+                               bassMagnitudes_[i] * (1.0f - smoothingFactor_);
+        }
+    }
 
-	for (usize i = 0; i < SPECTRUM_SIZE; ++i) {
-		f32 re = output[i * 2];
-		f32 im = output[i * 2 + 1];
-		f32 mag = std::sqrt(re * re + im * im);
-		magnitudes[i] = mag / (FFT_SIZE / 2);
-	}
+    // Onsets and tempo run on the raw spectrum; smoothing would blur attacks
+    beatTracker_.process(std::span<const f32>(currentMagnitudes_.data(), bins));
+    beatIntensity_ = beatTracker_.onsetStrength();
+    onsetSinceReport_ |= beatTracker_.onset();
+    for (u32 band = 0; band < ONSET_BANDS; ++band)
+        bandOnsetsSinceReport_[band] |= beatTracker_.bandOnsets()[band];
+    // Once the tempo is locked, report beats on the grid rather than raw onsets
+    beatSinceReport_ |= beatTracker_.tempoConfidence() >= BEAT_LOCK_CONFIDENCE
+                                ? beatTracker_.beat()
+                                : beatTracker_.onset();
 }
 
-vc::f32 AudioAnalyzer::detectBeat(vc::f32 currentEnergy) {
-    // Optimized beat detection using running sum (O(1) instead of O(N))
-    // Subtract old value, add new value
-    runningEnergySum_ -= energyHistory_[energyHistoryPos_];
-    runningEnergySum_ += currentEnergy;
-    
-    energyHistory_[energyHistoryPos_] = currentEnergy;
-    energyHistoryPos_ = (energyHistoryPos_ + 1) % energyHistory_.size();
-    
-    avgEnergy_ = runningEnergySum_ / energyHistory_.size();
-
-    if (avgEnergy_ > 0.0001f) {
-        f32 ratio = currentEnergy / avgEnergy_;
-        if (ratio > beatThreshold_) {
-            return ratio;
-        }
-    }
-    return 0.0f;
+usize AudioAnalyzer::copyPcm(std::span<vc::f32> out) const {
+    auto [first, second] = pcmBuffer_.getSpans(std::min<usize>(fft_.size(), out.size()));
+    std::copy(first.begin(), first.end(), out.begin());
+    std::copy(second.begin(), second.end(), out.begin() + first.size());
+    return first.size() + second.size();
 }
 
 } // namespace vc
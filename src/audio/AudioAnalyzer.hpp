@@ -6,12 +6,16 @@
 #include <array>
 #include <cmath>
 #include <numeric>
+#include "audio/BeatTracker.hpp"
+#include "audio/FftEngine.hpp"
+#include "util/Result.hpp"
 #include "util/Types.hpp"
 
 namespace vc {
 
-constexpr usize FFT_SIZE = 2048;
-constexpr usize SPECTRUM_SIZE = FFT_SIZE / 2;
+// High-resolution low band: bins of the bass FFT below this frequency
+inline constexpr f32 BASS_CUTOFF_HZ = 300.0f;
+inline constexpr u32 MAX_BASS_BINS = 128;
 
 // Simple circular buffer for O(1) push/pop
 // Replaces std::vector to avoid O(N) erase() in hot path
@@ -39,15 +43,21 @@ public:
     
     // Get contiguous span for FFT (may need two spans if wrapped)
     std::pair<std::span<const T>, std::span<const T>> getSpans() const {
-        usize start = (head_ + Size - count_) % Size;
-        if (start + count_ <= Size) {
+        return getSpans(count_);
+    }
+
+    // Same, limited to the newest `count` values
+    std::pair<std::span<const T>, std::span<const T>> getSpans(usize count) const {
+        count = std::min(count, count_);
+        usize start = (head_ + Size - count) % Size;
+        if (start + count <= Size) {
             // Contiguous
-            return {std::span(&buffer_[start], count_), std::span<const T>()};
+            return {std::span(&buffer_[start], count), std::span<const T>()};
         } else {
             // Wrapped
             usize firstPart = Size - start;
             return {std::span(&buffer_[start], firstPart), 
-                    std::span(buffer_.data(), count_ - firstPart)};
+                    std::span(buffer_.data(), count - firstPart)};
         }
     }
     
@@ -59,50 +69,88 @@ private:
 
 // Frequency band data for visualizer
 struct AudioSpectrum {
-    std::array<vc::f32, SPECTRUM_SIZE> magnitudes{};
+    std::array<vc::f32, MAX_SPECTRUM_BINS> magnitudes{}; // first `bins` valid
+    u32 bins{0};
+    vc::f32 binHz{0.0f};
+    // Bass FFT bins up to BASS_CUTOFF_HZ (first `bassBins` valid)
+    std::array<vc::f32, MAX_BASS_BINS> bassMagnitudes{};
+    u32 bassBins{0};
+    vc::f32 bassBinHz{0.0f};
     vc::f32 leftLevel{0.0f};
     vc::f32 rightLevel{0.0f};
-    vc::f32 beatIntensity{0.0f};
-    bool beatDetected{false};
+    vc::f32 beatIntensity{0.0f}; // onset strength, >1 above threshold
+    bool beatDetected{false};    // tracked beat, or any onset while unlocked
+    // Onsets since the previous report (full band and per ONSET_BAND_EDGES_HZ band)
+    bool onset{false};
+    std::array<bool, ONSET_BANDS> bandOnsets{};
+    vc::f32 bpm{0.0f};             // 0 until the tracker locks on
+    vc::f32 beatPhase{0.0f};       // [0, 1), 0 = on the beat
+    vc::f32 tempoConfidence{0.0f}; // 0..1
+};
+
+struct AnalyzerSettings {
+    u32 fftSize{2048};          // main spectrum, MIN_FFT_SIZE..MAX_FFT_SIZE
+    u32 hopSize{512};           // new samples between analyses
+    FftWindow window{FftWindow::Hann};
+    u32 bassFftSize{8192};      // second, longer FFT for the low band; 0 = off
 };
 
 class AudioAnalyzer {
 public:
     AudioAnalyzer();
 
-    AudioSpectrum analyze(std::span<const vc::f32> samples,
-                          u32 sampleRate,
-                          u32 channels);
+    // Resize the FFT engines and history; clears analysis state
+    Result<void> configure(const AnalyzerSettings& settings);
+    const AnalyzerSettings& settings() const { return settings_; }
 
-    // Get PCM data for external use (returns copy for API compatibility)
-    std::vector<vc::f32> pcmData() const {
-        std::vector<vc::f32> result;
-        result.reserve(pcmBuffer_.size());
-        for (usize i = 0; i < pcmBuffer_.size(); ++i) {
-            result.push_back(pcmBuffer_[i]);
-        }
-        return result;
+    // Run one analysis per hopSize samples of `samples` and write the
+    // latest result into `out`, overwriting every field (so `out` can be a
+    // recycled snapshot slot)
+    void analyze(std::span<const vc::f32> samples,
+                 u32 sampleRate,
+                 u32 channels,
+                 AudioSpectrum& out);
+
+    // Frames still needed before analyze() runs its next hop (including
+    // filling the FFT window after a reset); always at least 1
+    u32 framesUntilHop() const {
+        u32 hop = settings_.hopSize - std::min(sinceHop_, settings_.hopSize);
+        u32 fill = fft_.size() - static_cast<u32>(std::min<usize>(pcmBuffer_.size(), fft_.size()));
+        return std::max({hop, fill, 1u});
     }
 
+    // Copy the newest fftSize mono samples, oldest first; returns the
+    // number of samples written
+    usize copyPcm(std::span<vc::f32> out) const;
+
     void reset();
+    // Seed beat tracking, see BeatTracker::seed()
+    void seedTempo(vc::f32 bpm, vc::f32 phase) { beatTracker_.seed(bpm, phase); }
 
 private:
-	void performFFT(const CircularBuffer<vc::f32, FFT_SIZE>& input,
-		std::span<vc::f32> magnitudes);
-    vc::f32 detectBeat(vc::f32 currentEnergy);
+    void analyzeHop();
 
-    // Circular buffer for O(1) push/pop (fixes O(N) vector erase)
-    CircularBuffer<vc::f32, FFT_SIZE> pcmBuffer_;
+    AnalyzerSettings settings_;
+    FftEngine fft_;
+    FftEngine bassFft_;
+    u32 sinceHop_{0};
 
-    vc::f32 avgEnergy_{0.0f};
-    vc::f32 beatThreshold_{1.5f};
-    std::vector<vc::f32> energyHistory_;
-    usize energyHistoryPos_{0};
+    // Circular buffer for O(1) push/pop (fixes O(N) vector erase); sized
+    // for the largest FFT so every engine reads from the same history
+    CircularBuffer<vc::f32, MAX_FFT_SIZE> pcmBuffer_;
 
-    std::array<vc::f32, SPECTRUM_SIZE> smoothedMagnitudes_{};
+    BeatTracker beatTracker_;
+
+    std::array<vc::f32, MAX_SPECTRUM_BINS> currentMagnitudes_{};
+    std::array<vc::f32, MAX_SPECTRUM_BINS> smoothedMagnitudes_{};
+    std::array<vc::f32, MAX_BASS_BINS> bassMagnitudes_{};
+    std::array<vc::f32, MAX_BASS_BINS> smoothedBass_{};
+    u32 sampleRate_{0};
+    u32 bassBins_{0};
     vc::f32 smoothingFactor_{0.3f};
-    
-    // Running sum for O(1) beat detection (optimization)
-    vc::f32 runningEnergySum_{0.0f};
+    vc::f32 beatIntensity_{0.0f};
+    bool beatSinceReport_{false};
+    bool onsetSinceReport_{false};
+    std::array<bool, ONSET_BANDS> bandOnsetsSinceReport_{};
 };
 } // namespace vc
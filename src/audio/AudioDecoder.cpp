@@ -0,0 +1,334 @@
+#include "AudioDecoder.hpp"
+#include <algorithm>
+#include <cstring>
+#include "core/Logger.hpp"
+
+namespace vc {
+
+namespace {
+// Land this far before a seek target so decoders with inter-frame state
+// (MP3 bit reservoir, AAC/Opus overlap) produce clean audio at the target
+constexpr i64 SEEK_PREROLL_MS = 100;
+
+bool isRemote(const fs::path& path) {
+    return path.native().find("://") != std::string::npos;
+}
+} // namespace
+
+AudioDecoder::AudioDecoder() = default;
+
+AudioDecoder::~AudioDecoder() {
+    close();
+}
+
+Result<void> AudioDecoder::open(const fs::path& path, u32 sampleRate, u32 channels) {
+    close();
+
+    sampleRate_ = sampleRate;
+    channels_ = channels;
+
+    AVFormatContext* ctx = nullptr;
+    int ret = avformat_open_input(&ctx, path.c_str(), nullptr, nullptr);
+    if (ret < 0) {
+        return Result<void>::err("Failed to open " + path.string() + ": " +
+                                 ffmpegError(ret));
+    }
+    formatCtx_.reset(ctx);
+
+    ret = avformat_find_stream_info(formatCtx_.get(), nullptr);
+    if (ret < 0) {
+        return Result<void>::err("Failed to read stream info: " + ffmpegError(ret));
+    }
+
+    const AVCodec* codec = nullptr;
+    streamIndex_ = av_find_best_stream(
+            formatCtx_.get(), AVMEDIA_TYPE_AUDIO, -1, -1, &codec, 0);
+    if (streamIndex_ < 0 || !codec) {
+        return Result<void>::err("No audio stream in " + path.string());
+    }
+
+    codecCtx_.reset(avcodec_alloc_context3(codec));
+    if (!codecCtx_)
+        return Result<void>::err("Failed to allocate audio decoder context");
+
+    avcodec_parameters_to_context(codecCtx_.get(),
+                                  formatCtx_->streams[streamIndex_]->codecpar);
+    ret = avcodec_open2(codecCtx_.get(), codec, nullptr);
+    if (ret < 0) {
+        return Result<void>::err("Failed to open audio decoder: " + ffmpegError(ret));
+    }
+
+    if (codecCtx_->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC) {
+        av_channel_layout_default(&codecCtx_->ch_layout,
+                                  codecCtx_->ch_layout.nb_channels);
+    }
+
+    if (auto result = initResampler(); !result)
+        return result;
+
+    frame_.reset(av_frame_alloc());
+    packet_.reset(av_packet_alloc());
+    if (!frame_ || !packet_)
+        return Result<void>::err("Failed to allocate decoder frame/packet");
+
+    const AVStream* stream = formatCtx_->streams[streamIndex_];
+    startPts_ = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    if (stream->duration > 0) {
+        totalFrames_ = static_cast<u64>(av_rescale_q(
+                stream->duration, stream->time_base, {1, static_cast<int>(sampleRate_)}));
+    } else if (formatCtx_->duration > 0) {
+        totalFrames_ = static_cast<u64>(av_rescale(
+                formatCtx_->duration, sampleRate_, AV_TIME_BASE));
+    }
+    if (totalFrames_ > 0) {
+        duration_ = Duration(static_cast<i64>(totalFrames_ * 1000 / sampleRate_));
+    }
+    path_ = path;
+    // Nothing to index for streams; they can't be re-read cheaply anyway
+    indexDone_ = isRemote(path);
+
+    LOG_INFO("AudioDecoder: {} ({} Hz, {} ch -> {} Hz, {} ch, {} ms)",
+             isRemote(path) ? path.string() : path.filename().string(),
+             codecCtx_->sample_rate,
+             codecCtx_->ch_layout.nb_channels,
+             sampleRate_,
+             channels_,
+             duration_.count());
+    return Result<void>::ok();
+}
+
+void AudioDecoder::close() {
+    packet_.reset();
+    frame_.reset();
+    swrCtx_.reset();
+    codecCtx_.reset();
+    formatCtx_.reset();
+    indexCtx_.reset();
+    indexDone_ = false;
+    streamIndex_ = -1;
+    path_.clear();
+    startPts_ = 0;
+    pending_.clear();
+    pendingPos_ = 0;
+    duration_ = Duration{0};
+    totalFrames_ = 0;
+    position_ = 0;
+    decodedFrame_ = discardUntil_ = 0;
+    awaitTimestamp_ = false;
+    inputDrained_ = false;
+    eof_ = false;
+}
+
+Result<void> AudioDecoder::initResampler() {
+    AVChannelLayout outLayout;
+    av_channel_layout_default(&outLayout, static_cast<int>(channels_));
+
+    SwrContext* s = nullptr;
+    swr_alloc_set_opts2(&s,
+                        &outLayout,
+                        AV_SAMPLE_FMT_FLT,
+                        static_cast<int>(sampleRate_),
+                        &codecCtx_->ch_layout,
+                        codecCtx_->sample_fmt,
+                        codecCtx_->sample_rate,
+                        0,
+                        nullptr);
+    swrCtx_.reset(s);
+    if (!swrCtx_ || swr_init(swrCtx_.get()) < 0) {
+        swrCtx_.reset();
+        return Result<void>::err("Failed to initialize audio resampler");
+    }
+    return Result<void>::ok();
+}
+
+Result<void> AudioDecoder::seek(u64 frame) {
+    if (!isOpen())
+        return Result<void>::err("Decoder not open");
+
+    const AVStream* stream = formatCtx_->streams[streamIndex_];
+    const AVRational outputBase{1, static_cast<int>(sampleRate_)};
+    const i64 target = static_cast<i64>(frame);
+    const i64 landing = std::max<i64>(0, target - sampleRate_ * SEEK_PREROLL_MS / 1000);
+    const i64 pts = startPts_ + av_rescale_q(landing, outputBase, stream->time_base);
+
+    int ret = av_seek_frame(formatCtx_.get(), streamIndex_, pts, AVSEEK_FLAG_BACKWARD);
+    if (ret < 0) {
+        // Some demuxers only seek by byte or not backward; rewind instead
+        ret = av_seek_frame(formatCtx_.get(), streamIndex_, startPts_, AVSEEK_FLAG_BACKWARD);
+        if (ret < 0)
+            return Result<void>::err("Seek failed: " + ffmpegError(ret));
+    }
+
+    avcodec_flush_buffers(codecCtx_.get());
+    if (auto result = initResampler(); !result)
+        return result;
+
+    pending_.clear();
+    pendingPos_ = 0;
+    inputDrained_ = false;
+    eof_ = false;
+    discardUntil_ = target;
+    decodedFrame_ = landing;
+    awaitTimestamp_ = true;
+    position_ = frame;
+    return Result<void>::ok();
+}
+
+bool AudioDecoder::indexStep(u32 packets) {
+    if (indexDone_ || !isOpen())
+        return true;
+
+    if (!indexCtx_) {
+        AVFormatContext* ctx = nullptr;
+        if (avformat_open_input(&ctx, path_.c_str(), nullptr, nullptr) < 0) {
+            indexDone_ = true;
+            return true;
+        }
+        indexCtx_.reset(ctx);
+        if (avformat_find_stream_info(indexCtx_.get(), nullptr) < 0 ||
+            static_cast<int>(indexCtx_->nb_streams) <= streamIndex_) {
+            indexCtx_.reset();
+            indexDone_ = true;
+            return true;
+        }
+    }
+
+    AVStream* stream = formatCtx_->streams[streamIndex_];
+    AVPacketPtr packet(av_packet_alloc());
+    for (u32 i = 0; i < packets; ++i) {
+        if (av_read_frame(indexCtx_.get(), packet.get()) < 0) {
+            LOG_DEBUG("AudioDecoder: indexed {} ({} entries)",
+                      path_.filename().string(),
+                      avformat_index_get_entries_count(stream));
+            indexCtx_.reset();
+            indexDone_ = true;
+            return true;
+        }
+        if (packet->stream_index == streamIndex_ && packet->pts != AV_NOPTS_VALUE &&
+            packet->pos >= 0) {
+            av_add_index_entry(stream,
+                               packet->pos,
+                               packet->pts,
+                               packet->size,
+                               0,
+                               AVINDEX_KEYFRAME);
+        }
+        av_packet_unref(packet.get());
+    }
+    return false;
+}
+
+usize AudioDecoder::read(f32* out, usize frames) {
+    if (!isOpen())
+        return 0;
+
+    usize written = 0;
+    while (written < frames) {
+        if (pendingPos_ >= pending_.size()) {
+            pending_.clear();
+            pendingPos_ = 0;
+            if (eof_ || !decodeMore())
+                break;
+            continue;
+        }
+
+        usize available = (pending_.size() - pendingPos_) / channels_;
+        usize n = std::min(available, frames - written);
+        std::memcpy(out + written * channels_,
+                    pending_.data() + pendingPos_,
+                    n * channels_ * sizeof(f32));
+        pendingPos_ += n * channels_;
+        written += n;
+    }
+    position_ += written;
+    return written;
+}
+
+bool AudioDecoder::decodeMore() {
+    while (true) {
+        int ret = avcodec_receive_frame(codecCtx_.get(), frame_.get());
+        if (ret == 0) {
+            if (awaitTimestamp_) {
+                // First frame after a seek: find out where we actually landed
+                const i64 ts = frame_->best_effort_timestamp;
+                if (ts != AV_NOPTS_VALUE) {
+                    decodedFrame_ = av_rescale_q(
+                            ts - startPts_,
+                            formatCtx_->streams[streamIndex_]->time_base,
+                            {1, static_cast<int>(sampleRate_)});
+                }
+                awaitTimestamp_ = false;
+            }
+            const usize offset = pending_.size();
+            appendConverted(const_cast<const u8**>(frame_->extended_data),
+                            frame_->nb_samples);
+            av_frame_unref(frame_.get());
+            discardPreroll(offset);
+            if (!pending_.empty())
+                return true;
+            continue;
+        }
+
+        if (ret == AVERROR_EOF) {
+            // Drain whatever the resampler is still holding
+            const usize offset = pending_.size();
+            appendConverted(nullptr, 0);
+            discardPreroll(offset);
+            eof_ = true;
+            return !pending_.empty();
+        }
+
+        if (ret != AVERROR(EAGAIN)) {
+            LOG_WARN("AudioDecoder: decode error: {}", ffmpegError(ret));
+            eof_ = true;
+            return false;
+        }
+
+        if (inputDrained_)
+            continue;
+
+        ret = av_read_frame(formatCtx_.get(), packet_.get());
+        if (ret < 0) {
+            avcodec_send_packet(codecCtx_.get(), nullptr);
+            inputDrained_ = true;
+            continue;
+        }
+
+        if (packet_->stream_index == streamIndex_) {
+            ret = avcodec_send_packet(codecCtx_.get(), packet_.get());
+            if (ret < 0 && ret != AVERROR(EAGAIN)) {
+                LOG_WARN("AudioDecoder: dropped packet: {}", ffmpegError(ret));
+            }
+        }
+        av_packet_unref(packet_.get());
+    }
+}
+
+void AudioDecoder::appendConverted(const u8** input, int inputSamples) {
+    int capacity = swr_get_out_samples(swrCtx_.get(), inputSamples);
+    if (capacity <= 0)
+        return;
+
+    usize offset = pending_.size();
+    pending_.resize(offset + static_cast<usize>(capacity) * channels_);
+
+    u8* outPtr = reinterpret_cast<u8*>(pending_.data() + offset);
+    int converted = swr_convert(swrCtx_.get(), &outPtr, capacity, input, inputSamples);
+    if (converted < 0) {
+        LOG_WARN("AudioDecoder: resample error: {}", ffmpegError(converted));
+        converted = 0;
+    }
+    pending_.resize(offset + static_cast<usize>(converted) * channels_);
+}
+
+void AudioDecoder::discardPreroll(usize offset) {
+    const i64 produced = static_cast<i64>((pending_.size() - offset) / channels_);
+    if (decodedFrame_ < discardUntil_) {
+        const i64 drop = std::min(produced, discardUntil_ - decodedFrame_);
+        auto begin = pending_.begin() + static_cast<std::ptrdiff_t>(offset);
+        pending_.erase(begin, begin + static_cast<std::ptrdiff_t>(drop * channels_));
+    }
+    decodedFrame_ += produced;
+}
+
+} // namespace vc
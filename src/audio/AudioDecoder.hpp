@@ -0,0 +1,123 @@
+/**
+ * @file AudioDecoder.hpp
+ * @brief Pull-based audio file decoder built directly on libav*.
+ *
+ * This file defines the AudioDecoder class which opens a media file,
+ * decodes its best audio stream and resamples it to interleaved float PCM
+ * at a caller-chosen rate and channel count. Unlike QMediaPlayer it has no
+ * clock: the caller pulls exactly as many frames as it needs, which is what
+ * offline (headless) rendering and DecodeAheadSource want.
+ *
+ * Positions are counted in output frames. seek() is sample accurate: it
+ * lands on a packet at or before the target (with a little preroll for
+ * decoders that need it) and discards decoded audio up to the exact frame.
+ * indexStep() optionally builds a full packet index in slices so seeking
+ * also lands precisely in formats without a usable table of contents.
+ *
+ * @section Dependencies
+ * - FFmpeg (libavformat, libavcodec, libswresample)
+ *
+ * @section Patterns
+ * - RAII: FFmpeg contexts held in the FFmpegUtils smart pointers.
+ */
+
+#pragma once
+#include <vector>
+#include "recorder/FFmpegUtils.hpp"
+#include "util/Result.hpp"
+#include "util/Types.hpp"
+
+namespace vc {
+
+class AudioDecoder {
+public:
+    AudioDecoder();
+    ~AudioDecoder();
+
+    AudioDecoder(const AudioDecoder&) = delete;
+    AudioDecoder& operator=(const AudioDecoder&) = delete;
+
+    // `path` may also be a URL libavformat understands (http, ...)
+    Result<void> open(const fs::path& path, u32 sampleRate = 48000, u32 channels = 2);
+    void close();
+
+    // Continue output from `frame` (output rate) of the track
+    Result<void> seek(u64 frame);
+
+    // Scan up to `packets` more packets of the file into the demuxer's
+    // seek index; returns true once the index is complete (immediately for
+    // non-local sources). Cheap to call again afterwards.
+    bool indexStep(u32 packets);
+    bool indexed() const {
+        return indexDone_;
+    }
+
+    bool isOpen() const {
+        return codecCtx_ != nullptr;
+    }
+    bool atEnd() const {
+        return eof_ && pendingPos_ >= pending_.size();
+    }
+
+    // Reads up to `frames` interleaved frames into `out`.
+    // Returns the number of frames written; 0 means end of stream.
+    usize read(f32* out, usize frames);
+
+    Duration duration() const {
+        return duration_;
+    }
+    // Track length in output frames; 0 if the container doesn't say
+    u64 totalFrames() const {
+        return totalFrames_;
+    }
+    // Frame the next read() starts at
+    u64 position() const {
+        return position_;
+    }
+    u32 sampleRate() const {
+        return sampleRate_;
+    }
+    u32 channels() const {
+        return channels_;
+    }
+
+private:
+    bool decodeMore();
+    void appendConverted(const u8** input, int inputSamples);
+    Result<void> initResampler();
+    // Drop audio appended at `offset` that lies before the seek target
+    void discardPreroll(usize offset);
+
+    AVInputContextPtr formatCtx_;
+    AVCodecContextPtr codecCtx_;
+    SwrContextPtr swrCtx_;
+    AVFramePtr frame_;
+    AVPacketPtr packet_;
+    int streamIndex_{-1};
+    fs::path path_;
+    i64 startPts_{0};
+
+    // Seek index scan on a second demuxer
+    AVInputContextPtr indexCtx_;
+    bool indexDone_{false};
+
+    // After seek(): decoded audio before `discardUntil_` is dropped.
+    // `decodedFrame_` is the output frame the next decoded sample lands on
+    // (negative inside preroll before the stream start).
+    i64 decodedFrame_{0};
+    i64 discardUntil_{0};
+    bool awaitTimestamp_{false};
+
+    std::vector<f32> pending_;
+    usize pendingPos_{0};
+
+    u32 sampleRate_{48000};
+    u32 channels_{2};
+    Duration duration_{0};
+    u64 totalFrames_{0};
+    u64 position_{0};
+    bool inputDrained_{false};
+    bool eof_{false};
+};
+
+} // namespace vc
@@ -1,214 +1,410 @@
 #include "AudioEngine.hpp"
 #include "core/Config.hpp"
 #include "core/Logger.hpp"
+#include "GainStage.hpp"
 #include "util/FileUtils.hpp"
 
-#include <QAudioDevice>
-#include <QMediaDevices>
-#include <QUrl>
+#include <QMetaMethod>
 
 namespace vc {
 
+namespace {
+// Normalization keeps true peaks at or below this, like ReplayGain's clip
+// prevention
+constexpr f32 TRUE_PEAK_CEILING_DBTP = -1.0f;
+constexpr f32 MAX_NORMALIZATION_BOOST_DB = 12.0f;
+constexpr const char* SESSION_PLAYLIST = "last_session";
+} // namespace
+
 AudioEngine::AudioEngine() : QObject(nullptr) {}
 
 AudioEngine::~AudioEngine() {
-    stop();
+    // The source pushes into audioQueue_ from its output thread
+    source_.reset();
+    trackAnalysis_.stop();
+    loudness_.stop();
     stopAnalyzer_ = true;
+    audioQueue_.wake(AudioConsumer::Ana);
     if (analyzerThread_.joinable()) {
         analyzerThread_.join();
     }
 }
 
 Result<void> AudioEngine::init() {
-    audioOutput_ = std::make_unique<QAudioOutput>();
-    audioOutput_->setVolume(volume_);
-
-    player_ = std::make_unique<QMediaPlayer>();
-    player_->setAudioOutput(audioOutput_.get());
+    const auto& audioConfig = CONFIG.audio();
+    source_ = std::make_unique<DecodeAheadSource>(audioQueue_);
+    if (auto result = source_->start(std::clamp<u32>(audioConfig.sampleRate, 8000, 192000),
+                                     audioConfig.device,
+                                     std::max<u32>(audioConfig.bufferSize, 256));
+        !result) {
+        return result;
+    }
+    source_->setVolume(volume_);
+    // The device may have forced a different rate; analysis follows it
+    analysisRate_ = source_->sampleRate();
+    audioQueue_.setSampleRate(analysisRate_);
 
-    bufferOutput_ = std::make_unique<QAudioBufferOutput>();
-    player_->setAudioBufferOutput(bufferOutput_.get());
+    connect(source_.get(), &DecodeAheadSource::trackStarted, this, &AudioEngine::onTrackStarted);
+    connect(source_.get(), &DecodeAheadSource::endOfMedia, this, &AudioEngine::onEndOfMedia);
+    connect(source_.get(), &DecodeAheadSource::errorOccurred, this, &AudioEngine::onSourceError);
 
-    setupConnections(player_.get(), bufferOutput_.get());
+    positionTimer_.setInterval(100);
+    connect(&positionTimer_, &QTimer::timeout, this, [this] { emit positionChanged(position()); });
 
-    // Preload player for gapless
-    nextAudioOutput_ = std::make_unique<QAudioOutput>();
-    nextAudioOutput_->setVolume(volume_);
-    nextPlayer_ = std::make_unique<QMediaPlayer>();
-    nextPlayer_->setAudioOutput(nextAudioOutput_.get());
-    nextBufferOutput_ = std::make_unique<QAudioBufferOutput>();
-    nextPlayer_->setAudioBufferOutput(nextBufferOutput_.get());
+    loudness_.start(file::dataDir() / "loudness.tsv", audioConfig.loudnessThreads);
+    loudness_.ready.connect([this](const fs::path& track, const TrackLoudness& loudness) {
+        QMetaObject::invokeMethod(
+                this, [this, track, loudness] { onLoudnessReady(track, loudness); }, Qt::QueuedConnection);
+    });
 
     // Playlist signals
+    playlist_.itemsAdded.connect([this](usize first, usize count) {
+        std::vector<fs::path> tracks;
+        for (usize index = first; index < first + count; ++index) {
+            const auto* item = playlist_.itemAt(index);
+            if (!item || item->isRemote) continue;
+            // Last known result right away; the scanner re-measures if the file changed
+            if (auto known = loudness_.find(item->path)) playlist_.setLoudness(index, *known);
+            tracks.push_back(item->path);
+        }
+        loudness_.enqueue(tracks);
+    });
+    // Loader threads report; publish what they have at most every 100 ms
+    metadataTimer_.setSingleShot(true);
+    metadataTimer_.setInterval(100);
+    connect(&metadataTimer_, &QTimer::timeout, this, [this] { playlist_.applyPendingMetadata(); });
+    playlist_.metadataReady.connect([this] {
+        QMetaObject::invokeMethod(
+                this, [this] { if (!metadataTimer_.isActive()) metadataTimer_.start(); }, Qt::QueuedConnection);
+    });
+    playlist_.itemsUpdated.connect([this](const std::vector<usize>&) {
+        // Album gain groups by tags, which may only just have arrived
+        if (CONFIG.audio().normalization == "album") applyTrackGains();
+    });
     playlist_.currentChanged.connect([this](usize index) { onPlaylistCurrentChanged(index); });
-    playlist_.changed.connect([this] { saveLastPlaylist(); });
-
+    playlist_.changed.connect([this] {
+        saveLastPlaylist();
+        prepareNextTrack();
+    });
+
+    if (auto result = library_.open(file::dataDir() / "library.db"); result) {
+        playlist_.setLibrary(&library_);
+    } else {
+        LOG_WARN("{}; track metadata will be re-read every session", result.error().message);
+    }
     loadLastPlaylist();
 
+    AnalyzerSettings analysis;
+    analysis.fftSize = audioConfig.fftSize;
+    analysis.hopSize = audioConfig.fftHop;
+    analysis.bassFftSize = audioConfig.bassFftSize;
+    analysis.window = parseFftWindow(audioConfig.fftWindow).value_or(FftWindow::Hann);
+    if (auto result = analyzer_.configure(analysis); !result) {
+        LOG_WARN("Audio analysis settings rejected ({}), using defaults",
+                 result.error().message);
+    }
+
+    trackAnalysis_.start(file::cacheDir() / "timelines", analyzer_.settings(), analysisRate_);
+    trackAnalysis_.ready.connect([this](const fs::path& track) {
+        QMetaObject::invokeMethod(
+                this,
+                [this, track] {
+                    if (track == fs::path(currentSource_)) emit timelineReady();
+                },
+                Qt::QueuedConnection);
+    });
+
+    spectrumNotifyInterval_ =
+            chr::nanoseconds(1'000'000'000) / std::max<u32>(CONFIG.visualizer().fps, 1);
     stopAnalyzer_ = false;
     analyzerThread_ = std::jthread(&AudioEngine::analyzerWorker, this);
 
-    LOG_INFO("Audio engine initialized with QAudioBufferOutput");
+    LOG_INFO("Audio engine initialized with decode-ahead FFmpeg source");
     return Result<void>::ok();
 }
 
-void AudioEngine::setupConnections(QMediaPlayer* player, QAudioBufferOutput* bufferOutput) {
-    connect(player, &QMediaPlayer::playbackStateChanged, this, &AudioEngine::onPlayerStateChanged);
-    connect(player, &QMediaPlayer::positionChanged, this, &AudioEngine::onPositionChanged);
-    connect(player, &QMediaPlayer::durationChanged, this, &AudioEngine::onDurationChanged);
-    connect(player, &QMediaPlayer::errorOccurred, this, &AudioEngine::onErrorOccurred);
-    connect(player, &QMediaPlayer::mediaStatusChanged, this, &AudioEngine::onMediaStatusChanged);
-    connect(bufferOutput, &QAudioBufferOutput::audioBufferReceived, this, &AudioEngine::onAudioBufferReceived);
-}
-
 void AudioEngine::play() {
     if (!playlist_.currentItem() && !playlist_.empty()) {
         playlist_.jumpTo(0);
     }
-    if (player_->source().isEmpty() && playlist_.currentItem()) {
+    if (currentSource_.empty() && playlist_.currentItem()) {
         loadCurrentTrack();
     }
-    if (!player_->source().isEmpty()) {
-        player_->play();
+    if (!currentSource_.empty()) {
+        source_->play();
+        positionTimer_.start();
+        setState(PlaybackState::Playing);
     }
 }
 
-void AudioEngine::pause() { player_->pause(); }
-void AudioEngine::stop() { player_->stop(); analyzer_.reset(); }
+void AudioEngine::pause() {
+    if (state_ != PlaybackState::Playing) return;
+    source_->pause();
+    positionTimer_.stop();
+    setState(PlaybackState::Paused);
+}
+
+void AudioEngine::stop() {
+    if (!source_) return;
+    source_->pause();
+    source_->seek(Duration(0));
+    positionTimer_.stop();
+    resetAnalysis(Duration(0));
+    setState(PlaybackState::Stopped);
+    emit positionChanged(Duration(0));
+}
 
 void AudioEngine::togglePlayPause() {
     if (state_ == PlaybackState::Playing) pause();
     else play();
 }
 
-void AudioEngine::seek(Duration position) { player_->setPosition(position.count()); }
+void AudioEngine::seek(Duration position) {
+    source_->seek(position);
+    resetAnalysis(position);
+    emit positionChanged(position);
+}
 
 void AudioEngine::setVolume(f32 volume) {
     volume_ = std::clamp(volume, 0.0f, 1.0f);
-    if (audioOutput_) audioOutput_->setVolume(volume_);
-    if (nextAudioOutput_) nextAudioOutput_->setVolume(volume_);
+    if (source_) source_->setVolume(volume_);
 }
 
-Duration AudioEngine::position() const { return Duration(player_->position()); }
-Duration AudioEngine::duration() const { return Duration(player_->duration()); }
+Duration AudioEngine::position() const { return source_ ? source_->position() : Duration(0); }
+Duration AudioEngine::duration() const { return source_ ? source_->duration() : Duration(0); }
 
-void AudioEngine::onPlayerStateChanged(QMediaPlayer::PlaybackState state) {
-    if (sender() != player_.get()) return;
-    switch (state) {
-        case QMediaPlayer::StoppedState: state_ = PlaybackState::Stopped; break;
-        case QMediaPlayer::PlayingState: state_ = PlaybackState::Playing; break;
-        case QMediaPlayer::PausedState: state_ = PlaybackState::Paused; break;
-    }
+void AudioEngine::setState(PlaybackState state) {
+    if (state_ == state) return;
+    state_ = state;
     emit stateChanged(state_);
 }
 
-void AudioEngine::onPositionChanged(qint64 position) {
-    if (sender() == player_.get()) emit positionChanged(Duration(position));
-}
-
-void AudioEngine::onDurationChanged(qint64 duration) {
-    if (sender() == player_.get()) emit durationChanged(Duration(duration));
-}
-
-void AudioEngine::onErrorOccurred(QMediaPlayer::Error err, const QString& errorString) {
-    if (sender() == player_.get()) {
-        LOG_ERROR("Playback error: {}", errorString.toStdString());
-        emit errorSignal(errorString.toStdString());
+void AudioEngine::onTrackStarted(quint64 track, qint64 durationMs) {
+    if (track == nextTrack_ && track != currentTrack_) {
+        // Gapless transition: the source is already playing the next item,
+        // bring the playlist along without reopening it
+        currentTrack_ = track;
+        currentSource_ = nextSource_;
+        nextTrack_ = 0;
+        nextSource_.clear();
+        followingSource_ = true;
+        playlist_.next();
+        followingSource_ = false;
     }
+    resetAnalysis(Duration(0));
+    emit durationChanged(Duration(durationMs));
 }
 
-void AudioEngine::onMediaStatusChanged(QMediaPlayer::MediaStatus status) {
-    if (sender() != player_.get()) return;
-    if (status == QMediaPlayer::EndOfMedia && autoPlayNext_) {
-        if (!nextPlayer_->source().isEmpty()) {
-            swapPlayers();
-            playlist_.next(); 
-        } else if (!playlist_.next()) {
-            stop();
-        }
+void AudioEngine::onEndOfMedia(quint64 track) {
+    if (track != currentTrack_) return;
+    if (!autoPlayNext_ || !playlist_.next()) {
+        stop();
     }
 }
 
-void AudioEngine::onAudioBufferReceived(const QAudioBuffer& buffer) {
-    if (sender() == bufferOutput_.get()) processAudioBuffer(buffer);
+void AudioEngine::onSourceError(const QString& message) {
+    LOG_ERROR("Playback error: {}", message.toStdString());
+    emit errorSignal(message.toStdString());
 }
 
 void AudioEngine::onPlaylistCurrentChanged(usize index) {
-    loadCurrentTrack();
+    const auto* item = playlist_.itemAt(index);
+    const bool followed = followingSource_ && item &&
+                          (item->isRemote ? item->url : item->path.string()) == currentSource_;
+    if (followed) {
+        prepareNextTrack();
+    } else {
+        loadCurrentTrack();
+    }
     emit trackChanged();
     play();
 }
 
-void AudioEngine::swapPlayers() {
-    player_.swap(nextPlayer_);
-    audioOutput_.swap(nextAudioOutput_);
-    bufferOutput_.swap(nextBufferOutput_);
-    // Reconnect new active player
-    disconnect(nextPlayer_.get(), nullptr, this, nullptr);
-    disconnect(nextBufferOutput_.get(), nullptr, this, nullptr);
-    setupConnections(player_.get(), bufferOutput_.get());
-}
-
 void AudioEngine::loadCurrentTrack() {
     const auto* item = playlist_.currentItem();
     if (!item) return;
-    QUrl source = item->isRemote ? QUrl(QString::fromStdString(item->url)) : QUrl::fromLocalFile(QString::fromStdString(item->path.string()));
-    if (player_->source() != source) player_->setSource(source);
+    currentSource_ = item->isRemote ? item->url : item->path.string();
+    currentTrack_ = ++trackSerial_;
+    source_->open(currentSource_, currentTrack_);
+    source_->setTrackGain(currentTrack_, normalizationGain(currentSource_));
+    loudness_.enqueue({currentSource_}, true);
+    trackAnalysis_.request(currentSource_, true);
+    emit positionChanged(Duration(0));
     prepareNextTrack();
 }
 
 void AudioEngine::prepareNextTrack() {
-    const auto* nextItem = playlist_.itemAt(playlist_.currentIndex().value_or(0) + 1);
-    if (!nextItem) {
-        nextPlayer_->setSource(QUrl());
-        return;
+    if (!source_ || currentSource_.empty()) return;
+    auto nextIndex = playlist_.peekNext();
+    const auto* nextItem = nextIndex ? playlist_.itemAt(*nextIndex) : nullptr;
+    std::string next = nextItem ? (nextItem->isRemote ? nextItem->url : nextItem->path.string()) : std::string();
+    if (next == nextSource_) return;
+    nextSource_ = std::move(next);
+    nextTrack_ = nextSource_.empty() ? 0 : ++trackSerial_;
+    source_->setNext(nextSource_, nextTrack_);
+    if (nextTrack_) source_->setTrackGain(nextTrack_, normalizationGain(nextSource_));
+    trackAnalysis_.request(nextSource_);
+}
+
+void AudioEngine::onLoudnessReady(const fs::path& track, const TrackLoudness& loudness) {
+    playlist_.setLoudness(track, loudness);
+    // Album gain depends on every track of the album, so recompute on any
+    // result; Playlist keeps the album sums, so that's two lookups
+    if (track == fs::path(currentSource_) || track == fs::path(nextSource_) ||
+        CONFIG.audio().normalization == "album") {
+        applyTrackGains();
     }
-    QUrl source = nextItem->isRemote ? QUrl(QString::fromStdString(nextItem->url)) : QUrl::fromLocalFile(QString::fromStdString(nextItem->path.string()));
-    nextPlayer_->setSource(source);
+}
+
+f32 AudioEngine::normalizationGain(const std::string& source) const {
+    const auto& audioConfig = CONFIG.audio();
+    if (audioConfig.normalization == "off") return 1.0f;
+
+    const auto* item = playlist_.findLocal(fs::path(source));
+    if (!item || !item->metadata.loudness) return 1.0f;
+
+    f64 lufs = item->metadata.loudness->integratedLufs;
+    f32 peak = item->metadata.loudness->truePeakDbtp;
+    if (audioConfig.normalization == "album") {
+        if (auto album = playlist_.albumLoudness(*item)) {
+            lufs = album->integratedLufs;
+            peak = std::max(peak, album->truePeakDbtp);
+        }
+    }
+    if (lufs <= LOUDNESS_SILENCE_LUFS) return 1.0f;
+
+    // Never push the true peak over the ceiling, never boost without bound
+    const f32 gainDb = std::min({audioConfig.normalizationTarget - static_cast<f32>(lufs),
+                                 TRUE_PEAK_CEILING_DBTP - peak,
+                                 MAX_NORMALIZATION_BOOST_DB});
+    return dbToGain(gainDb);
+}
+
+void AudioEngine::applyTrackGains() {
+    if (!source_) return;
+    if (currentTrack_) source_->setTrackGain(currentTrack_, normalizationGain(currentSource_));
+    if (nextTrack_) source_->setTrackGain(nextTrack_, normalizationGain(nextSource_));
+}
+
+std::shared_ptr<const TrackTimeline> AudioEngine::timeline() const {
+    return currentSource_.empty() ? nullptr : trackAnalysis_.find(currentSource_);
+}
+
+void AudioEngine::resetAnalysis(Duration position) {
+    f32 bpm = 0.0f;
+    f32 phase = 0.0f;
+    if (auto cached = timeline()) {
+        const auto point = cached->at(position);
+        bpm = cached->sections()[point.section].bpm;
+        phase = point.beatPhase;
+    }
+    seedBpm_.store(bpm, std::memory_order_relaxed);
+    seedPhase_.store(phase, std::memory_order_relaxed);
+    analysisResetPending_.store(true, std::memory_order_release);
+    audioQueue_.wake(AudioConsumer::Ana);
 }
 
 void AudioEngine::loadLastPlaylist() {
+    if (library_.isOpen()) {
+        auto restored = playlist_.loadFromLibrary(SESSION_PLAYLIST);
+        if (restored && restored.value()) return;
+        if (!restored) LOG_WARN("Could not restore session: {}", restored.error().message);
+    }
+    // No library, or the first run with one: the old session file
     auto path = file::configDir() / "last_session.m3u";
     if (fs::exists(path)) playlist_.loadM3U(path);
 }
 
 void AudioEngine::saveLastPlaylist() {
+    if (library_.isOpen()) {
+        auto result = playlist_.saveToLibrary(SESSION_PLAYLIST);
+        if (result) return;
+        LOG_WARN("Could not save session to the library: {}", result.error().message);
+    }
     auto path = file::configDir() / "last_session.m3u";
     file::ensureDir(path.parent_path());
     playlist_.saveM3U(path);
 }
 
 void AudioEngine::analyzerWorker() {
-    std::vector<f32> localBuffer(2048);
+    constexpr u32 maxFrames = 4096;
+    // Latency smoothing: ~1/16 weight per pass
+    constexpr i64 latencyShift = 4;
     while (!stopAnalyzer_) {
-        u32 popped = audioQueue_.popAnaBatch(localBuffer.data(), localBuffer.size() / 2);
-        if (popped > 0) {
-            currentSpectrum_ = analyzer_.analyze(std::span(localBuffer.data(), popped * 2), 48000, 2);
-            emit spectrumUpdated(currentSpectrum_);
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        // Seek / track change: drop history from before the jump
+        if (analysisResetPending_.exchange(false, std::memory_order_acquire)) {
+            analyzer_.reset();
+            analyzer_.seedTempo(seedBpm_.load(std::memory_order_relaxed),
+                                seedPhase_.load(std::memory_order_relaxed));
+        }
+        // Sleep until the producer has delivered the rest of the next hop
+        const u32 needed = analyzer_.framesUntilHop();
+        if (audioQueue_.waitForFrames(AudioConsumer::Ana, needed) < needed) {
+            analyzerIdleWakeups_.fetch_add(1, std::memory_order_relaxed);
+            continue;
         }
+        const i64 arrivedNs = audioQueue_.lastPushNs();
+
+        // Analyze straight out of the ring; a wrapped tail is picked up next pass
+        auto spans = audioQueue_.peek(AudioConsumer::Ana, maxFrames);
+        if (spans.empty())
+            continue;
+
+        // Analyze straight into the back slot, then hand it over
+        auto& snapshot = analysis_.back();
+        analyzer_.analyze(spans.first, audioQueue_.sampleRate(), 2, snapshot.spectrum);
+        audioQueue_.consume(AudioConsumer::Ana, static_cast<u32>(spans.first.size() / 2));
+        snapshot.pcmSize = analyzer_.copyPcm(snapshot.pcm);
+        snapshot.sequence = ++analysisSequence_;
+        analysis_.publish();
+        notifySpectrum();
+
+        const i64 latency = AudioQueue::nowNs() - arrivedNs;
+        const i64 smoothed = analyzerLatencyNs_.load(std::memory_order_relaxed);
+        analyzerLatencyNs_.store(smoothed + ((latency - smoothed) >> latencyShift),
+                                 std::memory_order_relaxed);
+        if (latency > analyzerMaxLatencyNs_.load(std::memory_order_relaxed))
+            analyzerMaxLatencyNs_.store(latency, std::memory_order_relaxed);
+        analyzerPasses_.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
-void AudioEngine::processAudioBuffer(const QAudioBuffer& buffer) {
-    if (!buffer.isValid()) return;
-    const auto format = buffer.format();
-    const usize frameCount = static_cast<usize>(buffer.frameCount());
-    const usize channels = static_cast<usize>(format.channelCount());
-    const usize totalSamples = frameCount * channels;
+AnalyzerStats AudioEngine::analyzerStats() const {
+    AnalyzerStats stats;
+    stats.passes = analyzerPasses_.load(std::memory_order_relaxed);
+    stats.idleWakeups = analyzerIdleWakeups_.load(std::memory_order_relaxed);
+    stats.producerWakeups = audioQueue_.wakeupCount(AudioConsumer::Ana);
+    stats.latencyMs = static_cast<f64>(analyzerLatencyNs_.load(std::memory_order_relaxed)) / 1e6;
+    stats.maxLatencyMs =
+            static_cast<f64>(analyzerMaxLatencyNs_.load(std::memory_order_relaxed)) / 1e6;
+    return stats;
+}
 
-    if (scratchBuffer_.size() < totalSamples) scratchBuffer_.resize(totalSamples);
+const AnalysisSnapshot& AudioEngine::analysis() {
+    analysis_.update();
+    return analysis_.front();
+}
 
-    if (format.sampleFormat() == QAudioFormat::Float) {
-        std::copy(buffer.constData<f32>(), buffer.constData<f32>() + totalSamples, scratchBuffer_.begin());
-    } else if (format.sampleFormat() == QAudioFormat::Int16) {
-        const i16* data = buffer.constData<i16>();
-        for (usize i = 0; i < totalSamples; ++i) scratchBuffer_[i] = static_cast<f32>(data[i]) / 32768.0f;
-    }
+void AudioEngine::notifySpectrum() {
+    static const QMetaMethod signal = QMetaMethod::fromSignal(&AudioEngine::spectrumUpdated);
+    if (!isSignalConnected(signal))
+        return;
 
-    audioQueue_.pushAll(scratchBuffer_.data(), static_cast<u32>(frameCount), static_cast<u32>(channels), static_cast<u32>(format.sampleRate()));
-    emit pcmReceived(scratchBuffer_, static_cast<u32>(frameCount), static_cast<u32>(channels), static_cast<u32>(format.sampleRate()));
+    // One queued event in flight at most, and no more often than frames
+    auto now = chr::steady_clock::now();
+    if (now - lastSpectrumNotify_ < spectrumNotifyInterval_)
+        return;
+    if (spectrumNotifyPending_.exchange(true, std::memory_order_acq_rel))
+        return;
+    lastSpectrumNotify_ = now;
+
+    QMetaObject::invokeMethod(
+            this,
+            [this] {
+                spectrumNotifyPending_.store(false, std::memory_order_release);
+                emit spectrumUpdated();
+            },
+            Qt::QueuedConnection);
 }
 
 } // namespace vc
@@ -2,13 +2,14 @@
 #include <projectM-4/projectM.h>
 #include "AudioAnalyzer.hpp"
 #include "AudioQueue.hpp"
+#include "DecodeAheadSource.hpp"
+#include "MediaLibrary.hpp"
 #include "Playlist.hpp"
+#include "analysis/LoudnessScanner.hpp"
+#include "analysis/TrackAnalysisCache.hpp"
 #include "util/Result.hpp"
+#include "util/TripleBuffer.hpp"
 #include "util/Types.hpp"
-#include <QAudioBuffer>
-#include <QAudioBufferOutput>
-#include <QAudioOutput>
-#include <QMediaPlayer>
 #include <QTimer>
 #include <memory>
 #include <thread>
@@ -18,6 +19,23 @@ namespace vc {
 
 enum class PlaybackState { Stopped, Playing, Paused };
 
+// One analyzer pass, published lock-free from the analyzer thread
+struct AnalysisSnapshot {
+    AudioSpectrum spectrum;
+    std::array<f32, MAX_FFT_SIZE> pcm{}; // mono analysis window, oldest first
+    usize pcmSize{0};
+    u64 sequence{0}; // increments with every pass
+};
+
+// Analyzer thread counters. Cumulative; sample twice to get per-second rates.
+struct AnalyzerStats {
+    u64 passes{0};          // wakeups that analyzed audio
+    u64 idleWakeups{0};     // wakeups that found less than a hop (shutdown, spurious)
+    u64 producerWakeups{0}; // times the audio callback rang the analyzer's doorbell
+    f64 latencyMs{0.0};     // newest audio arrival -> snapshot published, smoothed
+    f64 maxLatencyMs{0.0};
+};
+
 class AudioEngine : public QObject {
     Q_OBJECT
 
@@ -43,58 +61,105 @@ public:
     Playlist& playlist() { return playlist_; }
     const Playlist& playlist() const { return playlist_; }
 
-    AudioSpectrum currentSpectrum() const { return currentSpectrum_; }
-    std::vector<f32> currentPCM() const { return analyzer_.pcmData(); }
+    // Newest analysis, read in place without copying or locking. Call from
+    // the GUI thread only; the reference is valid until the next call.
+    const AnalysisSnapshot& analysis();
+    const AudioSpectrum& currentSpectrum() { return analysis().spectrum; }
+    std::span<const f32> currentPCM() {
+        const auto& snapshot = analysis();
+        return {snapshot.pcm.data(), snapshot.pcmSize};
+    }
     AudioQueue& audioQueue() { return audioQueue_; }
     const AudioQueue& audioQueue() const { return audioQueue_; }
+    AnalyzerStats analyzerStats() const;
+
+    // Precomputed analysis of the current track; nullptr until the
+    // background pass has finished (see timelineReady)
+    std::shared_ptr<const TrackTimeline> timeline() const;
+
+    // Session playlist: saved to the media library (last_session.m3u if
+    // the library can't be opened)
+    void saveLastPlaylist();
 
 signals:
     void stateChanged(PlaybackState state);
     void positionChanged(Duration position);
     void durationChanged(Duration duration);
-    void spectrumUpdated(const AudioSpectrum& spectrum);
+    // New analysis is available via analysis(). Coalesced to at most one
+    // per visualizer frame, and only emitted while something is connected.
+    void spectrumUpdated();
     void trackChanged();
     void errorSignal(const std::string& error);
-    void pcmReceived(const std::vector<f32>& data, u32 frames, u32 channels, u32 sampleRate);
+    void timelineReady();
 
 private slots:
-    void onPlayerStateChanged(QMediaPlayer::PlaybackState state);
-    void onPositionChanged(qint64 position);
-    void onDurationChanged(qint64 duration);
-    void onErrorOccurred(QMediaPlayer::Error error, const QString& errorString);
-    void onAudioBufferReceived(const QAudioBuffer& buffer);
+    void onTrackStarted(quint64 track, qint64 durationMs);
+    void onEndOfMedia(quint64 track);
+    void onSourceError(const QString& message);
     void onPlaylistCurrentChanged(usize index);
-    void onMediaStatusChanged(QMediaPlayer::MediaStatus status);
+    void onLoudnessReady(const fs::path& track, const TrackLoudness& loudness);
 
 private:
-    void setupConnections(QMediaPlayer* player, QAudioBufferOutput* bufferOutput);
+    void setState(PlaybackState state);
     void loadCurrentTrack();
     void prepareNextTrack();
-    void swapPlayers();
-    void processAudioBuffer(const QAudioBuffer& buffer);
+    // Normalization gain for `source` per audio.normalization (1 if unknown)
+    f32 normalizationGain(const std::string& source) const;
+    void applyTrackGains();
     void analyzerWorker();
+    void notifySpectrum();
+    // Restart beat tracking at `position`, seeded from the timeline if any
+    void resetAnalysis(Duration position);
     void loadLastPlaylist();
-    void saveLastPlaylist();
 
-    std::unique_ptr<QMediaPlayer> player_;
-    std::unique_ptr<QAudioOutput> audioOutput_;
-    std::unique_ptr<QAudioBufferOutput> bufferOutput_;
-    std::unique_ptr<QMediaPlayer> nextPlayer_;
-    std::unique_ptr<QAudioOutput> nextAudioOutput_;
-    std::unique_ptr<QAudioBufferOutput> nextBufferOutput_;
+    std::unique_ptr<DecodeAheadSource> source_;
+    QTimer positionTimer_;
+    QTimer metadataTimer_;
+
+    // Source track ids: every open/setNext gets a fresh one
+    u64 trackSerial_{0};
+    u64 currentTrack_{0};
+    std::string currentSource_;
+    u64 nextTrack_{0};
+    std::string nextSource_;
+    // Set while the playlist follows a gapless transition the source made
+    bool followingSource_{false};
 
     std::jthread analyzerThread_;
     std::atomic<bool> stopAnalyzer_{false};
 
+    // Before playlist_: outlives the pointer playlist_ holds to it
+    MediaLibrary library_;
     Playlist playlist_;
     AudioAnalyzer analyzer_;
-    AudioSpectrum currentSpectrum_;
     AudioQueue audioQueue_;
 
+    TripleBuffer<AnalysisSnapshot> analysis_;
+    u64 analysisSequence_{0};
+    std::atomic<bool> spectrumNotifyPending_{false};
+    chr::steady_clock::time_point lastSpectrumNotify_;
+    chr::nanoseconds spectrumNotifyInterval_{chr::milliseconds(16)};
+
+    LoudnessScanner loudness_;
+    TrackAnalysisCache trackAnalysis_;
+    // Set by the GUI thread, applied by the analyzer thread before its
+    // next pass; seedBpm_ = 0 means reset without a seed
+    std::atomic<bool> analysisResetPending_{false};
+    std::atomic<f32> seedBpm_{0.0f};
+    std::atomic<f32> seedPhase_{0.0f};
+
+    // Written by the analyzer thread only
+    std::atomic<u64> analyzerPasses_{0};
+    std::atomic<u64> analyzerIdleWakeups_{0};
+    std::atomic<i64> analyzerLatencyNs_{0};
+    std::atomic<i64> analyzerMaxLatencyNs_{0};
+
     PlaybackState state_{PlaybackState::Stopped};
     f32 volume_{1.0f};
     bool autoPlayNext_{true};
-    std::vector<f32> scratchBuffer_;
+    // Rate of everything in audioQueue_ (audio.sample_rate unless the
+    // output device can't run at it)
+    u32 analysisRate_{44100};
 };
 
 } // namespace vc
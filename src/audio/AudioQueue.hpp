@@ -1,58 +1,81 @@
-// Version: 1.0.0
-// Last Edited: 2026-03-29 12:00:00
-// Description: Lock-free SPSC audio queues using moodycamel::ReaderWriterQueue
-//              Two-queue pattern: viz path (visualizer) + rec path (recorder)
+// Version: 2.1.0
+// Last Edited: 2026-10-15 12:00:00
+// Description: Single-writer broadcast audio ring
+//              One contiguous float ring written once, one read cursor per
+//              consumer (visualizer, recorder, analyzer), with a per-consumer
+//              doorbell for readers that block until enough audio arrives
 
 #pragma once
 
+#include "util/SpscQueue.hpp"
 #include "util/Types.hpp"
+#include <algorithm>
+#include <array>
 #include <atomic>
-#include <cstddef>
-#include <readerwriterqueue.h>
+#include <bit>
+#include <chrono>
 #include <cstring>
+#include <limits>
+#include <memory>
+#include <span>
 
 namespace vc {
 
-// Frame size optimized for cache lines (64 bytes)
-// 8 samples * 2 channels * 4 bytes = 64 bytes
-inline constexpr u32 AUDIO_FRAME_SAMPLES = 8;
+// Default capacity in stereo frames (rounded up to a power of two).
+// 65536 frames = ~1.4 s at 48 kHz = 512 KB of interleaved floats.
+inline constexpr u32 DEFAULT_QUEUE_CAPACITY = 65536;
 
-// Default capacity: 3 seconds at 48kHz stereo
-// 48000 * 2 * 3 = 288000 samples / 8 = 36000 frames
-inline constexpr u32 DEFAULT_QUEUE_CAPACITY = 36000;
+// Everything that reads from the ring. Each gets its own cursor.
+enum class AudioConsumer : u8 { Viz = 0, Rec, Ana };
+inline constexpr usize AUDIO_CONSUMER_COUNT = 3;
 
-// Cache-line aligned audio frame for optimal SPSC performance
-struct alignas(64) AudioFrame {
-    float samples[AUDIO_FRAME_SAMPLES * 2]; // Stereo interleaved
-    u32 sampleCount;  // Number of valid samples (may be < 8 at boundaries)
-    u32 channels;     // Always 2 (stereo) after conversion
-    u32 sampleRate;   // Sample rate (typically 48000)
+/**
+ * Up to two views of interleaved stereo samples in the ring.
+ * `second` is non-empty only when the readable region wraps around.
+ */
+struct AudioSpans {
+    std::span<const f32> first;
+    std::span<const f32> second;
 
-    AudioFrame() : sampleCount(0), channels(2), sampleRate(48000) {
-        std::memset(samples, 0, sizeof(samples));
+    u32 frames() const {
+        return static_cast<u32>((first.size() + second.size()) / 2);
+    }
+    bool empty() const {
+        return first.empty();
     }
 };
 
 /**
- * Lock-free audio queue manager with two-queue pattern.
- * 
- * AudioEngine (producer) pushes to both queues.
- * VisualizerRenderer (consumer) pops from vizQueue.
- * VideoRecorderThread (consumer) pops from recQueue.
- * 
- * Thread safety: SPSC semantics - single producer, single consumer per queue.
- * No mutexes in the audio callback path.
+ * Lock-free single-writer, multi-reader broadcast ring.
+ *
+ * AudioEngine (producer) converts each buffer to stereo once and writes it
+ * into one contiguous float ring. VisualizerRenderer, VideoRecorderThread
+ * and the analyzer thread each own a read cursor and consume independently
+ * via peek()/consume() (zero-copy, two spans across the wraparound) or the
+ * copying pop() convenience.
+ *
+ * The writer never blocks and never waits on readers. A reader that falls
+ * more than (capacity - guard) frames behind is skipped forward to the
+ * oldest still-safe frame and the skipped frames are counted as drops, so
+ * spans returned by peek() stay valid while the producer writes up to
+ * `guard` (capacity / 4) further frames.
+ *
+ * A consumer can block in waitForFrames() instead of polling. The writer
+ * checks one atomic per consumer after each push and only rings a reader's
+ * WakeSignal when that reader is asleep and the push crossed the frame
+ * count it asked for, so a reader waiting for a 512-frame hop costs at most
+ * one futex wake per hop and an idle or busy reader costs none.
+ *
+ * Thread safety: exactly one producer thread; exactly one thread per
+ * consumer. No mutexes anywhere.
  */
 class AudioQueue {
 public:
     explicit AudioQueue(u32 capacity = DEFAULT_QUEUE_CAPACITY)
-        : vizQueue_(capacity)
-        , recQueue_(capacity)
-        , anaQueue_(capacity)
-        , vizDropCount_(0)
-        , recDropCount_(0)
-        , anaDropCount_(0)
-        , totalPushed_(0)
+        : capacity_(std::bit_ceil(std::max<u32>(capacity, 1024)))
+        , mask_(capacity_ - 1)
+        , guard_(capacity_ / 4)
+        , buffer_(std::make_unique<f32[]>(static_cast<usize>(capacity_) * 2))
     {}
 
     // Non-copyable, non-movable (atomic members)
@@ -66,108 +89,179 @@ public:
     // ========================================================================
 
     /**
-     * Push audio data to visualizer queue.
-     * @param data Interleaved stereo samples
+     * Write audio once for all consumers.
+     * @param data Interleaved samples
      * @param frames Number of frames (samples per channel)
-     * @param channels Number of channels (will be converted to stereo)
-     * @param sampleRate Sample rate
-     * @return true if pushed successfully, false if dropped
+     * @param channels Source channel count (converted to stereo)
+     * @param sampleRate Source sample rate (published for consumers)
      */
-    bool pushViz(const float* data, u32 frames, u32 channels, u32 sampleRate) {
-        return pushInternal(vizQueue_, vizDropCount_, data, frames, channels, sampleRate);
-    }
+    void push(const f32* data, u32 frames, u32 channels, u32 sampleRate) {
+        if (!data || frames == 0 || channels == 0) return;
 
-    /**
-     * Push audio data to recorder queue.
-     * @param data Interleaved stereo samples
-     * @param frames Number of frames (samples per channel)
-     * @param channels Number of channels (will be converted to stereo)
-     * @param sampleRate Sample rate
-     * @return true if pushed successfully, false if dropped
-     */
-    bool pushRec(const float* data, u32 frames, u32 channels, u32 sampleRate) {
-        return pushInternal(recQueue_, recDropCount_, data, frames, channels, sampleRate);
-    }
+        sampleRate_.store(sampleRate, std::memory_order_relaxed);
+        totalPushed_.fetch_add(frames, std::memory_order_relaxed);
 
-    bool pushAna(const float* data, u32 frames, u32 channels, u32 sampleRate) {
-        return pushInternal(anaQueue_, anaDropCount_, data, frames, channels, sampleRate);
-    }
+        // Anything beyond one ring's worth would be overwritten immediately
+        if (frames > capacity_) {
+            data += static_cast<usize>(frames - capacity_) * channels;
+            frames = capacity_;
+        }
+
+        u64 w = writePos_.load(std::memory_order_relaxed);
+        u32 idx = static_cast<u32>(w & mask_);
+        u32 firstPart = std::min(frames, capacity_ - idx);
+
+        writeStereo(buffer_.get() + static_cast<usize>(idx) * 2, data, firstPart, channels);
+        if (firstPart < frames) {
+            writeStereo(buffer_.get(), data + static_cast<usize>(firstPart) * channels,
+                        frames - firstPart, channels);
+        }
 
-    void pushAll(const float* data, u32 frames, u32 channels, u32 sampleRate) {
-        pushViz(data, frames, channels, sampleRate);
-        pushRec(data, frames, channels, sampleRate);
-        pushAna(data, frames, channels, sampleRate);
+        lastPushNs_.store(nowNs(), std::memory_order_relaxed);
+        // seq_cst pairs with waitForFrames(): either the reader sees the new
+        // write position or we see its wake threshold
+        writePos_.store(w + frames, std::memory_order_seq_cst);
+        for (auto& c : cursors_) {
+            u64 wakeAt = c.wakeAt.load(std::memory_order_seq_cst);
+            if (wakeAt <= w + frames &&
+                c.wakeAt.compare_exchange_strong(wakeAt, NO_WAITER, std::memory_order_relaxed)) {
+                c.wakeups.fetch_add(1, std::memory_order_relaxed);
+                c.signal.notify();
+            }
+        }
     }
 
     // ========================================================================
-    // Consumer API (called from VisualizerRenderer / VideoRecorderThread)
+    // Consumer API
     // ========================================================================
 
     /**
-     * Pop a frame from visualizer queue.
-     * @param frame Output frame
-     * @return true if frame was popped, false if queue empty
+     * View up to `maxFrames` unread frames without copying.
+     * Call consume() with the number of frames actually used.
      */
-    bool popViz(AudioFrame& frame) {
-        return vizQueue_.try_dequeue(frame);
+    AudioSpans peek(AudioConsumer consumer, u32 maxFrames) {
+        auto& c = cursors_[index(consumer)];
+        u64 w = writePos_.load(std::memory_order_acquire);
+        u64 r = c.readPos.load(std::memory_order_relaxed);
+
+        u64 limit = capacity_ - guard_;
+        if (w - r > limit) {
+            u64 skipped = (w - r) - limit;
+            c.dropped.fetch_add(skipped, std::memory_order_relaxed);
+            r += skipped;
+            c.readPos.store(r, std::memory_order_relaxed);
+        }
+
+        u32 avail = static_cast<u32>(std::min<u64>(w - r, maxFrames));
+        if (avail == 0) return {};
+
+        u32 idx = static_cast<u32>(r & mask_);
+        u32 firstPart = std::min(avail, capacity_ - idx);
+        const f32* base = buffer_.get();
+
+        AudioSpans spans;
+        spans.first = {base + static_cast<usize>(idx) * 2, static_cast<usize>(firstPart) * 2};
+        if (firstPart < avail) {
+            spans.second = {base, static_cast<usize>(avail - firstPart) * 2};
+        }
+        return spans;
     }
 
-    /**
-     * Pop a frame from recorder queue.
-     * @param frame Output frame
-     * @return true if frame was popped, false if queue empty
-     */
-    bool popRec(AudioFrame& frame) {
-        return recQueue_.try_dequeue(frame);
+    /** Mark `frames` frames (from the last peek) as read. */
+    void consume(AudioConsumer consumer, u32 frames) {
+        auto& c = cursors_[index(consumer)];
+        c.readPos.store(c.readPos.load(std::memory_order_relaxed) + frames,
+                        std::memory_order_release);
     }
 
     /**
-     * Pop multiple frames from visualizer queue into a flat buffer.
-     * Useful for batch processing in visualizer.
-     * @param buffer Output buffer for interleaved samples
-     * @param maxFrames Maximum frames to pop
-     * @return Number of frames actually popped
+     * Copy up to `maxFrames` interleaved stereo frames into `buffer`.
+     * @return Number of frames copied
      */
-    u32 popVizBatch(float* buffer, u32 maxFrames) {
-        return popBatchInternal(vizQueue_, buffer, maxFrames);
+    u32 pop(AudioConsumer consumer, f32* buffer, u32 maxFrames) {
+        if (!buffer || maxFrames == 0) return 0;
+
+        auto spans = peek(consumer, maxFrames);
+        std::memcpy(buffer, spans.first.data(), spans.first.size_bytes());
+        if (!spans.second.empty()) {
+            std::memcpy(buffer + spans.first.size(), spans.second.data(),
+                        spans.second.size_bytes());
+        }
+
+        u32 frames = spans.frames();
+        consume(consumer, frames);
+        return frames;
     }
 
     /**
-     * Pop multiple frames from recorder queue into a flat buffer.
-     * @param buffer Output buffer for interleaved samples
-     * @param maxFrames Maximum frames to pop
-     * @return Number of frames actually popped
+     * Block until `consumer` has at least `frames` unread frames, or until
+     * wake() is called for it. May also return early on a spurious wakeup,
+     * so callers loop and re-check their own stop condition.
+     * @return Unread frames on return
      */
-    u32 popRecBatch(float* buffer, u32 maxFrames) {
-        return popBatchInternal(recQueue_, buffer, maxFrames);
+    u32 waitForFrames(AudioConsumer consumer, u32 frames) {
+        auto& c = cursors_[index(consumer)];
+        frames = std::min(frames, capacity_ - guard_);
+        u32 seen = c.signal.epoch();
+        u64 r = c.readPos.load(std::memory_order_relaxed);
+        c.wakeAt.store(r + frames, std::memory_order_seq_cst);
+
+        if (!c.interrupted.exchange(false, std::memory_order_acq_rel) &&
+            writePos_.load(std::memory_order_seq_cst) - r < frames) {
+            c.signal.wait(seen);
+        }
+        c.wakeAt.store(NO_WAITER, std::memory_order_relaxed);
+        c.interrupted.store(false, std::memory_order_relaxed);
+        return depth(consumer);
     }
 
-    u32 popAnaBatch(float* buffer, u32 maxFrames) {
-        return popBatchInternal(anaQueue_, buffer, maxFrames);
+    /** Release a consumer blocked in (or about to enter) waitForFrames() */
+    void wake(AudioConsumer consumer) {
+        auto& c = cursors_[index(consumer)];
+        c.interrupted.store(true, std::memory_order_release);
+        c.signal.notify();
+    }
+
+    /**
+     * Jump a consumer to the write head, discarding its backlog without
+     * counting drops. Call from the consumer's thread (or while it is idle),
+     * e.g. when a recording starts so it doesn't pick up stale audio.
+     */
+    void seekToLatest(AudioConsumer consumer) {
+        cursors_[index(consumer)].readPos.store(
+                writePos_.load(std::memory_order_acquire), std::memory_order_release);
     }
 
     // ========================================================================
     // Metrics (thread-safe via atomics)
     // ========================================================================
 
-    /** Get approximate depth of visualizer queue */
-    u32 vizDepth() const {
-        return static_cast<u32>(vizQueue_.size_approx());
+    /** Unread frames for a consumer */
+    u32 depth(AudioConsumer consumer) const {
+        u64 w = writePos_.load(std::memory_order_acquire);
+        u64 r = cursors_[index(consumer)].readPos.load(std::memory_order_acquire);
+        return static_cast<u32>(std::min<u64>(w - r, capacity_));
     }
 
-    /** Get approximate depth of recorder queue */
-    u32 recDepth() const {
-        return static_cast<u32>(recQueue_.size_approx());
+    /** Frames a consumer lost by falling too far behind */
+    u64 dropCount(AudioConsumer consumer) const {
+        return cursors_[index(consumer)].dropped.load(std::memory_order_relaxed);
     }
 
-    /** Get total frames dropped from visualizer queue */
-    u64 vizDropCount() const {
-        return vizDropCount_.load(std::memory_order_relaxed);
+    /** Times the producer woke a consumer blocked in waitForFrames() */
+    u64 wakeupCount(AudioConsumer consumer) const {
+        return cursors_[index(consumer)].wakeups.load(std::memory_order_relaxed);
     }
 
-    /** Get total frames dropped from recorder queue */
-    u64 recDropCount() const {
-        return recDropCount_.load(std::memory_order_relaxed);
+    /** steady_clock time of the most recent push, in nanoseconds */
+    i64 lastPushNs() const {
+        return lastPushNs_.load(std::memory_order_relaxed);
+    }
+
+    static i64 nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
     }
 
     /** Get total frames pushed (for diagnostics) */
@@ -175,88 +269,82 @@ public:
         return totalPushed_.load(std::memory_order_relaxed);
     }
 
+    /** Sample rate of the most recent push */
+    u32 sampleRate() const {
+        return sampleRate_.load(std::memory_order_relaxed);
+    }
+
+    /** Rate to report before anything has been pushed */
+    void setSampleRate(u32 sampleRate) {
+        sampleRate_.store(sampleRate, std::memory_order_relaxed);
+    }
+
+    u32 capacity() const {
+        return capacity_;
+    }
+
     /** Reset all counters */
     void resetCounters() {
-        vizDropCount_.store(0, std::memory_order_relaxed);
-        recDropCount_.store(0, std::memory_order_relaxed);
+        for (auto& c : cursors_) {
+            c.dropped.store(0, std::memory_order_relaxed);
+            c.wakeups.store(0, std::memory_order_relaxed);
+        }
         totalPushed_.store(0, std::memory_order_relaxed);
     }
 
-    /** Clear both queues */
+    /** Discard the backlog of every consumer */
     void clear() {
-        AudioFrame frame;
-        while (vizQueue_.try_dequeue(frame)) {}
-        while (recQueue_.try_dequeue(frame)) {}
-        while (anaQueue_.try_dequeue(frame)) {}
+        for (usize i = 0; i < AUDIO_CONSUMER_COUNT; ++i) {
+            seekToLatest(static_cast<AudioConsumer>(i));
+        }
     }
 
 private:
-    using Queue = moodycamel::ReaderWriterQueue<AudioFrame>;
-
-    Queue vizQueue_;
-    Queue recQueue_;
-    Queue anaQueue_;
-
-    std::atomic<u64> vizDropCount_;
-    std::atomic<u64> recDropCount_;
-    std::atomic<u64> anaDropCount_;
-    std::atomic<u64> totalPushed_;
-
-    bool pushInternal(Queue& queue, std::atomic<u64>& dropCount,
-                      const float* data, u32 frames, u32 channels, u32 sampleRate) {
-        if (!data || frames == 0) return false;
-
-        totalPushed_.fetch_add(frames, std::memory_order_relaxed);
+    static constexpr u64 NO_WAITER = std::numeric_limits<u64>::max();
+
+    struct alignas(64) Cursor {
+        std::atomic<u64> readPos{0};
+        std::atomic<u64> dropped{0};
+        // Write position a blocked reader is waiting for, or NO_WAITER
+        std::atomic<u64> wakeAt{NO_WAITER};
+        std::atomic<u64> wakeups{0};
+        std::atomic<bool> interrupted{false};
+        WakeSignal signal;
+    };
+
+    static constexpr usize index(AudioConsumer consumer) {
+        return static_cast<usize>(consumer);
+    }
 
-        // Convert to stereo frames and push in chunks
-        u32 processed = 0;
-        while (processed < frames) {
-            AudioFrame frame;
-            frame.sampleRate = sampleRate;
-            frame.channels = 2;
-
-            u32 remaining = frames - processed;
-            u32 chunkSize = std::min(remaining, AUDIO_FRAME_SAMPLES);
-            frame.sampleCount = chunkSize;
-
-            // Convert to stereo interleaved
-            for (u32 i = 0; i < chunkSize; ++i) {
-                u32 srcIdx = (processed + i) * channels;
-                if (channels >= 2) {
-                    frame.samples[i * 2] = data[srcIdx];
-                    frame.samples[i * 2 + 1] = data[srcIdx + 1];
-                } else if (channels == 1) {
-                    // Mono to stereo
-                    frame.samples[i * 2] = data[srcIdx];
-                    frame.samples[i * 2 + 1] = data[srcIdx];
-                }
+    static void writeStereo(f32* dst, const f32* src, u32 frames, u32 channels) {
+        if (channels == 2) {
+            std::memcpy(dst, src, static_cast<usize>(frames) * 2 * sizeof(f32));
+        } else if (channels == 1) {
+            // Mono to stereo
+            for (u32 i = 0; i < frames; ++i) {
+                dst[i * 2] = src[i];
+                dst[i * 2 + 1] = src[i];
             }
-
-            if (!queue.try_enqueue(frame)) {
-                dropCount.fetch_add(chunkSize, std::memory_order_relaxed);
-                return false;
+        } else {
+            // Keep front left/right of multichannel sources
+            for (u32 i = 0; i < frames; ++i) {
+                dst[i * 2] = src[i * channels];
+                dst[i * 2 + 1] = src[i * channels + 1];
             }
-
-            processed += chunkSize;
         }
-
-        return true;
     }
 
-    u32 popBatchInternal(Queue& queue, float* buffer, u32 maxFrames) {
-        if (!buffer || maxFrames == 0) return 0;
-
-        u32 popped = 0;
-        AudioFrame frame;
+    const u32 capacity_;
+    const u32 mask_;
+    const u32 guard_;
+    std::unique_ptr<f32[]> buffer_;
 
-        while (popped < maxFrames && queue.try_dequeue(frame)) {
-            u32 toCopy = std::min(frame.sampleCount, maxFrames - popped);
-            std::memcpy(buffer + popped * 2, frame.samples, toCopy * 2 * sizeof(float));
-            popped += toCopy;
-        }
+    alignas(64) std::atomic<u64> writePos_{0};
+    std::atomic<u64> totalPushed_{0};
+    std::atomic<i64> lastPushNs_{0};
+    std::atomic<u32> sampleRate_{48000};
 
-        return popped;
-    }
+    std::array<Cursor, AUDIO_CONSUMER_COUNT> cursors_{};
 };
 
 } // namespace vc
@@ -0,0 +1,256 @@
+#include "audio/BeatTracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vc {
+
+namespace {
+// log(1 + C|X|): compresses dynamics so quiet hats register next to kicks
+constexpr f32 LOG_COMPRESSION = 100.0f;
+// Threshold = running mean + k * running deviation + floor, time constant 1 s
+constexpr f32 THRESHOLD_SECONDS = 1.0f;
+constexpr f32 THRESHOLD_DEVIATIONS = 1.5f;
+constexpr f32 THRESHOLD_FLOOR = 0.02f;
+// No second onset in a band within this window
+constexpr f32 REFRACTORY_SECONDS = 0.08f;
+
+// Tempo: autocorrelate the last few seconds of novelty ten times a second
+constexpr f32 ENVELOPE_SECONDS = 6.0f;
+constexpr u32 MAX_ENVELOPE = 1024;
+constexpr f32 TEMPO_UPDATE_SECONDS = 0.1f;
+// Log-Gaussian tempo prior resolves octave ambiguity toward ~120 BPM
+constexpr f32 PRIOR_BPM = 120.0f;
+constexpr f32 PRIOR_OCTAVES = 1.0f;
+// Half the best lag wins with at least this share of its peak
+constexpr f32 OCTAVE_RATIO = 0.9f;
+// Estimates within this ratio refine the tempo; others must repeat first
+constexpr f32 TEMPO_TOLERANCE = 0.04f;
+constexpr u32 TEMPO_SWITCH_VOTES = 3;
+constexpr f32 TEMPO_SMOOTHING = 0.25f;
+
+// Beat oscillator: onsets within this phase error pull it into line
+constexpr f32 PHASE_CAPTURE = 0.3f;
+constexpr f32 PHASE_GAIN = 0.3f;
+constexpr f32 MIN_CONFIDENCE = 0.1f;
+// Confidence of a seeded tempo until the first autocorrelation replaces it
+constexpr f32 SEED_CONFIDENCE = 0.5f;
+} // namespace
+
+bool BeatTracker::Detector::update(f32 flux, f32 alpha, u32 refractory, f32& strength) {
+    f32 threshold = mean + THRESHOLD_DEVIATIONS * std::sqrt(var) + THRESHOLD_FLOOR;
+    strength = flux / threshold;
+    bool hit = flux > threshold && flux >= previous && sinceOnset >= refractory;
+    sinceOnset = hit ? 0 : std::min(sinceOnset + 1, refractory);
+    previous = flux;
+
+    f32 delta = flux - mean;
+    mean += alpha * delta;
+    var = (1.0f - alpha) * (var + alpha * delta * delta);
+    return hit;
+}
+
+void BeatTracker::configure(f32 hopRate, u32 bins, f32 binHz) {
+    hopRate_ = hopRate;
+    bins_ = bins;
+    for (u32 i = 0; i <= ONSET_BANDS; ++i) {
+        u32 bin = static_cast<u32>(std::ceil(ONSET_BAND_EDGES_HZ[i] / binHz));
+        bandBins_[i] = std::clamp<u32>(bin, 1, bins);
+    }
+
+    alpha_ = 1.0f - std::exp(-1.0f / (hopRate * THRESHOLD_SECONDS));
+    refractory_ = std::max<u32>(1, static_cast<u32>(REFRACTORY_SECONDS * hopRate));
+
+    u32 envelopeSize = std::clamp<u32>(static_cast<u32>(ENVELOPE_SECONDS * hopRate),
+                                       64,
+                                       MAX_ENVELOPE);
+    lagMin_ = std::max<u32>(2, static_cast<u32>(std::floor(hopRate * 60.0f / MAX_BPM)));
+    lagMax_ = std::min<u32>(envelopeSize / 2,
+                            static_cast<u32>(std::ceil(hopRate * 60.0f / MIN_BPM)));
+    tempoInterval_ = std::max<u32>(1, static_cast<u32>(TEMPO_UPDATE_SECONDS * hopRate));
+
+    previousLog_.assign(bins, 0.0f);
+    envelope_.assign(envelopeSize, 0.0f);
+    linear_.assign(envelopeSize, 0.0f);
+    correlations_.assign(lagMax_ + 2, 0.0f);
+    scores_.assign(lagMax_ + 1, 0.0f);
+    reset();
+}
+
+void BeatTracker::reset() {
+    std::fill(previousLog_.begin(), previousLog_.end(), 0.0f);
+    std::fill(envelope_.begin(), envelope_.end(), 0.0f);
+    bandDetectors_ = {};
+    fullDetector_ = {};
+    envelopeHead_ = envelopeCount_ = 0;
+    sinceTempo_ = 0;
+    candidateBpm_ = 0.0f;
+    candidateVotes_ = 0;
+    onset_ = beat_ = false;
+    bandOnsets_ = {};
+    onsetStrength_ = bpm_ = phase_ = confidence_ = 0.0f;
+}
+
+void BeatTracker::seed(f32 bpm, f32 phase) {
+    if (bpm < MIN_BPM || bpm > MAX_BPM)
+        return;
+    bpm_ = bpm;
+    phase_ = phase - std::floor(phase);
+    confidence_ = std::max(confidence_, SEED_CONFIDENCE);
+    candidateVotes_ = 0;
+}
+
+void BeatTracker::process(std::span<const f32> magnitudes) {
+    onset_ = beat_ = false;
+    if (bins_ == 0 || magnitudes.size() < bins_)
+        return;
+
+    // Per-band half-wave rectified flux of the log spectrum
+    f32 total = 0.0f;
+    for (u32 band = 0; band < ONSET_BANDS; ++band) {
+        const u32 lo = bandBins_[band];
+        const u32 hi = bandBins_[band + 1];
+        f32 flux = 0.0f;
+        for (u32 k = lo; k < hi; ++k) {
+            f32 level = std::log1p(LOG_COMPRESSION * magnitudes[k]);
+            flux += std::max(0.0f, level - previousLog_[k]);
+            previousLog_[k] = level;
+        }
+        total += flux;
+
+        f32 strength = 0.0f;
+        bandOnsets_[band] =
+                hi > lo && bandDetectors_[band].update(flux / static_cast<f32>(hi - lo),
+                                                       alpha_,
+                                                       refractory_,
+                                                       strength);
+    }
+
+    const u32 span = bandBins_[ONSET_BANDS] - bandBins_[0];
+    const f32 fullFlux = span ? total / static_cast<f32>(span) : 0.0f;
+    const f32 baseline = fullDetector_.mean;
+    onset_ = fullDetector_.update(fullFlux, alpha_, refractory_, onsetStrength_);
+
+    // Novelty: flux above its running mean
+    envelope_[envelopeHead_] = std::max(0.0f, fullFlux - baseline);
+    envelopeHead_ = (envelopeHead_ + 1) % static_cast<u32>(envelope_.size());
+    envelopeCount_ = std::min<u32>(envelopeCount_ + 1, static_cast<u32>(envelope_.size()));
+
+    if (++sinceTempo_ >= tempoInterval_) {
+        sinceTempo_ = 0;
+        updateTempo();
+    }
+
+    if (bpm_ <= 0.0f)
+        return;
+
+    phase_ += bpm_ / (60.0f * hopRate_);
+    if (onset_ && confidence_ >= MIN_CONFIDENCE) {
+        // An onset is where a beat should be: nudge the oscillator there
+        f32 error = phase_ - std::round(phase_);
+        if (std::abs(error) < PHASE_CAPTURE)
+            phase_ -= error * PHASE_GAIN;
+    }
+    if (phase_ >= 1.0f) {
+        phase_ -= std::floor(phase_);
+        beat_ = true;
+    } else if (phase_ < 0.0f) {
+        phase_ += 1.0f;
+    }
+}
+
+void BeatTracker::updateTempo() {
+    const u32 n = envelopeCount_;
+    if (n < lagMax_ * 2)
+        return;
+
+    // Oldest-first copy with the mean removed
+    const u32 size = static_cast<u32>(envelope_.size());
+    const u32 start = (envelopeHead_ + size - n) % size;
+    f32 mean = 0.0f;
+    for (u32 i = 0; i < n; ++i) {
+        linear_[i] = envelope_[(start + i) % size];
+        mean += linear_[i];
+    }
+    mean /= static_cast<f32>(n);
+    f32 energy = 0.0f;
+    for (u32 i = 0; i < n; ++i) {
+        linear_[i] -= mean;
+        energy += linear_[i] * linear_[i];
+    }
+    if (energy <= 1e-9f)
+        return;
+
+    auto correlation = [&](u32 lag) {
+        f32 sum = 0.0f;
+        for (u32 i = lag; i < n; ++i)
+            sum += linear_[i] * linear_[i - lag];
+        return sum / static_cast<f32>(n - lag);
+    };
+    auto prior = [&](f32 lag) {
+        f32 octaves = std::log2(hopRate_ * 60.0f / lag / PRIOR_BPM) / PRIOR_OCTAVES;
+        return std::exp(-0.5f * octaves * octaves);
+    };
+
+    for (u32 lag = lagMin_ - 1; lag <= lagMax_ + 1; ++lag)
+        correlations_[lag] = correlation(lag);
+
+    // A beat period that falls between two lags splits its peak across
+    // both, while twice the period may land on one lag and keep it whole:
+    // score each lag with its neighbours so both peaks weigh the same
+    auto peak = [&](u32 lag) {
+        return std::max(0.0f, correlations_[lag - 1]) + std::max(0.0f, correlations_[lag]) +
+               std::max(0.0f, correlations_[lag + 1]);
+    };
+
+    u32 bestLag = 0;
+    for (u32 lag = lagMin_; lag <= lagMax_; ++lag) {
+        scores_[lag] = peak(lag) * prior(static_cast<f32>(lag));
+        if (bestLag == 0 || scores_[lag] > scores_[bestLag])
+            bestLag = lag;
+    }
+    if (bestLag == 0 || scores_[bestLag] <= 0.0f)
+        return;
+
+    // Beats every period correlate as well at two periods, where the prior
+    // favours e.g. 87 over 174 BPM: take half the lag if it holds up
+    const u32 half = peak(bestLag / 2) >= peak((bestLag + 1) / 2) ? bestLag / 2 : (bestLag + 1) / 2;
+    if (half >= lagMin_ && peak(half) >= OCTAVE_RATIO * peak(bestLag))
+        bestLag = half;
+    const f32 bestCorrelation = correlations_[bestLag];
+
+    // Parabolic interpolation around the peak for sub-hop resolution
+    f32 lag = static_cast<f32>(bestLag);
+    if (bestLag > lagMin_ && bestLag < lagMax_) {
+        f32 before = scores_[bestLag - 1];
+        f32 after = scores_[bestLag + 1];
+        f32 curvature = before - 2.0f * scores_[bestLag] + after;
+        if (curvature < 0.0f)
+            lag += 0.5f * (before - after) / curvature;
+    }
+
+    const f32 estimate = hopRate_ * 60.0f / lag;
+    confidence_ = std::clamp(bestCorrelation / (energy / static_cast<f32>(n)), 0.0f, 1.0f);
+
+    if (bpm_ <= 0.0f) {
+        bpm_ = estimate;
+    } else if (std::abs(estimate - bpm_) < bpm_ * TEMPO_TOLERANCE) {
+        bpm_ += (estimate - bpm_) * TEMPO_SMOOTHING;
+        candidateVotes_ = 0;
+    } else {
+        // A different tempo has to win several updates in a row
+        if (candidateVotes_ > 0 &&
+            std::abs(estimate - candidateBpm_) < candidateBpm_ * TEMPO_TOLERANCE) {
+            ++candidateVotes_;
+        } else {
+            candidateBpm_ = estimate;
+            candidateVotes_ = 1;
+        }
+        if (candidateVotes_ >= TEMPO_SWITCH_VOTES) {
+            bpm_ = estimate;
+            candidateVotes_ = 0;
+        }
+    }
+}
+
+} // namespace vc
@@ -0,0 +1,93 @@
+#pragma once
+// BeatTracker.hpp - Spectral-flux onsets, realtime tempo and beat phase
+// Runs once per analyzer hop on the raw magnitude spectrum:
+//
+//   magnitudes -> log compress -> per-band half-wave flux -> adaptive
+//   threshold -> band / full onsets
+//   full flux -> novelty envelope -> autocorrelation -> BPM
+//   BPM + onsets -> phase-locked beat oscillator -> beatPhase, beats
+//
+// Everything is sized in configure(); process() never allocates.
+
+#include <array>
+#include <span>
+#include <vector>
+#include "util/Types.hpp"
+
+namespace vc {
+
+// Kick, bass/snare body, mids, hats
+inline constexpr u32 ONSET_BANDS = 4;
+inline constexpr std::array<f32, ONSET_BANDS + 1> ONSET_BAND_EDGES_HZ{
+        30.0f, 150.0f, 500.0f, 2500.0f, 16000.0f};
+
+inline constexpr f32 MIN_BPM = 60.0f;
+inline constexpr f32 MAX_BPM = 200.0f;
+
+class BeatTracker {
+public:
+    // `hopRate` = analyses per second; `bins` spaced `binHz` apart
+    void configure(f32 hopRate, u32 bins, f32 binHz);
+    void reset();
+    // Start from a known tempo and phase (e.g. a cached track timeline)
+    // instead of waiting seconds for the autocorrelation to lock
+    void seed(f32 bpm, f32 phase);
+
+    // One hop of raw (unsmoothed) magnitudes, `bins` entries
+    void process(std::span<const f32> magnitudes);
+
+    // Results of the latest process()
+    bool onset() const { return onset_; }
+    const std::array<bool, ONSET_BANDS>& bandOnsets() const { return bandOnsets_; }
+    f32 onsetStrength() const { return onsetStrength_; } // flux / threshold
+    bool beat() const { return beat_; }                  // phase wrapped
+    f32 bpm() const { return bpm_; }                     // 0 until locked
+    f32 beatPhase() const { return phase_; }             // [0, 1), 0 = on beat
+    f32 tempoConfidence() const { return confidence_; }  // 0..1
+
+private:
+    // Adaptive threshold: running mean + deviation of one flux signal
+    struct Detector {
+        f32 mean{0.0f};
+        f32 var{0.0f};
+        f32 previous{0.0f};
+        u32 sinceOnset{0};
+        bool update(f32 flux, f32 alpha, u32 refractory, f32& strength);
+    };
+
+    void updateTempo();
+
+    f32 hopRate_{0.0f};
+    u32 bins_{0};
+    std::array<u32, ONSET_BANDS + 1> bandBins_{};
+
+    std::vector<f32> previousLog_;
+    std::array<Detector, ONSET_BANDS> bandDetectors_{};
+    Detector fullDetector_;
+    f32 alpha_{0.0f};
+    u32 refractory_{1};
+
+    // Novelty envelope ring and autocorrelation scratch
+    std::vector<f32> envelope_;
+    std::vector<f32> linear_;
+    std::vector<f32> correlations_; // indexed by lag
+    std::vector<f32> scores_;       // indexed by lag
+    u32 envelopeHead_{0};
+    u32 envelopeCount_{0};
+    u32 lagMin_{1};
+    u32 lagMax_{1};
+    u32 tempoInterval_{1};
+    u32 sinceTempo_{0};
+    f32 candidateBpm_{0.0f};
+    u32 candidateVotes_{0};
+
+    bool onset_{false};
+    std::array<bool, ONSET_BANDS> bandOnsets_{};
+    f32 onsetStrength_{0.0f};
+    bool beat_{false};
+    f32 bpm_{0.0f};
+    f32 phase_{0.0f};
+    f32 confidence_{0.0f};
+};
+
+} // namespace vc
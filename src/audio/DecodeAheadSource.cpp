@@ -0,0 +1,515 @@
+#include "DecodeAheadSource.hpp"
+#include "GainStage.hpp"
+#include "core/Logger.hpp"
+
+#include <QAudioDevice>
+#include <QAudioSink>
+#include <QIODevice>
+#include <QMediaDevices>
+#include <algorithm>
+
+namespace vc {
+
+namespace {
+// Decoded audio kept ahead of the device
+constexpr u32 RING_SECONDS = 2;
+// Frames decoded per step; small enough to keep commands responsive
+constexpr u32 DECODE_CHUNK = 2048;
+// Open the next track this long before the current one runs out
+constexpr u64 LOOKAHEAD_SECONDS = 10;
+// Seek-index packets scanned per idle step
+constexpr u32 INDEX_PACKETS = 256;
+
+QAudioDevice findOutputDevice(const std::string& name) {
+    if (name.empty() || name == "default")
+        return QMediaDevices::defaultAudioOutput();
+    const QString wanted = QString::fromStdString(name);
+    for (const auto& device : QMediaDevices::audioOutputs()) {
+        if (device.description() == wanted || QString::fromUtf8(device.id()) == wanted)
+            return device;
+    }
+    LOG_WARN("Audio device '{}' not found, using the default output", name);
+    return QMediaDevices::defaultAudioOutput();
+}
+
+QAudioFormat stereoFormat(int rate, QAudioFormat::SampleFormat sampleFormat) {
+    QAudioFormat format;
+    format.setSampleRate(rate);
+    format.setChannelCount(2);
+    format.setSampleFormat(sampleFormat);
+    return format;
+}
+
+// Float at `rate` if possible, else Int16, else whatever rate the device prefers
+QAudioFormat chooseFormat(const QAudioDevice& device, u32 rate) {
+    for (int candidate : {static_cast<int>(rate), device.preferredFormat().sampleRate()}) {
+        for (auto sampleFormat : {QAudioFormat::Float, QAudioFormat::Int16}) {
+            auto format = stereoFormat(candidate, sampleFormat);
+            if (device.isFormatSupported(format))
+                return format;
+        }
+    }
+    return stereoFormat(static_cast<int>(rate), QAudioFormat::Float);
+}
+} // namespace
+
+// Pull-mode QIODevice the sink reads from. Lives on the output thread.
+class PcmDevice final : public QIODevice {
+public:
+    PcmDevice(DecodeAheadSource& source, const QAudioFormat& format)
+        : source_(source), format_(format), bytesPerFrame_(format.bytesPerFrame()) {}
+
+    bool openSink(const QAudioDevice& device, u32 bufferFrames) {
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+        sink_ = std::make_unique<QAudioSink>(device, format_);
+        sink_->setBufferSize(static_cast<qsizetype>(bufferFrames) * bytesPerFrame_);
+        QObject::connect(sink_.get(), &QAudioSink::stateChanged, this, [this](QAudio::State) {
+            const auto error = sink_->error();
+            if (error != QAudio::NoError && error != QAudio::UnderrunError) {
+                emit source_.errorOccurred(
+                        QStringLiteral("Audio output error %1").arg(static_cast<int>(error)));
+            }
+        });
+        sink_->start(this);
+        if (sink_->error() != QAudio::NoError) {
+            sink_.reset();
+            return false;
+        }
+        sink_->suspend();
+        return true;
+    }
+
+    void closeSink() {
+        if (sink_)
+            sink_->stop();
+        sink_.reset();
+        close();
+    }
+
+    void setPlaying(bool playing) {
+        if (!sink_)
+            return;
+        if (playing)
+            sink_->resume();
+        else
+            sink_->suspend();
+    }
+
+    void setVolume(f32 volume) {
+        if (sink_)
+            sink_->setVolume(volume);
+    }
+
+    // Apply flushes and markers without consuming audio (used while paused)
+    void sync() {
+        std::optional<PcmMarker> marker;
+        do {
+            source_.ring_->read(nullptr, 0, marker);
+            if (marker)
+                handle(*marker);
+        } while (marker);
+        source_.decoderWake_.notify();
+    }
+
+    bool isSequential() const override {
+        return true;
+    }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override {
+        const u32 frames = static_cast<u32>(maxSize / bytesPerFrame_);
+        if (frames == 0)
+            return 0;
+        if (pcm_.size() < static_cast<usize>(frames) * 2)
+            pcm_.resize(static_cast<usize>(frames) * 2);
+
+        if (auto gain = source_.trackGain(track_))
+            targetGain_ = *gain;
+
+        u32 produced = 0;
+        while (produced < frames) {
+            std::optional<PcmMarker> marker;
+            f32* segment = pcm_.data() + static_cast<usize>(produced) * 2;
+            const u32 n = source_.ring_->read(segment, frames - produced, marker);
+            if (marker) {
+                handle(*marker);
+                continue;
+            }
+            if (n == 0)
+                break;
+            applyGain(segment, n, 2, gain_, targetGain_);
+            gain_ = targetGain_;
+            produced += n;
+        }
+        source_.decoderWake_.notify();
+
+        if (produced > 0) {
+            source_.queue_.push(pcm_.data(), produced, 2, source_.sampleRate_);
+            trackFrame_ += produced;
+        }
+        if (produced < frames) {
+            std::fill(pcm_.begin() + static_cast<std::ptrdiff_t>(produced) * 2,
+                      pcm_.begin() + static_cast<std::ptrdiff_t>(frames) * 2,
+                      0.0f);
+            if (!ended_)
+                source_.underruns_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        const usize samples = static_cast<usize>(frames) * 2;
+        if (format_.sampleFormat() == QAudioFormat::Float) {
+            std::memcpy(data, pcm_.data(), samples * sizeof(f32));
+        } else {
+            auto* out = reinterpret_cast<i16*>(data);
+            for (usize i = 0; i < samples; ++i)
+                out[i] = static_cast<i16>(std::clamp(pcm_[i], -1.0f, 1.0f) * 32767.0f);
+        }
+
+        // Audible position: what we've handed over minus what the sink holds
+        const u64 queued = sink_ ? static_cast<u64>(sink_->bufferSize() - sink_->bytesFree()) /
+                                           static_cast<u64>(bytesPerFrame_)
+                                 : 0;
+        source_.positionFrames_.store(trackFrame_ > queued ? trackFrame_ - queued : 0,
+                                      std::memory_order_relaxed);
+        return static_cast<qint64>(frames) * bytesPerFrame_;
+    }
+
+    qint64 writeData(const char*, qint64) override {
+        return -1;
+    }
+
+private:
+    void handle(const PcmMarker& marker) {
+        ended_ = marker.kind == PcmMarker::Kind::End;
+        if (!ended_)
+            trackFrame_ = marker.trackFrame;
+        if (marker.kind == PcmMarker::Kind::Open || marker.kind == PcmMarker::Kind::Next) {
+            // Different audio from here on: jump to its gain, no ramp
+            track_ = marker.track;
+            gain_ = targetGain_ = source_.trackGain(track_).value_or(1.0f);
+        }
+        source_.onMarker(marker);
+    }
+
+    DecodeAheadSource& source_;
+    QAudioFormat format_;
+    int bytesPerFrame_;
+    std::unique_ptr<QAudioSink> sink_;
+    std::vector<f32> pcm_;
+    u64 trackFrame_{0};
+    bool ended_{true};
+    u64 track_{0};
+    f32 gain_{1.0f};       // applied at the end of the last buffer
+    f32 targetGain_{1.0f}; // ramped to over the next one
+};
+
+DecodeAheadSource::DecodeAheadSource(AudioQueue& queue) : QObject(nullptr), queue_(queue) {}
+
+DecodeAheadSource::~DecodeAheadSource() {
+    shutdown();
+}
+
+Result<void> DecodeAheadSource::start(u32 sampleRate, const std::string& device, u32 bufferFrames) {
+    const QAudioDevice output = findOutputDevice(device);
+    if (output.isNull())
+        return Result<void>::err("No audio output device available");
+
+    const QAudioFormat format = chooseFormat(output, sampleRate);
+    if (static_cast<u32>(format.sampleRate()) != sampleRate) {
+        LOG_WARN("{} does not support {} Hz, playing at {} Hz",
+                 output.description().toStdString(),
+                 sampleRate,
+                 format.sampleRate());
+    }
+    sampleRate_ = static_cast<u32>(format.sampleRate());
+    ring_ = std::make_unique<PcmRing>(sampleRate_ * RING_SECONDS);
+    scratch_.resize(static_cast<usize>(DECODE_CHUNK) * PcmRing::CHANNELS);
+
+    device_ = new PcmDevice(*this, format);
+    device_->moveToThread(&outputThread_);
+    outputThread_.setObjectName(QStringLiteral("AudioOutput"));
+    outputThread_.start(QThread::TimeCriticalPriority);
+
+    bool opened = false;
+    QMetaObject::invokeMethod(
+            device_,
+            [&] { opened = device_->openSink(output, bufferFrames); },
+            Qt::BlockingQueuedConnection);
+    if (!opened) {
+        shutdown();
+        return Result<void>::err("Failed to open audio output " +
+                                 output.description().toStdString());
+    }
+
+    decoderThread_ = std::jthread([this](std::stop_token stop) { decoderWorker(stop); });
+    LOG_INFO("Audio output: {} ({} Hz, {}, {} frame buffer)",
+             output.description().toStdString(),
+             sampleRate_,
+             format.sampleFormat() == QAudioFormat::Float ? "float" : "s16",
+             bufferFrames);
+    return Result<void>::ok();
+}
+
+void DecodeAheadSource::shutdown() {
+    if (decoderThread_.joinable()) {
+        decoderThread_.request_stop();
+        decoderWake_.notify();
+        decoderThread_.join();
+    }
+    if (device_) {
+        if (outputThread_.isRunning()) {
+            QMetaObject::invokeMethod(
+                    device_, [this] { device_->closeSink(); }, Qt::BlockingQueuedConnection);
+            outputThread_.quit();
+            outputThread_.wait();
+        }
+        delete device_;
+        device_ = nullptr;
+    }
+    current_.reset();
+    next_.reset();
+}
+
+void DecodeAheadSource::open(const std::string& url, u64 track) {
+    post({Command::Kind::Open, url, track});
+}
+
+void DecodeAheadSource::setNext(const std::string& url, u64 track) {
+    post({Command::Kind::SetNext, url, track});
+}
+
+void DecodeAheadSource::seek(Duration position) {
+    const u64 frame = static_cast<u64>(std::max<i64>(0, position.count())) * sampleRate_ / 1000;
+    // Show the target right away; the device confirms it when it gets there
+    positionFrames_.store(frame, std::memory_order_relaxed);
+    post({Command::Kind::Seek, {}, currentTrack(), frame});
+}
+
+void DecodeAheadSource::play() {
+    playing_.store(true, std::memory_order_relaxed);
+    if (device_)
+        QMetaObject::invokeMethod(device_, [this] { device_->setPlaying(true); });
+}
+
+void DecodeAheadSource::pause() {
+    playing_.store(false, std::memory_order_relaxed);
+    if (device_)
+        QMetaObject::invokeMethod(device_, [this] { device_->setPlaying(false); });
+}
+
+void DecodeAheadSource::setVolume(f32 volume) {
+    if (device_)
+        QMetaObject::invokeMethod(device_, [this, volume] { device_->setVolume(volume); });
+}
+
+void DecodeAheadSource::setTrackGain(u64 track, f32 gain) {
+    std::lock_guard lock(gainMutex_);
+    for (auto& [id, value] : gains_) {
+        if (id == track) {
+            value = gain;
+            return;
+        }
+    }
+    gains_[nextGainSlot_] = {track, gain};
+    nextGainSlot_ = (nextGainSlot_ + 1) % gains_.size();
+}
+
+std::optional<f32> DecodeAheadSource::trackGain(u64 track) {
+    std::unique_lock lock(gainMutex_, std::try_to_lock);
+    if (!lock || track == 0)
+        return std::nullopt;
+    for (const auto& [id, value] : gains_) {
+        if (id == track)
+            return value;
+    }
+    return std::nullopt;
+}
+
+Duration DecodeAheadSource::position() const {
+    return Duration(static_cast<i64>(positionFrames_.load(std::memory_order_relaxed) * 1000 /
+                                     sampleRate_));
+}
+
+Duration DecodeAheadSource::duration() const {
+    return Duration(static_cast<i64>(trackFrames_.load(std::memory_order_relaxed) * 1000 /
+                                     sampleRate_));
+}
+
+void DecodeAheadSource::post(Command command) {
+    {
+        std::lock_guard lock(commandMutex_);
+        commands_.push_back(std::move(command));
+    }
+    decoderWake_.notify();
+}
+
+void DecodeAheadSource::decoderWorker(std::stop_token stop) {
+    while (!stop.stop_requested()) {
+        // Commands, device reads and shutdown all ring the same doorbell
+        const u32 seen = decoderWake_.epoch();
+        runCommands();
+        if (!decodeStep() && !stop.stop_requested())
+            decoderWake_.wait(seen);
+    }
+}
+
+void DecodeAheadSource::runCommands() {
+    std::vector<Command> commands;
+    {
+        std::lock_guard lock(commandMutex_);
+        commands.swap(commands_);
+    }
+    if (commands.empty())
+        return;
+
+    bool flushed = false;
+    for (auto& command : commands) {
+        switch (command.kind) {
+        case Command::Kind::Open: {
+            std::unique_ptr<AudioDecoder> decoder;
+            if (next_ && command.url == nextUrl_) {
+                decoder = std::move(next_); // already opened by the look-ahead
+            } else {
+                decoder = std::make_unique<AudioDecoder>();
+                if (auto result = decoder->open(command.url, sampleRate_, 2); !result) {
+                    LOG_ERROR("Playback error: {}", result.error().message);
+                    emit errorOccurred(QString::fromStdString(result.error().message));
+                    decoder.reset();
+                }
+            }
+            ring_->flush();
+            flushed = true;
+            current_ = std::move(decoder);
+            currentUrl_ = command.url;
+            currentTrack_ = command.track;
+            currentEnded_ = !current_;
+            previousUrl_.clear();
+            if (current_)
+                writeMarker({PcmMarker::Kind::Open, command.track, 0, current_->totalFrames()});
+            break;
+        }
+        case Command::Kind::SetNext:
+            if (command.url != nextUrl_) {
+                next_.reset();
+                nextUrl_ = command.url;
+                nextFailed_ = false;
+            }
+            nextTrack_ = command.track;
+            break;
+        case Command::Kind::Seek: {
+            // The device may still be playing the track we already decoded
+            // past; go back to it and keep the newer one as next
+            if (command.track == previousTrack_ && !previousUrl_.empty() &&
+                command.track != currentTrack_) {
+                auto decoder = std::make_unique<AudioDecoder>();
+                if (!decoder->open(previousUrl_, sampleRate_, 2))
+                    break;
+                next_.reset();
+                nextUrl_ = currentUrl_;
+                nextTrack_ = currentTrack_;
+                nextFailed_ = false;
+                current_ = std::move(decoder);
+                currentUrl_ = previousUrl_;
+                currentTrack_ = previousTrack_;
+                previousUrl_.clear();
+            }
+            if (!current_ || command.track != currentTrack_)
+                break;
+            if (auto result = current_->seek(command.frame); !result) {
+                LOG_WARN("Seek failed: {}", result.error().message);
+                break;
+            }
+            ring_->flush();
+            flushed = true;
+            currentEnded_ = false;
+            writeMarker({PcmMarker::Kind::Seek,
+                         currentTrack_,
+                         command.frame,
+                         current_->totalFrames()});
+            break;
+        }
+        }
+    }
+
+    // A paused device doesn't read, so have it pick up the flush now
+    if (flushed && device_ && !isPlaying())
+        QMetaObject::invokeMethod(device_, [this] { device_->sync(); });
+}
+
+bool DecodeAheadSource::decodeStep() {
+    if (current_ && !currentEnded_ && ring_->writable() >= DECODE_CHUNK) {
+        const usize frames = current_->read(scratch_.data(), DECODE_CHUNK);
+        if (frames > 0) {
+            ring_->write(scratch_.data(), static_cast<u32>(frames));
+            return true;
+        }
+
+        // Track finished: continue with the next one's first sample
+        prepareNext();
+        if (next_) {
+            previousUrl_ = currentUrl_;
+            previousTrack_ = currentTrack_;
+            current_ = std::move(next_);
+            currentUrl_ = nextUrl_;
+            currentTrack_ = nextTrack_;
+            nextUrl_.clear();
+            writeMarker({PcmMarker::Kind::Next, currentTrack_, 0, current_->totalFrames()});
+        } else {
+            currentEnded_ = true;
+            writeMarker({PcmMarker::Kind::End, currentTrack_});
+        }
+        return true;
+    }
+
+    // Ring is full: spend the slack on look-ahead and the seek index
+    if (current_) {
+        const u64 total = current_->totalFrames();
+        const u64 remaining = total > current_->position() ? total - current_->position() : 0;
+        if ((total == 0 || remaining < LOOKAHEAD_SECONDS * sampleRate_) && prepareNext())
+            return true;
+        if (!current_->indexed()) {
+            current_->indexStep(INDEX_PACKETS);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DecodeAheadSource::prepareNext() {
+    if (next_ || nextUrl_.empty() || nextFailed_)
+        return false;
+
+    auto decoder = std::make_unique<AudioDecoder>();
+    if (auto result = decoder->open(nextUrl_, sampleRate_, 2); !result) {
+        LOG_WARN("Can't preload next track: {}", result.error().message);
+        nextFailed_ = true;
+        return true;
+    }
+    next_ = std::move(decoder);
+    return true;
+}
+
+void DecodeAheadSource::writeMarker(PcmMarker marker) {
+    if (!ring_->mark(marker))
+        LOG_WARN("DecodeAheadSource: marker queue full, dropped a track event");
+}
+
+void DecodeAheadSource::onMarker(const PcmMarker& marker) {
+    playingTrack_.store(marker.track, std::memory_order_relaxed);
+    switch (marker.kind) {
+    case PcmMarker::Kind::Open:
+    case PcmMarker::Kind::Next:
+        trackFrames_.store(marker.trackFrames, std::memory_order_relaxed);
+        positionFrames_.store(0, std::memory_order_relaxed);
+        emit trackStarted(marker.track,
+                          static_cast<qint64>(marker.trackFrames * 1000 / sampleRate_));
+        break;
+    case PcmMarker::Kind::Seek:
+        positionFrames_.store(marker.trackFrame, std::memory_order_relaxed);
+        break;
+    case PcmMarker::Kind::End:
+        emit endOfMedia(marker.track);
+        break;
+    }
+}
+
+} // namespace vc
@@ -0,0 +1,161 @@
+/**
+ * @file DecodeAheadSource.hpp
+ * @brief Playback source that decodes ahead of the audio device with FFmpeg.
+ *
+ * A decoder thread keeps a PcmRing about two seconds ahead of playback and
+ * an output thread hosts a pull-mode QAudioSink reading from it. Every
+ * buffer the device pulls is also pushed into the AudioQueue, so analysis
+ * and recording get the exact samples being played, at one fixed rate, with
+ * no GUI-thread hop.
+ *
+ * setTrackGain() scales a track (loudness normalization) on the output
+ * thread, before the audio is pushed to the AudioQueue, so analysis and
+ * recording see the levels that are heard. Changes mid-track ramp over one
+ * device buffer; a new track starts at its own gain.
+ *
+ * Tracks are identified by caller-chosen ids. setNext() names the track to
+ * continue with: it is opened (probed, decoder ready) shortly before the
+ * current one ends, and its first sample follows the current one's last
+ * in the ring (true gapless, one device, no second player).
+ * trackStarted() reports each transition when the output reaches it.
+ *
+ * @section Threads
+ * - Control methods: any thread (in practice the GUI thread).
+ * - Decoder thread: owns the AudioDecoders; commands arrive via a mailbox.
+ * - Output thread: owns the QAudioSink; signals are emitted from here.
+ *
+ * @section Dependencies
+ * - AudioDecoder (libavformat/libavcodec/libswresample)
+ * - Qt6::Multimedia (QAudioSink)
+ */
+
+#pragma once
+#include "AudioDecoder.hpp"
+#include "AudioQueue.hpp"
+#include "PcmRing.hpp"
+#include "util/Result.hpp"
+#include "util/Types.hpp"
+
+#include <QObject>
+#include <QThread>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vc {
+
+class PcmDevice;
+
+class DecodeAheadSource : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DecodeAheadSource(AudioQueue& queue);
+    ~DecodeAheadSource() override;
+
+    // Opens the output device ("default" or a device description) and
+    // starts both threads. Everything is decoded to stereo at `sampleRate`
+    // unless the device can't take that rate; see sampleRate().
+    Result<void> start(u32 sampleRate, const std::string& device, u32 bufferFrames);
+    void shutdown();
+
+    // Replace whatever is playing with `url` (path or libavformat URL)
+    void open(const std::string& url, u64 track);
+    // Track to continue with gaplessly after the current one; "" clears
+    void setNext(const std::string& url, u64 track);
+    void seek(Duration position);
+
+    void play();
+    void pause();
+    void setVolume(f32 volume);
+    // Linear gain for `track` (1 = as decoded); the last few tracks are kept
+    void setTrackGain(u64 track, f32 gain);
+
+    bool isPlaying() const {
+        return playing_.load(std::memory_order_relaxed);
+    }
+    u32 sampleRate() const {
+        return sampleRate_;
+    }
+    // Track the device is currently playing and its position there
+    u64 currentTrack() const {
+        return playingTrack_.load(std::memory_order_relaxed);
+    }
+    Duration position() const;
+    Duration duration() const;
+    u64 underruns() const {
+        return underruns_.load(std::memory_order_relaxed);
+    }
+
+signals:
+    void trackStarted(quint64 track, qint64 durationMs);
+    void endOfMedia(quint64 track);
+    void errorOccurred(const QString& message);
+
+private:
+    friend class PcmDevice;
+
+    struct Command {
+        enum class Kind { Open, SetNext, Seek };
+        Kind kind;
+        std::string url;
+        u64 track{0};
+        u64 frame{0};
+    };
+
+    void post(Command command);
+    void decoderWorker(std::stop_token stop);
+    void runCommands();
+    bool decodeStep();
+    bool prepareNext();
+    void writeMarker(PcmMarker marker);
+    // Output thread: consume a marker the device reached
+    void onMarker(const PcmMarker& marker);
+    // Output thread: gain set for `track`, nullopt if unknown or contended
+    std::optional<f32> trackGain(u64 track);
+
+    AudioQueue& queue_;
+    u32 sampleRate_{44100};
+    std::unique_ptr<PcmRing> ring_;
+    WakeSignal decoderWake_;
+
+    // Decoder thread
+    std::jthread decoderThread_;
+    std::mutex commandMutex_;
+    std::vector<Command> commands_;
+    std::unique_ptr<AudioDecoder> current_;
+    std::string currentUrl_;
+    u64 currentTrack_{0};
+    bool currentEnded_{true};
+    // Track decoded just before current_, until the device is past it
+    std::string previousUrl_;
+    u64 previousTrack_{0};
+    std::unique_ptr<AudioDecoder> next_;
+    std::string nextUrl_;
+    u64 nextTrack_{0};
+    bool nextFailed_{false};
+    std::vector<f32> scratch_;
+
+    // Track gains: written by the control thread, try-locked by the output
+    // thread so it never waits
+    std::mutex gainMutex_;
+    std::array<std::pair<u64, f32>, 4> gains_{};
+    usize nextGainSlot_{0};
+
+    // Output thread
+    QThread outputThread_;
+    PcmDevice* device_{nullptr};
+
+    // Published by the output thread
+    std::atomic<bool> playing_{false};
+    std::atomic<u64> playingTrack_{0};
+    std::atomic<u64> positionFrames_{0};
+    std::atomic<u64> trackFrames_{0};
+    std::atomic<u64> underruns_{0};
+};
+
+} // namespace vc
@@ -0,0 +1,152 @@
+#include "audio/FftEngine.hpp"
+#include "pffft/pffft.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numbers>
+#include <numeric>
+
+namespace vc {
+
+namespace {
+struct WindowName {
+    FftWindow window;
+    std::string_view name;
+};
+constexpr WindowName WINDOW_NAMES[] = {
+        {FftWindow::Rectangular, "rectangular"},
+        {FftWindow::Hann, "hann"},
+        {FftWindow::Hamming, "hamming"},
+        {FftWindow::Blackman, "blackman"},
+        {FftWindow::BlackmanHarris, "blackman-harris"},
+};
+
+// Generalized cosine window a0 - a1 cos(x) + a2 cos(2x) - a3 cos(3x)
+void cosineWindow(std::vector<f32>& out, f64 a0, f64 a1, f64 a2, f64 a3) {
+    const f64 step = 2.0 * std::numbers::pi / static_cast<f64>(out.size());
+    for (usize i = 0; i < out.size(); ++i) {
+        f64 x = step * static_cast<f64>(i);
+        out[i] = static_cast<f32>(a0 - a1 * std::cos(x) + a2 * std::cos(2 * x) -
+                                  a3 * std::cos(3 * x));
+    }
+}
+} // namespace
+
+std::optional<FftWindow> parseFftWindow(std::string_view name) {
+    for (const auto& entry : WINDOW_NAMES)
+        if (entry.name == name)
+            return entry.window;
+    return std::nullopt;
+}
+
+std::string_view fftWindowName(FftWindow window) {
+    for (const auto& entry : WINDOW_NAMES)
+        if (entry.window == window)
+            return entry.name;
+    return "hann";
+}
+
+FftEngine::~FftEngine() {
+    release();
+}
+
+void FftEngine::release() {
+    if (setup_)
+        pffft_destroy_setup(setup_);
+    for (f32* buffer : {input_, output_, work_})
+        if (buffer)
+            pffft_aligned_free(buffer);
+    setup_ = nullptr;
+    input_ = output_ = work_ = nullptr;
+    size_ = 0;
+}
+
+Result<void> FftEngine::configure(u32 size, FftWindow window) {
+    if (size < MIN_FFT_SIZE || size > MAX_FFT_SIZE || !std::has_single_bit(size)) {
+        return Result<void>::err("FFT size must be a power of two in [" +
+                                 std::to_string(MIN_FFT_SIZE) + ", " +
+                                 std::to_string(MAX_FFT_SIZE) + "], got " +
+                                 std::to_string(size));
+    }
+    if (setup_ && size == size_ && window == window_)
+        return Result<void>::ok();
+
+    release();
+    setup_ = pffft_new_setup(static_cast<int>(size), PFFFT_REAL);
+    const usize bytes = size * sizeof(f32);
+    input_ = static_cast<f32*>(pffft_aligned_malloc(bytes));
+    output_ = static_cast<f32*>(pffft_aligned_malloc(bytes));
+    work_ = static_cast<f32*>(pffft_aligned_malloc(bytes));
+    if (!setup_ || !input_ || !output_ || !work_) {
+        release();
+        return Result<void>::err("Failed to allocate PFFFT setup for size " +
+                                 std::to_string(size));
+    }
+    size_ = size;
+    window_ = window;
+
+    coefficients_.resize(size);
+    switch (window) {
+    case FftWindow::Rectangular:
+        std::fill(coefficients_.begin(), coefficients_.end(), 1.0f);
+        break;
+    case FftWindow::Hann:
+        cosineWindow(coefficients_, 0.5, 0.5, 0.0, 0.0);
+        break;
+    case FftWindow::Hamming:
+        cosineWindow(coefficients_, 0.54, 0.46, 0.0, 0.0);
+        break;
+    case FftWindow::Blackman:
+        cosineWindow(coefficients_, 0.42, 0.5, 0.08, 0.0);
+        break;
+    case FftWindow::BlackmanHarris:
+        cosineWindow(coefficients_, 0.35875, 0.48829, 0.14128, 0.01168);
+        break;
+    }
+    scale_ = 2.0f / std::accumulate(coefficients_.begin(), coefficients_.end(), 0.0f);
+    return Result<void>::ok();
+}
+
+void FftEngine::magnitudes(std::span<const f32> first,
+                           std::span<const f32> second,
+                           std::span<f32> out) {
+    if (!setup_)
+        return;
+
+    // Keep only the newest size_ samples, oldest first
+    if (second.size() >= size_) {
+        first = {};
+        second = second.last(size_);
+    } else if (first.size() + second.size() > size_) {
+        first = first.last(size_ - second.size());
+    }
+    const usize pad = size_ - first.size() - second.size();
+
+    const f32* w = coefficients_.data();
+    f32* in = input_;
+    std::fill_n(in, pad, 0.0f);
+    in += pad;
+    w += pad;
+    for (usize i = 0; i < first.size(); ++i)
+        in[i] = first[i] * w[i];
+    in += first.size();
+    w += first.size();
+    for (usize i = 0; i < second.size(); ++i)
+        in[i] = second[i] * w[i];
+
+    pffft_transform_ordered(setup_, input_, output_, work_, PFFFT_FORWARD);
+
+    // Ordered real output: [DC, Nyquist, re1, im1, re2, im2, ...]
+    const usize bins = std::min<usize>(out.size(), size_ / 2);
+    if (bins == 0)
+        return;
+    out[0] = std::abs(output_[0]) * scale_ * 0.5f;
+    for (usize k = 1; k < bins; ++k) {
+        f32 re = output_[k * 2];
+        f32 im = output_[k * 2 + 1];
+        out[k] = std::sqrt(re * re + im * im) * scale_;
+    }
+}
+
+} // namespace vc
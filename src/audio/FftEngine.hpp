@@ -0,0 +1,61 @@
+#pragma once
+// FftEngine.hpp - Windowed real FFT -> magnitude spectrum, one size per instance
+// Each engine owns its PFFFT setup and SIMD-aligned scratch, so any number
+// of them (at different sizes) can run side by side or on different threads
+
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "util/Result.hpp"
+#include "util/Types.hpp"
+
+struct PFFFT_Setup;
+
+namespace vc {
+
+inline constexpr u32 MIN_FFT_SIZE = 512;
+inline constexpr u32 MAX_FFT_SIZE = 16384;
+inline constexpr u32 MAX_SPECTRUM_BINS = MAX_FFT_SIZE / 2;
+
+enum class FftWindow : u8 { Rectangular, Hann, Hamming, Blackman, BlackmanHarris };
+
+std::optional<FftWindow> parseFftWindow(std::string_view name);
+std::string_view fftWindowName(FftWindow window);
+
+class FftEngine {
+public:
+    FftEngine() = default;
+    ~FftEngine();
+
+    FftEngine(const FftEngine&) = delete;
+    FftEngine& operator=(const FftEngine&) = delete;
+
+    // (Re)build for `size` (power of two, MIN_FFT_SIZE..MAX_FFT_SIZE).
+    // All allocation happens here; a no-op if nothing changed.
+    Result<void> configure(u32 size, FftWindow window);
+    void release();
+
+    bool ready() const { return setup_ != nullptr; }
+    u32 size() const { return size_; }
+    u32 bins() const { return size_ / 2; }
+    FftWindow window() const { return window_; }
+
+    // Window the last size() samples given as two spans in time order
+    // (e.g. CircularBuffer::getSpans()) and write up to bins() amplitude-
+    // normalized magnitudes to `out`. Missing leading samples count as 0.
+    void magnitudes(std::span<const f32> first,
+                    std::span<const f32> second,
+                    std::span<f32> out);
+
+private:
+    PFFFT_Setup* setup_{nullptr};
+    f32* input_{nullptr};  // PFFFT aligned
+    f32* output_{nullptr};
+    f32* work_{nullptr};
+    std::vector<f32> coefficients_; // window function, size_ entries
+    f32 scale_{0.0f}; // 2 / sum(window): a full-scale sine reads 1.0
+    u32 size_{0};
+    FftWindow window_{FftWindow::Hann};
+};
+
+} // namespace vc
@@ -0,0 +1,59 @@
+#pragma once
+// GainStage.hpp - Linear gain ramp over interleaved float PCM
+//
+// Runs on the audio output thread for every buffer, so it stays branch-free
+// per sample: SSE on x86, NEON on ARM, a scalar loop for the tail and
+// everywhere else. A constant gain is a ramp with from == to; unity gain
+// is skipped entirely.
+
+#include <cmath>
+#include "util/Types.hpp"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define VC_GAIN_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VC_GAIN_NEON 1
+#endif
+
+namespace vc {
+
+// Scales `samples` (interleaved, `channels` per frame) from gain `from` at
+// the first frame to `to` at the end of the buffer
+inline void applyGain(f32* samples, usize frames, u32 channels, f32 from, f32 to) {
+    if (frames == 0 || (from == 1.0f && to == 1.0f))
+        return;
+
+    const usize count = frames * channels;
+    // Per-sample increment; both channels of a frame may differ by one
+    // step, which is far below anything audible
+    const f32 step = (to - from) / static_cast<f32>(count);
+    usize i = 0;
+
+#if defined(VC_GAIN_SSE)
+    const __m128 step4 = _mm_set1_ps(step * 4.0f);
+    __m128 gain = _mm_setr_ps(from, from + step, from + 2.0f * step, from + 3.0f * step);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), gain));
+        gain = _mm_add_ps(gain, step4);
+    }
+#elif defined(VC_GAIN_NEON)
+    const float32x4_t step4 = vdupq_n_f32(step * 4.0f);
+    const f32 start[4] = {from, from + step, from + 2.0f * step, from + 3.0f * step};
+    float32x4_t gain = vld1q_f32(start);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(samples + i, vmulq_f32(vld1q_f32(samples + i), gain));
+        gain = vaddq_f32(gain, step4);
+    }
+#endif
+
+    for (; i < count; ++i)
+        samples[i] *= from + step * static_cast<f32>(i);
+}
+
+inline f32 dbToGain(f32 db) {
+    return std::pow(10.0f, db / 20.0f);
+}
+
+} // namespace vc
@@ -0,0 +1,306 @@
+#include "MediaLibrary.hpp"
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <atomic>
+#include "core/Logger.hpp"
+#include "util/FileUtils.hpp"
+
+namespace vc {
+
+namespace {
+constexpr int SCHEMA_VERSION = 1;
+
+const char* const TRACK_COLUMNS =
+        "path, size, mtime, title, artist, album, genre, year, track_number, duration_ms, "
+        "bitrate, sample_rate, channels, suno_clip_id, lyrics_path, art_id";
+
+QString text(const std::string& value) {
+    return QString::fromStdString(value);
+}
+
+std::string sqlError(const QSqlQuery& query) {
+    return query.lastError().text().toStdString();
+}
+
+LibraryTrack trackFromQuery(const QSqlQuery& query) {
+    LibraryTrack track;
+    track.id = query.value("id").toLongLong();
+    track.path = query.value("path").toString().toStdString();
+    track.size = query.value("size").toULongLong();
+    track.mtime = query.value("mtime").toLongLong();
+    auto& meta = track.metadata;
+    meta.title = query.value("title").toString().toStdString();
+    meta.artist = query.value("artist").toString().toStdString();
+    meta.album = query.value("album").toString().toStdString();
+    meta.genre = query.value("genre").toString().toStdString();
+    meta.year = query.value("year").toUInt();
+    meta.trackNumber = query.value("track_number").toUInt();
+    meta.duration = Duration(query.value("duration_ms").toLongLong());
+    meta.bitrate = query.value("bitrate").toUInt();
+    meta.sampleRate = query.value("sample_rate").toUInt();
+    meta.channels = query.value("channels").toUInt();
+    meta.sunoClipId = query.value("suno_clip_id").toString().toStdString();
+    // Stored signed: SQLite integers are 64-bit signed
+    meta.artId = static_cast<ArtId>(query.value("art_id").toLongLong());
+    track.lyricsPath = query.value("lyrics_path").toString().toStdString();
+    return track;
+}
+
+void bindTrack(QSqlQuery& query, const LibraryTrack& track) {
+    const auto& meta = track.metadata;
+    query.addBindValue(text(track.path.string()));
+    query.addBindValue(static_cast<qint64>(track.size));
+    query.addBindValue(static_cast<qint64>(track.mtime));
+    query.addBindValue(text(meta.title));
+    query.addBindValue(text(meta.artist));
+    query.addBindValue(text(meta.album));
+    query.addBindValue(text(meta.genre));
+    query.addBindValue(meta.year);
+    query.addBindValue(meta.trackNumber);
+    query.addBindValue(static_cast<qint64>(meta.duration.count()));
+    query.addBindValue(meta.bitrate);
+    query.addBindValue(meta.sampleRate);
+    query.addBindValue(meta.channels);
+    query.addBindValue(text(meta.sunoClipId));
+    query.addBindValue(text(track.lyricsPath));
+    query.addBindValue(static_cast<qint64>(meta.artId));
+}
+} // namespace
+
+MediaLibrary::MediaLibrary() {
+    // One connection per instance; tests open several
+    static std::atomic<int> counter{0};
+    connectionName_ = QStringLiteral("media_library_%1").arg(counter++);
+}
+
+MediaLibrary::~MediaLibrary() {
+    close();
+}
+
+Result<void> MediaLibrary::open(const fs::path& dbPath) {
+    close();
+    if (auto result = file::ensureDir(dbPath.parent_path()); !result)
+        return result;
+
+    db_ = QSqlDatabase::addDatabase("QSQLITE", connectionName_);
+    db_.setDatabaseName(text(dbPath.string()));
+    if (!db_.open()) {
+        return Result<void>::err("Failed to open media library: " +
+                                 db_.lastError().text().toStdString());
+    }
+
+    QSqlQuery query(db_);
+    // WAL: saving the session doesn't block on readers, and fewer fsyncs
+    query.exec("PRAGMA journal_mode=WAL");
+    query.exec("PRAGMA synchronous=NORMAL");
+    query.exec("PRAGMA foreign_keys=ON");
+
+    int version = 0;
+    if (query.exec("PRAGMA user_version") && query.next())
+        version = query.value(0).toInt();
+    if (version > SCHEMA_VERSION) {
+        return Result<void>::err("Media library was written by a newer version");
+    }
+
+    const char* const schema[] = {
+            "CREATE TABLE IF NOT EXISTS tracks ("
+            "id INTEGER PRIMARY KEY, "
+            "path TEXT NOT NULL UNIQUE, "
+            "size INTEGER, "
+            "mtime INTEGER, "
+            "title TEXT, "
+            "artist TEXT, "
+            "album TEXT, "
+            "genre TEXT, "
+            "year INTEGER, "
+            "track_number INTEGER, "
+            "duration_ms INTEGER, "
+            "bitrate INTEGER, "
+            "sample_rate INTEGER, "
+            "channels INTEGER, "
+            "suno_clip_id TEXT, "
+            "lyrics_path TEXT, "
+            "art_id INTEGER"
+            ")",
+            "CREATE TABLE IF NOT EXISTS playlists (name TEXT PRIMARY KEY)",
+            "CREATE TABLE IF NOT EXISTS playlist_items ("
+            "playlist TEXT NOT NULL REFERENCES playlists(name) ON DELETE CASCADE, "
+            "position INTEGER NOT NULL, "
+            "track_id INTEGER REFERENCES tracks(id) ON DELETE SET NULL, "
+            "location TEXT, "
+            "title TEXT, "
+            "PRIMARY KEY (playlist, position)"
+            ") WITHOUT ROWID",
+    };
+    for (const char* statement : schema) {
+        if (!query.exec(statement)) {
+            return Result<void>::err("Failed to create media library tables: " + sqlError(query));
+        }
+    }
+    query.exec(QStringLiteral("PRAGMA user_version=%1").arg(SCHEMA_VERSION));
+
+    LOG_INFO("Media library opened at {} ({} tracks)", dbPath.string(), trackCount());
+    return Result<void>::ok();
+}
+
+void MediaLibrary::close() {
+    if (!db_.isValid())
+        return;
+    db_.close();
+    db_ = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connectionName_);
+}
+
+std::vector<std::optional<LibraryTrack>> MediaLibrary::find(const std::vector<fs::path>& paths) {
+    std::vector<std::optional<LibraryTrack>> found(paths.size());
+    if (!isOpen() || paths.empty())
+        return found;
+
+    // One read transaction around the lookups; each is a UNIQUE index probe
+    db_.transaction();
+    QSqlQuery query(db_);
+    query.prepare(QStringLiteral("SELECT id, %1 FROM tracks WHERE path = ?").arg(QLatin1String(TRACK_COLUMNS)));
+    for (usize i = 0; i < paths.size(); ++i) {
+        query.addBindValue(text(paths[i].string()));
+        if (!query.exec()) {
+            LOG_WARN("Media library lookup failed: {}", sqlError(query));
+            break;
+        }
+        if (query.next())
+            found[i] = trackFromQuery(query);
+        query.finish();
+    }
+    db_.commit();
+    return found;
+}
+
+Result<void> MediaLibrary::store(std::vector<LibraryTrack>& tracks) {
+    if (!isOpen())
+        return Result<void>::err("Media library not open");
+    if (tracks.empty())
+        return Result<void>::ok();
+
+    db_.transaction();
+    QSqlQuery upsert(db_);
+    upsert.prepare(QStringLiteral("INSERT INTO tracks (%1) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?) "
+                                  "ON CONFLICT(path) DO UPDATE SET "
+                                  "size = excluded.size, mtime = excluded.mtime, "
+                                  "title = excluded.title, artist = excluded.artist, "
+                                  "album = excluded.album, genre = excluded.genre, "
+                                  "year = excluded.year, track_number = excluded.track_number, "
+                                  "duration_ms = excluded.duration_ms, bitrate = excluded.bitrate, "
+                                  "sample_rate = excluded.sample_rate, channels = excluded.channels, "
+                                  "suno_clip_id = excluded.suno_clip_id, "
+                                  "lyrics_path = excluded.lyrics_path, art_id = excluded.art_id")
+                           .arg(QLatin1String(TRACK_COLUMNS)));
+    QSqlQuery lookup(db_);
+    lookup.prepare("SELECT id FROM tracks WHERE path = ?");
+
+    for (auto& track : tracks) {
+        bindTrack(upsert, track);
+        if (!upsert.exec()) {
+            db_.rollback();
+            return Result<void>::err("Failed to store track: " + sqlError(upsert));
+        }
+        // lastInsertId() isn't set when the upsert took the UPDATE branch
+        lookup.addBindValue(text(track.path.string()));
+        if (lookup.exec() && lookup.next())
+            track.id = lookup.value(0).toLongLong();
+        lookup.finish();
+    }
+
+    if (!db_.commit())
+        return Result<void>::err("Failed to commit tracks: " + db_.lastError().text().toStdString());
+    return Result<void>::ok();
+}
+
+usize MediaLibrary::trackCount() {
+    if (!isOpen())
+        return 0;
+    QSqlQuery query(db_);
+    if (query.exec("SELECT COUNT(*) FROM tracks") && query.next())
+        return static_cast<usize>(query.value(0).toLongLong());
+    return 0;
+}
+
+Result<void> MediaLibrary::savePlaylist(const std::string& name,
+                                        const std::vector<LibraryPlaylistEntry>& entries) {
+    if (!isOpen())
+        return Result<void>::err("Media library not open");
+
+    db_.transaction();
+    QSqlQuery query(db_);
+    query.prepare("INSERT OR IGNORE INTO playlists (name) VALUES (?)");
+    query.addBindValue(text(name));
+    bool ok = query.exec();
+    if (ok) {
+        query.prepare("DELETE FROM playlist_items WHERE playlist = ?");
+        query.addBindValue(text(name));
+        ok = query.exec();
+    }
+
+    query.prepare("INSERT INTO playlist_items (playlist, position, track_id, location, title) "
+                  "VALUES (?, ?, ?, ?, ?)");
+    for (usize i = 0; ok && i < entries.size(); ++i) {
+        const auto& entry = entries[i];
+        query.addBindValue(text(name));
+        query.addBindValue(static_cast<qint64>(i));
+        query.addBindValue(entry.trackId != 0 ? QVariant(static_cast<qint64>(entry.trackId))
+                                              : QVariant());
+        query.addBindValue(text(entry.location));
+        query.addBindValue(text(entry.title));
+        ok = query.exec();
+    }
+
+    if (!ok) {
+        db_.rollback();
+        return Result<void>::err("Failed to save playlist " + name + ": " + sqlError(query));
+    }
+    if (!db_.commit())
+        return Result<void>::err("Failed to commit playlist: " + db_.lastError().text().toStdString());
+    return Result<void>::ok();
+}
+
+Result<std::optional<std::vector<LibraryPlaylistEntry>>> MediaLibrary::loadPlaylist(const std::string& name) {
+    using R = Result<std::optional<std::vector<LibraryPlaylistEntry>>>;
+    if (!isOpen())
+        return R::err("Media library not open");
+
+    QSqlQuery query(db_);
+    query.prepare("SELECT 1 FROM playlists WHERE name = ?");
+    query.addBindValue(text(name));
+    if (!query.exec())
+        return R::err("Failed to load playlist " + name + ": " + sqlError(query));
+    if (!query.next())
+        return R::ok(std::nullopt);
+
+    // Primary key order: one range scan, tracks joined by rowid
+    query.prepare(QStringLiteral("SELECT p.track_id AS entry_track, p.location AS entry_location, "
+                                 "p.title AS entry_title, t.id, t.%1 FROM playlist_items p "
+                                 "LEFT JOIN tracks t ON t.id = p.track_id "
+                                 "WHERE p.playlist = ? ORDER BY p.position")
+                          .arg(QString::fromLatin1(TRACK_COLUMNS).replace(", ", ", t.")));
+    query.addBindValue(text(name));
+    if (!query.exec())
+        return R::err("Failed to load playlist " + name + ": " + sqlError(query));
+
+    std::vector<LibraryPlaylistEntry> entries;
+    while (query.next()) {
+        LibraryPlaylistEntry entry;
+        entry.title = query.value("entry_title").toString().toStdString();
+        entry.location = query.value("entry_location").toString().toStdString();
+        // Otherwise a URL, an unindexed file, or a track since dropped
+        // from the library
+        if (!query.value("id").isNull()) {
+            entry.track = trackFromQuery(query);
+            entry.trackId = entry.track->id;
+        }
+        if (!entry.track && entry.location.empty())
+            continue;
+        entries.push_back(std::move(entry));
+    }
+    return R::ok(std::move(entries));
+}
+
+} // namespace vc
@@ -0,0 +1,80 @@
+/**
+ * @file MediaLibrary.hpp
+ * @brief SQLite index of local tracks and saved playlists.
+ *
+ * Every local file that has been read once is kept as a row with its size
+ * and mtime, tags, duration, .lrc sidecar and album-art id. Playlist looks
+ * files up here before reading them: a row whose size and mtime still
+ * match is used as is, so re-adding a folder or restoring a session only
+ * re-runs TagLib on files that changed.
+ *
+ * Playlists are stored as ordered rows referencing track ids (or a URL or
+ * a not-yet-indexed path), so restoring a 10k-track session is one indexed
+ * join instead of 10k file opens.
+ *
+ * @section Threads
+ * GUI thread only: the QSqlDatabase connection belongs to the thread that
+ * opened it. Callers batch their writes; each store()/savePlaylist() is a
+ * single transaction.
+ */
+
+#pragma once
+#include <QSqlDatabase>
+#include <optional>
+#include <string>
+#include <vector>
+#include "audio/analysis/MediaMetadata.hpp"
+#include "util/Result.hpp"
+#include "util/Types.hpp"
+
+namespace vc {
+
+struct LibraryTrack {
+    i64 id{0}; // 0 until stored
+    fs::path path;
+    u64 size{0};
+    i64 mtime{0};
+    MediaMetadata metadata;
+    std::string lyricsPath;
+};
+
+// One playlist row: a library track if indexed, and always its location
+// (URL or path) to fall back on
+struct LibraryPlaylistEntry {
+    i64 trackId{0};
+    std::string location;
+    std::string title;
+    std::optional<LibraryTrack> track; // filled in by loadPlaylist()
+};
+
+class MediaLibrary {
+public:
+    MediaLibrary();
+    ~MediaLibrary();
+
+    MediaLibrary(const MediaLibrary&) = delete;
+    MediaLibrary& operator=(const MediaLibrary&) = delete;
+
+    Result<void> open(const fs::path& dbPath);
+    void close();
+    bool isOpen() const { return db_.isOpen(); }
+
+    // Rows for `paths`, in order; nullopt where unknown. Whether a row is
+    // still current is up to the caller (compare file::stamp()).
+    std::vector<std::optional<LibraryTrack>> find(const std::vector<fs::path>& paths);
+    // Insert or update by path and fill in ids
+    Result<void> store(std::vector<LibraryTrack>& tracks);
+    usize trackCount();
+
+    // Replaces the playlist `name` entirely
+    Result<void> savePlaylist(const std::string& name,
+                              const std::vector<LibraryPlaylistEntry>& entries);
+    // nullopt if no playlist of that name was ever saved
+    Result<std::optional<std::vector<LibraryPlaylistEntry>>> loadPlaylist(const std::string& name);
+
+private:
+    QSqlDatabase db_;
+    QString connectionName_;
+};
+
+} // namespace vc
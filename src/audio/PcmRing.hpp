@@ -0,0 +1,176 @@
+#pragma once
+// PcmRing.hpp - Decode-ahead buffer between the decoder and output threads
+//
+// Interleaved stereo f32 frames plus in-band markers (track starts, seeks,
+// end of media) that the reader meets at exactly the frame they were
+// written at. Positions are monotonically increasing u64 frame counts.
+//
+// flush() lets the writer discard everything not yet played (seek, new
+// track) without touching the reader's cursor: it records where new data
+// starts and bumps an epoch, and the reader jumps there on its next call.
+
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include "util/SpscQueue.hpp"
+#include "util/Types.hpp"
+
+namespace vc {
+
+struct PcmMarker {
+    enum class Kind : u8 {
+        Open, // first frame of a track that replaced whatever played
+        Seek, // playback continues from trackFrame
+        Next, // gapless continuation into the next track
+        End,  // nothing follows
+    };
+
+    Kind kind{Kind::Open};
+    u64 track{0};       // caller's id for the track
+    u64 trackFrame{0};  // track position of the frame that follows
+    u64 trackFrames{0}; // track length, 0 if unknown
+    u64 at{0};          // ring position the marker sits at
+    u64 epoch{0};
+};
+
+class PcmRing {
+public:
+    static constexpr u32 CHANNELS = 2;
+
+    explicit PcmRing(u32 capacityFrames, u32 maxMarkers = 64)
+        : capacity_(std::bit_ceil(std::max<u32>(capacityFrames, 2)))
+        , mask_(capacity_ - 1)
+        , samples_(std::make_unique<f32[]>(static_cast<usize>(capacity_) * CHANNELS))
+        , markers_(maxMarkers)
+    {}
+
+    PcmRing(const PcmRing&) = delete;
+    PcmRing& operator=(const PcmRing&) = delete;
+
+    u32 capacity() const {
+        return capacity_;
+    }
+
+    // --- Writer thread ----------------------------------------------------
+
+    u32 writable() const {
+        const u64 write = writePos_.load(std::memory_order_relaxed);
+        const u64 read = readPos_.load(std::memory_order_acquire);
+        return write - read >= capacity_ ? 0 : capacity_ - static_cast<u32>(write - read);
+    }
+
+    // Copies up to writable() frames; returns how many were taken
+    u32 write(const f32* data, u32 frames) {
+        frames = std::min(frames, writable());
+        const u64 write = writePos_.load(std::memory_order_relaxed);
+        const u32 start = static_cast<u32>(write & mask_);
+        const u32 first = std::min(frames, capacity_ - start);
+        std::memcpy(&samples_[static_cast<usize>(start) * CHANNELS],
+                    data,
+                    static_cast<usize>(first) * CHANNELS * sizeof(f32));
+        std::memcpy(&samples_[0],
+                    data + static_cast<usize>(first) * CHANNELS,
+                    static_cast<usize>(frames - first) * CHANNELS * sizeof(f32));
+        writePos_.store(write + frames, std::memory_order_release);
+        return frames;
+    }
+
+    // Queue a marker at the current write position. False if the reader
+    // has fallen that far behind on markers.
+    bool mark(PcmMarker marker) {
+        marker.at = writePos_.load(std::memory_order_relaxed);
+        marker.epoch = epoch_.load(std::memory_order_relaxed);
+        return markers_.tryPush(marker);
+    }
+
+    // Drop everything written so far that the reader hasn't consumed
+    void flush() {
+        flushPos_.store(writePos_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        epoch_.store(epoch_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // --- Reader thread ----------------------------------------------------
+
+    // Either copies up to `frames` frames into `out` and returns the count,
+    // or, when the next marker is due, returns 0 with `marker` set; audio
+    // and markers are never returned from the same call. Pass frames = 0 to
+    // only apply pending flushes and collect a due marker.
+    u32 read(f32* out, u32 frames, std::optional<PcmMarker>& marker) {
+        marker.reset();
+        // Write position before epoch: data newer than a flush implies the
+        // flush is visible, so nothing stale is read as current
+        const u64 write = writePos_.load(std::memory_order_acquire);
+        const u64 epoch = epoch_.load(std::memory_order_acquire);
+        u64 read = readPos_.load(std::memory_order_relaxed);
+        if (epoch != readerEpoch_) {
+            readerEpoch_ = epoch;
+            read = std::max(read, flushPos_.load(std::memory_order_relaxed));
+            readPos_.store(read, std::memory_order_release);
+        }
+
+        // Markers were queued before the data after them, so every marker
+        // inside [read, write) is visible by now
+        while (true) {
+            if (!nextMarker_) {
+                PcmMarker m;
+                if (!markers_.tryPop(m))
+                    break;
+                nextMarker_ = m;
+            }
+            if (nextMarker_->epoch < readerEpoch_)
+                nextMarker_.reset(); // flushed away
+            else
+                break;
+        }
+
+        u64 limit = write > read ? write - read : 0;
+        if (nextMarker_ && nextMarker_->epoch == readerEpoch_) {
+            if (nextMarker_->at <= read) {
+                marker = nextMarker_;
+                nextMarker_.reset();
+                return 0;
+            }
+            limit = std::min(limit, nextMarker_->at - read);
+        }
+
+        frames = static_cast<u32>(std::min<u64>(frames, limit));
+        if (frames == 0)
+            return 0;
+        const u32 start = static_cast<u32>(read & mask_);
+        const u32 first = std::min(frames, capacity_ - start);
+        std::memcpy(out,
+                    &samples_[static_cast<usize>(start) * CHANNELS],
+                    static_cast<usize>(first) * CHANNELS * sizeof(f32));
+        std::memcpy(out + static_cast<usize>(first) * CHANNELS,
+                    &samples_[0],
+                    static_cast<usize>(frames - first) * CHANNELS * sizeof(f32));
+        readPos_.store(read + frames, std::memory_order_release);
+        return frames;
+    }
+
+    // Approximate from any thread
+    u32 buffered() const {
+        const u64 write = writePos_.load(std::memory_order_acquire);
+        const u64 read = readPos_.load(std::memory_order_acquire);
+        return write > read ? static_cast<u32>(std::min<u64>(write - read, capacity_)) : 0;
+    }
+
+private:
+    const u32 capacity_;
+    const u32 mask_;
+    std::unique_ptr<f32[]> samples_;
+    SpscQueue<PcmMarker> markers_;
+
+    alignas(64) std::atomic<u64> writePos_{0};
+    std::atomic<u64> flushPos_{0};
+    std::atomic<u64> epoch_{0};
+
+    alignas(64) std::atomic<u64> readPos_{0};
+    // Reader-only
+    u64 readerEpoch_{0};
+    std::optional<PcmMarker> nextMarker_;
+};
+
+} // namespace vc
@@ -2,146 +2,257 @@
 #include "core/Logger.hpp"
 #include "util/FileUtils.hpp"
 #include <algorithm>
+#include <cmath>
 #include <fstream>
-#include <numeric>
+#include <functional>
+#include <unordered_map>
 
 namespace vc {
 
+namespace {
+bool isUrl(const std::string& location) {
+    return location.find("://") != std::string::npos;
+}
+
+std::string albumKey(const MediaMetadata& metadata) {
+    return metadata.artist + '\x1f' + metadata.album;
+}
+} // namespace
+
 Playlist::Playlist()
     : rng_(std::random_device{}())
 {
 }
 
 void Playlist::addFile(const fs::path& path) {
-    if (!fs::exists(path)) {
-        LOG_WARN("File not found: {}", path.string());
-        return;
-    }
-    
-    if (!MetadataReader::canRead(path)) {
-        LOG_WARN("Unsupported file format: {}", path.string());
-        return;
-    }
-    
-    PlaylistItem item;
-    item.path = path;
-    
-    auto metaResult = MetadataReader::read(path);
-    if (metaResult) {
-        item.metadata = std::move(*metaResult);
-    } else {
-        LOG_WARN("Failed to read metadata: {}", metaResult.error().message);
-        item.metadata.title = path.stem().string();
-    }
-    
-    // Check for matching LRC file (external lyrics with timing)
-    fs::path lrcPath = path;
-    lrcPath.replace_extension(".lrc");
-    
-    if (fs::exists(lrcPath)) {
-        item.lyricsPath = lrcPath.string();
-        LOG_INFO("Found lyrics file: {}", lrcPath.string());
+    addFiles({path});
+}
+
+void Playlist::addUrl(const std::string& url, const std::string& title) {
+    std::vector<PlaylistItem> newItems;
+    newItems.push_back(makeRemoteItem(url, title));
+    appendBatch(std::move(newItems), {});
+}
+
+void Playlist::addFiles(const std::vector<fs::path>& paths) {
+    std::vector<fs::path> readable;
+    readable.reserve(paths.size());
+    for (const auto& path : paths) {
+        if (MetadataReader::canRead(path)) {
+            readable.push_back(path);
+        } else {
+            LOG_WARN("Unsupported file format: {}", path.string());
+        }
     }
     
-    usize index = items_.size();
-    items_.push_back(std::move(item));
-    
-    if (shuffle_) {
-        shuffleOrder_.push_back(index);
-        if (shuffleOrder_.size() > 1) {
-            std::uniform_int_distribution<usize> dist(0, shuffleOrder_.size() - 1);
-            std::swap(shuffleOrder_.back(), shuffleOrder_[dist(rng_)]);
-        }
+    auto known = library_ ? library_->find(readable)
+                          : std::vector<std::optional<LibraryTrack>>(readable.size());
+    std::vector<PlaylistItem> newItems;
+    std::vector<MetadataJob> jobs;
+    newItems.reserve(readable.size());
+    jobs.reserve(readable.size());
+    for (usize i = 0; i < readable.size(); ++i) {
+        newItems.push_back(makeLocalItem(readable[i], std::move(known[i]), jobs));
     }
     
-    itemAdded.emitSignal(index);
-    changed.emitSignal();
+    if (newItems.empty()) return;
     
-    LOG_DEBUG("Added to playlist: {}", path.filename().string());
+    LOG_DEBUG("Added {} tracks to playlist", newItems.size());
+    appendBatch(std::move(newItems), std::move(jobs));
 }
 
-void Playlist::addUrl(const std::string& url, const std::string& title) {
+PlaylistItem Playlist::makeRemoteItem(const std::string& url, const std::string& title) {
     PlaylistItem item;
+    item.id = nextItemId_++;
     item.url = url;
     item.isRemote = true;
     item.metadata.title = title.empty() ? url : title;
-    
-    usize index = items_.size();
-    items_.push_back(std::move(item));
-    
-    if (shuffle_) {
-        shuffleOrder_.push_back(index);
+    return item;
+}
+
+PlaylistItem Playlist::makeLocalItem(const fs::path& path,
+                                     std::optional<LibraryTrack> known,
+                                     std::vector<MetadataJob>& jobs) {
+    // Listed (and playable) now; the loader fills in or confirms the tags
+    PlaylistItem item;
+    item.id = nextItemId_++;
+    item.path = path;
+    item.metadataPending = true;
+    if (known) {
+        // Shown from the library right away; the worker only re-reads
+        // the file if its size or mtime changed
+        item.libraryId = known->id;
+        item.metadata = std::move(known->metadata);
+        item.lyricsPath = std::move(known->lyricsPath);
+        AlbumArtStore::instance().adopt(item.metadata.artId, path);
+        jobs.push_back({item.id, path, std::pair{known->size, known->mtime}});
+    } else {
+        item.metadata.title = path.stem().string();
+        jobs.push_back({item.id, path, std::nullopt});
     }
-    
-    itemAdded.emitSignal(index);
-    changed.emitSignal();
+    return item;
 }
 
-void Playlist::addFiles(const std::vector<fs::path>& paths) {
-    for (const auto& path : paths) {
-        addFile(path);
+void Playlist::appendBatch(std::vector<PlaylistItem> newItems, std::vector<MetadataJob> jobs) {
+    if (newItems.empty()) return;
+    const usize first = items_.size();
+    const usize count = newItems.size();
+    for (auto& item : newItems) {
+        const u64 id = item.id;
+        const ItemHandle handle = items_.pushBack(std::move(item));
+        byId_[id] = handle;
+        indexItem(handle);
+        if (shuffle_) shuffleIn(handle);
     }
+    
+    submitMetadata(std::move(jobs));
+    itemsAdded.emitSignal(first, count);
+    changed.emitSignal();
 }
 
 void Playlist::removeAt(usize index) {
     if (index >= items_.size()) return;
     
-    items_.erase(items_.begin() + index);
-    
-    if (currentIndex_) {
-        if (*currentIndex_ == index) {
-            currentIndex_ = std::nullopt;
-        } else if (*currentIndex_ > index) {
-            --(*currentIndex_);
-        }
-    }
-    
-    if (shuffle_) {
-        regenerateShuffleOrder();
-    }
+    eraseItem(items_.handleAt(index));
     
-    itemRemoved.emitSignal(index);
+    itemsRemoved.emitSignal(index, 1);
     changed.emitSignal();
 }
 
 void Playlist::clear() {
+    if (loader_) loader_->cancelAll();
+    const usize count = items_.size();
     items_.clear();
-    currentIndex_ = std::nullopt;
+    byId_.clear();
+    byPath_.clear();
+    albums_.clear();
+    current_ = NONE;
     shuffleOrder_.clear();
-    shufflePosition_ = 0;
+    shuffleSlot_.clear();
+    shuffleCursor_ = NONE;
     
+    if (count > 0) itemsRemoved.emitSignal(0, count);
     changed.emitSignal();
 }
 
 void Playlist::move(usize from, usize to) {
     if (from >= items_.size() || to >= items_.size() || from == to) return;
     
-    auto item = std::move(items_[from]);
-    items_.erase(items_.begin() + from);
-    items_.insert(items_.begin() + to, std::move(item));
-    
-    if (currentIndex_) {
-        if (*currentIndex_ == from) {
-            *currentIndex_ = to;
-        } else if (from < *currentIndex_ && to >= *currentIndex_) {
-            --(*currentIndex_);
-        } else if (from > *currentIndex_ && to <= *currentIndex_) {
-            ++(*currentIndex_);
-        }
-    }
-    
-    if (shuffle_) {
-        regenerateShuffleOrder();
-    }
+    // Handles follow the item, so current_ and the shuffle order stay put
+    items_.move(from, to);
     
+    itemMoved.emitSignal(from, to);
     changed.emitSignal();
 }
 
-const PlaylistItem* Playlist::currentItem() const {
-    if (!currentIndex_ || *currentIndex_ >= items_.size()) {
-        return nullptr;
+void Playlist::eraseItem(ItemHandle handle) {
+    if (shuffle_) shuffleOut(handle);
+    if (current_ == handle) current_ = NONE;
+    byId_.erase(items_.get(handle).id);
+    unindexItem(handle);
+    items_.eraseHandle(handle);
+}
+
+void Playlist::indexItem(ItemHandle handle) {
+    const auto& item = items_.get(handle);
+    if (item.isRemote) return;
+    byPath_[item.path.string()].push_back(handle);
+    albumIn(handle);
+}
+
+void Playlist::unindexItem(ItemHandle handle) {
+    const auto& item = items_.get(handle);
+    if (item.isRemote) return;
+    if (auto it = byPath_.find(item.path.string()); it != byPath_.end()) {
+        std::erase(it->second, handle);
+        if (it->second.empty()) byPath_.erase(it);
     }
-    return &items_[*currentIndex_];
+    albumOut(handle);
+}
+
+void Playlist::albumIn(ItemHandle handle) {
+    const auto& item = items_.get(handle);
+    if (item.isRemote || item.metadata.album.empty()) return;
+    auto& album = albums_[albumKey(item.metadata)];
+    album.tracks.push_back(handle);
+    album.stale = true;
+}
+
+void Playlist::albumOut(ItemHandle handle) {
+    const auto& item = items_.get(handle);
+    if (item.isRemote || item.metadata.album.empty()) return;
+    auto it = albums_.find(albumKey(item.metadata));
+    if (it == albums_.end()) return;
+    std::erase(it->second.tracks, handle);
+    if (it->second.tracks.empty())
+        albums_.erase(it);
+    else
+        it->second.stale = true;
+}
+
+void Playlist::albumChanged(const PlaylistItem& item) {
+    if (item.isRemote || item.metadata.album.empty()) return;
+    if (auto it = albums_.find(albumKey(item.metadata)); it != albums_.end())
+        it->second.stale = true;
+}
+
+void Playlist::setLoudness(usize index, const TrackLoudness& loudness) {
+    if (index < items_.size()) {
+        items_[index].metadata.loudness = loudness;
+        albumChanged(items_[index]);
+    }
+}
+
+void Playlist::setLoudness(const fs::path& path, const TrackLoudness& loudness) {
+    auto it = byPath_.find(path.string());
+    if (it == byPath_.end()) return;
+    for (ItemHandle handle : it->second) {
+        auto& item = items_.get(handle);
+        item.metadata.loudness = loudness;
+        albumChanged(item);
+    }
+}
+
+const PlaylistItem* Playlist::findLocal(const fs::path& path) const {
+    auto it = byPath_.find(path.string());
+    return it == byPath_.end() ? nullptr : &items_.get(it->second.front());
+}
+
+std::optional<AlbumLoudness> Playlist::albumLoudness(const PlaylistItem& item) const {
+    if (item.isRemote || item.metadata.album.empty()) return std::nullopt;
+    auto it = albums_.find(albumKey(item.metadata));
+    if (it == albums_.end()) return std::nullopt;
+    const Album& album = it->second;
+    if (album.stale) {
+        f64 energy = 0.0;
+        f64 seconds = 0.0;
+        AlbumLoudness result;
+        for (ItemHandle handle : album.tracks) {
+            const auto& loudness = items_.get(handle).metadata.loudness;
+            if (!loudness || loudness->integratedLufs <= LOUDNESS_SILENCE_LUFS) continue;
+            energy += loudness->durationSec * std::pow(10.0, loudness->integratedLufs / 10.0);
+            seconds += loudness->durationSec;
+            result.truePeakDbtp = std::max(result.truePeakDbtp, loudness->truePeakDbtp);
+        }
+        if (seconds > 0.0) {
+            result.integratedLufs = 10.0 * std::log10(energy / seconds);
+            album.loudness = result;
+        } else {
+            album.loudness.reset();
+        }
+        album.stale = false;
+    }
+    return album.loudness;
+}
+
+std::optional<usize> Playlist::currentIndex() const {
+    if (current_ == NONE) return std::nullopt;
+    return items_.indexOf(current_);
+}
+
+const PlaylistItem* Playlist::currentItem() const {
+    if (current_ == NONE) return nullptr;
+    return &items_.get(current_);
 }
 
 const PlaylistItem* Playlist::itemAt(usize index) const {
@@ -152,85 +263,118 @@ const PlaylistItem* Playlist::itemAt(usize index) const {
 bool Playlist::next() {
     if (items_.empty()) return false;
     
-    if (repeatMode_ == RepeatMode::One && currentIndex_) {
-        currentChanged.emitSignal(*currentIndex_);
-        return true;
+    if (repeatMode_ == RepeatMode::One && current_ != NONE) {
+        return playCurrent();
     }
     
     if (shuffle_) {
-        ++shufflePosition_;
-        if (shufflePosition_ >= shuffleOrder_.size()) {
-            if (repeatMode_ == RepeatMode::All) {
-                shufflePosition_ = 0;
-                regenerateShuffleOrder();
-            } else {
-                return false;
+        const usize position = shuffleNextPosition();
+        if (position < shuffleOrder_.size()) {
+            shuffleCursor_ = shuffleOrder_.handleAt(position);
+        } else if (repeatMode_ == RepeatMode::All) {
+            // New round; don't open it with the track that just ended
+            regenerateShuffleOrder(NONE);
+            if (shuffleOrder_.size() > 1 && shuffleOrder_[0] == current_) {
+                std::uniform_int_distribution<usize> dist(1, shuffleOrder_.size() - 1);
+                shuffleOrder_.move(0, dist(rng_));
             }
+            shuffleCursor_ = shuffleOrder_.handleAt(0);
+        } else {
+            return false;
         }
-        currentIndex_ = shuffleOrder_[shufflePosition_];
+        current_ = shuffleOrder_.get(shuffleCursor_);
     } else {
-        if (!currentIndex_) {
-            currentIndex_ = 0;
+        if (current_ == NONE) {
+            current_ = items_.handleAt(0);
         } else {
-            ++(*currentIndex_);
-            if (*currentIndex_ >= items_.size()) {
+            usize index = items_.indexOf(current_) + 1;
+            if (index >= items_.size()) {
                 if (repeatMode_ == RepeatMode::All) {
-                    currentIndex_ = 0;
+                    index = 0;
                 } else {
-                    currentIndex_ = std::nullopt;
+                    current_ = NONE;
                     return false;
                 }
             }
+            current_ = items_.handleAt(index);
         }
     }
     
-    currentChanged.emitSignal(*currentIndex_);
-    return true;
+    return playCurrent();
+}
+
+std::optional<usize> Playlist::peekNext() const {
+    if (items_.empty()) return std::nullopt;
+    if (repeatMode_ == RepeatMode::One && current_ != NONE) return currentIndex();
+
+    if (shuffle_) {
+        const usize position = shuffleNextPosition();
+        if (position < shuffleOrder_.size()) return items_.indexOf(shuffleOrder_[position]);
+        return std::nullopt;
+    }
+    if (current_ == NONE) return 0;
+    const usize index = items_.indexOf(current_) + 1;
+    if (index < items_.size()) return index;
+    if (repeatMode_ == RepeatMode::All) return 0;
+    return std::nullopt;
 }
 
 bool Playlist::previous() {
     if (items_.empty()) return false;
     
     if (shuffle_) {
-        if (shufflePosition_ == 0) {
+        const usize position = shuffleCursor_ == NONE ? 0 : shuffleOrder_.indexOf(shuffleCursor_);
+        if (position == 0) {
             if (repeatMode_ == RepeatMode::All) {
-                shufflePosition_ = shuffleOrder_.size() - 1;
+                shuffleCursor_ = shuffleOrder_.handleAt(shuffleOrder_.size() - 1);
             } else {
                 return false;
             }
         } else {
-            --shufflePosition_;
+            shuffleCursor_ = shuffleOrder_.handleAt(position - 1);
         }
-        currentIndex_ = shuffleOrder_[shufflePosition_];
+        current_ = shuffleOrder_.get(shuffleCursor_);
     } else {
-        if (!currentIndex_ || *currentIndex_ == 0) {
+        const usize index = current_ == NONE ? 0 : items_.indexOf(current_);
+        if (index == 0) {
             if (repeatMode_ == RepeatMode::All) {
-                currentIndex_ = items_.size() - 1;
+                current_ = items_.handleAt(items_.size() - 1);
             } else {
                 return false;
             }
         } else {
-            --(*currentIndex_);
+            current_ = items_.handleAt(index - 1);
         }
     }
     
-    currentChanged.emitSignal(*currentIndex_);
-    return true;
+    return playCurrent();
 }
 
 bool Playlist::jumpTo(usize index) {
     if (index >= items_.size()) return false;
     
-    currentIndex_ = index;
+    current_ = items_.handleAt(index);
     
     if (shuffle_) {
-        auto it = std::find(shuffleOrder_.begin(), shuffleOrder_.end(), index);
-        if (it != shuffleOrder_.end()) {
-            shufflePosition_ = std::distance(shuffleOrder_.begin(), it);
+        // Becomes the next step of the round, so history stays intact and
+        // the tracks not played yet still are
+        const ShuffleHandle slot = shuffleSlot_[current_];
+        const usize from = shuffleOrder_.indexOf(slot);
+        usize to = 0;
+        if (shuffleCursor_ != NONE) {
+            const usize cursor = shuffleOrder_.indexOf(shuffleCursor_);
+            to = from <= cursor ? cursor : cursor + 1;
         }
+        shuffleOrder_.move(from, to);
+        shuffleCursor_ = slot;
     }
     
-    currentChanged.emitSignal(*currentIndex_);
+    return playCurrent();
+}
+
+bool Playlist::playCurrent() {
+    loadMetadataNow(current_);
+    currentChanged.emitSignal(items_.indexOf(current_));
     return true;
 }
 
@@ -240,10 +384,11 @@ void Playlist::setShuffle(bool enabled) {
     shuffle_ = enabled;
     
     if (shuffle_) {
-        regenerateShuffleOrder();
-        if (currentIndex_) {
-            shufflePosition_ = realIndexToShuffle(*currentIndex_);
-        }
+        regenerateShuffleOrder(current_);
+    } else {
+        shuffleOrder_.clear();
+        shuffleSlot_.clear();
+        shuffleCursor_ = NONE;
     }
     
     changed.emitSignal();
@@ -263,24 +408,47 @@ void Playlist::cycleRepeatMode() {
     changed.emitSignal();
 }
 
-void Playlist::regenerateShuffleOrder() {
-    shuffleOrder_.resize(items_.size());
-    std::iota(shuffleOrder_.begin(), shuffleOrder_.end(), 0);
-    std::shuffle(shuffleOrder_.begin(), shuffleOrder_.end(), rng_);
-    shufflePosition_ = 0;
+void Playlist::regenerateShuffleOrder(ItemHandle first) {
+    std::vector<ItemHandle> order;
+    order.reserve(items_.size());
+    for (auto it = items_.begin(); it != items_.end(); ++it) {
+        order.push_back(it.handle());
+    }
+    std::shuffle(order.begin(), order.end(), rng_);
+    if (first != NONE) {
+        std::iter_swap(order.begin(), std::ranges::find(order, first));
+    }
+    
+    shuffleOrder_.clear();
+    shuffleOrder_.reserve(order.size());
+    shuffleSlot_.assign(items_.handleBound(), NONE);
+    for (ItemHandle handle : order) {
+        shuffleSlot_[handle] = shuffleOrder_.pushBack(handle);
+    }
+    shuffleCursor_ = first != NONE ? shuffleSlot_[first] : NONE;
 }
 
-usize Playlist::shuffleIndexToReal(usize shuffleIdx) const {
-    if (shuffleIdx >= shuffleOrder_.size()) return 0;
-    return shuffleOrder_[shuffleIdx];
+void Playlist::shuffleIn(ItemHandle handle) {
+    // Anywhere among the tracks still to come this round
+    std::uniform_int_distribution<usize> dist(shuffleNextPosition(), shuffleOrder_.size());
+    if (shuffleSlot_.size() < items_.handleBound()) {
+        shuffleSlot_.resize(items_.handleBound(), NONE);
+    }
+    shuffleSlot_[handle] = shuffleOrder_.insert(dist(rng_), handle);
 }
 
-usize Playlist::realIndexToShuffle(usize realIdx) const {
-    auto it = std::find(shuffleOrder_.begin(), shuffleOrder_.end(), realIdx);
-    if (it != shuffleOrder_.end()) {
-        return std::distance(shuffleOrder_.begin(), it);
+void Playlist::shuffleOut(ItemHandle handle) {
+    const ShuffleHandle slot = shuffleSlot_[handle];
+    shuffleSlot_[handle] = NONE;
+    const usize position = shuffleOrder_.indexOf(slot);
+    if (slot == shuffleCursor_) {
+        shuffleCursor_ = position > 0 ? shuffleOrder_.handleAt(position - 1) : NONE;
     }
-    return 0;
+    shuffleOrder_.erase(position);
+}
+
+usize Playlist::shuffleNextPosition() const {
+    return shuffleCursor_ == NONE ? 0 : shuffleOrder_.indexOf(shuffleCursor_) + 1;
 }
 
 Result<void> Playlist::saveM3U(const fs::path& path) const {
@@ -310,11 +478,8 @@ Result<void> Playlist::loadM3U(const fs::path& path) {
         return Result<void>::err("Failed to open file");
     }
 
-    bool wasShuffle = shuffle_;
-    shuffle_ = false;
-
     std::string line;
-    std::vector<PlaylistItem> newItems;
+    std::vector<std::string> locations;
     
     while (std::getline(file, line)) {
         line.erase(0, line.find_first_not_of(" \t\r\n"));
@@ -322,54 +487,233 @@ Result<void> Playlist::loadM3U(const fs::path& path) {
 
         if (line.empty() || line[0] == '#') continue;
 
-        PlaylistItem item;
-        if (line.starts_with("http") || line.starts_with("https")) {
-            item.url = line;
-            item.isRemote = true;
-            item.metadata.title = line;
+        if (isUrl(line)) {
+            locations.push_back(line);
         } else {
             fs::path filePath(line);
             if (!filePath.is_absolute()) {
                 filePath = path.parent_path() / filePath;
             }
-            
-            if (!fs::exists(filePath)) {
-                LOG_WARN("Playlist: File not found, skipping: {}", filePath.string());
-                continue;
-            }
-            
-            LOG_DEBUG("Playlist: Loading file: {}", filePath.string());
-            item.path = filePath;
-            
-            auto metaResult = MetadataReader::read(filePath);
-            if (metaResult) {
-                item.metadata = std::move(*metaResult);
-            } else {
-                item.metadata.title = filePath.stem().string();
-            }
-            
-            fs::path lrcPath = filePath;
-            lrcPath.replace_extension(".lrc");
-            if (fs::exists(lrcPath)) item.lyricsPath = lrcPath.string();
+            // Missing files are dropped when their metadata comes back
+            locations.push_back(filePath.string());
         }
-        newItems.push_back(std::move(item));
     }
 
+    // Known files come straight from the library, the rest are read
+    std::vector<fs::path> local;
+    for (const auto& location : locations) {
+        if (!isUrl(location)) local.push_back(location);
+    }
+    auto known = library_ ? library_->find(local)
+                          : std::vector<std::optional<LibraryTrack>>(local.size());
+    
+    std::vector<PlaylistItem> newItems;
+    std::vector<MetadataJob> jobs;
+    usize nextLocal = 0;
+    for (const auto& location : locations) {
+        if (isUrl(location)) {
+            newItems.push_back(makeRemoteItem(location, location));
+        } else {
+            newItems.push_back(makeLocalItem(local[nextLocal], std::move(known[nextLocal]), jobs));
+            ++nextLocal;
+        }
+    }
 
     if (!newItems.empty()) {
-        items_.insert(items_.end(), std::make_move_iterator(newItems.begin()), 
-                                    std::make_move_iterator(newItems.end()));
-        
-        if (wasShuffle) {
-            shuffle_ = true;
-            regenerateShuffleOrder();
-        }
-        
-        changed.emitSignal();
         LOG_INFO("Playlist: Loaded {} items from M3U", newItems.size());
+        appendBatch(std::move(newItems), std::move(jobs));
     }
-
     return Result<void>::ok();
 }
 
+Result<void> Playlist::saveToLibrary(const std::string& name) const {
+    if (!library_) return Result<void>::err("No media library");
+    
+    std::vector<LibraryPlaylistEntry> entries;
+    entries.reserve(items_.size());
+    for (const auto& item : items_) {
+        LibraryPlaylistEntry entry;
+        entry.trackId = item.libraryId;
+        entry.location = item.isRemote ? item.url : item.path.string();
+        entry.title = item.metadata.title;
+        entries.push_back(std::move(entry));
+    }
+    return library_->savePlaylist(name, entries);
+}
+
+Result<bool> Playlist::loadFromLibrary(const std::string& name) {
+    if (!library_) return Result<bool>::err("No media library");
+    
+    // One indexed query for the whole playlist; no file is opened here
+    auto loaded = library_->loadPlaylist(name);
+    if (!loaded) return Result<bool>::err(loaded.error());
+    if (!loaded.value()) return Result<bool>::ok(false);
+    
+    auto& entries = *loaded.value();
+    std::vector<PlaylistItem> newItems;
+    std::vector<MetadataJob> jobs;
+    newItems.reserve(entries.size());
+    jobs.reserve(entries.size());
+    for (auto& entry : entries) {
+        if (entry.track) {
+            fs::path path = entry.track->path;
+            newItems.push_back(makeLocalItem(path, std::move(entry.track), jobs));
+        } else if (isUrl(entry.location)) {
+            newItems.push_back(makeRemoteItem(entry.location, entry.title));
+        } else {
+            newItems.push_back(makeLocalItem(entry.location, std::nullopt, jobs));
+        }
+    }
+    
+    if (!newItems.empty()) {
+        LOG_INFO("Playlist: Restored {} items from the library", newItems.size());
+        appendBatch(std::move(newItems), std::move(jobs));
+    }
+    return Result<bool>::ok(true);
+}
+
+void Playlist::applyPendingMetadata() {
+    if (!loader_) return;
+    auto results = loader_->takeResults();
+    if (results.empty()) return;
+    
+    // Results for items removed in the meantime simply find nothing
+    std::vector<ItemHandle> updated;
+    std::vector<ItemHandle> missing;
+    std::vector<LibraryTrack> toStore;
+    for (auto& result : results) {
+        auto it = byId_.find(result.id);
+        if (it == byId_.end()) continue;
+        auto& item = items_.get(it->second);
+        if (!item.metadataPending) continue;
+        if (!result.found) {
+            missing.push_back(it->second);
+            continue;
+        }
+        const auto stamp = std::pair{result.size, result.mtime};
+        albumOut(it->second);
+        const bool changed = applyMetadata(item, std::move(result));
+        albumIn(it->second);
+        if (changed) {
+            updated.push_back(it->second);
+            toStore.push_back(libraryTrack(item, stamp));
+        }
+    }
+    
+    // Unchanged library tracks need neither a write nor a repaint
+    storeInLibrary(updated, std::move(toStore));
+    if (!updated.empty()) {
+        std::vector<usize> rows;
+        rows.reserve(updated.size());
+        for (ItemHandle handle : updated) rows.push_back(items_.indexOf(handle));
+        std::ranges::sort(rows);
+        itemsUpdated.emitSignal(rows);
+    }
+    if (!missing.empty()) removeMissing(missing);
+}
+
+usize Playlist::metadataPending() const {
+    return loader_ ? loader_->pending() : 0;
+}
+
+void Playlist::submitMetadata(std::vector<MetadataJob> jobs) {
+    if (jobs.empty()) return;
+    if (!loader_) {
+        loader_ = std::make_unique<MetadataLoader>();
+        loader_->resultsAvailable.connect([this] { metadataReady.emitSignal(); });
+    }
+    loader_->submit(std::move(jobs));
+}
+
+void Playlist::loadMetadataNow(ItemHandle handle) {
+    auto& item = items_.get(handle);
+    if (!item.metadataPending) return;
+    
+    // About to play: its tags and lyrics are needed now, not in a batch.
+    // For a library track that is a stat and a sidecar check.
+    MetadataJob job{item.id, item.path, std::nullopt};
+    if (item.libraryId != 0 && library_) {
+        if (auto known = library_->find({item.path}).front()) {
+            job.known = std::pair{known->size, known->mtime};
+        }
+    }
+    auto result = MetadataLoader::load(job);
+    if (!result.found) {
+        item.valid = false;
+        item.metadataPending = false;
+        itemsUpdated.emitSignal({items_.indexOf(handle)});
+        return;
+    }
+    const auto stamp = std::pair{result.size, result.mtime};
+    albumOut(handle);
+    const bool changed = applyMetadata(item, std::move(result));
+    albumIn(handle);
+    if (changed) {
+        storeInLibrary({handle}, {libraryTrack(item, stamp)});
+        itemsUpdated.emitSignal({items_.indexOf(handle)});
+    }
+}
+
+bool Playlist::applyMetadata(PlaylistItem& item, MetadataResult&& result) {
+    item.metadataPending = false;
+    if (result.unchanged) {
+        // Tags from the library still hold; only the sidecar may differ
+        if (item.lyricsPath == result.lyricsPath) return false;
+        item.lyricsPath = std::move(result.lyricsPath);
+        return true;
+    }
+    
+    // A loudness result may have been attached to the placeholder already
+    auto loudness = std::move(item.metadata.loudness);
+    item.metadata = std::move(result.metadata);
+    if (!item.metadata.loudness) item.metadata.loudness = std::move(loudness);
+    item.lyricsPath = std::move(result.lyricsPath);
+    return true;
+}
+
+LibraryTrack Playlist::libraryTrack(const PlaylistItem& item, std::pair<u64, i64> stamp) {
+    LibraryTrack track;
+    track.id = item.libraryId;
+    track.path = item.path;
+    track.size = stamp.first;
+    track.mtime = stamp.second;
+    track.metadata = item.metadata;
+    track.lyricsPath = item.lyricsPath;
+    return track;
+}
+
+void Playlist::storeInLibrary(const std::vector<ItemHandle>& handles, std::vector<LibraryTrack> tracks) {
+    if (!library_ || tracks.empty()) return;
+    // One transaction per batch
+    if (auto result = library_->store(tracks); !result) {
+        LOG_WARN("Media library: {}", result.error().message);
+        return;
+    }
+    for (usize i = 0; i < handles.size(); ++i) {
+        items_.get(handles[i]).libraryId = tracks[i].id;
+    }
+}
+
+void Playlist::removeMissing(const std::vector<ItemHandle>& handles) {
+    // Files that vanished since the playlist was saved; the synchronous
+    // loader used to skip these. Highest rows first, so each contiguous
+    // run goes out as one removal and lower rows don't shift meanwhile.
+    std::vector<usize> rows;
+    rows.reserve(handles.size());
+    for (ItemHandle handle : handles) rows.push_back(items_.indexOf(handle));
+    std::ranges::sort(rows, std::greater{});
+    
+    for (usize i = 0; i < rows.size();) {
+        usize end = i + 1;
+        while (end < rows.size() && rows[end] + 1 == rows[end - 1]) ++end;
+        for (usize k = i; k < end; ++k) {
+            eraseItem(items_.handleAt(rows[k]));
+        }
+        itemsRemoved.emitSignal(rows[end - 1], end - i);
+        i = end;
+    }
+    
+    changed.emitSignal();
+}
+
 } // namespace vc
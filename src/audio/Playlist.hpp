@@ -4,24 +4,37 @@
 
 #include "util/Types.hpp"
 #include "util/Signal.hpp"
-#include "analysis/MediaMetadata.hpp"
+#include "util/SequenceTree.hpp"
+#include "MediaLibrary.hpp"
+#include "analysis/MetadataLoader.hpp"
+#include <memory>
 #include <vector>
 #include <random>
 #include <optional>
+#include <unordered_map>
 
 namespace vc {
 
 struct PlaylistItem {
+    u64 id{0};  // Unique for the playlist's lifetime
+    i64 libraryId{0};  // MediaLibrary row, 0 if not indexed (yet)
     fs::path path;
     std::string url;
     bool isRemote{false};
     MediaMetadata metadata;
     std::string lyricsPath;  // Path to external .lrc file
     bool valid{true};
+    bool metadataPending{false};  // Placeholder until MetadataLoader reports
     // Helper to get title for fuzzy matching
     std::string title() const { return metadata.title.empty() ? path.stem().string() : metadata.title; }
 };
 
+// Duration-weighted power mean over an album's scanned, non-silent tracks
+struct AlbumLoudness {
+    f64 integratedLufs{LOUDNESS_SILENCE_LUFS};
+    f32 truePeakDbtp{-96.0f};
+};
+
 enum class RepeatMode {
     Off,
     One,
@@ -32,24 +45,45 @@ class Playlist {
 public:
     Playlist();
     
-    // Modification
+    // Optional. With a library, known files skip TagLib unless their size
+    // or mtime changed, and every read is recorded for next time.
+    void setLibrary(MediaLibrary* library) { library_ = library; }
+    
+    // Modification. Files are listed immediately, with their library tags
+    // or else their file name as title; tags, art and lyrics are read (or
+    // confirmed current) on a worker pool and published by
+    // applyPendingMetadata().
     void addFile(const fs::path& path);
     void addUrl(const std::string& url, const std::string& title = "");
     void addFiles(const std::vector<fs::path>& paths);
     void removeAt(usize index);
     void clear();
+    // O(log n); the current track and the shuffle order are unaffected
     void move(usize from, usize to);
+    // Attach a loudness scan result. Not a listed property, so no signal.
+    void setLoudness(usize index, const TrackLoudness& loudness);
+    void setLoudness(const fs::path& path, const TrackLoudness& loudness);
+    // A local item listing `path`; O(1)
+    const PlaylistItem* findLocal(const fs::path& path) const;
+    // Over the tracks sharing `item`'s album and artist; nullopt if none
+    // is scanned yet. Cached until a track of that album changes.
+    std::optional<AlbumLoudness> albumLoudness(const PlaylistItem& item) const;
     
     // Navigation
-    std::optional<usize> currentIndex() const { return currentIndex_; }
+    std::optional<usize> currentIndex() const;
     const PlaylistItem* currentItem() const;
     const PlaylistItem* itemAt(usize index) const;
     
     bool next();
+    // Index next() would move to, without moving. nullopt at the end, and
+    // when shuffle-repeat is about to draw a new order.
+    std::optional<usize> peekNext() const;
     bool previous();
     bool jumpTo(usize index);
     
-    // Playback modes
+    // Playback modes. The shuffle order is kept across edits: added tracks
+    // land at random among those not yet played, removed ones drop out,
+    // and moves don't touch it.
     bool shuffle() const { return shuffle_; }
     void setShuffle(bool enabled);
     
@@ -60,32 +94,91 @@ public:
     // Queries
     usize size() const { return items_.size(); }
     bool empty() const { return items_.empty(); }
-    const std::vector<PlaylistItem>& items() const { return items_; }
+    // In order; O(log n) to index, amortized O(1) per step to iterate
+    const SequenceTree<PlaylistItem>& items() const { return items_; }
     
     // Persistence
     Result<void> saveM3U(const fs::path& path) const;
     Result<void> loadM3U(const fs::path& path);
+    // Saved playlists in the library; load returns false if none is named so
+    Result<void> saveToLibrary(const std::string& name) const;
+    Result<bool> loadFromLibrary(const std::string& name);
+    
+    // Publish metadata loaded since the last call as one batch (owner's
+    // thread; schedule it from metadataReady)
+    void applyPendingMetadata();
+    usize metadataPending() const;
     
     // Signals
     Signal<> changed;
     Signal<usize> currentChanged;
-    Signal<usize> itemAdded;
-    Signal<usize> itemRemoved;
+    // Row-level edits, emitted after the fact and before `changed`
+    Signal<usize, usize> itemsAdded;  // first index, count; once per add call
+    Signal<usize, usize> itemsRemoved;  // first index, count
+    Signal<usize, usize> itemMoved;  // from, to
+    Signal<const std::vector<usize>&> itemsUpdated;  // metadata filled in
+    // Emitted from a loader thread when loaded metadata starts waiting
+    Signal<> metadataReady;
     
 private:
-    void regenerateShuffleOrder();
-    usize shuffleIndexToReal(usize shuffleIdx) const;
-    usize realIndexToShuffle(usize realIdx) const;
+    using ItemHandle = SequenceTree<PlaylistItem>::Handle;
+    using ShuffleHandle = SequenceTree<ItemHandle>::Handle;
+    static constexpr u32 NONE = SequenceTree<PlaylistItem>::NONE;
     
-    std::vector<PlaylistItem> items_;
-    std::optional<usize> currentIndex_;
+    // Full reshuffle; `first` (if set) leads and is the cursor
+    void regenerateShuffleOrder(ItemHandle first);
+    void shuffleIn(ItemHandle handle);
+    void shuffleOut(ItemHandle handle);
+    usize shuffleNextPosition() const;
+    void eraseItem(ItemHandle handle);
+    // byPath_/albums_ upkeep; albumOut/albumIn around tag changes
+    void indexItem(ItemHandle handle);
+    void unindexItem(ItemHandle handle);
+    void albumIn(ItemHandle handle);
+    void albumOut(ItemHandle handle);
+    void albumChanged(const PlaylistItem& item);
+    bool playCurrent();
+    PlaylistItem makeRemoteItem(const std::string& url, const std::string& title);
+    PlaylistItem makeLocalItem(const fs::path& path,
+                               std::optional<LibraryTrack> known,
+                               std::vector<MetadataJob>& jobs);
+    void appendBatch(std::vector<PlaylistItem> newItems, std::vector<MetadataJob> jobs);
+    void submitMetadata(std::vector<MetadataJob> jobs);
+    void loadMetadataNow(ItemHandle handle);
+    // False if nothing changed (library track confirmed as is)
+    static bool applyMetadata(PlaylistItem& item, MetadataResult&& result);
+    static LibraryTrack libraryTrack(const PlaylistItem& item, std::pair<u64, i64> stamp);
+    void storeInLibrary(const std::vector<ItemHandle>& handles, std::vector<LibraryTrack> tracks);
+    void removeMissing(const std::vector<ItemHandle>& handles);
     
+    SequenceTree<PlaylistItem> items_;
+    std::unordered_map<u64, ItemHandle> byId_;
+    ItemHandle current_{NONE};
+
+    // Local items by path (a file may be listed twice) and by album, so a
+    // loudness result or an album gain doesn't walk the whole playlist
+    struct Album {
+        std::vector<ItemHandle> tracks;
+        mutable bool stale{true};
+        mutable std::optional<AlbumLoudness> loudness;
+    };
+    std::unordered_map<std::string, std::vector<ItemHandle>> byPath_;
+    std::unordered_map<std::string, Album> albums_;
+    
+    // Item handles in play order; everything up to the cursor has been
+    // played this round (cursor NONE: nothing yet)
     bool shuffle_{false};
-    std::vector<usize> shuffleOrder_;
-    usize shufflePosition_{0};
+    SequenceTree<ItemHandle> shuffleOrder_;
+    std::vector<ShuffleHandle> shuffleSlot_;  // indexed by item handle
+    ShuffleHandle shuffleCursor_{NONE};
     
     RepeatMode repeatMode_{RepeatMode::Off};
     std::mt19937 rng_;
+    
+    u64 nextItemId_{1};
+    MediaLibrary* library_{nullptr};
+    // Last member: its threads stop before the rest is torn down
+    std::unique_ptr<MetadataLoader> loader_;
 };
 
 } // namespace vc
@@ -0,0 +1,187 @@
+#include "audio/analysis/AlbumArtStore.hpp"
+#include "audio/analysis/MediaMetadata.hpp"
+#include "core/Logger.hpp"
+#include "util/FileUtils.hpp"
+
+#include <format>
+
+namespace vc {
+
+namespace {
+constexpr int THUMBNAIL_QUALITY = 88;
+
+u64 fnv1a(const char* data, usize size) {
+    u64 hash = 0xcbf29ce484222325ull;
+    for (usize i = 0; i < size; ++i) {
+        hash ^= static_cast<u8>(data[i]);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+QImage scaleToThumbnail(const QImage& image) {
+    if (image.width() <= AlbumArtStore::THUMBNAIL_EDGE &&
+        image.height() <= AlbumArtStore::THUMBNAIL_EDGE)
+        return image;
+    return image.scaled(AlbumArtStore::THUMBNAIL_EDGE,
+                        AlbumArtStore::THUMBNAIL_EDGE,
+                        Qt::KeepAspectRatio,
+                        Qt::SmoothTransformation);
+}
+} // namespace
+
+AlbumArtStore& AlbumArtStore::instance() {
+    static AlbumArtStore instance(file::cacheDir() / "art");
+    return instance;
+}
+
+AlbumArtStore::AlbumArtStore(fs::path directory, usize budgetBytes)
+    : directory_(std::move(directory)), budget_(budgetBytes) {}
+
+ArtId AlbumArtStore::idFor(const QByteArray& encoded) {
+    const u64 hash = fnv1a(encoded.constData(), static_cast<usize>(encoded.size()));
+    return hash == 0 ? 1 : hash;
+}
+
+ArtId AlbumArtStore::intern(const QByteArray& encoded, const fs::path& source) {
+    if (encoded.isEmpty())
+        return 0;
+    const ArtId id = idFor(encoded);
+    {
+        std::lock_guard lock(mutex_);
+        // Claimed before decoding so concurrent sightings of the same
+        // cover (the rest of the album) return at once
+        if (!sources_.try_emplace(id, source).second)
+            return id;
+    }
+
+    std::error_code ec;
+    if (fs::exists(thumbnailPath(id), ec))
+        return id;
+
+    QImage full;
+    if (!full.loadFromData(encoded)) {
+        LOG_DEBUG("Undecodable album art in {}", source.filename().string());
+        std::lock_guard lock(mutex_);
+        sources_.erase(id);
+        return 0;
+    }
+    if (auto result = writeThumbnail(id, scaleToThumbnail(full)); !result)
+        LOG_WARN("Album art: {}", result.error().message);
+    return id;
+}
+
+void AlbumArtStore::adopt(ArtId id, const fs::path& source) {
+    if (id == 0)
+        return;
+    std::lock_guard lock(mutex_);
+    sources_.try_emplace(id, source);
+}
+
+std::optional<QImage> AlbumArtStore::thumbnail(ArtId id) {
+    if (id == 0)
+        return std::nullopt;
+    {
+        std::lock_guard lock(mutex_);
+        if (auto it = index_.find(id); it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->second;
+        }
+    }
+
+    QImage image;
+    if (!image.load(QString::fromStdString(thumbnailPath(id).string()))) {
+        // Not written yet, or the cache was cleared: rebuild from the track
+        auto full = fullSize(id);
+        if (!full)
+            return std::nullopt;
+        image = scaleToThumbnail(*full);
+        if (auto result = writeThumbnail(id, image); !result)
+            LOG_WARN("Album art: {}", result.error().message);
+    }
+
+    std::lock_guard lock(mutex_);
+    cache(id, image);
+    return image;
+}
+
+std::optional<QImage> AlbumArtStore::fullSize(ArtId id) {
+    fs::path source;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = sources_.find(id);
+        if (it == sources_.end())
+            return std::nullopt;
+        source = it->second;
+    }
+
+    const QByteArray encoded = MetadataReader::extractAlbumArtData(source);
+    if (encoded.isEmpty() || idFor(encoded) != id) {
+        // Retagged or gone since it was interned
+        LOG_DEBUG("Album art {:016x} no longer in {}", id, source.filename().string());
+        return std::nullopt;
+    }
+    QImage image;
+    if (!image.loadFromData(encoded))
+        return std::nullopt;
+    return image;
+}
+
+void AlbumArtStore::setBudget(usize bytes) {
+    std::lock_guard lock(mutex_);
+    budget_ = bytes;
+    trim();
+}
+
+usize AlbumArtStore::cachedBytes() const {
+    std::lock_guard lock(mutex_);
+    return bytes_;
+}
+
+usize AlbumArtStore::cachedThumbnails() const {
+    std::lock_guard lock(mutex_);
+    return lru_.size();
+}
+
+fs::path AlbumArtStore::thumbnailPath(ArtId id) const {
+    return directory_ / std::format("{:016x}.jpg", id);
+}
+
+Result<void> AlbumArtStore::writeThumbnail(ArtId id, const QImage& thumbnail) {
+    if (auto result = file::ensureDir(directory_); !result)
+        return result;
+    // Written aside and renamed so readers never see half a file
+    const fs::path path = thumbnailPath(id);
+    fs::path temp = path;
+    temp += ".tmp";
+    if (!thumbnail.save(QString::fromStdString(temp.string()), "JPG", THUMBNAIL_QUALITY))
+        return Result<void>::err("Cannot write " + temp.string());
+    std::error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec)
+        return Result<void>::err("Cannot write " + path.string() + ": " + ec.message());
+    return Result<void>::ok();
+}
+
+void AlbumArtStore::cache(ArtId id, QImage thumbnail) {
+    if (auto it = index_.find(id); it != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+    bytes_ += static_cast<usize>(thumbnail.sizeInBytes());
+    lru_.emplace_front(id, std::move(thumbnail));
+    index_[id] = lru_.begin();
+    trim();
+}
+
+void AlbumArtStore::trim() {
+    // Keep the newest entry even if it alone exceeds the budget
+    while (bytes_ > budget_ && lru_.size() > 1) {
+        auto& [id, image] = lru_.back();
+        bytes_ -= static_cast<usize>(image.sizeInBytes());
+        index_.erase(id);
+        lru_.pop_back();
+    }
+}
+
+} // namespace vc
@@ -0,0 +1,83 @@
+/**
+ * @file AlbumArtStore.hpp
+ * @brief Shared, content-addressed album art with a bounded thumbnail cache.
+ *
+ * Playlist items no longer carry a decoded cover each. MetadataReader hands
+ * the embedded (still encoded) picture to intern(), which hashes the bytes
+ * and returns an ArtId; every track of an album shares the same id and the
+ * item keeps just those 8 bytes.
+ *
+ * The first time an id is seen the picture is decoded once, scaled to a
+ * THUMBNAIL_EDGE px thumbnail and written to `<cacheDir>/art/<id>.jpg`,
+ * so later runs never decode the original for display. Thumbnails in use
+ * live in a byte-bounded LRU; full-size art is not kept at all and is
+ * re-read from a track that carries it on demand (fullSize()).
+ *
+ * @section Threads
+ * All methods are thread-safe. thumbnail() and fullSize() may touch the
+ * disk and decode; call them off the GUI thread (AlbumArtProvider does).
+ */
+
+#pragma once
+#include <QByteArray>
+#include <QImage>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include "util/Result.hpp"
+#include "util/Types.hpp"
+
+namespace vc {
+
+using ArtId = u64; // 0 = no art
+
+class AlbumArtStore {
+public:
+    static constexpr int THUMBNAIL_EDGE = 256;
+    static constexpr usize DEFAULT_BUDGET = 32 * 1024 * 1024;
+
+    // Process-wide store under <cacheDir>/art
+    static AlbumArtStore& instance();
+
+    explicit AlbumArtStore(fs::path directory, usize budgetBytes = DEFAULT_BUDGET);
+
+    AlbumArtStore(const AlbumArtStore&) = delete;
+    AlbumArtStore& operator=(const AlbumArtStore&) = delete;
+
+    // Register an encoded picture found in `source`; returns 0 if it
+    // can't be decoded. Only the first sighting of an id decodes.
+    ArtId intern(const QByteArray& encoded, const fs::path& source);
+    // Note where an id from an earlier run (e.g. the media library) can be
+    // re-read from, without reading it now
+    void adopt(ArtId id, const fs::path& source);
+
+    std::optional<QImage> thumbnail(ArtId id);
+    // Decoded from the source track each time; not cached
+    std::optional<QImage> fullSize(ArtId id);
+
+    void setBudget(usize bytes);
+    usize cachedBytes() const;
+    usize cachedThumbnails() const;
+
+    static ArtId idFor(const QByteArray& encoded);
+
+private:
+    fs::path thumbnailPath(ArtId id) const;
+    Result<void> writeThumbnail(ArtId id, const QImage& thumbnail);
+    void cache(ArtId id, QImage thumbnail); // requires mutex_
+    void trim();                            // requires mutex_
+
+    fs::path directory_;
+
+    mutable std::mutex mutex_;
+    usize budget_;
+    usize bytes_{0};
+    // Most recently used at the front
+    std::list<std::pair<ArtId, QImage>> lru_;
+    std::unordered_map<ArtId, std::list<std::pair<ArtId, QImage>>::iterator> index_;
+    // One track per cover to re-read full-size art from
+    std::unordered_map<ArtId, fs::path> sources_;
+};
+
+} // namespace vc
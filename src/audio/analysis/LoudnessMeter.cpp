@@ -0,0 +1,207 @@
+#include "audio/analysis/LoudnessMeter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace vc {
+
+namespace {
+constexpr u32 GATING_SUB_BLOCKS = 4;      // 400 ms
+constexpr u32 SHORT_TERM_SUB_BLOCKS = 30; // 3 s
+constexpr f64 ABSOLUTE_GATE_LUFS = -70.0;
+constexpr f64 RELATIVE_GATE_LU = -10.0;
+constexpr f64 RANGE_GATE_LU = -20.0;
+// Frames run through the true-peak interpolator per pass
+constexpr usize TRUE_PEAK_CHUNK = 256;
+
+f64 loudnessOf(f64 energy) {
+    return -0.691 + 10.0 * std::log10(energy);
+}
+f64 energyOf(f64 lufs) {
+    return std::pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+// Mean energy of the blocks above `gate` (and how many there were)
+std::pair<f64, usize> gatedMean(const std::vector<f64>& blocks, f64 gate) {
+    f64 sum = 0.0;
+    usize count = 0;
+    for (f64 e : blocks) {
+        if (e > gate) {
+            sum += e;
+            ++count;
+        }
+    }
+    return {count ? sum / static_cast<f64>(count) : 0.0, count};
+}
+} // namespace
+
+LoudnessMeter::LoudnessMeter(u32 sampleRate)
+    : sampleRate_(sampleRate), subBlockFrames_(std::max<u32>(sampleRate / 10, 1)) {
+    // K-weighting for any rate (BS.1770 gives 48 kHz coefficients; these
+    // are the analog prototypes they were derived from)
+    const f64 rate = static_cast<f64>(sampleRate);
+    {
+        constexpr f64 f0 = 1681.974450955533;
+        constexpr f64 gainDb = 3.999843853973347;
+        constexpr f64 q = 0.7071752369554196;
+        const f64 k = std::tan(std::numbers::pi * f0 / rate);
+        const f64 vh = std::pow(10.0, gainDb / 20.0);
+        const f64 vb = std::pow(vh, 0.4996667741545416);
+        const f64 a0 = 1.0 + k / q + k * k;
+        kWeighting_[0] = {(vh + vb * k / q + k * k) / a0,
+                          2.0 * (k * k - vh) / a0,
+                          (vh - vb * k / q + k * k) / a0,
+                          2.0 * (k * k - 1.0) / a0,
+                          (1.0 - k / q + k * k) / a0};
+    }
+    {
+        constexpr f64 f0 = 38.13547087602444;
+        constexpr f64 q = 0.5003270373238773;
+        const f64 k = std::tan(std::numbers::pi * f0 / rate);
+        const f64 a0 = 1.0 + k / q + k * k;
+        kWeighting_[1] = {1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+    }
+
+    // Windowed-sinc interpolator; phase 0 passes samples through, phases
+    // 1..3 sit 1/4, 1/2 and 3/4 of a sample later. Taps are stored
+    // oldest-first so each phase is a plain dot product over the history.
+    constexpr u32 length = TRUE_PEAK_PHASES * TRUE_PEAK_TAPS;
+    constexpr f64 center = length / 2;
+    for (u32 phase = 0; phase < TRUE_PEAK_PHASES; ++phase) {
+        std::array<f64, TRUE_PEAK_TAPS> h{};
+        f64 sum = 0.0;
+        for (u32 j = 0; j < TRUE_PEAK_TAPS; ++j) {
+            const f64 k = static_cast<f64>(phase + j * TRUE_PEAK_PHASES);
+            const f64 x = (k - center) / TRUE_PEAK_PHASES;
+            const f64 sinc =
+                    x == 0.0 ? 1.0 : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+            const f64 w = 2.0 * std::numbers::pi * k / length;
+            const f64 blackman = 0.42 - 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w);
+            h[j] = sinc * blackman;
+            sum += h[j];
+        }
+        f32 bound = 0.0f;
+        for (u32 j = 0; j < TRUE_PEAK_TAPS; ++j) {
+            const f32 tap = static_cast<f32>(h[j] / sum);
+            taps_[phase * TRUE_PEAK_TAPS + (TRUE_PEAK_TAPS - 1 - j)] = tap;
+            bound += std::abs(tap);
+        }
+        tapGainBound_ = std::max(tapGainBound_, bound);
+    }
+    for (auto& history : history_)
+        history.assign(TRUE_PEAK_TAPS - 1, 0.0f);
+}
+
+void LoudnessMeter::add(const f32* stereo, usize frames) {
+    addTruePeak(stereo, frames);
+
+    for (usize i = 0; i < frames; ++i) {
+        f64 power = 0.0;
+        for (usize ch = 0; ch < 2; ++ch) {
+            f64 x = stereo[i * 2 + ch];
+            for (usize stage = 0; stage < 2; ++stage) {
+                const Biquad& f = kWeighting_[stage];
+                auto& z = state_[ch][stage];
+                const f64 y = f.b0 * x + z[0];
+                z[0] = f.b1 * x - f.a1 * y + z[1];
+                z[1] = f.b2 * x - f.a2 * y;
+                x = y;
+            }
+            power += x * x;
+        }
+        subBlockSum_ += power;
+        if (++subBlockFill_ == subBlockFrames_)
+            endSubBlock();
+    }
+    frames_ += frames;
+}
+
+void LoudnessMeter::endSubBlock() {
+    subBlocks_.push_back(subBlockSum_ / subBlockFrames_);
+    subBlockSum_ = 0.0;
+    subBlockFill_ = 0;
+
+    auto meanOfLast = [this](usize count) {
+        f64 sum = 0.0;
+        for (auto it = subBlocks_.end() - static_cast<std::ptrdiff_t>(count); it != subBlocks_.end(); ++it)
+            sum += *it;
+        return sum / static_cast<f64>(count);
+    };
+    if (subBlocks_.size() >= GATING_SUB_BLOCKS)
+        gating_.push_back(meanOfLast(GATING_SUB_BLOCKS));
+    if (subBlocks_.size() >= SHORT_TERM_SUB_BLOCKS)
+        shortTerm_.push_back(meanOfLast(SHORT_TERM_SUB_BLOCKS));
+}
+
+void LoudnessMeter::addTruePeak(const f32* stereo, usize frames) {
+    constexpr usize keep = TRUE_PEAK_TAPS - 1;
+    for (usize offset = 0; offset < frames; offset += TRUE_PEAK_CHUNK) {
+        const usize n = std::min(TRUE_PEAK_CHUNK, frames - offset);
+        for (usize ch = 0; ch < 2; ++ch) {
+            auto& buffer = history_[ch];
+            buffer.resize(keep + n);
+            f32 maxAbs = 0.0f;
+            for (usize i = 0; i < n; ++i) {
+                buffer[keep + i] = stereo[(offset + i) * 2 + ch];
+            }
+            for (f32 x : buffer)
+                maxAbs = std::max(maxAbs, std::abs(x));
+
+            // No interpolated value can exceed the window peak times the
+            // filter's absolute sum; most of a track never gets close
+            if (maxAbs * tapGainBound_ > truePeak_) {
+                f32 peak = truePeak_;
+                for (usize i = 0; i < n; ++i) {
+                    const f32* window = buffer.data() + i;
+                    for (u32 phase = 0; phase < TRUE_PEAK_PHASES; ++phase) {
+                        const f32* tap = taps_.data() + phase * TRUE_PEAK_TAPS;
+                        f32 y = 0.0f;
+                        for (u32 j = 0; j < TRUE_PEAK_TAPS; ++j)
+                            y += tap[j] * window[j];
+                        peak = std::max(peak, std::abs(y));
+                    }
+                }
+                truePeak_ = peak;
+            }
+            std::copy(buffer.end() - keep, buffer.end(), buffer.begin());
+            buffer.resize(keep);
+        }
+    }
+}
+
+TrackLoudness LoudnessMeter::result() const {
+    TrackLoudness result;
+    result.durationSec = static_cast<f32>(static_cast<f64>(frames_) / sampleRate_);
+    result.truePeakDbtp =
+            truePeak_ > 0.0f ? std::max(20.0f * std::log10(truePeak_), -96.0f) : -96.0f;
+
+    const f64 absoluteGate = energyOf(ABSOLUTE_GATE_LUFS);
+    const auto [ungated, above] = gatedMean(gating_, absoluteGate);
+    if (above > 0) {
+        const f64 gate = std::max(absoluteGate, ungated * std::pow(10.0, RELATIVE_GATE_LU / 10.0));
+        const auto [gated, count] = gatedMean(gating_, gate);
+        if (count > 0)
+            result.integratedLufs = static_cast<f32>(loudnessOf(gated));
+    }
+
+    const auto [shortMean, shortAbove] = gatedMean(shortTerm_, absoluteGate);
+    if (shortAbove > 0) {
+        const f64 gate = std::max(absoluteGate, shortMean * std::pow(10.0, RANGE_GATE_LU / 10.0));
+        std::vector<f64> levels;
+        for (f64 e : shortTerm_) {
+            if (e > gate)
+                levels.push_back(loudnessOf(e));
+        }
+        if (levels.size() >= 2) {
+            std::sort(levels.begin(), levels.end());
+            const f64 last = static_cast<f64>(levels.size() - 1);
+            const f64 low = levels[static_cast<usize>(std::lround(last * 0.10))];
+            const f64 high = levels[static_cast<usize>(std::lround(last * 0.95))];
+            result.rangeLu = static_cast<f32>(high - low);
+        }
+    }
+    return result;
+}
+
+} // namespace vc
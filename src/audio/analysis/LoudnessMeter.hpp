@@ -0,0 +1,74 @@
+/**
+ * @file LoudnessMeter.hpp
+ * @brief ITU-R BS.1770-4 / EBU R128 loudness measurement of stereo PCM.
+ *
+ * Feed a whole track through add() and read result():
+ * - Integrated loudness: K-weighted mean square over 400 ms blocks (75%
+ *   overlap), gated at -70 LUFS and then 10 LU below the ungated mean.
+ * - Loudness range (EBU Tech 3342): spread between the 10th and 95th
+ *   percentile of 3 s short-term loudness, gated at -70 LUFS and 20 LU
+ *   below their mean.
+ * - True peak: 4x polyphase oversampling, skipped for stretches that
+ *   provably can't beat the current peak.
+ *
+ * Energy is accumulated in 100 ms sub-blocks, so memory grows by two
+ * doubles per 100 ms of audio.
+ */
+
+#pragma once
+#include <array>
+#include <vector>
+#include "util/Types.hpp"
+
+namespace vc {
+
+// Reported for tracks with nothing above the absolute gate
+inline constexpr f32 LOUDNESS_SILENCE_LUFS = -70.0f;
+
+struct TrackLoudness {
+    f32 integratedLufs{LOUDNESS_SILENCE_LUFS};
+    f32 truePeakDbtp{-96.0f};
+    f32 rangeLu{0.0f};
+    f32 durationSec{0.0f};
+};
+
+class LoudnessMeter {
+public:
+    explicit LoudnessMeter(u32 sampleRate);
+
+    // Interleaved stereo
+    void add(const f32* stereo, usize frames);
+    TrackLoudness result() const;
+
+    static constexpr u32 TRUE_PEAK_PHASES = 4;
+    static constexpr u32 TRUE_PEAK_TAPS = 16; // per phase
+
+private:
+    struct Biquad {
+        f64 b0, b1, b2, a1, a2;
+    };
+
+    void endSubBlock();
+    void addTruePeak(const f32* stereo, usize frames);
+
+    u32 sampleRate_;
+    std::array<Biquad, 2> kWeighting_; // high shelf, then high pass
+    // Filter state [channel][stage]: z1, z2 (transposed direct form II)
+    std::array<std::array<std::array<f64, 2>, 2>, 2> state_{};
+
+    u32 subBlockFrames_;
+    u32 subBlockFill_{0};
+    f64 subBlockSum_{0.0};
+    u64 frames_{0};
+    std::vector<f64> subBlocks_;  // mean square per 100 ms, both channels summed
+    std::vector<f64> gating_;     // 400 ms blocks
+    std::vector<f64> shortTerm_;  // 3 s blocks, every 100 ms
+
+    // Polyphase interpolator, phase-major
+    std::array<f32, TRUE_PEAK_PHASES * TRUE_PEAK_TAPS> taps_{};
+    f32 tapGainBound_{0.0f}; // max over phases of sum |tap|
+    std::array<std::vector<f32>, 2> history_; // deinterleaved, TAPS - 1 + chunk
+    f32 truePeak_{0.0f};
+};
+
+} // namespace vc
@@ -0,0 +1,251 @@
+#include "audio/analysis/LoudnessScanner.hpp"
+#include "audio/AudioDecoder.hpp"
+#include "core/Logger.hpp"
+#include "util/FileUtils.hpp"
+
+#include <charconv>
+#include <format>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace vc {
+
+namespace {
+// BS.1770 is defined at 48 kHz; true peak is measured after resampling
+constexpr u32 SCAN_RATE = 48000;
+constexpr usize READ_FRAMES = 8192;
+// Workers yield to playback, rendering and the GUI
+constexpr int WORKER_NICE = 10;
+constexpr std::string_view JOURNAL_HEADER = "# chadvis loudness v1";
+
+bool isLocal(const fs::path& track) {
+    return !track.empty() && track.native().find("://") == std::string::npos;
+}
+
+// size, mtime, integrated, true peak, range, duration, path
+std::string journalLine(const std::string& key, u64 size, i64 mtime, const TrackLoudness& l) {
+    return std::format("{}\t{}\t{:.2f}\t{:.2f}\t{:.2f}\t{:.3f}\t{}\n",
+                       size, mtime, l.integratedLufs, l.truePeakDbtp, l.rangeLu, l.durationSec, key);
+}
+
+template <typename T>
+bool parseField(std::string_view& line, T& value) {
+    const auto tab = line.find('\t');
+    if (tab == std::string_view::npos)
+        return false;
+    const auto field = line.substr(0, tab);
+    line.remove_prefix(tab + 1);
+    return std::from_chars(field.data(), field.data() + field.size(), value).ec == std::errc{};
+}
+} // namespace
+
+LoudnessScanner::~LoudnessScanner() {
+    stop();
+}
+
+void LoudnessScanner::start(fs::path journal, u32 threads) {
+    stop();
+    journalPath_ = std::move(journal);
+    loadJournal();
+
+    if (threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (u32 i = 0; i < threads; ++i)
+        threads_.emplace_back([this](std::stop_token stop) { worker(stop); });
+    LOG_DEBUG("Loudness scanner: {} workers, {} tracks known", threads, entries_.size());
+}
+
+void LoudnessScanner::stop() {
+    for (auto& thread : threads_)
+        thread.request_stop();
+    wake_.notify_all();
+    threads_.clear(); // joins
+    journal_.close();
+}
+
+void LoudnessScanner::enqueue(const std::vector<fs::path>& tracks, bool urgent) {
+    usize added = 0;
+    {
+        std::lock_guard lock(mutex_);
+        for (const auto& track : tracks) {
+            if (!isLocal(track))
+                continue;
+            if (!queued_.insert(track.string()).second) {
+                if (urgent) {
+                    std::erase(queue_, track);
+                    queue_.push_front(track);
+                }
+                continue;
+            }
+            if (queue_.empty() && active_ == 0) {
+                batchStart_ = chr::steady_clock::now();
+                batchMeasured_ = 0;
+            }
+            if (urgent)
+                queue_.push_front(track);
+            else
+                queue_.push_back(track);
+            ++added;
+        }
+    }
+    if (added == 1)
+        wake_.notify_one();
+    else if (added > 1)
+        wake_.notify_all();
+}
+
+std::optional<TrackLoudness> LoudnessScanner::find(const fs::path& track) const {
+    std::lock_guard lock(mutex_);
+    auto it = entries_.find(track.string());
+    if (it == entries_.end())
+        return std::nullopt;
+    return it->second.loudness;
+}
+
+usize LoudnessScanner::pending() const {
+    std::lock_guard lock(mutex_);
+    return queue_.size() + active_;
+}
+
+Result<TrackLoudness> LoudnessScanner::measure(const fs::path& track, std::stop_token stop) {
+    AudioDecoder decoder;
+    if (auto result = decoder.open(track, SCAN_RATE, 2); !result)
+        return Result<TrackLoudness>::err(result.error());
+
+    LoudnessMeter meter(SCAN_RATE);
+    std::vector<f32> pcm(READ_FRAMES * 2);
+    while (!stop.stop_requested()) {
+        const usize n = decoder.read(pcm.data(), READ_FRAMES);
+        if (n == 0)
+            break;
+        meter.add(pcm.data(), n);
+    }
+    if (stop.stop_requested())
+        return Result<TrackLoudness>::err("Cancelled");
+    return Result<TrackLoudness>::ok(meter.result());
+}
+
+void LoudnessScanner::worker(std::stop_token stop) {
+#ifdef __linux__
+    setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), WORKER_NICE);
+#endif
+
+    while (!stop.stop_requested()) {
+        fs::path track;
+        std::optional<Entry> known;
+        bool failedBefore = false;
+        {
+            std::unique_lock lock(mutex_);
+            if (!wake_.wait(lock, stop, [this] { return !queue_.empty(); }))
+                return;
+            track = std::move(queue_.front());
+            queue_.pop_front();
+            const std::string key = track.string();
+            queued_.erase(key);
+            if (auto it = entries_.find(key); it != entries_.end())
+                known = it->second;
+            failedBefore = failed_.contains(key);
+            ++active_;
+        }
+
+        const auto stamp = file::stamp(track);
+        const bool fresh = stamp && known && known->size == stamp->first &&
+                           known->mtime == stamp->second;
+        bool measured = false;
+        if (stamp && !fresh && !failedBefore) {
+            if (auto result = measure(track, stop)) {
+                const Entry entry{stamp->first, stamp->second, result.value()};
+                record(track.string(), entry);
+                ready.emitSignal(track, entry.loudness);
+                measured = true;
+            } else if (!stop.stop_requested()) {
+                LOG_WARN("Loudness scan failed for {}: {}",
+                         track.filename().string(),
+                         result.error().message);
+                std::lock_guard lock(mutex_);
+                failed_.insert(track.string());
+            }
+        }
+
+        std::lock_guard lock(mutex_);
+        --active_;
+        if (measured)
+            ++batchMeasured_;
+        if (queue_.empty() && active_ == 0 && batchMeasured_ > 0) {
+            const auto ms = chr::duration_cast<chr::milliseconds>(chr::steady_clock::now() -
+                                                                  batchStart_)
+                                    .count();
+            LOG_INFO("Loudness scan: measured {} tracks in {:.1f} s", batchMeasured_, ms / 1000.0);
+            batchMeasured_ = 0;
+        }
+    }
+}
+
+void LoudnessScanner::loadJournal() {
+    std::lock_guard lock(mutex_);
+    entries_.clear();
+    usize lines = 0;
+    bool tornTail = false;
+    if (auto text = file::readText(journalPath_)) {
+        std::string_view rest = text.value();
+        while (!rest.empty()) {
+            const auto end = rest.find('\n');
+            if (end == std::string_view::npos) {
+                tornTail = true; // crashed mid-line
+                break;
+            }
+            std::string_view line = rest.substr(0, end);
+            rest.remove_prefix(end + 1);
+            if (line.empty() || line.front() == '#')
+                continue;
+
+            Entry entry;
+            auto& l = entry.loudness;
+            if (!parseField(line, entry.size) || !parseField(line, entry.mtime) ||
+                !parseField(line, l.integratedLufs) || !parseField(line, l.truePeakDbtp) ||
+                !parseField(line, l.rangeLu) || !parseField(line, l.durationSec) || line.empty()) {
+                continue;
+            }
+            entries_[std::string(line)] = entry; // later lines win
+            ++lines;
+        }
+    }
+
+    // Rewrite once superseded lines dominate, then append from there
+    if (lines > entries_.size() * 2 + 64) {
+        std::string compact = std::string(JOURNAL_HEADER) + '\n';
+        for (const auto& [key, entry] : entries_) {
+            compact += journalLine(key, entry.size, entry.mtime, entry.loudness);
+        }
+        if (auto result = file::writeText(journalPath_, compact); !result)
+            LOG_WARN("Loudness journal compaction failed: {}", result.error().message);
+    }
+
+    const bool existed = fs::exists(journalPath_);
+    if (!existed) {
+        if (auto result = file::ensureDir(journalPath_.parent_path()); !result)
+            LOG_WARN("Loudness journal: {}", result.error().message);
+    }
+    journal_.open(journalPath_, std::ios::app);
+    if (!journal_)
+        LOG_WARN("Cannot open loudness journal {}; results won't persist", journalPath_.string());
+    else if (!existed)
+        journal_ << JOURNAL_HEADER << '\n';
+    else if (tornTail)
+        journal_ << '\n';
+}
+
+void LoudnessScanner::record(const std::string& key, const Entry& entry) {
+    std::lock_guard lock(mutex_);
+    entries_[key] = entry;
+    failed_.erase(key);
+    if (!journal_)
+        return;
+    // One flushed line per track: a crash loses at most the line being written
+    journal_ << journalLine(key, entry.size, entry.mtime, entry.loudness) << std::flush;
+}
+
+} // namespace vc
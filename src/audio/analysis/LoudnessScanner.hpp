@@ -0,0 +1,93 @@
+/**
+ * @file LoudnessScanner.hpp
+ * @brief Parallel EBU R128 scan of local tracks, kept in a resumable journal.
+ *
+ * enqueue() hands tracks to a pool of worker threads (one per core by
+ * default, at lowered priority so playback and rendering keep theirs).
+ * Each worker decodes a whole file with AudioDecoder at 48 kHz and runs it
+ * through a LoudnessMeter.
+ *
+ * Every result is appended to a tab-separated journal as soon as it is
+ * measured, keyed by path with the file's size and mtime. On the next
+ * start the journal is loaded and tracks whose size and mtime still match
+ * are skipped, so an interrupted scan picks up where it stopped and a
+ * re-scan of an unchanged library costs one stat() per file.
+ *
+ * @section Threads
+ * - enqueue()/find(): any thread.
+ * - ready: emitted from a worker thread.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "audio/analysis/LoudnessMeter.hpp"
+#include "util/Result.hpp"
+#include "util/Signal.hpp"
+#include "util/Types.hpp"
+
+namespace vc {
+
+class LoudnessScanner {
+public:
+    LoudnessScanner() = default;
+    ~LoudnessScanner();
+
+    LoudnessScanner(const LoudnessScanner&) = delete;
+    LoudnessScanner& operator=(const LoudnessScanner&) = delete;
+
+    // Load `journal` and start `threads` workers (0 = one per core)
+    void start(fs::path journal, u32 threads = 0);
+    void stop();
+
+    // Queue local files; tracks unchanged since their last scan are
+    // skipped. Urgent ones go to the front (the track about to play).
+    void enqueue(const std::vector<fs::path>& tracks, bool urgent = false);
+    // Last known result, possibly for an older version of the file
+    std::optional<TrackLoudness> find(const fs::path& track) const;
+    usize pending() const;
+
+    // Decode and measure one file (the workers' job, usable directly)
+    static Result<TrackLoudness> measure(const fs::path& track, std::stop_token stop = {});
+
+    // A track was (re)measured
+    Signal<const fs::path&, const TrackLoudness&> ready;
+
+private:
+    struct Entry {
+        u64 size{0};
+        i64 mtime{0};
+        TrackLoudness loudness;
+    };
+
+    void worker(std::stop_token stop);
+    void loadJournal();
+    void record(const std::string& key, const Entry& entry);
+
+    fs::path journalPath_;
+    std::ofstream journal_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable_any wake_;
+    std::deque<fs::path> queue_;
+    std::unordered_set<std::string> queued_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::unordered_set<std::string> failed_;
+    usize active_{0};
+
+    // Current burst of work, for the summary log line
+    chr::steady_clock::time_point batchStart_;
+    usize batchMeasured_{0};
+
+    std::vector<std::jthread> threads_;
+};
+
+} // namespace vc
@@ -96,8 +96,8 @@ Result<MediaMetadata> MetadataReader::read(const fs::path& path) {
         meta.title = path.stem().string();
     }
     
-    // Try to extract album art
-    meta.albumArt = extractAlbumArt(path);
+    // Album art is kept once per cover, not per track
+    meta.artId = AlbumArtStore::instance().intern(extractAlbumArtData(path), path);
     
     LOG_DEBUG("Read metadata for: {} - {}", meta.artist, meta.title);
     return Result<MediaMetadata>::ok(std::move(meta));
@@ -109,7 +109,7 @@ bool MetadataReader::canRead(const fs::path& path) {
     return file::audioExtensions.contains(ext);
 }
 
-std::optional<QPixmap> MetadataReader::extractAlbumArt(const fs::path& path) {
+QByteArray MetadataReader::extractAlbumArtData(const fs::path& path) {
     auto ext = path.extension().string();
     std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
     
@@ -121,13 +121,9 @@ std::optional<QPixmap> MetadataReader::extractAlbumArt(const fs::path& path) {
             auto frames = tag->frameListMap()["APIC"];
             if (!frames.isEmpty()) {
                 auto* pic = dynamic_cast<TagLib::ID3v2::AttachedPictureFrame*>(frames.front());
-                if (pic) {
-                    QPixmap pixmap;
-                    if (pixmap.loadFromData(
-                        reinterpret_cast<const uchar*>(pic->picture().data()),
-                        pic->picture().size())) {
-                        return pixmap;
-                    }
+                if (pic && !pic->picture().isEmpty()) {
+                    return QByteArray(pic->picture().data(),
+                                      static_cast<qsizetype>(pic->picture().size()));
                 }
             }
         }
@@ -140,17 +136,15 @@ std::optional<QPixmap> MetadataReader::extractAlbumArt(const fs::path& path) {
             auto pictures = flacFile.pictureList();
             if (!pictures.isEmpty()) {
                 auto* pic = pictures.front();
-                QPixmap pixmap;
-                if (pixmap.loadFromData(
-                    reinterpret_cast<const uchar*>(pic->data().data()),
-                    pic->data().size())) {
-                    return pixmap;
+                if (!pic->data().isEmpty()) {
+                    return QByteArray(pic->data().data(),
+                                      static_cast<qsizetype>(pic->data().size()));
                 }
             }
         }
     }
     
-    return std::nullopt;
+    return {};
 }
 
 } // namespace vc
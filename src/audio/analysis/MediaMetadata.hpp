@@ -4,7 +4,9 @@
 
 #include "util/Types.hpp"
 #include "util/Result.hpp"
-#include <QPixmap>
+#include "AlbumArtStore.hpp"
+#include "LoudnessMeter.hpp"
+#include <QByteArray>
 
 namespace vc {
 
@@ -20,7 +22,8 @@ struct MediaMetadata {
     u32 sampleRate{0};      // Hz
     u32 channels{0};
     std::string sunoClipId; // Optional: Link to Suno Clip
-    std::optional<QPixmap> albumArt;
+    ArtId artId{0};         // Cover in AlbumArtStore, shared across the album
+    std::optional<TrackLoudness> loudness; // Filled in by LoudnessScanner
     
     // Formatted display strings
     std::string displayTitle() const;
@@ -33,9 +36,8 @@ class MetadataReader {
 public:
     static Result<MediaMetadata> read(const fs::path& path);
     static bool canRead(const fs::path& path);
-    
-private:
-    static std::optional<QPixmap> extractAlbumArt(const fs::path& path);
+    // Embedded cover, still encoded; empty if there is none
+    static QByteArray extractAlbumArtData(const fs::path& path);
 };
 
 } // namespace vc
@@ -0,0 +1,108 @@
+#include "MetadataLoader.hpp"
+#include "core/Logger.hpp"
+#include "util/FileUtils.hpp"
+
+namespace vc {
+
+MetadataLoader::MetadataLoader(u32 threads) {
+    if (threads == 0) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    for (u32 i = 0; i < threads; ++i) {
+        threads_.emplace_back([this](std::stop_token stop) { worker(stop); });
+    }
+}
+
+MetadataLoader::~MetadataLoader() {
+    for (auto& thread : threads_) {
+        thread.request_stop();
+    }
+    wake_.notify_all();
+    threads_.clear(); // joins
+}
+
+void MetadataLoader::submit(std::vector<MetadataJob> jobs) {
+    if (jobs.empty()) return;
+    {
+        std::lock_guard lock(mutex_);
+        for (auto& job : jobs) {
+            queue_.push_back(std::move(job));
+        }
+    }
+    wake_.notify_all();
+}
+
+void MetadataLoader::cancelAll() {
+    std::lock_guard lock(mutex_);
+    queue_.clear();
+}
+
+std::vector<MetadataResult> MetadataLoader::takeResults() {
+    std::lock_guard lock(mutex_);
+    return std::exchange(results_, {});
+}
+
+usize MetadataLoader::pending() const {
+    std::lock_guard lock(mutex_);
+    return queue_.size() + running_ + results_.size();
+}
+
+MetadataResult MetadataLoader::load(const MetadataJob& job) {
+    MetadataResult result;
+    result.id = job.id;
+
+    const auto stamp = file::stamp(job.path);
+    if (!stamp) {
+        LOG_WARN("File not found: {}", job.path.string());
+        result.found = false;
+        return result;
+    }
+    result.size = stamp->first;
+    result.mtime = stamp->second;
+
+    if (job.known == stamp) {
+        result.unchanged = true;
+    } else if (auto metaResult = MetadataReader::read(job.path)) {
+        result.metadata = std::move(*metaResult);
+    } else {
+        LOG_WARN("Failed to read metadata: {}", metaResult.error().message);
+        result.metadata.title = job.path.stem().string();
+    }
+
+    // Check for matching LRC file (external lyrics with timing). Looked up
+    // even for unchanged tracks: a sidecar can appear on its own.
+    std::error_code ec;
+    fs::path lrcPath = job.path;
+    lrcPath.replace_extension(".lrc");
+    if (fs::exists(lrcPath, ec)) {
+        result.lyricsPath = lrcPath.string();
+        LOG_DEBUG("Found lyrics file: {}", lrcPath.string());
+    }
+    return result;
+}
+
+void MetadataLoader::worker(std::stop_token stop) {
+    while (!stop.stop_requested()) {
+        MetadataJob job;
+        {
+            std::unique_lock lock(mutex_);
+            if (!wake_.wait(lock, stop, [this] { return !queue_.empty(); })) return;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+            ++running_;
+        }
+
+        auto result = load(job);
+
+        bool first = false;
+        {
+            std::lock_guard lock(mutex_);
+            --running_;
+            first = results_.empty();
+            results_.push_back(std::move(result));
+        }
+        if (first) resultsAvailable.emitSignal();
+    }
+}
+
+} // namespace vc
@@ -0,0 +1,75 @@
+#pragma once
+// MetadataLoader.hpp - Reads track metadata on a worker pool
+//
+// Playlist inserts placeholders right away and submits them here; workers
+// run MetadataReader (TagLib, embedded art, .lrc sidecar lookup) off the
+// GUI thread and collect results until the owner takes them as one batch.
+// resultsAvailable fires once per batch, when the first result lands in an
+// empty buffer, so the owner can schedule a single drain.
+
+#include "MediaMetadata.hpp"
+#include "util/Signal.hpp"
+#include "util/Types.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace vc {
+
+struct MetadataJob {
+    u64 id{0}; // caller's key for the item
+    fs::path path;
+    // Size and mtime the caller already has tags for; if the file still
+    // matches, only the sidecar lookup runs
+    std::optional<std::pair<u64, i64>> known;
+};
+
+struct MetadataResult {
+    u64 id{0};
+    bool found{true};      // false if the file no longer exists
+    bool unchanged{false}; // matched job.known; metadata left empty
+    u64 size{0};
+    i64 mtime{0};
+    MediaMetadata metadata;
+    std::string lyricsPath;
+};
+
+class MetadataLoader {
+public:
+    // threads = 0: one per core
+    explicit MetadataLoader(u32 threads = 0);
+    ~MetadataLoader();
+
+    MetadataLoader(const MetadataLoader&) = delete;
+    MetadataLoader& operator=(const MetadataLoader&) = delete;
+
+    void submit(std::vector<MetadataJob> jobs);
+    // Drop queued jobs; ones already running still report
+    void cancelAll();
+    std::vector<MetadataResult> takeResults();
+    // Queued, running, or finished but not yet taken
+    usize pending() const;
+
+    // Blocking read of one file, as the workers do it
+    static MetadataResult load(const MetadataJob& job);
+
+    // Worker thread
+    Signal<> resultsAvailable;
+
+private:
+    void worker(std::stop_token stop);
+
+    mutable std::mutex mutex_;
+    std::condition_variable_any wake_;
+    std::deque<MetadataJob> queue_;
+    usize running_{0};
+    std::vector<MetadataResult> results_;
+
+    std::vector<std::jthread> threads_;
+};
+
+} // namespace vc
@@ -0,0 +1,197 @@
+#include "audio/analysis/TrackAnalysisCache.hpp"
+#include "audio/AudioDecoder.hpp"
+#include "core/Logger.hpp"
+
+#include <chrono>
+#include <format>
+#include <fstream>
+
+namespace vc {
+
+namespace {
+constexpr usize HASH_SAMPLE_BYTES = 256 * 1024;
+// Mapped timelines kept around (current, next, a few recent)
+constexpr usize MAX_LOADED = 16;
+
+bool isLocal(const fs::path& track) {
+    return !track.empty() && track.native().find("://") == std::string::npos;
+}
+
+// FNV-1a, 64 bit
+u64 fnv1a(u64 hash, const u8* data, usize size) {
+    for (usize i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+} // namespace
+
+TrackAnalysisCache::~TrackAnalysisCache() {
+    stop();
+}
+
+void TrackAnalysisCache::start(fs::path directory, const AnalyzerSettings& settings, u32 sampleRate) {
+    stop();
+    directory_ = std::move(directory);
+    settings_ = settings;
+    sampleRate_ = sampleRate;
+    thread_ = std::jthread([this](std::stop_token stop) { worker(stop); });
+}
+
+void TrackAnalysisCache::stop() {
+    if (thread_.joinable()) {
+        thread_.request_stop();
+        wake_.notify_all();
+        thread_.join();
+    }
+}
+
+void TrackAnalysisCache::request(const fs::path& track, bool urgent) {
+    if (!isLocal(track))
+        return;
+    {
+        std::lock_guard lock(mutex_);
+        const std::string key = track.string();
+        if (timelines_.contains(key) || failed_.contains(key))
+            return;
+        std::erase(queue_, track);
+        if (urgent)
+            queue_.push_front(track);
+        else
+            queue_.push_back(track);
+    }
+    wake_.notify_one();
+}
+
+std::shared_ptr<const TrackTimeline> TrackAnalysisCache::find(const fs::path& track) const {
+    std::lock_guard lock(mutex_);
+    auto it = timelines_.find(track.string());
+    return it != timelines_.end() ? it->second : nullptr;
+}
+
+Result<u64> TrackAnalysisCache::contentHash(const fs::path& path) {
+    std::error_code ec;
+    const u64 size = fs::file_size(path, ec);
+    if (ec)
+        return Result<u64>::err("Cannot stat " + path.string() + ": " + ec.message());
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return Result<u64>::err("Cannot read " + path.string());
+
+    u64 hash = fnv1a(0xcbf29ce484222325ull, reinterpret_cast<const u8*>(&size), sizeof(size));
+    std::vector<u8> buffer(HASH_SAMPLE_BYTES);
+    const u64 last = size > HASH_SAMPLE_BYTES ? size - HASH_SAMPLE_BYTES : 0;
+    for (u64 offset : {u64{0}, last / 2, last}) {
+        in.seekg(static_cast<std::streamoff>(offset));
+        in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        hash = fnv1a(hash, buffer.data(), static_cast<usize>(in.gcount()));
+        in.clear();
+    }
+    return Result<u64>::ok(hash);
+}
+
+bool TrackAnalysisCache::matchesSettings(const TrackTimeline& timeline) const {
+    const auto& header = timeline.header();
+    return header.sampleRate == sampleRate_ && header.hopSize == settings_.hopSize &&
+           header.fftSize == settings_.fftSize;
+}
+
+void TrackAnalysisCache::worker(std::stop_token stop) {
+    while (!stop.stop_requested()) {
+        fs::path track;
+        {
+            std::unique_lock lock(mutex_);
+            if (!wake_.wait(lock, stop, [this] { return !queue_.empty(); }))
+                return;
+            track = std::move(queue_.front());
+            queue_.pop_front();
+            if (timelines_.contains(track.string()))
+                continue;
+        }
+
+        auto result = loadOrAnalyze(track, stop);
+        if (stop.stop_requested())
+            return;
+
+        const std::string key = track.string();
+        if (!result) {
+            LOG_WARN("Track analysis failed for {}: {}", track.filename().string(), result.error().message);
+            std::lock_guard lock(mutex_);
+            failed_.insert(key);
+            continue;
+        }
+        {
+            std::lock_guard lock(mutex_);
+            timelines_[key] = std::make_shared<const TrackTimeline>(std::move(result).value());
+            loadOrder_.push_back(key);
+            if (loadOrder_.size() > MAX_LOADED) {
+                timelines_.erase(loadOrder_.front());
+                loadOrder_.pop_front();
+            }
+        }
+        ready.emitSignal(track);
+    }
+}
+
+Result<TrackTimeline> TrackAnalysisCache::loadOrAnalyze(const fs::path& track, std::stop_token stop) {
+    auto hash = contentHash(track);
+    if (!hash)
+        return Result<TrackTimeline>::err(hash.error());
+
+    const fs::path file = directory_ / std::format("{:016x}.cvtl", hash.value());
+    if (auto cached = TrackTimeline::open(file); cached && matchesSettings(cached.value()) &&
+                                                cached.value().header().contentHash == hash.value()) {
+        LOG_DEBUG("Track timeline cache hit: {}", track.filename().string());
+        return cached;
+    }
+
+    if (auto result = analyze(track, hash.value(), file, stop); !result)
+        return Result<TrackTimeline>::err(result.error());
+    return TrackTimeline::open(file);
+}
+
+Result<void> TrackAnalysisCache::analyze(const fs::path& track,
+                                         u64 hash,
+                                         const fs::path& output,
+                                         std::stop_token stop) {
+    const auto begin = chr::steady_clock::now();
+
+    AudioDecoder decoder;
+    if (auto result = decoder.open(track, sampleRate_, 2); !result)
+        return result;
+    AudioAnalyzer analyzer;
+    if (auto result = analyzer.configure(settings_); !result)
+        return result;
+
+    const u32 hop = settings_.hopSize;
+    std::vector<f32> pcm(static_cast<usize>(hop) * 2);
+    auto spectrum = std::make_unique<AudioSpectrum>();
+    TimelineBuilder builder(sampleRate_, hop, settings_.fftSize);
+    u64 frames = 0;
+    while (!stop.stop_requested()) {
+        const usize n = decoder.read(pcm.data(), hop);
+        if (n == 0)
+            break;
+        // Pad the last partial hop so its onsets still land
+        std::fill(pcm.begin() + static_cast<std::ptrdiff_t>(n) * 2, pcm.end(), 0.0f);
+        analyzer.analyze(pcm, sampleRate_, 2, *spectrum);
+        builder.addHop(*spectrum, std::span(pcm).first(n * 2));
+        frames += n;
+    }
+    if (stop.stop_requested())
+        return Result<void>::err("Cancelled");
+
+    if (auto result = builder.write(output, hash, frames); !result)
+        return result;
+
+    const auto ms = chr::duration_cast<chr::milliseconds>(chr::steady_clock::now() - begin).count();
+    LOG_INFO("Analyzed {}: {} hops in {} ms ({:.0f}x realtime)",
+             track.filename().string(),
+             builder.hopCount(),
+             ms,
+             static_cast<f64>(frames) * 1000.0 / sampleRate_ / static_cast<f64>(std::max<i64>(ms, 1)));
+    return Result<void>::ok();
+}
+
+} // namespace vc
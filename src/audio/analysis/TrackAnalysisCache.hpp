@@ -0,0 +1,81 @@
+/**
+ * @file TrackAnalysisCache.hpp
+ * @brief Background whole-track analysis, cached on disk by content hash.
+ *
+ * request() queues a local file; a worker thread decodes it with
+ * AudioDecoder as fast as it can, runs the same AudioAnalyzer settings as
+ * live playback over every hop, and writes a TrackTimeline to
+ * `<cacheDir>/timelines/<hash>.cvtl`. The hash covers the file size and
+ * three 256 KiB samples, so renamed or re-tagged-in-place files with the
+ * same audio keep their timeline while re-encodes get a new one.
+ *
+ * find() never blocks on analysis: it returns the mapped timeline once it
+ * exists and nullptr before that.
+ *
+ * @section Threads
+ * - request()/find(): any thread.
+ * - ready: emitted from the worker thread.
+ */
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include "audio/AudioAnalyzer.hpp"
+#include "audio/analysis/TrackTimeline.hpp"
+#include "util/Result.hpp"
+#include "util/Signal.hpp"
+#include "util/Types.hpp"
+
+namespace vc {
+
+class TrackAnalysisCache {
+public:
+    TrackAnalysisCache() = default;
+    ~TrackAnalysisCache();
+
+    TrackAnalysisCache(const TrackAnalysisCache&) = delete;
+    TrackAnalysisCache& operator=(const TrackAnalysisCache&) = delete;
+
+    // Timelines are analyzed at `sampleRate` with `settings`; cached ones
+    // made with anything else are redone
+    void start(fs::path directory, const AnalyzerSettings& settings, u32 sampleRate);
+    void stop();
+
+    // Queue `track` unless its timeline is loaded; urgent jumps the queue
+    void request(const fs::path& track, bool urgent = false);
+    std::shared_ptr<const TrackTimeline> find(const fs::path& track) const;
+
+    static Result<u64> contentHash(const fs::path& path);
+
+    // Timeline for the track became available via find()
+    Signal<const fs::path&> ready;
+
+private:
+    void worker(std::stop_token stop);
+    Result<TrackTimeline> loadOrAnalyze(const fs::path& track, std::stop_token stop);
+    Result<void> analyze(const fs::path& track,
+                         u64 hash,
+                         const fs::path& output,
+                         std::stop_token stop);
+    bool matchesSettings(const TrackTimeline& timeline) const;
+
+    fs::path directory_;
+    AnalyzerSettings settings_;
+    u32 sampleRate_{0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable_any wake_;
+    std::deque<fs::path> queue_;
+    std::unordered_map<std::string, std::shared_ptr<const TrackTimeline>> timelines_;
+    std::deque<std::string> loadOrder_; // oldest first, for eviction
+    std::unordered_set<std::string> failed_;
+
+    std::jthread thread_;
+};
+
+} // namespace vc
@@ -0,0 +1,289 @@
+#include "audio/analysis/TrackTimeline.hpp"
+#include "audio/AudioAnalyzer.hpp"
+
+#include <cmath>
+#include <fcntl.h>
+#include <fstream>
+#include <numeric>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace vc {
+
+namespace {
+// Hops quieter than this don't count toward loudness
+constexpr f32 SILENCE_DB = -70.0f;
+// Sections: compare the mean level of the WINDOW seconds before and after
+// each second; a boundary needs this much change and this much distance
+// from every other boundary
+constexpr u32 SECTION_WINDOW_SECONDS = 8;
+constexpr f32 SECTION_CHANGE_DB = 3.0f;
+constexpr u32 MIN_SECTION_SECONDS = 8;
+constexpr usize MAX_SECTIONS = 64;
+
+f32 powerDb(f64 power) {
+    return static_cast<f32>(10.0 * std::log10(std::max(power, 1e-12)));
+}
+} // namespace
+
+// --- TrackTimeline ---------------------------------------------------------
+
+TrackTimeline::~TrackTimeline() {
+    unmap();
+}
+
+TrackTimeline::TrackTimeline(TrackTimeline&& other) noexcept {
+    *this = std::move(other);
+}
+
+TrackTimeline& TrackTimeline::operator=(TrackTimeline&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        mapping_ = std::exchange(other.mapping_, nullptr);
+        mappedBytes_ = std::exchange(other.mappedBytes_, 0);
+        header_ = std::exchange(other.header_, nullptr);
+        hops_ = std::exchange(other.hops_, {});
+        sections_ = std::exchange(other.sections_, {});
+    }
+    return *this;
+}
+
+void TrackTimeline::unmap() {
+    if (mapping_)
+        munmap(mapping_, mappedBytes_);
+    mapping_ = nullptr;
+    mappedBytes_ = 0;
+    header_ = nullptr;
+    hops_ = {};
+    sections_ = {};
+}
+
+Result<TrackTimeline> TrackTimeline::open(const fs::path& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return Result<TrackTimeline>::err("Cannot open timeline " + path.string());
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || static_cast<usize>(st.st_size) < sizeof(TimelineHeader)) {
+        ::close(fd);
+        return Result<TrackTimeline>::err("Truncated timeline " + path.string());
+    }
+
+    const usize bytes = static_cast<usize>(st.st_size);
+    void* mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return Result<TrackTimeline>::err("Cannot map timeline " + path.string());
+
+    TrackTimeline timeline;
+    timeline.mapping_ = mapping;
+    timeline.mappedBytes_ = bytes;
+    timeline.header_ = static_cast<const TimelineHeader*>(mapping);
+
+    const auto& header = *timeline.header_;
+    if (header.magic != TIMELINE_MAGIC || header.version != TIMELINE_VERSION)
+        return Result<TrackTimeline>::err("Not a current timeline: " + path.string());
+    const usize expected = sizeof(TimelineHeader) +
+                           static_cast<usize>(header.hopCount) * sizeof(TimelineHop) +
+                           static_cast<usize>(header.sectionCount) * sizeof(TimelineSection);
+    if (bytes != expected || header.hopCount == 0 || header.sectionCount == 0 ||
+        header.sampleRate == 0 || header.hopSize == 0) {
+        return Result<TrackTimeline>::err("Corrupt timeline " + path.string());
+    }
+
+    const auto* base = static_cast<const u8*>(mapping) + sizeof(TimelineHeader);
+    timeline.hops_ = {reinterpret_cast<const TimelineHop*>(base), header.hopCount};
+    timeline.sections_ = {
+            reinterpret_cast<const TimelineSection*>(base + header.hopCount * sizeof(TimelineHop)),
+            header.sectionCount};
+    return Result<TrackTimeline>::ok(std::move(timeline));
+}
+
+Duration TrackTimeline::duration() const {
+    return Duration(static_cast<i64>(header_->totalFrames * 1000 / header_->sampleRate));
+}
+
+u32 TrackTimeline::hopIndex(u64 frame) const {
+    return static_cast<u32>(std::min<u64>(frame / header_->hopSize, hops_.size() - 1));
+}
+
+TimelinePoint TrackTimeline::at(u64 frame) const {
+    const TimelineHop& hop = hops_[hopIndex(frame)];
+    TimelinePoint point;
+    for (u32 b = 0; b < ONSET_BANDS; ++b) {
+        point.bandDb[b] = dequantizeDb(hop.bandLevel[b]);
+        point.bandOnsets[b] = hop.flags & (HOP_BAND_ONSET << b);
+    }
+    point.loudnessDb = dequantizeDb(hop.loudness);
+    point.beatPhase = static_cast<f32>(hop.beatPhase) / 256.0f;
+    point.onset = hop.flags & HOP_ONSET;
+    point.beat = hop.flags & HOP_BEAT;
+    point.section = std::min<u32>(hop.section, header_->sectionCount - 1);
+    return point;
+}
+
+TimelinePoint TrackTimeline::at(Duration position) const {
+    return at(static_cast<u64>(std::max<i64>(0, position.count())) * header_->sampleRate / 1000);
+}
+
+const TimelineSection& TrackTimeline::sectionAt(Duration position) const {
+    return sections_[at(position).section];
+}
+
+// --- TimelineBuilder -------------------------------------------------------
+
+TimelineBuilder::TimelineBuilder(u32 sampleRate, u32 hopSize, u32 fftSize) {
+    header_.sampleRate = sampleRate;
+    header_.hopSize = hopSize;
+    header_.fftSize = fftSize;
+}
+
+void TimelineBuilder::addHop(const AudioSpectrum& spectrum, std::span<const f32> stereo) {
+    TimelineHop hop{};
+    for (u32 b = 0; b < ONSET_BANDS; ++b) {
+        f64 energy = 0.0;
+        if (spectrum.binHz > 0.0f) {
+            const u32 lo = static_cast<u32>(std::ceil(ONSET_BAND_EDGES_HZ[b] / spectrum.binHz));
+            const u32 hi = std::min<u32>(
+                    static_cast<u32>(std::ceil(ONSET_BAND_EDGES_HZ[b + 1] / spectrum.binHz)),
+                    spectrum.bins);
+            for (u32 k = lo; k < hi; ++k)
+                energy += static_cast<f64>(spectrum.magnitudes[k]) * spectrum.magnitudes[k];
+        }
+        hop.bandLevel[b] = quantizeDb(powerDb(energy));
+        if (spectrum.bandOnsets[b])
+            hop.flags |= HOP_BAND_ONSET << b;
+    }
+
+    f64 sum = 0.0;
+    for (f32 s : stereo)
+        sum += static_cast<f64>(s) * s;
+    const f64 power = stereo.empty() ? 0.0 : sum / static_cast<f64>(stereo.size());
+    hop.loudness = quantizeDb(powerDb(power));
+    hop.beatPhase = static_cast<u8>(std::clamp(spectrum.beatPhase * 256.0f, 0.0f, 255.0f));
+    if (spectrum.onset)
+        hop.flags |= HOP_ONSET;
+    if (spectrum.beatDetected && spectrum.bpm > 0.0f)
+        hop.flags |= HOP_BEAT;
+
+    hops_.push_back(hop);
+    hopPower_.push_back(static_cast<f32>(power));
+    hopBpm_.push_back(spectrum.bpm);
+}
+
+void TimelineBuilder::buildSections() {
+    sections_.clear();
+    const u32 hops = static_cast<u32>(hops_.size());
+    const u32 hopsPerSecond = std::max<u32>(1, header_.sampleRate / header_.hopSize);
+    const u32 seconds = hops / hopsPerSecond;
+
+    // Mean power per second
+    std::vector<f64> second(seconds, 0.0);
+    for (u32 s = 0; s < seconds; ++s) {
+        for (u32 h = s * hopsPerSecond; h < (s + 1) * hopsPerSecond; ++h)
+            second[s] += hopPower_[h];
+        second[s] /= hopsPerSecond;
+    }
+
+    // Level change across each second, strongest first
+    struct Candidate {
+        u32 second;
+        f32 change;
+    };
+    std::vector<Candidate> candidates;
+    constexpr u32 W = SECTION_WINDOW_SECONDS;
+    for (u32 s = W; s + W <= seconds; ++s) {
+        f64 before = std::accumulate(second.begin() + (s - W), second.begin() + s, 0.0) / W;
+        f64 after = std::accumulate(second.begin() + s, second.begin() + (s + W), 0.0) / W;
+        f32 change = std::abs(powerDb(after) - powerDb(before));
+        if (change >= SECTION_CHANGE_DB)
+            candidates.push_back({s, change});
+    }
+    std::ranges::sort(candidates, std::ranges::greater{}, &Candidate::change);
+
+    std::vector<u32> boundaries;
+    for (const auto& candidate : candidates) {
+        if (boundaries.size() + 1 >= MAX_SECTIONS)
+            break;
+        const bool spaced = std::ranges::none_of(boundaries, [&](u32 b) {
+            return (b > candidate.second ? b - candidate.second : candidate.second - b) <
+                   MIN_SECTION_SECONDS;
+        });
+        if (spaced && candidate.second >= MIN_SECTION_SECONDS &&
+            candidate.second + MIN_SECTION_SECONDS <= seconds) {
+            boundaries.push_back(candidate.second);
+        }
+    }
+    std::ranges::sort(boundaries);
+
+    u32 start = 0;
+    auto close = [&](u32 end) {
+        TimelineSection section{start, end};
+        f64 power = 0.0;
+        f64 bpmSum = 0.0;
+        u32 bpmCount = 0;
+        for (u32 h = start; h < end; ++h) {
+            power += hopPower_[h];
+            if (hopBpm_[h] > 0.0f) {
+                bpmSum += hopBpm_[h];
+                ++bpmCount;
+            }
+        }
+        section.loudnessDb = powerDb(end > start ? power / (end - start) : 0.0);
+        section.bpm = bpmCount ? static_cast<f32>(bpmSum / bpmCount) : 0.0f;
+        for (u32 h = start; h < end; ++h)
+            hops_[h].section = static_cast<u8>(sections_.size());
+        sections_.push_back(section);
+        start = end;
+    };
+    for (u32 b : boundaries)
+        close(b * hopsPerSecond);
+    close(hops);
+}
+
+Result<void> TimelineBuilder::write(const fs::path& path, u64 contentHash, u64 totalFrames) {
+    if (hops_.empty())
+        return Result<void>::err("Empty timeline");
+
+    buildSections();
+
+    f64 power = 0.0;
+    u32 loud = 0;
+    for (f32 p : hopPower_) {
+        if (powerDb(p) > SILENCE_DB) {
+            power += p;
+            ++loud;
+        }
+    }
+    header_.contentHash = contentHash;
+    header_.totalFrames = totalFrames;
+    header_.hopCount = static_cast<u32>(hops_.size());
+    header_.sectionCount = static_cast<u32>(sections_.size());
+    header_.loudnessDb = loud ? powerDb(power / loud) : TIMELINE_DB_FLOOR;
+    auto lastBpm = std::ranges::find_if(hopBpm_.rbegin(), hopBpm_.rend(), [](f32 b) {
+        return b > 0.0f;
+    });
+    header_.bpm = lastBpm != hopBpm_.rend() ? *lastBpm : 0.0f;
+
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    fs::path temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+        out.write(reinterpret_cast<const char*>(hops_.data()),
+                  static_cast<std::streamsize>(hops_.size() * sizeof(TimelineHop)));
+        out.write(reinterpret_cast<const char*>(sections_.data()),
+                  static_cast<std::streamsize>(sections_.size() * sizeof(TimelineSection)));
+        if (!out)
+            return Result<void>::err("Failed to write " + temp.string());
+    }
+    fs::rename(temp, path, ec);
+    if (ec)
+        return Result<void>::err("Failed to store " + path.string() + ": " + ec.message());
+    return Result<void>::ok();
+}
+
+} // namespace vc
@@ -0,0 +1,161 @@
+/**
+ * @file TrackTimeline.hpp
+ * @brief Precomputed per-hop analysis of a whole track, memory-mapped.
+ *
+ * A timeline is what AudioAnalyzer would report for every hop of a track,
+ * computed once (faster than realtime, see TrackAnalysisCache) and stored
+ * as a flat binary file:
+ *
+ *   TimelineHeader | TimelineHop[hopCount] | TimelineSection[sectionCount]
+ *
+ * Hops are 8 bytes (levels quantized to 0.5 dB), so five minutes at
+ * 44.1 kHz / 512 is ~200 KB. TrackTimeline maps the file read-only and
+ * answers "what happens at time t" with one index computation.
+ *
+ * @section Patterns
+ * - RAII: the mapping lives as long as the TrackTimeline (move-only).
+ * - Builder: TimelineBuilder collects hops, derives sections, writes the
+ *   file atomically (temp file + rename).
+ */
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+#include "audio/BeatTracker.hpp"
+#include "util/Result.hpp"
+#include "util/Types.hpp"
+
+namespace vc {
+
+struct AudioSpectrum;
+
+inline constexpr std::array<char, 4> TIMELINE_MAGIC{'C', 'V', 'T', 'L'};
+inline constexpr u32 TIMELINE_VERSION = 1;
+
+// Levels are stored as u8 steps of TIMELINE_DB_STEP above TIMELINE_DB_FLOOR
+inline constexpr f32 TIMELINE_DB_FLOOR = -96.0f;
+inline constexpr f32 TIMELINE_DB_STEP = 0.5f; // range -96..+31.5 dB
+
+struct TimelineHeader {
+    std::array<char, 4> magic{TIMELINE_MAGIC};
+    u32 version{TIMELINE_VERSION};
+    u64 contentHash{0};
+    u64 totalFrames{0};
+    u32 sampleRate{0};
+    u32 hopSize{0};
+    u32 fftSize{0};
+    u32 hopCount{0};
+    u32 sectionCount{0};
+    f32 bpm{0.0f};        // tempo at the end of the track, 0 if never locked
+    f32 loudnessDb{0.0f}; // mean power of non-silent hops, dBFS
+    u32 reserved[3]{};
+};
+static_assert(sizeof(TimelineHeader) == 64);
+
+enum TimelineHopFlags : u8 {
+    HOP_ONSET = 1 << 0,
+    HOP_BEAT = 1 << 1,
+    HOP_BAND_ONSET = 1 << 2, // band b sets HOP_BAND_ONSET << b
+};
+
+struct TimelineHop {
+    std::array<u8, ONSET_BANDS> bandLevel; // band energy, quantized dB
+    u8 loudness;                           // hop RMS, quantized dB
+    u8 beatPhase;                          // phase * 256
+    u8 flags;                              // TimelineHopFlags
+    u8 section;                            // index into sections()
+};
+static_assert(sizeof(TimelineHop) == 8);
+
+struct TimelineSection {
+    u32 startHop{0};
+    u32 endHop{0}; // exclusive
+    f32 loudnessDb{0.0f};
+    f32 bpm{0.0f};
+};
+
+// One hop, decoded
+struct TimelinePoint {
+    std::array<f32, ONSET_BANDS> bandDb{};
+    f32 loudnessDb{TIMELINE_DB_FLOOR};
+    f32 beatPhase{0.0f};
+    bool onset{false};
+    bool beat{false};
+    std::array<bool, ONSET_BANDS> bandOnsets{};
+    u32 section{0};
+};
+
+inline u8 quantizeDb(f32 db) {
+    const f32 steps = (db - TIMELINE_DB_FLOOR) / TIMELINE_DB_STEP;
+    return static_cast<u8>(std::clamp(steps + 0.5f, 0.0f, 255.0f));
+}
+inline f32 dequantizeDb(u8 level) {
+    return TIMELINE_DB_FLOOR + static_cast<f32>(level) * TIMELINE_DB_STEP;
+}
+
+class TrackTimeline {
+public:
+    TrackTimeline() = default;
+    ~TrackTimeline();
+    TrackTimeline(TrackTimeline&& other) noexcept;
+    TrackTimeline& operator=(TrackTimeline&& other) noexcept;
+    TrackTimeline(const TrackTimeline&) = delete;
+    TrackTimeline& operator=(const TrackTimeline&) = delete;
+
+    // Map and validate a timeline file
+    static Result<TrackTimeline> open(const fs::path& path);
+
+    const TimelineHeader& header() const {
+        return *header_;
+    }
+    std::span<const TimelineHop> hops() const {
+        return hops_;
+    }
+    std::span<const TimelineSection> sections() const {
+        return sections_;
+    }
+    Duration duration() const;
+
+    // Hop containing `frame` / `position` (clamped to the last hop)
+    u32 hopIndex(u64 frame) const;
+    TimelinePoint at(u64 frame) const;
+    TimelinePoint at(Duration position) const;
+    const TimelineSection& sectionAt(Duration position) const;
+
+private:
+    void unmap();
+
+    void* mapping_{nullptr};
+    usize mappedBytes_{0};
+    const TimelineHeader* header_{nullptr};
+    std::span<const TimelineHop> hops_;
+    std::span<const TimelineSection> sections_;
+};
+
+class TimelineBuilder {
+public:
+    TimelineBuilder(u32 sampleRate, u32 hopSize, u32 fftSize);
+
+    // One analyzer hop: its report and the stereo frames it covered
+    void addHop(const AudioSpectrum& spectrum, std::span<const f32> stereo);
+
+    usize hopCount() const {
+        return hops_.size();
+    }
+
+    // Derive sections and write `path` (replaced atomically)
+    Result<void> write(const fs::path& path, u64 contentHash, u64 totalFrames);
+
+private:
+    void buildSections();
+
+    TimelineHeader header_;
+    std::vector<TimelineHop> hops_;
+    std::vector<f32> hopPower_; // linear mean square per hop
+    std::vector<f32> hopBpm_;
+    std::vector<TimelineSection> sections_;
+};
+
+} // namespace vc
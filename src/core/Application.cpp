@@ -5,6 +5,7 @@
 #include "Config.hpp"
 #include "Logger.hpp"
 #include "audio/AudioEngine.hpp"
+#include "recorder/OfflineRenderer.hpp"
 #include "recorder/VideoRecorder.hpp"
 #include "util/FileUtils.hpp"
 #include "util/GLIncludes.hpp"
@@ -56,6 +57,7 @@ Application::~Application() {
 	// Cleanup order: QML engine first, then visualizer, then Qt app
 	qmlEngine_.reset();
 	visualizerWindow_.reset();
+	offlineRenderer_.reset();
 
 	videoRecorder_.reset();
 	audioEngine_.reset();
@@ -344,6 +346,11 @@ Result<void> Application::init(const AppOptions& opts) {
 
 	QQuickWindow::setGraphicsApi(QSGRendererInterface::OpenGL);
 
+	// Headless never opens a window; don't require a display server either
+	if (opts.headless && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+
 	// Create Qt application
 	qapp_ = std::make_unique<QApplication>(argc_, argv_);
 	qapp_->setApplicationName("ChadVis");
@@ -354,6 +361,10 @@ Result<void> Application::init(const AppOptions& opts) {
 	// Setup styling
 	setupStyle();
 
+	if (opts.headless) {
+		return initHeadless(opts);
+	}
+
 	// Initialize components
 	LOG_DEBUG("Initializing audio engine...");
 	audioEngine_ = std::make_unique<AudioEngine>();
@@ -438,17 +449,71 @@ Result<void> Application::init(const AppOptions& opts) {
 	return Result<void>::ok();
 }
 
+Result<void> Application::initHeadless(const AppOptions& opts) {
+	if (opts.inputFiles.empty()) {
+		return Result<void>::err("--headless needs at least one input file");
+	}
+	if (opts.outputFile && opts.inputFiles.size() > 1) {
+		LOG_WARN("--output ignored with {} inputs; writing to {}",
+			opts.inputFiles.size(), CONFIG.recording().outputDirectory.string());
+	}
+
+	headlessInputs_ = opts.inputFiles;
+	if (opts.inputFiles.size() == 1) {
+		headlessOutput_ = opts.outputFile;
+	}
+
+	auto settings = EncoderSettings::fromConfig();
+	offlineRenderer_ = std::make_unique<OfflineRenderer>();
+	if (auto result = offlineRenderer_->init(settings.video.width, settings.video.height); !result) {
+		LOG_ERROR("Headless renderer init failed: {}", result.error().message);
+		return result;
+	}
+
+	LOG_INFO("Headless mode: {} file(s) queued for offline render", headlessInputs_.size());
+	return Result<void>::ok();
+}
+
+int Application::runHeadless() {
+	auto settings = EncoderSettings::fromConfig();
+	int failures = 0;
+
+	for (const auto& input : headlessInputs_) {
+		settings.outputPath = headlessOutput_
+			? fs::absolute(*headlessOutput_)
+			: CONFIG.recording().outputDirectory /
+				(input.stem().string() + settings.containerExtension());
+
+		if (auto result = offlineRenderer_->render(input, settings); !result) {
+			LOG_ERROR("Headless render of {} failed: {}", input.string(), result.error().message);
+			++failures;
+			if (offlineRenderer_->isCancelled()) {
+				break;
+			}
+		}
+	}
+
+	return failures > 0 ? 1 : 0;
+}
+
 int Application::exec() {
 	if (!qapp_) {
 		LOG_ERROR("Application not initialized");
 		return 1;
 	}
+	if (offlineRenderer_) {
+		return runHeadless();
+	}
 	return qapp_->exec();
 }
 
 void Application::quit() {
 	LOG_INFO("Shutting down...");
 
+	if (offlineRenderer_) {
+		offlineRenderer_->cancel();
+	}
+
 	// Stop recording if active
 	if (videoRecorder_ && videoRecorder_->isRecording()) {
 		videoRecorder_->stop();
@@ -457,9 +522,8 @@ void Application::quit() {
 	// Stop audio
 	if (audioEngine_) {
 		// Save last session playlist
-		auto lastSession = file::configDir() / "last_session.m3u";
-		audioEngine_->playlist().saveM3U(lastSession);
-		LOG_DEBUG("Saved session playlist to {}", lastSession.string());
+		audioEngine_->saveLastPlaylist();
+		LOG_DEBUG("Saved session playlist");
 
 		audioEngine_->stop();
 	}
@@ -517,7 +581,7 @@ void Application::printHelp() {
 	Cli::printOption("-v, --version", "Show version information");
 	Cli::printOption("-d, --debug", "Enable debug logging", "no");
 	Cli::printOption("-c, --config <path>", "Use custom config file");
-	Cli::printOption("--headless", "Run without GUI (batch mode)");
+	Cli::printOption("--headless", "Render files to video offline, no GUI (batch mode)");
 	Cli::printOption("--generate-completion <shell>", "Generate shell completion script");
 
 	Cli::printSection("Audio Options");
@@ -563,6 +627,8 @@ void Application::printHelp() {
 		<< " " << dim() << "# Play all FLAC files" << reset() << "\n\n"
 		<< " " << brightCyan() << "chadvis-projectm-qt -r -o video.mp4 song.mp3" << reset() << "\n"
 		<< " " << dim() << "# Record to video.mp4" << reset() << "\n\n"
+		<< " " << brightCyan() << "chadvis-projectm-qt --headless -o video.mp4 song.mp3" << reset() << "\n"
+		<< " " << dim() << "# Render offline, faster than realtime, no window" << reset() << "\n\n"
 		<< " " << brightCyan() << "chadvis-projectm-qt --recording-codec h264_nvenc -r" << reset() << "\n"
 		<< " " << dim() << "# Use NVIDIA hardware encoding" << reset() << "\n\n"
 		<< " " << brightCyan() << "chadvis-projectm-qt --help recording" << reset() << "\n"
@@ -33,6 +33,7 @@ class VideoRecorder;
 class PresetManager;
 class LyricsSync;
 class VisualizerWindow;
+class OfflineRenderer;
 
 namespace suno {
 class SunoController;
@@ -133,6 +134,8 @@ private:
 	void setupQmlStyle();
 	void printVersion();
 	void printHelp();
+	Result<void> initHeadless(const AppOptions& opts);
+	int runHeadless();
 
 	/// Generate list of all flag names from CliArgs.inc table (for findClosestMatch)
 	std::vector<std::string_view> allFlagNames();
@@ -152,6 +155,11 @@ std::unique_ptr<LyricsSync> lyricsSync_;
 std::unique_ptr<suno::SunoController> sunoController_;
 std::unique_ptr<VisualizerWindow> visualizerWindow_;
 
+	// Headless batch mode (--headless)
+	std::unique_ptr<OfflineRenderer> offlineRenderer_;
+	std::vector<fs::path> headlessInputs_;
+	std::optional<fs::path> headlessOutput_;
+
 	int argc_;
 	char** argv_;
 };
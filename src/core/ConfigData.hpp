@@ -61,6 +61,8 @@ struct VideoEncoderConfig {
     }
     u32 gopSize{0};
     u32 bFrames{0};
+    bool gpuConvert{true}; // RGBA -> YUV420 on the GPU before readback
+    bool vfr{false};       // variable frame rate instead of dup/skip to fps
 };
 
 // Audio encoding settings
@@ -101,6 +103,8 @@ struct VisualizerConfig {
     f32 hardCutSensitivity{1.0f}; // Sensitivity for hard cuts
     bool aspectCorrection{true};
     bool shufflePresets{true};
+    u32 shuffleWindow{20}; // no repeats within this many shuffled presets
+    u32 prewarmDepth{2};   // upcoming presets loaded ahead; 0 = off
     std::string forcePreset{};
     bool useDefaultPreset{false};
     u32 meshX{32}; // Grid size X
@@ -113,6 +117,17 @@ struct AudioConfig {
     std::string device{"default"};
     u32 bufferSize{2048};
     u32 sampleRate{44100};
+
+    // Spectrum analysis (see AnalyzerSettings)
+    u32 fftSize{2048};
+    u32 fftHop{512};
+    std::string fftWindow{"hann"};
+    u32 bassFftSize{8192}; // 0 = no separate bass FFT
+
+    // Loudness normalization (see LoudnessScanner)
+    std::string normalization{"track"}; // off, track, album
+    f32 normalizationTarget{-18.0f};    // LUFS
+    u32 loudnessThreads{0};             // scanner workers, 0 = one per core
 };
 
 // UI configuration
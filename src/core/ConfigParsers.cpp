@@ -1,5 +1,6 @@
 #include "ConfigParsers.hpp"
 #include <algorithm>
+#include <bit>
 #include "Logger.hpp"
 
 namespace vc {
@@ -45,6 +46,21 @@ void ConfigParsers::parseAudio(const toml::table& tbl, AudioConfig& cfg) {
         cfg.device = get(*audio, "device", std::string("default"));
         cfg.bufferSize = get(*audio, "buffer_size", 2048u);
         cfg.sampleRate = get(*audio, "sample_rate", 44100u);
+        // FFT sizes must be powers of two; round down into 512..16384
+        auto fftSize = [&](std::string_view key, u32 def) {
+            return std::bit_floor(std::clamp(get(*audio, key, def), 512u, 16384u));
+        };
+        cfg.fftSize = fftSize("fft_size", 2048u);
+        cfg.fftHop = std::clamp(get(*audio, "fft_hop", 512u), 64u, cfg.fftSize);
+        cfg.fftWindow = get(*audio, "fft_window", std::string("hann"));
+        u32 bass = get(*audio, "bass_fft_size", 8192u);
+        cfg.bassFftSize = bass == 0 ? 0 : fftSize("bass_fft_size", 8192u);
+        cfg.normalization = get(*audio, "normalization", std::string("track"));
+        if (cfg.normalization != "off" && cfg.normalization != "album") {
+            cfg.normalization = "track";
+        }
+        cfg.normalizationTarget = std::clamp(get(*audio, "normalization_target", -18.0f), -40.0f, 0.0f);
+        cfg.loudnessThreads = std::min(get(*audio, "loudness_threads", 0u), 256u);
     }
 }
 
@@ -67,6 +83,8 @@ void ConfigParsers::parseVisualizer(const toml::table& tbl,
                 std::clamp(get(*viz, "hard_cut_sensitivity", 1.0f), 0.1f, 10.0f);
         cfg.aspectCorrection = get(*viz, "aspect_correction", true);
         cfg.shufflePresets = get(*viz, "shuffle_presets", true);
+        cfg.shuffleWindow = std::min(get(*viz, "shuffle_window", 20u), 1000u);
+        cfg.prewarmDepth = std::min(get(*viz, "prewarm_depth", 2u), 8u);
         cfg.forcePreset = get(*viz, "force_preset", std::string());
         cfg.useDefaultPreset = get(*viz, "use_default_preset", false);
         cfg.meshX = std::clamp(get(*viz, "mesh_x", 32u), 8u, 512u);
@@ -112,6 +130,8 @@ void ConfigParsers::parseRecording(const toml::table& tbl,
                     (std::clamp(get(*video, "height", 720u), 120u, 4320u) + 1) &
                     ~1;
             cfg.video.fps = std::clamp(get(*video, "fps", 30u), 10u, 120u);
+            cfg.video.gpuConvert = get(*video, "gpu_convert", true);
+            cfg.video.vfr = get(*video, "vfr", false);
         }
 
         if (auto audio = (*rec)["audio"].as_table()) {
@@ -220,7 +240,14 @@ toml::table ConfigParsers::serialize(
     root.insert("audio",
                 toml::table{{"device", audio.device},
                             {"buffer_size", (i64)audio.bufferSize},
-                            {"sample_rate", (i64)audio.sampleRate}});
+                            {"sample_rate", (i64)audio.sampleRate},
+                            {"fft_size", (i64)audio.fftSize},
+                            {"fft_hop", (i64)audio.fftHop},
+                            {"fft_window", audio.fftWindow},
+                            {"bass_fft_size", (i64)audio.bassFftSize},
+                            {"normalization", audio.normalization},
+                            {"normalization_target", (double)audio.normalizationTarget},
+                            {"loudness_threads", (i64)audio.loudnessThreads}});
 
     toml::table vizTbl{
             {"preset_path", visualizer.presetPath.string()},
@@ -233,6 +260,8 @@ toml::table ConfigParsers::serialize(
             {"hard_cut_sensitivity", (double)visualizer.hardCutSensitivity},
             {"aspect_correction", visualizer.aspectCorrection},
             {"shuffle_presets", visualizer.shufflePresets},
+            {"shuffle_window", (i64)visualizer.shuffleWindow},
+            {"prewarm_depth", (i64)visualizer.prewarmDepth},
             {"force_preset", visualizer.forcePreset},
             {"use_default_preset", visualizer.useDefaultPreset},
             {"mesh_x", (i64)visualizer.meshX},
@@ -249,7 +278,9 @@ toml::table ConfigParsers::serialize(
                          {"pixel_format", recording.video.pixelFormat},
                          {"width", (i64)recording.video.width},
                          {"height", (i64)recording.video.height},
-                         {"fps", (i64)recording.video.fps}};
+                         {"fps", (i64)recording.video.fps},
+                         {"gpu_convert", recording.video.gpuConvert},
+                         {"vfr", recording.video.vfr}};
     toml::table recAudio{{"codec", recording.audio.codec},
                          {"bitrate", (i64)recording.audio.bitrate}};
     root.insert(
@@ -66,8 +66,20 @@ ColumnLayout {
             color: Theme.surfaceOverlay
             radius: Theme.radiusSmall
 
+            Image {
+                id: coverArt
+                anchors.fill: parent
+                anchors.margins: 1
+                source: AudioBridge.currentTrack.artUrl || ""
+                sourceSize: Qt.size(96, 96)
+                fillMode: Image.PreserveAspectCrop
+                asynchronous: true
+                visible: status === Image.Ready
+            }
+
             Text {
                 anchors.centerIn: parent
+                visible: !coverArt.visible
                 text: "♪"
                 color: Theme.textSecondary
                 font.pixelSize: 24
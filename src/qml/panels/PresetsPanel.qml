@@ -1,14 +1,13 @@
 import QtQuick
 import QtQuick.Layouts
 import QtQuick.Controls
+import QtQuick.Dialogs
 import QtQuick.Effects
 import ChadVis
 import "../components"
 
 ColumnLayout {
     id: root
-    property string searchQuery: ""
-    property string selectedCategory: ""
     spacing: Theme.spacingMedium
 
     ColumnLayout {
@@ -20,8 +19,8 @@ ColumnLayout {
             id: searchField
             Layout.fillWidth: true
             placeholderText: "Search presets..."
-            text: root.searchQuery
-            onTextChanged: root.searchQuery = text
+            text: PresetBridge.searchQuery
+            onTextChanged: PresetBridge.searchQuery = text
             background: Rectangle {
                 radius: Theme.radiusSmall; color: Theme.surfaceRaised; border.color: Theme.border; border.width: searchField.activeFocus ? 2 : 1
             }
@@ -31,33 +30,41 @@ ColumnLayout {
         RowLayout {
             Layout.fillWidth: true; spacing: Theme.spacingSmall
             ComboBox {
-                id: categoryCombo; Layout.fillWidth: true; model: ["All", "Favorites", "Blacklisted"].concat(PresetBridge.categories)
+                id: categoryCombo; Layout.fillWidth: true; model: ["All", "Favorites", "Blacklisted", "Quarantined"].concat(PresetBridge.categories)
                 onActivated: {
-                    var val = model[index]; if (val === "All") root.selectedCategory = ""; else if (val === "Favorites") root.selectedCategory = "__favorites__"; else if (val === "Blacklisted") root.selectedCategory = "__blacklisted__"; else root.selectedCategory = val
+                    var val = model[index]; if (val === "All") PresetBridge.selectedCategory = ""; else if (val === "Favorites") PresetBridge.selectedCategory = "__favorites__"; else if (val === "Blacklisted") PresetBridge.selectedCategory = "__blacklisted__"; else if (val === "Quarantined") PresetBridge.selectedCategory = "__quarantined__"; else PresetBridge.selectedCategory = val
                 }
                 background: Rectangle { radius: Theme.radiusSmall; color: Theme.surfaceRaised; border.color: Theme.border }
                 contentItem: Text { text: categoryCombo.displayText; color: Theme.textPrimary; font.pixelSize: Theme.fontBody.pixelSize; verticalAlignment: Text.AlignVCenter; leftPadding: Theme.spacingSmall }
             }
             AppButton { icon: "qrc:/qt/qml/ChadVis/resources/icons/random.svg"; implicitWidth: 44; implicitHeight: 44; onClicked: PresetBridge.selectRandom() }
+            AppButton { icon: "qrc:/qt/qml/ChadVis/resources/icons/save.svg"; implicitWidth: 44; implicitHeight: 44; onClicked: costDialog.open() }
         }
     }
 
     ListView {
-        id: presetList; Layout.fillWidth: true; Layout.fillHeight: true; clip: true; model: PresetBridge.filteredPresets()
+        id: presetList; Layout.fillWidth: true; Layout.fillHeight: true; clip: true; model: PresetBridge.model
         delegate: PresetDelegate {
-            width: presetList.width; onSelected: PresetBridge.selectByIndex(modelData.index); onFavoriteToggled: PresetBridge.toggleFavorite(modelData.index); onBlacklistToggled: PresetBridge.toggleBlacklist(modelData.index)
+            width: presetList.width; onSelected: PresetBridge.selectByIndex(presetIndex); onFavoriteToggled: PresetBridge.toggleFavorite(presetIndex); onBlacklistToggled: PresetBridge.toggleBlacklist(presetIndex)
         }
         ScrollBar.vertical: ScrollBar { policy: ScrollBar.AsNeeded }
         highlight: Rectangle { color: Theme.accent; opacity: 0.2; radius: Theme.radiusSmall }
         highlightFollowsCurrentItem: true; highlightMoveDuration: 150
-        Connections { target: PresetBridge; function onPresetsChanged() { presetList.model = PresetBridge.filteredPresets() } }
     }
 
     component PresetDelegate: Rectangle {
         id: delegate; height: 64; color: mouseArea.containsMouse ? Theme.surfaceRaised : Theme.surface; radius: Theme.radiusSmall
-        property bool isFavorite: modelData ? modelData.favorite : false
-        property bool isBlacklisted: modelData ? modelData.blacklisted : false
-        property int rating: modelData ? modelData.rating : 0
+        required property int presetIndex
+        required property string name
+        required property string author
+        required property string category
+        required property bool favorite
+        required property bool blacklisted
+        required property int rating
+        required property real frameMs
+        required property bool quarantined
+        property bool isFavorite: favorite
+        property bool isBlacklisted: blacklisted
         signal selected(); signal favoriteToggled(); signal blacklistToggled()
 
         RowLayout {
@@ -76,8 +83,14 @@ ColumnLayout {
     }
             ColumnLayout {
                 Layout.fillWidth: true; spacing: 2
-                Text { text: modelData ? modelData.name : ""; color: delegate.isBlacklisted ? Theme.textSecondary : Theme.textPrimary; font.pixelSize: Theme.fontBody.pixelSize; elide: Text.ElideRight; Layout.fillWidth: true }
-                Text { text: modelData ? (modelData.author ? modelData.author : modelData.category) : ""; color: Theme.textSecondary; font.pixelSize: Theme.fontCaption.pixelSize; elide: Text.ElideRight; Layout.fillWidth: true }
+                Text { text: delegate.name; color: delegate.isBlacklisted ? Theme.textSecondary : Theme.textPrimary; font.pixelSize: Theme.fontBody.pixelSize; elide: Text.ElideRight; Layout.fillWidth: true }
+                Text { text: delegate.author ? delegate.author : delegate.category; color: Theme.textSecondary; font.pixelSize: Theme.fontCaption.pixelSize; elide: Text.ElideRight; Layout.fillWidth: true }
+            }
+            Text {
+                // Measured frame time; click a quarantined preset's to release it
+                text: delegate.frameMs > 0 ? delegate.frameMs.toFixed(1) + " ms" : ""; visible: text !== ""
+                color: delegate.quarantined ? Theme.error : Theme.textSecondary; font.pixelSize: Theme.fontCaption.pixelSize; Layout.alignment: Qt.AlignVCenter
+                MouseArea { anchors.fill: parent; enabled: delegate.quarantined; onClicked: PresetBridge.releaseQuarantine(delegate.presetIndex) }
             }
             Row {
                 spacing: 2; Layout.alignment: Qt.AlignVCenter
@@ -93,7 +106,7 @@ ColumnLayout {
                 colorization: 1.0
                 colorizationColor: index < delegate.rating ? Theme.accent : Theme.textSecondary
             }
-            MouseArea { anchors.fill: parent; onClicked: PresetBridge.setRating(modelData.index, index + 1) }
+            MouseArea { anchors.fill: parent; onClicked: PresetBridge.setRating(delegate.presetIndex, index + 1) }
         }
                 }
             }
@@ -102,4 +115,12 @@ ColumnLayout {
         }
         MouseArea { id: mouseArea; anchors.fill: parent; hoverEnabled: true; onDoubleClicked: delegate.selected() }
     }
+
+    FileDialog {
+        id: costDialog
+        title: "Export Preset Costs"
+        fileMode: FileDialog.SaveFile
+        nameFilters: ["CSV files (*.csv)", "JSON files (*.json)"]
+        onAccepted: PresetBridge.exportPresetCosts(selectedFile.toString().replace("file://", ""))
+    }
 }
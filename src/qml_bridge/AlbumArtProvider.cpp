@@ -0,0 +1,59 @@
+#include "AlbumArtProvider.hpp"
+#include "audio/analysis/AlbumArtStore.hpp"
+
+#include <QImage>
+#include <QRunnable>
+#include <QThreadPool>
+
+namespace qml_bridge {
+
+namespace {
+
+class AlbumArtResponse : public QQuickImageResponse, public QRunnable {
+public:
+    AlbumArtResponse(vc::ArtId artId, bool full, QSize requestedSize)
+        : artId_(artId), full_(full), requestedSize_(requestedSize) {
+        setAutoDelete(false); // owned by the QML engine
+    }
+
+    QQuickTextureFactory* textureFactory() const override {
+        return QQuickTextureFactory::textureFactoryForImage(image_);
+    }
+
+    void run() override {
+        auto& store = vc::AlbumArtStore::instance();
+        if (auto image = full_ ? store.fullSize(artId_) : store.thumbnail(artId_)) {
+            image_ = requestedSize_.isValid()
+                    ? image->scaled(requestedSize_, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+                    : *image;
+        }
+        emit finished();
+    }
+
+private:
+    vc::ArtId artId_;
+    bool full_;
+    QSize requestedSize_;
+    QImage image_;
+};
+
+} // namespace
+
+QQuickImageResponse* AlbumArtProvider::requestImageResponse(const QString& id,
+                                                            const QSize& requestedSize) {
+    const auto parts = id.split('/');
+    bool ok = false;
+    const vc::ArtId artId = parts.value(0).toULongLong(&ok, 16);
+    const bool full = parts.value(1) == QStringLiteral("full");
+
+    auto* response = new AlbumArtResponse(ok ? artId : 0, full, requestedSize);
+    QThreadPool::globalInstance()->start(response);
+    return response;
+}
+
+QString AlbumArtProvider::urlFor(std::uint64_t artId) {
+    if (artId == 0) return {};
+    return QStringLiteral("image://%1/%2").arg(QLatin1String(ID)).arg(artId, 16, 16, QLatin1Char('0'));
+}
+
+} // namespace qml_bridge
@@ -0,0 +1,29 @@
+/**
+ * @file AlbumArtProvider.hpp
+ * @brief Serves AlbumArtStore covers to QML as image://albumart/<id>
+ *
+ * `image://albumart/<id>` is the cached thumbnail, `image://albumart/<id>/full`
+ * the original decoded from its track. Both are produced on the global
+ * QThreadPool, never on the GUI thread.
+ */
+
+#pragma once
+
+#include <QQuickAsyncImageProvider>
+#include <QString>
+#include <cstdint>
+
+namespace qml_bridge {
+
+class AlbumArtProvider : public QQuickAsyncImageProvider {
+public:
+    static constexpr const char* ID = "albumart";
+
+    QQuickImageResponse* requestImageResponse(const QString& id,
+                                              const QSize& requestedSize) override;
+
+    // "" for no art, so QML can bind Image.source straight to it
+    static QString urlFor(std::uint64_t artId);
+};
+
+} // namespace qml_bridge
@@ -1,4 +1,5 @@
 #include "AudioBridge.hpp"
+#include "AlbumArtProvider.hpp"
 #include "audio/AudioEngine.hpp"
 #include "audio/analysis/MediaMetadata.hpp"
 #include "core/Application.hpp"
@@ -102,6 +103,7 @@ void AudioBridge::onEngineTrackChanged() {
             currentTrack_["title"] = QString::fromStdString(meta.displayTitle());
             currentTrack_["artist"] = QString::fromStdString(meta.displayArtist());
             currentTrack_["path"] = QString::fromStdString(item->path.string());
+            currentTrack_["artUrl"] = AlbumArtProvider::urlFor(meta.artId);
         }
     }
     emit trackChanged();
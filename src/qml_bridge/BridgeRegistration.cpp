@@ -1,4 +1,5 @@
 #include "BridgeRegistration.hpp"
+#include "AlbumArtProvider.hpp"
 #include "AudioBridge.hpp"
 #include "PlaylistBridge.hpp"
 #include "VisualizerBridge.hpp"
@@ -35,6 +36,9 @@ void registerBridges(QQmlApplicationEngine* engine,
     qmlRegisterSingletonType<OverlayBridge>("ChadVis", 1, 0, "OverlayBridge", OverlayBridge::create);
     qmlRegisterSingletonType<SettingsBridge>("ChadVis", 1, 0, "SettingsBridge", SettingsBridge::create);
 
+    // Engine takes ownership
+    engine->addImageProvider(AlbumArtProvider::ID, new AlbumArtProvider);
+
     AudioBridge::setAudioEngine(audioEngine);
     PlaylistBridge::setPlaylist(&audioEngine->playlist());
     VisualizerBridge::setVisualizerEngine(visualizer);
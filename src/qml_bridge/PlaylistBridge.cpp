@@ -1,10 +1,13 @@
 #include "PlaylistBridge.hpp"
+#include "AlbumArtProvider.hpp"
 #include "audio/Playlist.hpp"
 #include "util/FileUtils.hpp"
 #include <QAbstractItemModel>
 #include <QQmlEngine>
 #include <QString>
+#include <algorithm>
 #include <cstdint>
+#include <functional>
 
 namespace qml_bridge {
 
@@ -13,10 +16,22 @@ PlaylistBridge* PlaylistBridge::s_instance = nullptr;
 vc::Playlist* PlaylistBridge::s_connectedPlaylist = nullptr;
 std::optional<std::size_t> PlaylistBridge::s_changedConnection = std::nullopt;
 std::optional<std::size_t> PlaylistBridge::s_currentChangedConnection = std::nullopt;
+std::optional<std::size_t> PlaylistBridge::s_itemsUpdatedConnection = std::nullopt;
+std::optional<std::size_t> PlaylistBridge::s_itemsAddedConnection = std::nullopt;
+std::optional<std::size_t> PlaylistBridge::s_itemsRemovedConnection = std::nullopt;
+std::optional<std::size_t> PlaylistBridge::s_itemMovedConnection = std::nullopt;
 bool PlaylistBridge::s_suppressPlaylistNotifications = false;
 
 PlaylistBridge::PlaylistBridge(QObject* parent) : QAbstractListModel(parent) {
     s_instance = this;
+    rows_ = playlistSize();
+    shownCurrent_ = currentIndex();
+
+    // Bursts of edits, metadata and track changes reach QML once a frame
+    flushTimer_.setSingleShot(true);
+    flushTimer_.setInterval(FLUSH_INTERVAL_MS);
+    QObject::connect(&flushTimer_, &QTimer::timeout, this, &PlaylistBridge::flushPending);
+
     connectPlaylistSignals();
 }
 
@@ -28,6 +43,7 @@ void PlaylistBridge::setPlaylist(vc::Playlist* playlist) {
     s_playlist = playlist;
     connectPlaylistSignals();
     if (s_instance) {
+        s_instance->resetRows();
         s_instance->onPlaylistChanged();
     }
 }
@@ -43,9 +59,25 @@ void PlaylistBridge::connectPlaylistSignals() {
     if (s_currentChangedConnection && s_connectedPlaylist) {
         s_connectedPlaylist->currentChanged.disconnect(*s_currentChangedConnection);
     }
+    if (s_itemsUpdatedConnection && s_connectedPlaylist) {
+        s_connectedPlaylist->itemsUpdated.disconnect(*s_itemsUpdatedConnection);
+    }
+    if (s_itemsAddedConnection && s_connectedPlaylist) {
+        s_connectedPlaylist->itemsAdded.disconnect(*s_itemsAddedConnection);
+    }
+    if (s_itemsRemovedConnection && s_connectedPlaylist) {
+        s_connectedPlaylist->itemsRemoved.disconnect(*s_itemsRemovedConnection);
+    }
+    if (s_itemMovedConnection && s_connectedPlaylist) {
+        s_connectedPlaylist->itemMoved.disconnect(*s_itemMovedConnection);
+    }
 
     s_changedConnection.reset();
     s_currentChangedConnection.reset();
+    s_itemsUpdatedConnection.reset();
+    s_itemsAddedConnection.reset();
+    s_itemsRemovedConnection.reset();
+    s_itemMovedConnection.reset();
     s_connectedPlaylist = s_playlist;
 
     if (!s_playlist) {
@@ -65,18 +97,48 @@ void PlaylistBridge::connectPlaylistSignals() {
 
         s_instance->onPlaylistCurrentChanged(index);
     });
+
+    s_itemsUpdatedConnection = s_playlist->itemsUpdated.connect([](const std::vector<std::size_t>& rows) {
+        if (s_instance) {
+            s_instance->onPlaylistItemsUpdated(rows);
+        }
+    });
+
+    // Row-level edits map onto insert/remove/move notifications, so views
+    // keep their delegates and scroll position instead of resetting
+    s_itemsAddedConnection = s_playlist->itemsAdded.connect([](std::size_t first, std::size_t count) {
+        if (s_instance) {
+            s_instance->onPlaylistItemsAdded(first, count);
+        }
+    });
+
+    s_itemsRemovedConnection = s_playlist->itemsRemoved.connect([](std::size_t first, std::size_t count) {
+        if (s_instance) {
+            s_instance->onPlaylistItemsRemoved(first, count);
+        }
+    });
+
+    s_itemMovedConnection = s_playlist->itemMoved.connect([](std::size_t from, std::size_t to) {
+        if (s_instance) {
+            s_instance->onPlaylistItemMoved(from, to);
+        }
+    });
 }
 
 int PlaylistBridge::rowCount(const QModelIndex&) const {
-    return s_playlist ? static_cast<int>(s_playlist->items().size()) : 0;
+    // Rows announced to views; the playlist may hold a not-yet-flushed tail
+    return rows_;
+}
+
+int PlaylistBridge::playlistSize() const {
+    return s_playlist ? static_cast<int>(s_playlist->size()) : 0;
 }
 
 QVariant PlaylistBridge::data(const QModelIndex& index, int role) const {
     if (!s_playlist || !index.isValid()) return QVariant();
-    const auto& items = s_playlist->items();
-    if (index.row() >= static_cast<int>(items.size())) return QVariant();
+    if (index.row() >= std::min(rows_, playlistSize())) return QVariant();
     
-    const auto& item = items[index.row()];
+    const auto& item = s_playlist->items()[index.row()];
     switch (role) {
         case TitleRole: return QString::fromStdString(item.metadata.displayTitle());
         case ArtistRole: return QString::fromStdString(item.metadata.displayArtist());
@@ -84,7 +146,8 @@ QVariant PlaylistBridge::data(const QModelIndex& index, int role) const {
             return QString::fromStdString(item.isRemote ? item.url : item.path.string());
   case DurationFormattedRole:
     return vc::file::formatDurationQString(item.metadata.duration.count());
-        case IsCurrentRole: return s_playlist->currentIndex() == static_cast<size_t>(index.row());
+        case IsCurrentRole: return shownCurrent_ == index.row();
+        case ArtUrlRole: return AlbumArtProvider::urlFor(item.metadata.artId);
     }
     return QVariant();
 }
@@ -96,6 +159,7 @@ QHash<int, QByteArray> PlaylistBridge::roleNames() const {
     roles[PathRole] = "path";
     roles[DurationFormattedRole] = "durationFormatted";
     roles[IsCurrentRole] = "isCurrent";
+    roles[ArtUrlRole] = "artUrl";
     return roles;
 }
 
@@ -143,38 +207,17 @@ void PlaylistBridge::addFiles(const QList<QUrl>& urls) {
         return;
     }
 
-    s_suppressPlaylistNotifications = true;
-    beginInsertRows(QModelIndex(), rowCount(), rowCount() + static_cast<int>(paths.size()) - 1);
-    for (const auto& path : paths) s_playlist->addFile(path);
-    endInsertRows();
-    s_suppressPlaylistNotifications = false;
-    emit countChanged();
-    emit currentIndexChanged();
+    s_playlist->addFiles(paths);
 }
 
 void PlaylistBridge::removeAt(int row) {
   if (!s_playlist || row < 0 || row >= rowCount()) return;
-  s_suppressPlaylistNotifications = true;
-  beginRemoveRows(QModelIndex(), row, row);
   s_playlist->removeAt(row);
-  endRemoveRows();
-  s_suppressPlaylistNotifications = false;
-  emit countChanged();
-  emit currentIndexChanged();
-  if (rowCount() > 0) {
-    emit dataChanged(QAbstractListModel::index(0, 0), QAbstractListModel::index(rowCount() - 1, 0), {IsCurrentRole});
-  }
 }
 
 void PlaylistBridge::clear() {
     if (!s_playlist) return;
-    s_suppressPlaylistNotifications = true;
-    beginResetModel();
     s_playlist->clear();
-    endResetModel();
-    s_suppressPlaylistNotifications = false;
-    emit countChanged();
-    emit currentIndexChanged();
 }
 
 void PlaylistBridge::playAt(int index) {
@@ -221,19 +264,7 @@ void PlaylistBridge::moveItem(int from, int to) {
         return;
     }
 
-    const auto destination = to > from ? to + 1 : to;
-
-    s_suppressPlaylistNotifications = true;
-    beginMoveRows(QModelIndex(), from, from, QModelIndex(), destination);
     s_playlist->move(static_cast<vc::usize>(from), static_cast<vc::usize>(to));
-    endMoveRows();
-    s_suppressPlaylistNotifications = false;
-
-  emit countChanged();
-  emit currentIndexChanged();
-  if (rowCount() > 0) {
-    emit dataChanged(QAbstractListModel::index(0, 0), QAbstractListModel::index(rowCount() - 1, 0), {IsCurrentRole});
-  }
 }
 
 QString PlaylistBridge::getItemPath(int idx) const {
@@ -254,24 +285,199 @@ void PlaylistBridge::onPlaylistChanged() {
         return;
     }
 
-    beginResetModel();
-    endResetModel();
+    // Edits arrive as row signals first; a mismatch means one didn't
+    if (rows_ + pendingInserted_ != playlistSize()) {
+        resetRows();
+    }
 
-    emit countChanged();
-    emit currentIndexChanged();
-    emit shuffleChanged();
-    emit repeatModeChanged();
+    propertiesDirty_ = true;
+    scheduleFlush();
+}
+
+void PlaylistBridge::onPlaylistItemsUpdated(const std::vector<std::size_t>& rows) {
+    // Rows still in the uncommitted tail are read fresh when it's announced
+    for (const std::size_t row : rows) {
+        if (static_cast<int>(row) < rows_) {
+            pendingRows_.push_back(static_cast<int>(row));
+        }
+    }
+    if (!pendingRows_.empty()) {
+        scheduleFlush();
+    }
+}
+
+void PlaylistBridge::onPlaylistItemsAdded(std::size_t first, std::size_t count) {
+    const int row = static_cast<int>(first);
+    const int n = static_cast<int>(count);
+    if (n == 0) {
+        return;
+    }
+    if (row > rows_ + pendingInserted_) {
+        resetRows();
+        return;
+    }
+
+    if (row >= rows_) {
+        // Into the tail: announced together with the rest of the burst
+        pendingInserted_ += n;
+    } else {
+        beginInsertRows(QModelIndex(), row, row + n - 1);
+        rows_ += n;
+        remapPending([&](int r) { return r >= row ? r + n : r; });
+        endInsertRows();
+    }
+    scheduleFlush();
+}
+
+void PlaylistBridge::onPlaylistItemsRemoved(std::size_t first, std::size_t count) {
+    const int row = static_cast<int>(first);
+    const int end = static_cast<int>(first + count);
+    if (row == end) {
+        return;
+    }
+    if (end > rows_ + pendingInserted_) {
+        resetRows();
+        return;
+    }
+
+    // Whatever falls in the tail was never announced
+    if (end > rows_) {
+        pendingInserted_ -= end - std::max(row, rows_);
+    }
+    const int committedEnd = std::min(end, rows_);
+    if (row < committedEnd) {
+        const int n = committedEnd - row;
+        beginRemoveRows(QModelIndex(), row, committedEnd - 1);
+        rows_ -= n;
+        remapPending([&](int r) { return r < row ? r : r < committedEnd ? -1 : r - n; });
+        endRemoveRows();
+    }
+    scheduleFlush();
+}
+
+void PlaylistBridge::onPlaylistItemMoved(std::size_t from, std::size_t to) {
+    const int source = static_cast<int>(from);
+    const int target = static_cast<int>(to);
+    if (source == target) {
+        return;
+    }
+    if (std::max(source, target) >= rows_ + pendingInserted_) {
+        resetRows();
+        return;
+    }
+
+    if (source < rows_ && target < rows_) {
+        // Qt's destination is the row the item lands before, pre-removal
+        const int destination = target > source ? target + 1 : target;
+        beginMoveRows(QModelIndex(), source, source, QModelIndex(), destination);
+        remapPending([&](int r) {
+            if (r == source) return target;
+            if (source < target && r > source && r <= target) return r - 1;
+            if (target < source && r >= target && r < source) return r + 1;
+            return r;
+        });
+        endMoveRows();
+    } else if (source < rows_) {
+        // Into the tail: leaves the committed rows, announced with the tail
+        beginRemoveRows(QModelIndex(), source, source);
+        --rows_;
+        ++pendingInserted_;
+        remapPending([&](int r) { return r < source ? r : r == source ? -1 : r - 1; });
+        endRemoveRows();
+    } else if (target < rows_) {
+        beginInsertRows(QModelIndex(), target, target);
+        ++rows_;
+        --pendingInserted_;
+        remapPending([&](int r) { return r >= target ? r + 1 : r; });
+        endInsertRows();
+    }
+    // Within the tail nothing has been shown yet
+    scheduleFlush();
 }
 
 void PlaylistBridge::onPlaylistCurrentChanged(std::size_t) {
-  if (!s_instance || s_suppressPlaylistNotifications) {
-    return;
-  }
+    if (!s_instance || s_suppressPlaylistNotifications) {
+        return;
+    }
 
-  emit currentIndexChanged();
-  if (rowCount() > 0) {
-    emit dataChanged(QAbstractListModel::index(0, 0), QAbstractListModel::index(rowCount() - 1, 0), {IsCurrentRole});
-  }
+    currentDirty_ = true;
+    scheduleFlush();
+}
+
+void PlaylistBridge::remapPending(const std::function<int(int)>& map) {
+    std::size_t kept = 0;
+    for (const int row : pendingRows_) {
+        if (const int mapped = map(row); mapped >= 0) {
+            pendingRows_[kept++] = mapped;
+        }
+    }
+    pendingRows_.resize(kept);
+    if (shownCurrent_ >= 0) {
+        shownCurrent_ = map(shownCurrent_);
+    }
+}
+
+void PlaylistBridge::scheduleFlush() {
+    if (!flushTimer_.isActive()) {
+        flushTimer_.start();
+    }
+}
+
+void PlaylistBridge::flushPending() {
+    if (pendingInserted_ > 0) {
+        beginInsertRows(QModelIndex(), rows_, rows_ + pendingInserted_ - 1);
+        rows_ += pendingInserted_;
+        pendingInserted_ = 0;
+        endInsertRows();
+    }
+
+    // One dataChanged per contiguous run, so views repaint only those rows
+    std::ranges::sort(pendingRows_);
+    const auto [last, tail] = std::ranges::unique(pendingRows_);
+    pendingRows_.erase(last, tail);
+    for (std::size_t i = 0; i < pendingRows_.size();) {
+        std::size_t end = i + 1;
+        while (end < pendingRows_.size() && pendingRows_[end] == pendingRows_[end - 1] + 1) {
+            ++end;
+        }
+        emit dataChanged(QAbstractListModel::index(pendingRows_[i], 0),
+                         QAbstractListModel::index(pendingRows_[end - 1], 0),
+                         {TitleRole, ArtistRole, DurationFormattedRole, ArtUrlRole});
+        i = end;
+    }
+    pendingRows_.clear();
+
+    const int current = currentIndex();
+    if (current != shownCurrent_) {
+        // Only the old and new current rows change their highlight
+        for (const int row : {shownCurrent_, current}) {
+            if (row >= 0 && row < rows_) {
+                const auto changed = QAbstractListModel::index(row, 0);
+                emit dataChanged(changed, changed, {IsCurrentRole});
+            }
+        }
+        shownCurrent_ = current;
+    }
+
+    if (propertiesDirty_) {
+        emit countChanged();
+        emit shuffleChanged();
+        emit repeatModeChanged();
+    }
+    if (propertiesDirty_ || currentDirty_) {
+        emit currentIndexChanged();
+    }
+    propertiesDirty_ = false;
+    currentDirty_ = false;
+}
+
+void PlaylistBridge::resetRows() {
+    beginResetModel();
+    rows_ = playlistSize();
+    pendingInserted_ = 0;
+    pendingRows_.clear();
+    endResetModel();
+    shownCurrent_ = currentIndex();
 }
 
 } // namespace qml_bridge
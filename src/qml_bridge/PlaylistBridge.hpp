@@ -3,8 +3,11 @@
 #include <QtQml/qqml.h>
 #include <QString>
 #include <QStringList>
+#include <QTimer>
 #include <QUrl>
+#include <functional>
 #include <optional>
+#include <vector>
 
 namespace vc {
 class Playlist;
@@ -28,7 +31,8 @@ public:
         ArtistRole,
         PathRole,
         DurationFormattedRole,
-        IsCurrentRole
+        IsCurrentRole,
+        ArtUrlRole
     };
 
     explicit PlaylistBridge(QObject* parent = nullptr);
@@ -64,14 +68,42 @@ signals:
 private slots:
     void onPlaylistChanged();
     void onPlaylistCurrentChanged(std::size_t index);
+    void onPlaylistItemsUpdated(const std::vector<std::size_t>& rows);
+    void onPlaylistItemsAdded(std::size_t first, std::size_t count);
+    void onPlaylistItemsRemoved(std::size_t first, std::size_t count);
+    void onPlaylistItemMoved(std::size_t from, std::size_t to);
 
 private:
+    static constexpr int FLUSH_INTERVAL_MS = 16; // one frame at 60 Hz
+
+    int playlistSize() const;
+    void scheduleFlush();
+    void flushPending();
+    void resetRows();
+    // Re-index rows queued for repaint after a structural edit; -1 drops
+    void remapPending(const std::function<int(int)>& map);
+
+    // The playlist is always the rows views know about (rows_) followed by
+    // pendingInserted_ appended rows they'll hear of on the next flush.
+    // Inserts, removes and moves among known rows are passed on at once,
+    // as Qt requires; everything else waits for the frame.
+    QTimer flushTimer_;
+    int rows_{0};
+    int pendingInserted_{0};
+    std::vector<int> pendingRows_; // metadata updates, known rows only
+    int shownCurrent_{-1};         // row the views highlight
+    bool currentDirty_{false};
+    bool propertiesDirty_{false};
 
     static vc::Playlist* s_playlist;
     static PlaylistBridge* s_instance;
     static vc::Playlist* s_connectedPlaylist;
     static std::optional<std::size_t> s_changedConnection;
     static std::optional<std::size_t> s_currentChangedConnection;
+    static std::optional<std::size_t> s_itemsUpdatedConnection;
+    static std::optional<std::size_t> s_itemsAddedConnection;
+    static std::optional<std::size_t> s_itemsRemovedConnection;
+    static std::optional<std::size_t> s_itemMovedConnection;
     static bool s_suppressPlaylistNotifications;
 };
 
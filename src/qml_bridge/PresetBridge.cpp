@@ -2,16 +2,21 @@
 #include "visualizer/PresetManager.hpp"
 #include "visualizer/PresetData.hpp"
 #include "visualizer/RatingManager.hpp"
+#include "core/Logger.hpp"
 #include <QQmlEngine>
 
 namespace qml_bridge {
 
 vc::PresetManager* PresetBridge::s_manager = nullptr;
 PresetBridge* PresetBridge::s_instance = nullptr;
+vc::PresetManager* PresetBridge::s_connectedManager = nullptr;
 
 PresetBridge::PresetBridge(QObject* parent)
     : QObject(parent)
 {
+    filterModel_.setSourceModel(&presetModel_);
+    QObject::connect(&filterModel_, &PresetFilterModel::queryChanged, this, &PresetBridge::searchQueryChanged);
+    QObject::connect(&filterModel_, &PresetFilterModel::categoryChanged, this, &PresetBridge::selectedCategoryChanged);
 }
 
 QObject* PresetBridge::create(QQmlEngine* qmlEngine, QJSEngine* jsEngine)
@@ -19,6 +24,7 @@ QObject* PresetBridge::create(QQmlEngine* qmlEngine, QJSEngine* jsEngine)
     Q_UNUSED(jsEngine)
     if (!s_instance) {
         s_instance = new PresetBridge(qmlEngine);
+        connectSignals();
     }
     return s_instance;
 }
@@ -26,17 +32,27 @@ QObject* PresetBridge::create(QQmlEngine* qmlEngine, QJSEngine* jsEngine)
 void PresetBridge::setPresetManager(vc::PresetManager* manager)
 {
     s_manager = manager;
+    connectSignals();
 }
 
 void PresetBridge::connectSignals()
 {
-    if (s_manager && s_instance) {
+    if (s_manager && s_instance && s_connectedManager != s_manager) {
+        s_connectedManager = s_manager;
+        s_instance->presetModel_.setPresetManager(s_manager);
         s_manager->presetChanged.connect([s = s_instance](const vc::PresetInfo* p) {
             s->onPresetChanged(p);
         });
         s_manager->listChanged.connect([s = s_instance]() {
             s->onListChanged();
         });
+        s_manager->presetUpdated.connect([s = s_instance](std::size_t index) {
+            s->onPresetUpdated(index);
+        });
+        // Profiled plays end on the render thread
+        s_manager->costUpdated.connect([s = s_instance](std::size_t index) {
+            QMetaObject::invokeMethod(s, [s, index] { s->onCostUpdated(index); }, Qt::QueuedConnection);
+        });
     }
 }
 
@@ -45,6 +61,7 @@ QVariantList PresetBridge::presets() const
     if (!s_manager) return {};
 
     QVariantList result;
+    auto lock = s_manager->lock();
     for (const auto& preset : s_manager->allPresets()) {
         result.append(presetToVariant(preset));
     }
@@ -56,6 +73,7 @@ QVariantList PresetBridge::activePresets() const
     if (!s_manager) return {};
 
     QVariantList result;
+    auto lock = s_manager->lock();
     for (const auto* preset : s_manager->activePresets()) {
         result.append(presetToVariant(*preset));
     }
@@ -67,6 +85,7 @@ QVariantList PresetBridge::favoritePresets() const
     if (!s_manager) return {};
 
     QVariantList result;
+    auto lock = s_manager->lock();
     for (const auto* preset : s_manager->favoritePresets()) {
         result.append(presetToVariant(*preset));
     }
@@ -78,6 +97,7 @@ QStringList PresetBridge::categories() const
     if (!s_manager) return {};
 
     QStringList result;
+    auto lock = s_manager->lock();
     for (const auto& cat : s_manager->categories()) {
         result.append(QString::fromStdString(cat));
     }
@@ -88,6 +108,7 @@ QVariantMap PresetBridge::currentPreset() const
 {
     if (!s_manager) return {};
 
+    auto lock = s_manager->lock();
     const auto* current = s_manager->current();
     if (!current) return {};
 
@@ -111,30 +132,22 @@ int PresetBridge::activeCount() const
 
 QString PresetBridge::searchQuery() const
 {
-    return searchQuery_;
+    return filterModel_.query();
 }
 
 QString PresetBridge::selectedCategory() const
 {
-    return selectedCategory_;
+    return filterModel_.category();
 }
 
 void PresetBridge::setSearchQuery(const QString& query)
 {
-    if (searchQuery_ != query) {
-        searchQuery_ = query;
-        emit searchQueryChanged();
-        emit presetsChanged();
-    }
+    filterModel_.setQuery(query);
 }
 
 void PresetBridge::setSelectedCategory(const QString& category)
 {
-    if (selectedCategory_ != category) {
-        selectedCategory_ = category;
-        emit selectedCategoryChanged();
-        emit presetsChanged();
-    }
+    filterModel_.setCategory(category);
 }
 
 bool PresetBridge::selectByIndex(int index)
@@ -185,10 +198,9 @@ void PresetBridge::setRating(int index, int rating)
 {
     if (!s_manager || index < 0 || rating < 1 || rating > 5) return;
 
-    const auto& presets = s_manager->allPresets();
-    if (static_cast<size_t>(index) < presets.size()) {
-        vc::RatingManager::instance().setRating(
-            presets[index].name, static_cast<int>(rating));
+    if (static_cast<size_t>(index) < s_manager->count()) {
+        s_manager->setRating(static_cast<size_t>(index), rating);
+        presetModel_.presetUpdated(index, {PresetListModel::RatingRole});
         emit presetsChanged();
     }
 }
@@ -202,25 +214,14 @@ QVariantList PresetBridge::filteredPresets() const
 {
     if (!s_manager) return {};
 
-    std::vector<const vc::PresetInfo*> filtered;
-
-    if (!searchQuery_.isEmpty()) {
-        filtered = s_manager->search(searchQuery_.toStdString());
-    } else if (selectedCategory_ == QLatin1String("__favorites__")) {
-        for (const auto* p : s_manager->favoritePresets()) {
-            filtered.push_back(p);
-        }
-    } else if (!selectedCategory_.isEmpty()) {
-        filtered = s_manager->byCategory(selectedCategory_.toStdString());
-    } else {
-        for (const auto* p : s_manager->activePresets()) {
-            filtered.push_back(p);
-        }
-    }
-
+    // Same rows as `model`, for scripts that want plain lists
     QVariantList result;
-    for (const auto* preset : filtered) {
-        result.append(presetToVariant(*preset));
+    auto lock = s_manager->lock();
+    const auto& presets = s_manager->allPresets();
+    for (int row = 0; row < filterModel_.rowCount(); ++row) {
+        const int source = filterModel_.mapToSource(filterModel_.index(row, 0)).row();
+        if (source >= 0 && static_cast<std::size_t>(source) < presets.size())
+            result.append(presetToVariant(presets[static_cast<std::size_t>(source)]));
     }
     return result;
 }
@@ -232,6 +233,24 @@ void PresetBridge::rescan()
     }
 }
 
+bool PresetBridge::exportPresetCosts(const QString& path)
+{
+    if (!s_manager || path.isEmpty()) return false;
+
+    if (auto res = s_manager->exportCosts(vc::fs::path(path.toStdString())); !res) {
+        LOG_WARN("PresetBridge: Failed to export preset costs: {}", res.error().message);
+        return false;
+    }
+    return true;
+}
+
+void PresetBridge::releaseQuarantine(int index)
+{
+    if (s_manager && index >= 0) {
+        s_manager->releaseQuarantine(static_cast<size_t>(index));
+    }
+}
+
 void PresetBridge::onPresetChanged(const vc::PresetInfo* preset)
 {
     Q_UNUSED(preset)
@@ -240,9 +259,25 @@ void PresetBridge::onPresetChanged(const vc::PresetInfo* preset)
 
 void PresetBridge::onListChanged()
 {
+    presetModel_.reload();
     emit presetsChanged();
 }
 
+void PresetBridge::onPresetUpdated(std::size_t index)
+{
+    presetModel_.presetUpdated(static_cast<int>(index),
+                               {PresetListModel::FavoriteRole, PresetListModel::BlacklistedRole});
+    emit presetsChanged();
+}
+
+void PresetBridge::onCostUpdated(std::size_t index)
+{
+    if (!s_manager || index >= s_manager->count()) return;
+    presetModel_.presetUpdated(static_cast<int>(index),
+                               {PresetListModel::FrameMsRole, PresetListModel::LoadMsRole,
+                                PresetListModel::QuarantinedRole});
+}
+
 QVariantMap PresetBridge::presetToVariant(const vc::PresetInfo& info) const
 {
     QVariantMap map;
@@ -5,6 +5,8 @@
 #include <QVariantList>
 #include <QVariantMap>
 #include <QStringList>
+#include "PresetFilterModel.hpp"
+#include "PresetListModel.hpp"
 #include "visualizer/PresetData.hpp"
 
 namespace vc {
@@ -18,6 +20,8 @@ class PresetBridge : public QObject {
     QML_ELEMENT
     QML_SINGLETON
 
+    // Filtered by searchQuery/selectedCategory; what the preset panel lists
+    Q_PROPERTY(QAbstractItemModel* model READ model CONSTANT)
     Q_PROPERTY(QVariantList presets READ presets NOTIFY presetsChanged)
     Q_PROPERTY(QVariantList activePresets READ activePresets NOTIFY presetsChanged)
     Q_PROPERTY(QVariantList favoritePresets READ favoritePresets NOTIFY presetsChanged)
@@ -37,6 +41,9 @@ public:
     static void setPresetManager(vc::PresetManager* manager);
     static void connectSignals();
 
+    QAbstractItemModel* model() {
+        return &filterModel_;
+    }
     QVariantList presets() const;
     QVariantList activePresets() const;
     QVariantList favoritePresets() const;
@@ -63,6 +70,9 @@ public slots:
     Q_INVOKABLE int getRating(const QString& presetName) const;
     Q_INVOKABLE QVariantList filteredPresets() const;
     Q_INVOKABLE void rescan();
+    // CSV, or JSON for a .json path; see PresetPersistence::exportCosts()
+    Q_INVOKABLE bool exportPresetCosts(const QString& path);
+    Q_INVOKABLE void releaseQuarantine(int index);
 
 signals:
     void presetsChanged();
@@ -73,16 +83,18 @@ signals:
 private slots:
     void onPresetChanged(const vc::PresetInfo* preset);
     void onListChanged();
+    void onPresetUpdated(std::size_t index);
+    void onCostUpdated(std::size_t index);
 
 private:
     QVariantMap presetToVariant(const vc::PresetInfo& info) const;
 
     static vc::PresetManager* s_manager;
     static PresetBridge* s_instance;
+    static vc::PresetManager* s_connectedManager;
 
-    QString searchQuery_;
-    QString selectedCategory_;
-    QVariantList cachedPresets_;
+    PresetListModel presetModel_;
+    PresetFilterModel filterModel_;
 };
 
 } // namespace qml_bridge
@@ -0,0 +1,156 @@
+#include "PresetFilterModel.hpp"
+#include "PresetListModel.hpp"
+#include "visualizer/PresetManager.hpp"
+#include "visualizer/PresetSearch.hpp"
+
+namespace qml_bridge {
+
+PresetFilterModel::PresetFilterModel(QObject* parent) : QAbstractProxyModel(parent) {}
+
+void PresetFilterModel::setSourceModel(QAbstractItemModel* source) {
+    if (sourceModel())
+        disconnect(sourceModel(), nullptr, this, nullptr);
+
+    QAbstractProxyModel::setSourceModel(source);
+    presets_ = qobject_cast<PresetListModel*>(source);
+
+    if (source) {
+        connect(source, &QAbstractItemModel::modelReset, this, &PresetFilterModel::refilter);
+        connect(source, &QAbstractItemModel::layoutChanged, this, &PresetFilterModel::refilter);
+        connect(source, &QAbstractItemModel::dataChanged, this, &PresetFilterModel::onSourceDataChanged);
+    }
+    refilter();
+}
+
+void PresetFilterModel::setQuery(const QString& query) {
+    if (query_ == query)
+        return;
+    query_ = query;
+    emit queryChanged();
+    refilter();
+}
+
+void PresetFilterModel::setCategory(const QString& category) {
+    if (category_ == category)
+        return;
+    category_ = category;
+    emit categoryChanged();
+    refilter();
+}
+
+void PresetFilterModel::refilter() {
+    const int before = count();
+    beginResetModel();
+    rows_.clear();
+
+    const auto* manager = presets_ ? presets_->presetManager() : nullptr;
+    std::unique_lock<std::recursive_mutex> lock;
+    if (manager)
+        lock = manager->lock();
+    const std::size_t total = manager ? manager->count() : 0;
+    if (manager) {
+        const auto& presets = manager->allPresets();
+        const std::string category = category_.toStdString();
+        const bool favorites = category == FAVORITES;
+        const bool blacklisted = category == BLACKLISTED;
+        const bool quarantined = category == QUARANTINED;
+        const bool named = !category.empty() && !favorites && !blacklisted && !quarantined;
+        auto accept = [&](const vc::PresetInfo& p) {
+            if (blacklisted)
+                return p.blacklisted;
+            if (p.blacklisted)
+                return false;
+            if (favorites)
+                return p.favorite;
+            if (quarantined)
+                return p.cost.quarantined;
+            return !named || p.category == category;
+        };
+
+        const std::string query = query_.toStdString();
+        if (!vc::PresetSearch::tokenize(query).empty()) {
+            // Ranked; the category only narrows it
+            for (const auto& hit : manager->searchIndex().search(query)) {
+                if (hit.preset < total && accept(presets[hit.preset]))
+                    rows_.push_back(static_cast<int>(hit.preset));
+            }
+        } else if (named) {
+            for (vc::u32 i : manager->searchIndex().inCategory(category)) {
+                if (i < total && accept(presets[i]))
+                    rows_.push_back(static_cast<int>(i));
+            }
+        } else {
+            for (std::size_t i = 0; i < total; ++i) {
+                if (accept(presets[i]))
+                    rows_.push_back(static_cast<int>(i));
+            }
+        }
+    }
+
+    proxyRow_.assign(total, -1);
+    for (std::size_t row = 0; row < rows_.size(); ++row)
+        proxyRow_[static_cast<std::size_t>(rows_[row])] = static_cast<int>(row);
+    // Views re-read rows on the reset; don't hold up the render thread
+    if (lock)
+        lock.unlock();
+
+    endResetModel();
+    if (count() != before)
+        emit countChanged();
+}
+
+void PresetFilterModel::onSourceDataChanged(const QModelIndex& topLeft,
+                                            const QModelIndex& bottomRight,
+                                            const QList<int>& roles) {
+    // Flag changes can move a preset in or out of the view
+    const bool membership = roles.isEmpty() || roles.contains(PresetListModel::BlacklistedRole) ||
+                            (category_ == QLatin1String(FAVORITES) && roles.contains(PresetListModel::FavoriteRole)) ||
+                            (category_ == QLatin1String(QUARANTINED) && roles.contains(PresetListModel::QuarantinedRole));
+    if (membership) {
+        refilter();
+        return;
+    }
+
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const auto source = static_cast<std::size_t>(row);
+        if (row < 0 || source >= proxyRow_.size() || proxyRow_[source] < 0)
+            continue;
+        const QModelIndex idx = index(proxyRow_[source], 0);
+        emit dataChanged(idx, idx, roles);
+    }
+}
+
+QModelIndex PresetFilterModel::index(int row, int column, const QModelIndex& parent) const {
+    if (parent.isValid() || column != 0 || row < 0 || row >= count())
+        return QModelIndex();
+    return createIndex(row, column);
+}
+
+QModelIndex PresetFilterModel::parent(const QModelIndex&) const {
+    return QModelIndex();
+}
+
+int PresetFilterModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : count();
+}
+
+int PresetFilterModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : 1;
+}
+
+QModelIndex PresetFilterModel::mapToSource(const QModelIndex& proxyIndex) const {
+    if (!sourceModel() || !proxyIndex.isValid() || proxyIndex.row() >= count())
+        return QModelIndex();
+    return sourceModel()->index(rows_[static_cast<std::size_t>(proxyIndex.row())], 0);
+}
+
+QModelIndex PresetFilterModel::mapFromSource(const QModelIndex& sourceIndex) const {
+    if (!sourceIndex.isValid())
+        return QModelIndex();
+    const auto row = static_cast<std::size_t>(sourceIndex.row());
+    if (row >= proxyRow_.size() || proxyRow_[row] < 0)
+        return QModelIndex();
+    return index(proxyRow_[row], 0);
+}
+
+} // namespace qml_bridge
@@ -0,0 +1,71 @@
+#pragma once
+#include <QAbstractProxyModel>
+#include <QPointer>
+#include <QString>
+#include <vector>
+
+namespace qml_bridge {
+
+class PresetListModel;
+
+// What the preset panel shows: the PresetListModel rows matching the
+// search text and category, ranked by PresetSearch when there is a query.
+// Rows come straight from the search index and category buckets rather
+// than filterAcceptsRow() over every preset, so a keystroke costs the
+// number of matches, not the size of the collection.
+class PresetFilterModel : public QAbstractProxyModel {
+    Q_OBJECT
+
+    Q_PROPERTY(QString query READ query WRITE setQuery NOTIFY queryChanged)
+    Q_PROPERTY(QString category READ category WRITE setCategory NOTIFY categoryChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    // Pseudo-categories; "" shows every preset not blacklisted
+    static constexpr const char* FAVORITES = "__favorites__";
+    static constexpr const char* BLACKLISTED = "__blacklisted__";
+    static constexpr const char* QUARANTINED = "__quarantined__";
+
+    explicit PresetFilterModel(QObject* parent = nullptr);
+
+    // Expects a PresetListModel
+    void setSourceModel(QAbstractItemModel* source) override;
+
+    QString query() const {
+        return query_;
+    }
+    void setQuery(const QString& query);
+    QString category() const {
+        return category_;
+    }
+    void setCategory(const QString& category);
+    int count() const {
+        return static_cast<int>(rows_.size());
+    }
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex mapToSource(const QModelIndex& proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex& sourceIndex) const override;
+
+signals:
+    void queryChanged();
+    void categoryChanged();
+    void countChanged();
+
+private:
+    void refilter();
+    void onSourceDataChanged(const QModelIndex& topLeft,
+                             const QModelIndex& bottomRight,
+                             const QList<int>& roles);
+
+    QPointer<PresetListModel> presets_;
+    QString query_;
+    QString category_;
+    std::vector<int> rows_;     // proxy row -> source row
+    std::vector<int> proxyRow_; // source row -> proxy row, -1 if hidden
+};
+
+} // namespace qml_bridge
@@ -0,0 +1,93 @@
+#include "PresetListModel.hpp"
+#include "visualizer/PresetManager.hpp"
+#include "visualizer/RatingManager.hpp"
+
+namespace qml_bridge {
+
+PresetListModel::PresetListModel(QObject* parent) : QAbstractListModel(parent) {}
+
+void PresetListModel::setPresetManager(const vc::PresetManager* manager) {
+    beginResetModel();
+    manager_ = manager;
+    endResetModel();
+}
+
+void PresetListModel::reload() {
+    beginResetModel();
+    endResetModel();
+}
+
+void PresetListModel::presetUpdated(int row, const QList<int>& roles) {
+    if (row < 0 || row >= rowCount())
+        return;
+    const QModelIndex idx = index(row);
+    emit dataChanged(idx, idx, roles);
+}
+
+int PresetListModel::rowCount(const QModelIndex& parent) const {
+    if (parent.isValid() || !manager_)
+        return 0;
+    return static_cast<int>(manager_->count());
+}
+
+QVariant PresetListModel::data(const QModelIndex& index, int role) const {
+    if (!manager_ || !index.isValid())
+        return QVariant();
+    // The render thread updates play counts and costs
+    auto lock = manager_->lock();
+    if (index.row() >= rowCount())
+        return QVariant();
+
+    const auto& info = manager_->allPresets()[static_cast<std::size_t>(index.row())];
+    switch (role) {
+    case Qt::DisplayRole:
+    case NameRole:
+        return QString::fromStdString(info.name);
+    case AuthorRole:
+        return QString::fromStdString(info.author);
+    case CategoryRole:
+        return QString::fromStdString(info.category);
+    case PathRole:
+        return QString::fromStdString(info.path.string());
+    case FavoriteRole:
+        return info.favorite;
+    case BlacklistedRole:
+        return info.blacklisted;
+    case PlayCountRole:
+        return static_cast<int>(info.playCount);
+    case RatingRole:
+        return vc::RatingManager::instance().getRating(info.name);
+    case PresetIndexRole:
+        return index.row();
+    case HasShaderRole:
+        return info.features.hasWarpShader() || info.features.hasCompShader();
+    case FrameMsRole:
+        return info.cost.frameMs();
+    case LoadMsRole:
+        return info.cost.loadMs;
+    case QuarantinedRole:
+        return info.cost.quarantined;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> PresetListModel::roleNames() const {
+    return {
+        {NameRole, "name"},
+        {AuthorRole, "author"},
+        {CategoryRole, "category"},
+        {PathRole, "path"},
+        {FavoriteRole, "favorite"},
+        {BlacklistedRole, "blacklisted"},
+        {PlayCountRole, "playCount"},
+        {RatingRole, "rating"},
+        {PresetIndexRole, "presetIndex"},
+        {HasShaderRole, "hasShader"},
+        {FrameMsRole, "frameMs"},
+        {LoadMsRole, "loadMs"},
+        {QuarantinedRole, "quarantined"},
+    };
+}
+
+} // namespace qml_bridge
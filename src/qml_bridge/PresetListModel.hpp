@@ -0,0 +1,52 @@
+#pragma once
+#include <QAbstractListModel>
+
+namespace vc {
+class PresetManager;
+}
+
+namespace qml_bridge {
+
+// Every preset PresetManager knows, in its order; roles read the
+// PresetInfo in place. PresetFilterModel narrows it down for the panel.
+class PresetListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        NameRole = Qt::UserRole + 1,
+        AuthorRole,
+        CategoryRole,
+        PathRole,
+        FavoriteRole,
+        BlacklistedRole,
+        PlayCountRole,
+        RatingRole,
+        PresetIndexRole, // index for PresetBridge.selectByIndex() & co.
+        HasShaderRole,
+        FrameMsRole,   // measured, 0 until played long enough
+        LoadMsRole,
+        QuarantinedRole
+    };
+
+    explicit PresetListModel(QObject* parent = nullptr);
+
+    void setPresetManager(const vc::PresetManager* manager);
+    const vc::PresetManager* presetManager() const {
+        return manager_;
+    }
+
+    // After a rescan
+    void reload();
+    // One preset's flags or rating changed
+    void presetUpdated(int row, const QList<int>& roles = {});
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+private:
+    const vc::PresetManager* manager_{nullptr};
+};
+
+} // namespace qml_bridge
@@ -81,24 +81,6 @@ void VisualizerItem::handleWindowChanged(QQuickWindow* window) {
 		connect(silentAudioTimer_.get(), &QTimer::timeout, this, &VisualizerItem::feedSilentAudio, Qt::DirectConnection);
 		silentAudioTimer_->start();
 	}
-
-	// Connect to audio engine's PCM signal for incremental audio feeding
-	connectAudioSignal();
-}
-
-void VisualizerItem::connectAudioSignal() {
-	if (audioConnected_ || !s_audioEngine) return;
-
-	connect(s_audioEngine, &vc::AudioEngine::pcmReceived,
-		this, [this](const std::vector<float>& data, u32 frames, u32 channels, u32 sampleRate) {
-			onPcmReceived(data, frames, channels, sampleRate);
-		}, Qt::QueuedConnection);
-
-	audioConnected_ = true;
-	LOG_INFO("VisualizerItem: Connected to audio engine PCM signal");
-}
-
-void VisualizerItem::onPcmReceived(const std::vector<float>&, vc::u32, vc::u32, vc::u32) {
 }
 
 void VisualizerItem::feedSilentAudio() {
@@ -155,6 +137,7 @@ void VisualizerItem::initializeRenderer() {
     }
 
     if (s_presetManager) {
+        auto lock = s_presetManager->lock();
         const auto& presets = s_presetManager->allPresets();
         if (!presets.empty()) {
             renderer_->projectM().engine().loadPreset(presets[0].path.string());
@@ -172,7 +155,6 @@ void VisualizerItem::cleanup() {
 		renderer_ = nullptr;
 	}
 	initialized_ = false;
-	audioConnected_ = false;
 }
 
 } // namespace qml_bridge
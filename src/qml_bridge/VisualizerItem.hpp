@@ -52,7 +52,6 @@ protected:
 public slots:
 	void handleWindowChanged(QQuickWindow* window);
 	void cleanup();
-	void onPcmReceived(const std::vector<float>& data, vc::u32 frames, vc::u32 channels, vc::u32 sampleRate);
 
 signals:
 	void fpsChanged();
@@ -66,7 +65,6 @@ private slots:
 private:
 	void initializeRenderer();
 	void updateDimensions();
-	void connectAudioSignal();
 
 	static vc::AudioEngine* s_audioEngine;
 	static vc::PresetManager* s_presetManager;
@@ -74,7 +72,6 @@ private:
 	vc::VisualizerRenderer* renderer_{nullptr};
 
 	bool initialized_{false};
-	bool audioConnected_{false};
 	int fps_{60};
 	std::unique_ptr<QTimer> renderTimer_;
 	std::unique_ptr<QTimer> silentAudioTimer_;
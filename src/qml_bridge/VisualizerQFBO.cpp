@@ -27,7 +27,6 @@ vc::PresetManager* VisualizerQFBO::s_presetManager = nullptr;
 
 VisualizerQFBO::VisualizerQFBO(QQuickItem* parent)
 : QQuickFramebufferObject(parent)
-, silentAudioTimer_(std::make_unique<QTimer>())
 , renderTimer_(std::make_unique<QTimer>())
 {
 setFlag(ItemHasContents);
@@ -101,15 +100,6 @@ Qt::DirectConnection);
 renderTimer_->start();
 LOG_INFO("VisualizerQFBO: Render timer started at {} FPS", fps_.load());
 }
-
-if (silentAudioTimer_) {
-silentAudioTimer_->setInterval(16);
-connect(silentAudioTimer_.get(), &QTimer::timeout, this, &VisualizerQFBO::feedSilentAudio,
-Qt::DirectConnection);
-silentAudioTimer_->start();
-}
-
-connectAudioSignal();
 }
 
 void VisualizerQFBO::cleanup() {
@@ -133,36 +123,6 @@ window()->update();
 }
 }
 
-void VisualizerQFBO::connectAudioSignal() {
-if (audioConnected_.load() || !s_audioEngine) return;
-
-connect(s_audioEngine, &vc::AudioEngine::pcmReceived,
-this, [this](const std::vector<float>& data, u32 frames, u32 channels, u32 sampleRate) {
-onPcmReceived(data, frames, channels, sampleRate);
-}, Qt::QueuedConnection);
-
-audioConnected_.store(true);
-LOG_INFO("VisualizerQFBO: Connected to audio engine PCM signal");
-}
-
-void VisualizerQFBO::onPcmReceived(const std::vector<float>& data, vc::u32 frames,
-    vc::u32 channels, vc::u32 sampleRate) {
-    Q_UNUSED(data)
-    Q_UNUSED(frames)
-    Q_UNUSED(channels)
-    Q_UNUSED(sampleRate)
-}
-
-void VisualizerQFBO::feedSilentAudio() {
-    if (!s_audioEngine) return;
-
-    auto& audioQueue = s_audioEngine->audioQueue();
-    if (audioQueue.vizDepth() < 100) {
-        alignas(64) float silentBuffer[1024 * 2] = {0};
-        audioQueue.pushViz(silentBuffer, 512, 2, 48000);
-    }
-}
-
 void VisualizerQFBO::updateDimensions() {
 if (!window()) return;
 
@@ -213,6 +173,7 @@ if (!initialized_) {
 renderer_->initialize(width_, height_);
 
 if (VisualizerQFBO::globalPresetManager()) {
+auto lock = VisualizerQFBO::globalPresetManager()->lock();
 const auto& presets = VisualizerQFBO::globalPresetManager()->allPresets();
 if (!presets.empty()) {
 renderer_->projectM().engine().loadPreset(presets[0].path.string());
@@ -266,12 +227,21 @@ void VisualizerQFBORenderer::render() {
 
     auto* audioQueue = renderer_->audioQueue();
     if (audioQueue) {
-        constexpr u32 BATCH_SIZE = 4096;
-        alignas(64) float batchBuffer[BATCH_SIZE * 2];
-        u32 framesToFeed = 2048;
-        u32 popped = audioQueue->popVizBatch(batchBuffer, framesToFeed);
-        if (popped > 0) {
-            renderer_->projectM().engine().addPCMDataInterleaved(batchBuffer, popped, 2);
+        constexpr u32 framesToFeed = 2048;
+        auto& engine = renderer_->projectM().engine();
+        auto spans = audioQueue->peek(vc::AudioConsumer::Viz, framesToFeed);
+        if (spans.empty()) {
+            // Keep projectM animating while nothing is playing
+            alignas(64) static const float silence[512 * 2] = {};
+            engine.addPCMDataInterleaved(silence, 512, 2);
+        } else {
+            engine.addPCMDataInterleaved(spans.first.data(),
+                static_cast<u32>(spans.first.size() / 2), 2);
+            if (!spans.second.empty()) {
+                engine.addPCMDataInterleaved(spans.second.data(),
+                    static_cast<u32>(spans.second.size() / 2), 2);
+            }
+            audioQueue->consume(vc::AudioConsumer::Viz, spans.frames());
         }
     }
 
@@ -78,13 +78,9 @@ void itemChange(ItemChange change, const ItemChangeData& value) override;
 
 public slots:
 void handleWindowChanged(QQuickWindow* window);
-void onPcmReceived(const std::vector<float>& data, vc::u32 frames,
-vc::u32 channels, vc::u32 sampleRate);
-void feedSilentAudio();
 void cleanup();
 
 private:
-void connectAudioSignal();
 void updateDimensions();
 void forceInitialUpdate();
 
@@ -95,14 +91,12 @@ std::atomic<int> fps_{60};
 std::atomic<int> presetIndex_{0};
 std::atomic<bool> recording_{false};
 std::atomic<bool> fullscreen_{false};
-std::atomic<bool> audioConnected_{false};
 std::atomic<bool> dimensionsDirty_{false};
 
 std::atomic<vc::u32> width_{0};
 std::atomic<vc::u32> height_{0};
 qreal devicePixelRatio_{1.0};
 
-std::unique_ptr<QTimer> silentAudioTimer_;
 std::unique_ptr<QTimer> renderTimer_;
 };
 
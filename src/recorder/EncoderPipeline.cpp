@@ -0,0 +1,341 @@
+#include "EncoderPipeline.hpp"
+#include <algorithm>
+#include <array>
+#include "audio/AudioQueue.hpp"
+#include "core/Logger.hpp"
+
+namespace vc {
+
+namespace {
+constexpr u32 AUDIO_BATCH_FRAMES = 4096;
+constexpr auto AUDIO_POLL_INTERVAL = std::chrono::milliseconds(5);
+// No samples for this long means nothing is playing; pad with silence
+constexpr i64 AUDIO_STALL_US = 200'000;
+} // namespace
+
+EncoderPipeline::EncoderPipeline(VideoRecorderFFmpeg& ffmpeg, FrameGrabber& frames)
+    : ffmpeg_(ffmpeg), frames_(frames) {}
+
+EncoderPipeline::~EncoderPipeline() {
+    stop();
+}
+
+Result<void> EncoderPipeline::start() {
+    if (running_)
+        return Result<void>::ok();
+
+    framePool_.clear();
+    for (u32 i = 0; i < FRAMES_IN_FLIGHT; ++i) {
+        auto frame = ffmpeg_.allocVideoFrame();
+        if (!frame)
+            return Result<void>::err("Failed to allocate encoder frames");
+        freeFrames_.tryPush(frame.get());
+        framePool_.push_back(std::move(frame));
+    }
+
+    clock_.start(RecordingClock::nowUs());
+    draining_ = false;
+    running_ = true;
+    convert_.thread = std::jthread([this] { convertLoop(); });
+    video_.thread = std::jthread([this] { videoLoop(); });
+    audio_.thread = std::jthread([this] { audioLoop(); });
+    mux_.thread = std::jthread([this] { muxLoop(); });
+
+    LOG_DEBUG("EncoderPipeline: started ({} frames in flight)", FRAMES_IN_FLIGHT);
+    return Result<void>::ok();
+}
+
+void EncoderPipeline::stop() {
+    if (!running_)
+        return;
+
+    // Each stage forwards an end-of-stream marker once its input is done,
+    // so joining upstream-first drains everything in order
+    draining_.store(true, std::memory_order_release);
+    for (auto* stage : {&convert_, &video_, &audio_, &mux_}) {
+        stage->wake.notify();
+        if (stage->thread.joinable())
+            stage->thread.join();
+    }
+
+    AVFrame* frame = nullptr;
+    while (freeFrames_.tryPop(frame)) {
+    }
+    framePool_.clear();
+    running_ = false;
+
+    LOG_DEBUG("EncoderPipeline: drained ({} frames, {} bytes)",
+              framesEncoded(),
+              bytesWritten());
+}
+
+std::shared_ptr<FramePool> EncoderPipeline::framePool() const {
+    std::lock_guard lock(poolMutex_);
+    return capturePool_.lock();
+}
+
+template<typename T>
+void EncoderPipeline::push(SpscQueue<T>& queue, T value, Stage& self, Stage& consumer) {
+    while (true) {
+        u32 seen = self.wake.epoch();
+        if (queue.tryPush(value)) {
+            consumer.wake.notify();
+            return;
+        }
+        self.wake.wait(seen);
+    }
+}
+
+void EncoderPipeline::convertLoop() {
+    AVFrame* dst = nullptr;
+    const FramePool* lastPool = nullptr;
+
+    while (true) {
+        GrabbedFrame frame;
+        if (!frames_.getNextFrame(frame, 10)) {
+            if (draining_.load(std::memory_order_acquire) && !frames_.hasFrames())
+                break;
+            continue;
+        }
+
+        if (frame.pooled && frame.pooled.pool().get() != lastPool) {
+            lastPool = frame.pooled.pool().get();
+            std::lock_guard lock(poolMutex_);
+            capturePool_ = frame.pooled.pool();
+        }
+
+        // Wait for the video stage to hand back an encoded frame
+        while (!dst) {
+            u32 seen = convert_.wake.epoch();
+            if (freeFrames_.tryPop(dst))
+                break;
+            convert_.wake.wait(seen);
+        }
+
+        const i64 mediaUs = clock_.mediaTimeUs(frame.timestamp);
+        if (!ffmpeg_.convertVideo(frame, dst)) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            LOG_WARN("EncoderPipeline: failed to convert frame {}", frame.frameNumber);
+            continue;
+        }
+
+        // The capture slot is no longer needed once converted
+        frame.pooled.reset();
+        convert_.processed.fetch_add(1, std::memory_order_relaxed);
+        push(convertedFrames_, ConvertedFrame{dst, mediaUs}, convert_, video_);
+        dst = nullptr;
+    }
+
+    push(convertedFrames_, ConvertedFrame{}, convert_, video_);
+}
+
+void EncoderPipeline::videoLoop() {
+    const VideoRecorderFFmpeg::PacketSink sink = [this](AVPacket* packet) {
+        AVPacket* owned = av_packet_alloc();
+        av_packet_move_ref(owned, packet);
+        push(videoPackets_, owned, video_, mux_);
+    };
+
+    while (true) {
+        u32 seen = video_.wake.epoch();
+        ConvertedFrame converted;
+        if (!convertedFrames_.tryPop(converted)) {
+            video_.wake.wait(seen);
+            continue;
+        }
+        convert_.wake.notify();
+        AVFrame* frame = converted.frame;
+        if (!frame)
+            break;
+
+        if (ffmpeg_.sendVideo(frame, converted.mediaUs, sink)) {
+            video_.processed.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            LOG_WARN("EncoderPipeline: failed to encode video frame");
+        }
+
+        freeFrames_.tryPush(frame);
+        convert_.wake.notify();
+    }
+
+    ffmpeg_.sendVideo(nullptr, 0, sink);
+    push(videoPackets_, static_cast<AVPacket*>(nullptr), video_, mux_);
+}
+
+void EncoderPipeline::audioLoop() {
+    const VideoRecorderFFmpeg::PacketSink sink = [this](AVPacket* packet) {
+        AVPacket* owned = av_packet_alloc();
+        av_packet_move_ref(owned, packet);
+        push(audioPackets_, owned, audio_, mux_);
+    };
+
+    static const std::array<f32, AUDIO_BATCH_FRAMES * 2> silence{};
+    // Input (AudioQueue) rate; the encoder's resampler converts from it
+    u32 rate = ffmpeg_.audioInputRate();
+    AudioQueue* syncedQueue = nullptr;
+    u64 position = 0; // input frames handed to the encoder, padding included
+    i64 lastAudioUs = RecordingClock::nowUs();
+    drift_.start(rate);
+
+    while (ffmpeg_.hasAudio()) {
+        // Read the flag first so one last pass drains what is already queued
+        bool draining = draining_.load(std::memory_order_acquire);
+        u32 popped = 0;
+        const i64 now = RecordingClock::nowUs();
+
+        if (auto* queue = audioQueue_.load(std::memory_order_acquire)) {
+            if (queue != syncedQueue) {
+                // Start from "now", not from whatever played before recording
+                queue->seekToLatest(AudioConsumer::Rec);
+                syncedQueue = queue;
+            }
+            if (u32 queueRate = queue->sampleRate(); queueRate != rate) {
+                // Keep the timeline continuous across the switch
+                if (ffmpeg_.setAudioInputRate(queueRate)) {
+                    position = position * queueRate / std::max<u32>(rate, 1);
+                    rate = queueRate;
+                    drift_.start(rate);
+                } else {
+                    errors_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            // Resample straight out of the ring; both halves land in the
+            // encoder's FIFO before the slots are released
+            auto spans = queue->peek(AudioConsumer::Rec, AUDIO_BATCH_FRAMES);
+            popped = spans.frames();
+            if (popped > 0) {
+                bool ok = ffmpeg_.sendAudio(spans.first, sink);
+                ok = ffmpeg_.sendAudio(spans.second, sink) && ok;
+                if (!ok)
+                    errors_.fetch_add(1, std::memory_order_relaxed);
+                queue->consume(AudioConsumer::Rec, popped);
+                audio_.processed.fetch_add(popped, std::memory_order_relaxed);
+
+                // Everything still queued was produced by now as well
+                position += popped;
+                lastAudioUs = now;
+                const u64 produced = position + queue->depth(AudioConsumer::Rec);
+                if (i64 delta = drift_.update(produced, now); delta != 0) {
+                    ffmpeg_.compensateAudio(static_cast<i32>(delta),
+                                            static_cast<i32>(rate * DriftCompensator::INTERVAL_US /
+                                                             1'000'000));
+                    driftPpm_.store(drift_.ppm(), std::memory_order_relaxed);
+                }
+                clock_.anchorAudio(produced + drift_.compensatedFrames(), rate, now);
+            }
+        }
+
+        if (popped == 0 && now - lastAudioUs >= AUDIO_STALL_US) {
+            // Playback paused or no source: fill the gap up to where the
+            // clock says audio should be, so later video stays aligned
+            i64 target = clock_.mediaTimeUs(now) * rate / 1'000'000 - drift_.compensatedFrames();
+            while (static_cast<i64>(position) < target) {
+                u64 frames = std::min<u64>(static_cast<u64>(target) - position,
+                                           AUDIO_BATCH_FRAMES);
+                ffmpeg_.sendAudio(std::span<const f32>(silence.data(), frames * 2), sink);
+                position += frames;
+            }
+            lastAudioUs = now;
+            clock_.anchorAudio(position + drift_.compensatedFrames(), rate, now);
+        }
+
+        if (draining)
+            break;
+        if (popped == 0)
+            std::this_thread::sleep_for(AUDIO_POLL_INTERVAL);
+    }
+
+    ffmpeg_.flushAudio(sink);
+    push(audioPackets_, static_cast<AVPacket*>(nullptr), audio_, mux_);
+}
+
+void EncoderPipeline::muxLoop() {
+    bool videoDone = false;
+    bool audioDone = false;
+
+    auto write = [this](AVPacket* packet, AVStream* stream) {
+        u64 bytes = 0;
+        if (ffmpeg_.writePacket(packet, stream, bytes)) {
+            bytesWritten_.fetch_add(bytes, std::memory_order_relaxed);
+            mux_.processed.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+        }
+        av_packet_free(&packet);
+    };
+
+    while (!videoDone || !audioDone) {
+        u32 seen = mux_.wake.epoch();
+        bool progressed = false;
+        AVPacket* packet = nullptr;
+
+        while (!videoDone && videoPackets_.tryPop(packet)) {
+            progressed = true;
+            video_.wake.notify();
+            if (!packet)
+                videoDone = true;
+            else
+                write(packet, ffmpeg_.videoStream());
+        }
+        while (!audioDone && audioPackets_.tryPop(packet)) {
+            progressed = true;
+            audio_.wake.notify();
+            if (!packet)
+                audioDone = true;
+            else
+                write(packet, ffmpeg_.audioStream());
+        }
+
+        if (!progressed)
+            mux_.wake.wait(seen);
+    }
+}
+
+void EncoderPipeline::fillStage(PipelineStageStats& out,
+                                Stage& stage,
+                                u32 depth,
+                                u32 capacity,
+                                f64 intervalSecs) {
+    u64 processed = stage.processed.load(std::memory_order_relaxed);
+    out.processed = processed;
+    out.perSecond = intervalSecs > 0.0
+                            ? static_cast<f64>(processed - stage.lastProcessed) / intervalSecs
+                            : 0.0;
+    out.queueDepth = depth;
+    out.queueCapacity = capacity;
+    stage.lastProcessed = processed;
+}
+
+void EncoderPipeline::sampleStats(RecordingStats& stats, f64 intervalSecs) {
+    fillStage(stats.convertStage,
+              convert_,
+              static_cast<u32>(frames_.queueSize()),
+              static_cast<u32>(frames_.capacity()),
+              intervalSecs);
+    fillStage(stats.videoStage,
+              video_,
+              convertedFrames_.size(),
+              convertedFrames_.capacity(),
+              intervalSecs);
+
+    auto* queue = audioQueue_.load(std::memory_order_acquire);
+    fillStage(stats.audioStage,
+              audio_,
+              queue ? queue->depth(AudioConsumer::Rec) : 0,
+              queue ? queue->capacity() : 0,
+              intervalSecs);
+    stats.audioClockDriftMs = static_cast<f64>(clock_.audioDriftUs()) / 1000.0;
+    stats.audioDriftCompensationPpm = driftPpm_.load(std::memory_order_relaxed);
+    stats.videoSyncErrorMs = static_cast<f64>(ffmpeg_.videoSyncErrorUs()) / 1000.0;
+    stats.framesDuplicated = ffmpeg_.framesDuplicated();
+    stats.framesSkipped = ffmpeg_.framesSkipped();
+
+    fillStage(stats.muxStage,
+              mux_,
+              videoPackets_.size() + audioPackets_.size(),
+              videoPackets_.capacity() + audioPackets_.capacity(),
+              intervalSecs);
+}
+
+} // namespace vc
@@ -0,0 +1,146 @@
+/**
+ * @file EncoderPipeline.hpp
+ * @brief Multi-threaded convert -> encode -> mux pipeline for live recording.
+ *
+ * This file defines the EncoderPipeline class which splits recording into
+ * four stage threads:
+ *
+ *   FrameGrabber -> [convert] -> frames -> [video encode] -> packets -+
+ *   AudioQueue   ------------------------> [audio encode] -> packets -+-> [mux]
+ *
+ * Stages are connected by bounded lock-free SPSC queues, so converting
+ * frame N+1 overlaps encoding frame N and muxing never blocks an encoder.
+ * Converted AVFrames come from a small fixed set that the video stage
+ * hands back to the convert stage after encoding. A full downstream queue
+ * stalls its producer (backpressure ends at FrameGrabber, which drops the
+ * oldest frame and counts it).
+ *
+ * Each VideoRecorderFFmpeg context is touched by exactly one stage, so the
+ * stages never take VideoRecorderFFmpeg's mutex.
+ *
+ * Timing follows the audio: the audio stage anchors a RecordingClock to the
+ * sample position it has recorded, and the convert stage maps each frame's
+ * capture timestamp through it to a media time for the video encoder. While
+ * no audio arrives the audio stage writes silence so the audio track keeps
+ * pace with wall time. A DriftCompensator nudges the encoder's resampler a
+ * few hundred ppm at most so the audio clock itself tracks wall time over
+ * long recordings, instead of video being squeezed onto a drifting clock.
+ * The audio stage follows AudioQueue::sampleRate() as its input rate.
+ *
+ * @section Dependencies
+ * - VideoRecorderFFmpeg (stage API)
+ * - FrameGrabber, AudioQueue
+ * - SpscQueue / WakeSignal
+ * - RecordingClock, DriftCompensator
+ */
+
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "FrameGrabber.hpp"
+#include "RecordingClock.hpp"
+#include "VideoRecorderCore.hpp"
+#include "VideoRecorderFFmpeg.hpp"
+#include "util/Result.hpp"
+#include "util/SpscQueue.hpp"
+
+namespace vc {
+
+class AudioQueue;
+
+class EncoderPipeline {
+public:
+    EncoderPipeline(VideoRecorderFFmpeg& ffmpeg, FrameGrabber& frames);
+    ~EncoderPipeline();
+
+    EncoderPipeline(const EncoderPipeline&) = delete;
+    EncoderPipeline& operator=(const EncoderPipeline&) = delete;
+
+    void setAudioQueue(AudioQueue* queue) {
+        audioQueue_.store(queue, std::memory_order_release);
+    }
+
+    // Allocates the in-flight encoder frames and spawns the stage threads
+    Result<void> start();
+
+    // Finish everything already captured, flush both encoders and return
+    // once the muxer has written the last packet. Stop the FrameGrabber
+    // first so the convert stage sees the end of the stream.
+    void stop();
+
+    u64 framesEncoded() const {
+        return video_.processed.load(std::memory_order_relaxed);
+    }
+    u64 bytesWritten() const {
+        return bytesWritten_.load(std::memory_order_relaxed);
+    }
+    u64 errorCount() const {
+        return errors_.load(std::memory_order_relaxed);
+    }
+
+    // Pool the most recently converted capture frame was leased from
+    std::shared_ptr<FramePool> framePool() const;
+
+    // Fill the per-stage and A/V sync fields of `stats`; rates are over the
+    // time since the previous call. Call from one thread only.
+    void sampleStats(RecordingStats& stats, f64 intervalSecs);
+
+private:
+    static constexpr u32 FRAMES_IN_FLIGHT = 4;
+    static constexpr u32 PACKET_QUEUE_SIZE = 256;
+
+    // Converted frame plus its position on the recording timeline
+    struct ConvertedFrame {
+        AVFrame* frame{nullptr}; // nullptr = EOS
+        i64 mediaUs{0};
+    };
+
+    struct Stage {
+        std::jthread thread;
+        WakeSignal wake;
+        std::atomic<u64> processed{0};
+        u64 lastProcessed{0};
+    };
+
+    void convertLoop();
+    void videoLoop();
+    void audioLoop();
+    void muxLoop();
+
+    // Producer side of a stage link: wait on `self` while `queue` is full
+    template<typename T>
+    void push(SpscQueue<T>& queue, T value, Stage& self, Stage& consumer);
+
+    static void fillStage(PipelineStageStats& out, Stage& stage, u32 depth,
+                          u32 capacity, f64 intervalSecs);
+
+    VideoRecorderFFmpeg& ffmpeg_;
+    FrameGrabber& frames_;
+    std::atomic<AudioQueue*> audioQueue_{nullptr};
+    RecordingClock clock_;
+    DriftCompensator drift_;          // audio stage only
+    std::atomic<f64> driftPpm_{0.0};  // drift_.ppm() for stats
+
+    std::vector<AVFramePtr> framePool_;
+    SpscQueue<AVFrame*> freeFrames_{FRAMES_IN_FLIGHT};
+    SpscQueue<ConvertedFrame> convertedFrames_{FRAMES_IN_FLIGHT};
+    SpscQueue<AVPacket*> videoPackets_{PACKET_QUEUE_SIZE};  // nullptr = EOS
+    SpscQueue<AVPacket*> audioPackets_{PACKET_QUEUE_SIZE};  // nullptr = EOS
+
+    Stage convert_;
+    Stage video_;
+    Stage audio_;
+    Stage mux_;
+
+    mutable std::mutex poolMutex_;
+    std::weak_ptr<FramePool> capturePool_;
+
+    std::atomic<bool> draining_{false};
+    std::atomic<u64> bytesWritten_{0};
+    std::atomic<u64> errors_{0};
+    bool running_{false};
+};
+
+} // namespace vc
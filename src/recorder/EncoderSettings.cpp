@@ -165,6 +165,7 @@ EncoderSettings EncoderSettings::fromConfig() {
     settings.video.width = recCfg.video.width;
     settings.video.height = recCfg.video.height;
     settings.video.fps = recCfg.video.fps;
+    settings.video.variableFrameRate = recCfg.video.vfr;
     settings.video.crf = 23; // Default to 23 for better performance on N4500
 
     // Parse preset
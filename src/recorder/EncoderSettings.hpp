@@ -85,6 +85,7 @@ struct VideoSettings {
     u32 gopSize{0};             // 0 = auto (fps * 2)
     u32 bFrames{3};
     bool twoPass{false};
+    bool variableFrameRate{false}; // PTS straight from capture time, no dup/skip
     
     // Hardware acceleration
     HWAccelDevice hwAccel{HWAccelDevice::None};
@@ -3,8 +3,10 @@
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
+#include <libavutil/audio_fifo.h>
 #include <libavutil/avutil.h>
 #include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
 #include <libswscale/swscale.h>
 #include <libswresample/swresample.h>
 }
@@ -28,16 +30,22 @@ struct AVFormatContextDeleter {
         }
     } 
 };
+struct AVInputContextDeleter {
+    void operator()(AVFormatContext* c) const { if (c) avformat_close_input(&c); }
+};
 struct SwsContextDeleter { void operator()(SwsContext* s) const { if (s) sws_freeContext(s); } };
 struct SwrContextDeleter { void operator()(SwrContext* s) const { if (s) swr_free(&s); } };
+struct AVAudioFifoDeleter { void operator()(AVAudioFifo* f) const { if (f) av_audio_fifo_free(f); } };
 
 // Unique pointer aliases
 using AVFramePtr = std::unique_ptr<AVFrame, AVFrameDeleter>;
 using AVPacketPtr = std::unique_ptr<AVPacket, AVPacketDeleter>;
 using AVCodecContextPtr = std::unique_ptr<AVCodecContext, AVCodecContextDeleter>;
 using AVFormatContextPtr = std::unique_ptr<AVFormatContext, AVFormatContextDeleter>;
+using AVInputContextPtr = std::unique_ptr<AVFormatContext, AVInputContextDeleter>;
 using SwsContextPtr = std::unique_ptr<SwsContext, SwsContextDeleter>;
 using SwrContextPtr = std::unique_ptr<SwrContext, SwrContextDeleter>;
+using AVAudioFifoPtr = std::unique_ptr<AVAudioFifo, AVAudioFifoDeleter>;
 
 // Helper for error messages
 inline std::string ffmpegError(int err) {
@@ -9,17 +9,27 @@
 #include <queue>
 #include <thread>
 #include <vector>
+#include "FramePool.hpp"
 #include "util/Types.hpp"
 #include "visualizer/RenderTarget.hpp"
 
 namespace vc {
 
 struct GrabbedFrame {
-    std::vector<u8> data;
+    FrameRef pooled;        // leased pool slot (live capture)
+    std::vector<u8> data;   // owned pixels (synchronous grabs, offline)
     u32 width{0};
     u32 height{0};
     i64 timestamp{0}; // microseconds
     u32 frameNumber{0};
+    FrameFormat format{FrameFormat::RGBA};
+
+    const u8* pixels() const {
+        return pooled ? pooled.data() : data.data();
+    }
+    bool empty() const {
+        return !pooled && data.empty();
+    }
 };
 
 class FrameGrabber : protected QOpenGLFunctions_3_3_Core {
@@ -29,14 +39,11 @@ public:
 
     // Configuration
     void setSize(u32 width, u32 height);
-    void setFlipVertical(bool flip) {
-        flipVertical_ = flip;
-    }
 
-    // Grab frame from render target
+    // Grab frame from render target (RGBA, GL row order; the encoder flips)
     void grab(RenderTarget& target, i64 timestamp);
 
-    // Grab from current framebuffer
+    // Grab from current framebuffer (RGBA, GL row order)
     void grabScreen(u32 width, u32 height, i64 timestamp);
 
     // Get next frame (blocking)
@@ -45,6 +52,9 @@ public:
     // Check if frames available
     bool hasFrames() const;
     usize queueSize() const;
+    usize capacity() const {
+        return MAX_QUEUE_SIZE;
+    }
 
     // Statistics
     u32 droppedFrames() const {
@@ -73,13 +83,8 @@ public:
     }
 
 private:
-    void flipImage(std::vector<u8>& data, u32 width, u32 height);
-    void flipImageGPU(std::vector<u8>& data, u32 width, u32 height);
-
     u32 width_{1920};
     u32 height_{1080};
-    bool flipVertical_{true}; // OpenGL is bottom-up
-    bool useGPUFlip_{true};   // Use GPU acceleration for flipping
 
     std::queue<GrabbedFrame> frameQueue_;
     mutable std::mutex queueMutex_;
@@ -92,40 +97,4 @@ private:
     static constexpr usize MAX_QUEUE_SIZE = 30; // ~0.5 sec at 60fps
 };
 
-// PBO-based async frame grabber for better performance
-class AsyncFrameGrabber : protected QOpenGLFunctions_3_3_Core {
-public:
-    AsyncFrameGrabber();
-    ~AsyncFrameGrabber();
-
-    // Initialize with size and PBO count
-    Result<void> init(u32 width, u32 height, u32 pboCount = 3);
-    void shutdown();
-
-    // Start async read (non-blocking)
-    void startRead(RenderTarget& target, i64 timestamp);
-
-    // Get completed frame (non-blocking)
-    bool getCompletedFrame(GrabbedFrame& frame);
-
-    // Resize (recreates PBOs)
-    Result<void> resize(u32 width, u32 height);
-
-private:
-    struct PBOSlot {
-        GLuint pbo{0};
-        bool inUse{false};
-        bool ready{false};
-        i64 timestamp{0};
-        u32 frameNumber{0};
-    };
-
-    std::vector<PBOSlot> pboSlots_;
-    u32 currentSlot_{0};
-    u32 width_{0};
-    u32 height_{0};
-    u32 frameNumber_{0};
-    bool initialized_{false};
-};
-
 } // namespace vc
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "FramePool.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include "core/Logger.hpp"
+
+namespace vc {
+
+// ============================================================================
+// FrameRef
+// ============================================================================
+
+FrameRef::FrameRef(std::shared_ptr<FramePool> pool, u32 slot)
+    : pool_(std::move(pool)), slot_(slot) {}
+
+FrameRef::~FrameRef() {
+    reset();
+}
+
+FrameRef::FrameRef(const FrameRef& other) : pool_(other.pool_), slot_(other.slot_) {
+    if (pool_)
+        pool_->retain(slot_);
+}
+
+FrameRef& FrameRef::operator=(const FrameRef& other) {
+    if (this != &other) {
+        if (other.pool_)
+            other.pool_->retain(other.slot_);
+        reset();
+        pool_ = other.pool_;
+        slot_ = other.slot_;
+    }
+    return *this;
+}
+
+FrameRef::FrameRef(FrameRef&& other) noexcept
+    : pool_(std::move(other.pool_)), slot_(other.slot_) {}
+
+FrameRef& FrameRef::operator=(FrameRef&& other) noexcept {
+    if (this != &other) {
+        reset();
+        pool_ = std::move(other.pool_);
+        slot_ = other.slot_;
+    }
+    return *this;
+}
+
+u8* FrameRef::data() const {
+    return pool_ ? pool_->slots_[slot_].data : nullptr;
+}
+
+usize FrameRef::size() const {
+    return pool_ ? pool_->slotBytes_ : 0;
+}
+
+FrameFormat FrameRef::format() const {
+    return pool_ ? pool_->format_ : FrameFormat::RGBA;
+}
+
+void FrameRef::reset() {
+    if (pool_) {
+        pool_->release(slot_);
+        pool_.reset();
+    }
+}
+
+// ============================================================================
+// FramePool
+// ============================================================================
+
+std::shared_ptr<FramePool> FramePool::create(usize slotBytes,
+                                             u32 slotCount,
+                                             FrameFormat format) {
+    return std::shared_ptr<FramePool>(new FramePool(slotBytes, slotCount, format));
+}
+
+FramePool::FramePool(usize slotBytes, u32 slotCount, FrameFormat format)
+    : slotBytes_(slotBytes),
+      slotCount_(std::clamp<u32>(slotCount, 1, MAX_FRAME_POOL_SLOTS)),
+      format_(format),
+      slots_(std::make_unique<Slot[]>(slotCount_)) {
+    usize allocBytes = (std::max<usize>(slotBytes_, 1) + FRAME_POOL_ALIGNMENT - 1) &
+                       ~(FRAME_POOL_ALIGNMENT - 1);
+
+    u64 mask = 0;
+    for (u32 i = 0; i < slotCount_; ++i) {
+        auto* data = static_cast<u8*>(std::aligned_alloc(FRAME_POOL_ALIGNMENT, allocBytes));
+        if (!data) {
+            LOG_WARN("FramePool: allocated only {}/{} slots", i, slotCount_);
+            break;
+        }
+        // Touch every page now so the first recorded frames don't fault
+        std::memset(data, 0, allocBytes);
+        slots_[i].data = data;
+        mask |= u64{1} << i;
+    }
+    allocated_ = static_cast<u32>(std::popcount(mask));
+    freeMask_.store(mask, std::memory_order_release);
+
+    LOG_DEBUG("FramePool: {} slots x {} KB", allocated_, allocBytes / 1024);
+}
+
+FramePool::~FramePool() {
+    // Every FrameRef holds a shared_ptr to us, so no slot is leased here
+    for (u32 i = 0; i < slotCount_; ++i)
+        std::free(slots_[i].data);
+}
+
+FrameRef FramePool::acquire() {
+    u64 mask = freeMask_.load(std::memory_order_acquire);
+    while (mask != 0) {
+        u32 slot = static_cast<u32>(std::countr_zero(mask));
+        if (freeMask_.compare_exchange_weak(mask,
+                                            mask & ~(u64{1} << slot),
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+            slots_[slot].refs.store(1, std::memory_order_relaxed);
+
+            u32 used = inUse();
+            u32 peak = peakInUse_.load(std::memory_order_relaxed);
+            while (used > peak &&
+                   !peakInUse_.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+            }
+            return FrameRef(shared_from_this(), slot);
+        }
+    }
+
+    exhausted_.fetch_add(1, std::memory_order_relaxed);
+    return {};
+}
+
+u32 FramePool::inUse() const {
+    // Slots that failed to allocate are never free, but not leased either
+    return allocated_ -
+           static_cast<u32>(std::popcount(freeMask_.load(std::memory_order_relaxed)));
+}
+
+void FramePool::retain(u32 slot) {
+    slots_[slot].refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FramePool::release(u32 slot) {
+    if (slots_[slot].refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        freeMask_.fetch_or(u64{1} << slot, std::memory_order_release);
+}
+
+} // namespace vc
@@ -0,0 +1,134 @@
+/**
+ * @file FramePool.hpp
+ * @brief Recycled, page-aligned frame buffers for the capture -> encode path.
+ *
+ * This file defines FramePool, a fixed set of preallocated frame slots, and
+ * FrameRef, a refcounted lease on one slot. The capture side (PBO readback)
+ * acquires a slot, fills it and hands the FrameRef through the frame queue;
+ * the encoder thread drops its FrameRef after encoding, which returns the
+ * slot. Nothing on that path allocates once recording has started.
+ *
+ * When every slot is leased acquire() fails instead of allocating, so a slow
+ * encoder shows up as counted capture drops rather than unbounded memory.
+ *
+ * @section Patterns
+ * - Object pool: fixed slot count, free slots tracked in one atomic bitmask.
+ * - RAII: FrameRef copies share a slot; the last one releases it.
+ */
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include "util/Types.hpp"
+
+namespace vc {
+
+class FramePool;
+
+// Pixel layout of a captured frame
+enum class FrameFormat : u8 {
+    RGBA, // 4 B/px, GL readback order (bottom row first)
+    I420, // 1.5 B/px, top-down planar Y, U, V (GPU converted)
+};
+
+// Slots are page aligned so the PBO memcpy and sws reads stay on whole pages
+inline constexpr usize FRAME_POOL_ALIGNMENT = 4096;
+// ~130 ms of headroom at 60 fps; 64 MB of RGBA at 1080p
+inline constexpr u32 DEFAULT_FRAME_POOL_SLOTS = 8;
+inline constexpr u32 MAX_FRAME_POOL_SLOTS = 64;
+
+class FrameRef {
+public:
+    FrameRef() = default;
+    ~FrameRef();
+
+    // Copyable so a lease can travel through Signal<> and Qt signals
+    FrameRef(const FrameRef& other);
+    FrameRef& operator=(const FrameRef& other);
+    FrameRef(FrameRef&& other) noexcept;
+    FrameRef& operator=(FrameRef&& other) noexcept;
+
+    u8* data() const;
+    usize size() const;
+    FrameFormat format() const;
+    explicit operator bool() const {
+        return pool_ != nullptr;
+    }
+
+    // Drop this reference; the slot is returned once no copies remain
+    void reset();
+
+    const std::shared_ptr<FramePool>& pool() const {
+        return pool_;
+    }
+
+private:
+    friend class FramePool;
+    FrameRef(std::shared_ptr<FramePool> pool, u32 slot);
+
+    std::shared_ptr<FramePool> pool_;
+    u32 slot_{0};
+};
+
+class FramePool : public std::enable_shared_from_this<FramePool> {
+public:
+    // Allocates and prefaults `slotCount` (<= 64) slots of `slotBytes` each
+    static std::shared_ptr<FramePool> create(usize slotBytes,
+                                             u32 slotCount = DEFAULT_FRAME_POOL_SLOTS,
+                                             FrameFormat format = FrameFormat::RGBA);
+
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Lease a free slot. Returns an empty FrameRef (and counts it) when the
+    // pool is exhausted. Safe from any thread.
+    FrameRef acquire();
+
+    usize slotBytes() const {
+        return slotBytes_;
+    }
+    // Slots actually allocated; fewer than asked for if memory ran out
+    u32 slotCount() const {
+        return allocated_;
+    }
+    FrameFormat format() const {
+        return format_;
+    }
+
+    // Occupancy metrics (thread-safe via atomics)
+    u32 inUse() const;
+    u32 peakInUse() const {
+        return peakInUse_.load(std::memory_order_relaxed);
+    }
+    u64 exhaustedCount() const {
+        return exhausted_.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class FrameRef;
+
+    struct Slot {
+        u8* data{nullptr};
+        std::atomic<u32> refs{0};
+    };
+
+    FramePool(usize slotBytes, u32 slotCount, FrameFormat format);
+
+    void retain(u32 slot);
+    void release(u32 slot);
+
+    const usize slotBytes_;
+    const u32 slotCount_;
+    const FrameFormat format_;
+    std::unique_ptr<Slot[]> slots_;
+    u32 allocated_{0};
+
+    // Bit i set = slot i free
+    alignas(64) std::atomic<u64> freeMask_{0};
+    std::atomic<u32> peakInUse_{0};
+    std::atomic<u64> exhausted_{0};
+};
+
+} // namespace vc
@@ -0,0 +1,158 @@
+#include "OfflineRenderer.hpp"
+#include <QGuiApplication>
+#include "VideoRecorderFFmpeg.hpp"
+#include "audio/AudioDecoder.hpp"
+#include "core/Logger.hpp"
+#include "visualizer/VisualizerRenderer.hpp"
+#include "visualizer/projectm/Engine.hpp"
+
+namespace vc {
+
+OfflineRenderer::OfflineRenderer() = default;
+
+OfflineRenderer::~OfflineRenderer() {
+    // The renderer owns GL objects; tear it down with the context current
+    if (renderer_ && context_ && context_->makeCurrent(surface_.get())) {
+        renderer_.reset();
+        context_->doneCurrent();
+    }
+}
+
+Result<void> OfflineRenderer::init(u32 width, u32 height) {
+    context_ = std::make_unique<QOpenGLContext>();
+    context_->setFormat(QSurfaceFormat::defaultFormat());
+    if (!context_->create()) {
+        return Result<void>::err("Failed to create offscreen OpenGL context");
+    }
+
+    surface_ = std::make_unique<QOffscreenSurface>();
+    surface_->setFormat(context_->format());
+    surface_->create();
+    if (!context_->makeCurrent(surface_.get())) {
+        return Result<void>::err("Failed to make offscreen context current");
+    }
+
+    renderer_ = std::make_unique<VisualizerRenderer>();
+    renderer_->setRecordingSize(width, height);
+    renderer_->setOffline(true);
+    renderer_->initialize(width, height);
+    if (!renderer_->projectM().isInitialized()) {
+        return Result<void>::err("projectM failed to initialize offscreen");
+    }
+    if (!pm::Engine::hasFrameTime()) {
+        LOG_WARN("OfflineRenderer: projectM {}.{} can't be stepped by frame time "
+                 "(needs 4.1); animation follows the wall clock, so its speed "
+                 "depends on how fast frames render",
+                 PROJECTM_VERSION_MAJOR,
+                 PROJECTM_VERSION_MINOR);
+    }
+
+    LOG_INFO("OfflineRenderer: GL {}.{} on '{}' ({}x{})",
+             context_->format().majorVersion(),
+             context_->format().minorVersion(),
+             QGuiApplication::platformName().toStdString(),
+             width,
+             height);
+    return Result<void>::ok();
+}
+
+Result<void> OfflineRenderer::render(const fs::path& input,
+                                     const EncoderSettings& settings) {
+    if (!renderer_)
+        return Result<void>::err("OfflineRenderer not initialized");
+    if (!context_->makeCurrent(surface_.get()))
+        return Result<void>::err("Failed to make offscreen context current");
+
+    cancelled_ = false;
+
+    const u32 rate = settings.audio.sampleRate;
+    const u32 fps = settings.video.fps;
+    const u32 channels = 2;
+
+    AudioDecoder decoder;
+    if (auto result = decoder.open(input, rate, channels); !result)
+        return result;
+
+    VideoRecorderFFmpeg ffmpeg;
+    if (auto result = ffmpeg.init(settings); !result)
+        return result;
+
+    renderer_->setRecordingSize(settings.video.width, settings.video.height);
+
+    // Fixed timestep: frame n covers samples [n*rate/fps, (n+1)*rate/fps)
+    const usize maxFramesPerVideoFrame = (rate + fps - 1) / fps;
+    std::vector<f32> pcm(maxFramesPerVideoFrame * channels);
+
+    GrabbedFrame frame;
+    frame.width = settings.video.width;
+    frame.height = settings.video.height;
+
+    u64 bytesWritten = 0;
+    u64 frameIndex = 0;
+    u64 audioCursor = 0;
+    const u64 totalFrames =
+            static_cast<u64>(decoder.duration().count()) * fps / 1000;
+    const auto started = chr::steady_clock::now();
+
+    LOG_INFO("OfflineRenderer: {} -> {} ({} frames @ {} fps)",
+             input.filename().string(),
+             ffmpeg.getOutputPath(),
+             totalFrames,
+             fps);
+
+    while (!cancelled_) {
+        u64 frameEnd = (frameIndex + 1) * rate / fps;
+        usize got = decoder.read(pcm.data(), frameEnd - audioCursor);
+        if (got == 0)
+            break;
+        audioCursor += got;
+
+        f64 frameTime = static_cast<f64>(frameIndex) / fps;
+        if (!renderer_->renderOffline(pcm.data(), got, frameTime, frame)) {
+            return Result<void>::err("Offline render failed at frame " +
+                                     std::to_string(frameIndex));
+        }
+
+        frame.timestamp = static_cast<i64>(frameIndex * 1'000'000 / fps);
+        frame.frameNumber = static_cast<u32>(frameIndex);
+        ffmpeg.encodeVideo(frame, bytesWritten);
+
+        ffmpeg.encodeAudio(std::span<const f32>(pcm.data(), got * channels),
+                           bytesWritten);
+
+        ++frameIndex;
+        if (frameIndex % fps == 0) {
+            // Let queued quit requests (SIGINT) reach Application::quit
+            QCoreApplication::processEvents();
+        }
+        if (frameIndex % (fps * 10) == 0) {
+            LOG_INFO("OfflineRenderer: {}/{} frames ({} MB)",
+                     frameIndex,
+                     totalFrames,
+                     bytesWritten / (1024 * 1024));
+        }
+    }
+
+    ffmpeg.flush(bytesWritten);
+    std::string outputPath = ffmpeg.getOutputPath();
+    ffmpeg.cleanup();
+    context_->doneCurrent();
+
+    f64 wall = chr::duration<f64>(chr::steady_clock::now() - started).count();
+    f64 media = static_cast<f64>(frameIndex) / fps;
+    LOG_INFO("OfflineRenderer: {} {} frames ({:.1f}s of media) in {:.1f}s "
+             "({:.2f}x realtime, {} MB) -> {}",
+             cancelled_.load() ? "Cancelled after" : "Rendered",
+             frameIndex,
+             media,
+             wall,
+             wall > 0.0 ? media / wall : 0.0,
+             bytesWritten / (1024 * 1024),
+             outputPath);
+
+    if (cancelled_)
+        return Result<void>::err("Offline render cancelled");
+    return Result<void>::ok();
+}
+
+} // namespace vc
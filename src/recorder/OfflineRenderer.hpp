@@ -0,0 +1,64 @@
+/**
+ * @file OfflineRenderer.hpp
+ * @brief Headless render-and-encode of an audio file to video.
+ *
+ * This file defines the OfflineRenderer class which powers `--headless`.
+ * It decodes the input with AudioDecoder, steps projectM at a fixed
+ * timestep (sampleRate / fps samples per frame) through VisualizerRenderer
+ * into an offscreen RenderTarget, and hands every frame and its audio slice
+ * straight to VideoRecorderFFmpeg. There is no realtime clock, no
+ * QMediaPlayer and no window, so an export runs as fast as the GL
+ * implementation (Mesa llvmpipe, surfaceless EGL, a real GPU) and the
+ * encoder allow, and never drops frames. projectM before 4.1 can't be
+ * stepped that way and animates on the wall clock; init() warns.
+ *
+ * @section Dependencies
+ * - AudioDecoder
+ * - VisualizerRenderer
+ * - VideoRecorderFFmpeg
+ * - QOffscreenSurface / QOpenGLContext
+ */
+
+#pragma once
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <atomic>
+#include <memory>
+#include "EncoderSettings.hpp"
+#include "util/Result.hpp"
+#include "util/Types.hpp"
+
+namespace vc {
+
+class VisualizerRenderer;
+
+class OfflineRenderer {
+public:
+    OfflineRenderer();
+    ~OfflineRenderer();
+
+    OfflineRenderer(const OfflineRenderer&) = delete;
+    OfflineRenderer& operator=(const OfflineRenderer&) = delete;
+
+    // Creates the offscreen GL context and projectM at the given size
+    Result<void> init(u32 width, u32 height);
+
+    // Renders `input` to `settings.outputPath`; blocks until done
+    Result<void> render(const fs::path& input, const EncoderSettings& settings);
+
+    // Thread/signal safe: stops the current render after the next frame
+    void cancel() {
+        cancelled_ = true;
+    }
+    bool isCancelled() const {
+        return cancelled_;
+    }
+
+private:
+    std::unique_ptr<QOffscreenSurface> surface_;
+    std::unique_ptr<QOpenGLContext> context_;
+    std::unique_ptr<VisualizerRenderer> renderer_;
+    std::atomic<bool> cancelled_{false};
+};
+
+} // namespace vc
@@ -0,0 +1,179 @@
+/**
+ * @file RecordingClock.hpp
+ * @brief Maps capture timestamps onto the recorded audio timeline.
+ *
+ * Audio PTS in a recording is a plain sample count, so the audio device's
+ * clock is the recording's master clock. Video frames carry steady_clock
+ * capture times instead. RecordingClock keeps the offset between the two:
+ * the audio stage reports how many samples it has seen at a given wall
+ * time, and the video stage asks for the media time of a capture
+ * timestamp. Sound cards run a few tens of ppm off the system clock, which
+ * is hundreds of ms over an hour; following the sample position keeps
+ * video locked to the audio the file actually contains.
+ *
+ * Single writer (audio stage), any number of readers; lock-free.
+ */
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include "util/Types.hpp"
+
+namespace vc {
+
+class RecordingClock {
+public:
+    // Same base as GrabbedFrame::timestamp
+    static i64 nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                       chr::steady_clock::now().time_since_epoch())
+                .count();
+    }
+
+    // Media time 0 is `wallUs`. Until the first audio anchor the clock
+    // simply follows wall time from there.
+    void start(i64 wallUs) {
+        startUs_ = wallUs;
+        anchored_ = false;
+        filteredOffset_ = static_cast<f64>(-wallUs);
+        offsetUs_.store(-wallUs, std::memory_order_release);
+        driftUs_.store(0, std::memory_order_relaxed);
+    }
+
+    // Audio stage: `samplePosition` frames at `sampleRate` had been produced
+    // by `wallUs`. Anchors arrive in device-period bursts, so the offset is
+    // low-pass filtered; the constant part of that jitter is just latency.
+    void anchorAudio(u64 samplePosition, u32 sampleRate, i64 wallUs) {
+        if (sampleRate == 0)
+            return;
+        i64 audioUs = static_cast<i64>(samplePosition * 1'000'000 / sampleRate);
+        f64 measured = static_cast<f64>(audioUs - wallUs);
+        if (!anchored_) {
+            filteredOffset_ = measured;
+            anchored_ = true;
+        } else {
+            filteredOffset_ += (measured - filteredOffset_) * ANCHOR_SMOOTHING;
+        }
+        offsetUs_.store(std::llround(filteredOffset_), std::memory_order_release);
+        driftUs_.store((wallUs - startUs_) - audioUs, std::memory_order_relaxed);
+    }
+
+    // Position on the recording timeline of something captured at `wallUs`
+    i64 mediaTimeUs(i64 wallUs) const {
+        return wallUs + offsetUs_.load(std::memory_order_acquire);
+    }
+
+    // Wall time elapsed minus audio time recorded; positive when the audio
+    // device runs slow relative to steady_clock
+    i64 audioDriftUs() const {
+        return driftUs_.load(std::memory_order_relaxed);
+    }
+
+private:
+    // ~0.25 s time constant at the audio stage's 5 ms poll rate
+    static constexpr f64 ANCHOR_SMOOTHING = 0.02;
+
+    // Writer-only state
+    i64 startUs_{0};
+    f64 filteredOffset_{0.0};
+    bool anchored_{false};
+
+    std::atomic<i64> offsetUs_{0}; // media time = wall time + offset
+    std::atomic<i64> driftUs_{0};
+};
+
+/**
+ * Slowly stretches or squeezes recorded audio so its sample clock keeps
+ * pace with steady_clock.
+ *
+ * RecordingClock makes video follow whatever the audio device delivers;
+ * left alone, a device running 100 ppm slow makes an hour-long recording
+ * 0.36 s short and costs a dozen skipped frames. After every batch the
+ * audio stage reports how many frames (padding included) have been
+ * produced; the compensator compares that with wall time since the first
+ * report, averages the difference over each one-second interval and
+ * low-passes it to ignore buffer-period jitter, then returns how many
+ * frames the resampler should add (or drop) over the next interval.
+ *
+ * The rate is capped at MAX_PPM, far below audible pitch change. Only the
+ * drift *slope* is corrected: the constant start-up latency in the first
+ * report is kept as-is.
+ *
+ * Audio stage only; not thread-safe.
+ */
+class DriftCompensator {
+public:
+    static constexpr i64 INTERVAL_US = 1'000'000;
+    static constexpr f64 MAX_PPM = 500.0;
+
+    void start(u32 sampleRate) {
+        sampleRate_ = sampleRate;
+        started_ = false;
+        compensated_ = 0;
+        errorSum_ = 0.0;
+        errorCount_ = 0;
+        filteredError_ = 0.0;
+        ppm_ = 0.0;
+    }
+
+    // `frames` produced (before compensation) as of `wallUs`. Returns the
+    // frames to add (positive) or drop over the next INTERVAL_US; 0 while
+    // warming up or between intervals.
+    i64 update(u64 frames, i64 wallUs) {
+        if (sampleRate_ == 0)
+            return 0;
+        if (!started_) {
+            started_ = true;
+            startFrames_ = frames;
+            startUs_ = lastUs_ = wallUs;
+            return 0;
+        }
+        const f64 expected = static_cast<f64>(wallUs - startUs_) * sampleRate_ / 1e6;
+        const f64 produced = static_cast<f64>(frames - startFrames_) + compensated_;
+        errorSum_ += expected - produced;
+        ++errorCount_;
+        if (wallUs - lastUs_ < INTERVAL_US)
+            return 0;
+        lastUs_ = wallUs;
+
+        filteredError_ += (errorSum_ / errorCount_ - filteredError_) * ERROR_SMOOTHING;
+        errorSum_ = 0.0;
+        errorCount_ = 0;
+        if (wallUs - startUs_ < WARMUP_US)
+            return 0;
+
+        // Absorb the remaining error over ERROR_HORIZON intervals, capped
+        const f64 limit = MAX_PPM * 1e-6 * sampleRate_ * INTERVAL_US / 1e6;
+        const i64 delta = std::llround(
+                std::clamp(filteredError_ / ERROR_HORIZON, -limit, limit));
+        compensated_ += delta;
+        filteredError_ -= static_cast<f64>(delta);
+        ppm_ = static_cast<f64>(delta) * 1e6 / (sampleRate_ * INTERVAL_US / 1e6);
+        return delta;
+    }
+
+    // Frames added (negative: dropped) so far
+    i64 compensatedFrames() const { return compensated_; }
+    // Rate applied over the last interval
+    f64 ppm() const { return ppm_; }
+
+private:
+    static constexpr i64 WARMUP_US = 10'000'000;
+    static constexpr f64 ERROR_SMOOTHING = 0.1; // ~10 s at one update per second
+    static constexpr f64 ERROR_HORIZON = 10.0;
+
+    u32 sampleRate_{0};
+    bool started_{false};
+    u64 startFrames_{0};
+    i64 startUs_{0};
+    i64 lastUs_{0};
+    i64 compensated_{0};
+    f64 errorSum_{0.0}; // expected minus produced, this interval
+    u32 errorCount_{0};
+    f64 filteredError_{0.0};
+    f64 ppm_{0.0};
+};
+
+} // namespace vc
@@ -76,6 +76,21 @@ Result<void> VideoRecorder::stop() {
   return Result<void>::ok();
 }
 
+void VideoRecorder::submitVideoFrame(FrameRef pooled,
+  u32 width, u32 height, i64 timestamp) {
+  if (state_ != RecordingState::Recording || !worker_ || !pooled)
+    return;
+
+  GrabbedFrame frame;
+  frame.width = width;
+  frame.height = height;
+  frame.timestamp = timestamp;
+  frame.format = pooled.format();
+  frame.pooled = std::move(pooled);
+
+  worker_->pushVideoFrame(std::move(frame));
+}
+
 void VideoRecorder::submitVideoFrame(std::vector<u8>&& data,
   u32 width, u32 height, i64 timestamp) {
   if (state_ != RecordingState::Recording || !worker_)
@@ -3,6 +3,7 @@
 #include <memory>
 #include <vector>
 #include "EncoderSettings.hpp"
+#include "FramePool.hpp"
 #include "util/Result.hpp"
 #include "util/Signal.hpp"
 #include "util/Types.hpp"
@@ -14,6 +15,14 @@ class VideoRecorderThread;
 
 enum class RecordingState { Stopped, Starting, Recording, Stopping, Finalizing, Error };
 
+// One stage of the encoder pipeline (see EncoderPipeline)
+struct PipelineStageStats {
+  u64 processed{0};     // frames / packets out of the stage
+  f64 perSecond{0.0};   // over the last stats interval
+  u32 queueDepth{0};    // items waiting at the stage's input
+  u32 queueCapacity{0};
+};
+
 struct RecordingStats {
   Duration elapsed{0};
   u64 framesWritten{0};
@@ -21,6 +30,21 @@ struct RecordingStats {
   u64 bytesWritten{0};
   f64 avgFps{0.0};
   f64 encodingFps{0.0};
+  // Capture frame pool occupancy (0 slots = no pooled frames seen yet)
+  u32 poolSlots{0};
+  u32 poolInUse{0};
+  u32 poolPeakInUse{0};
+  u64 poolExhausted{0};
+  PipelineStageStats convertStage;  // captured frame -> encoder pixel format
+  PipelineStageStats videoStage;    // video encoder (frames in)
+  PipelineStageStats audioStage;    // audio encoder (sample frames in)
+  PipelineStageStats muxStage;      // packets written
+  // A/V sync: video PTS comes from capture time on the audio sample clock
+  f64 audioClockDriftMs{0.0}; // wall time minus recorded audio time
+  f64 audioDriftCompensationPpm{0.0}; // resampler stretch applied to absorb drift
+  f64 videoSyncErrorMs{0.0};  // last frame's PTS minus its capture time
+  u64 framesDuplicated{0};    // CFR: repeated to fill late-capture gaps
+  u64 framesSkipped{0};       // CFR: second capture inside one frame slot
   std::string currentFile;
 };
 
@@ -33,6 +57,7 @@ public:
   Result<void> start(const fs::path& outputPath);
   Result<void> stop();
 
+  void submitVideoFrame(FrameRef frame, u32 width, u32 height, i64 timestamp);
   void submitVideoFrame(std::vector<u8>&& data, u32 width, u32 height, i64 timestamp);
   void submitVideoFrame(const u8* data, u32 width, u32 height, i64 timestamp);
   void submitAudioSamples(const f32* data, u32 samples, u32 channels, u32 sampleRate);
@@ -4,6 +4,7 @@
 #include <libavcodec/version.h>
 #include <libavutil/opt.h>
 #include "core/Logger.hpp"
+#include <algorithm>
 #include <filesystem>
 #include <fmt/core.h>
 #include <fcntl.h>
@@ -17,6 +18,18 @@
 
 namespace vc {
 
+namespace {
+// Frame size used for encoders that accept any frame size (frame_size == 0)
+constexpr int AUDIO_CHUNK_FRAMES = 1024;
+// sendAudio() input: interleaved stereo, as AudioQueue and AudioDecoder
+// hand it out; swr maps it to the configured channel count
+constexpr int AUDIO_INPUT_CHANNELS = 2;
+// Initial swr output capacity; covers EncoderPipeline's 4096-frame batches
+constexpr int AUDIO_RESAMPLE_FRAMES = 8192;
+// VFR video time base (the MPEG 90 kHz clock)
+constexpr int VFR_TIME_BASE = 90000;
+} // namespace
+
 VideoRecorderFFmpeg::VideoRecorderFFmpeg() = default;
 
 VideoRecorderFFmpeg::~VideoRecorderFFmpeg() {
@@ -108,7 +121,8 @@ Result<void> VideoRecorderFFmpeg::init(const EncoderSettings& settings) {
   }
 
   packet_.reset(av_packet_alloc());
-  if (!packet_) {
+  audioPacket_.reset(av_packet_alloc());
+  if (!packet_ || !audioPacket_) {
     return Result<void>::err("Failed to allocate packet");
   }
 
@@ -122,8 +136,13 @@ void VideoRecorderFFmpeg::cleanup() {
     std::lock_guard lock(mutex_);
 
     packet_.reset();
+    audioPacket_.reset();
     videoFrame_.reset();
     audioFrame_.reset();
+    resampleFrame_.reset();
+    audioFifo_.reset();
+    audioFrameSize_ = 0;
+    audioInputRate_ = 0;
     swsCtx_.reset();
     swrCtx_.reset();
     videoCodecCtx_.reset();
@@ -136,7 +155,7 @@ void VideoRecorderFFmpeg::cleanup() {
 
     videoStream_ = nullptr;
     audioStream_ = nullptr;
-    videoFrameCount_ = 0;
+    nextVideoPts_ = 0;
     audioFrameCount_ = 0;
 
     if (fileLockFd_ >= 0) {
@@ -148,120 +167,270 @@ void VideoRecorderFFmpeg::cleanup() {
 
 bool VideoRecorderFFmpeg::encodeVideo(const GrabbedFrame& frame,
   u64& bytesWritten) {
-  if (frame.data.empty())
+  std::lock_guard lock(mutex_);
+  if (!videoFrame_ || !convertVideo(frame, videoFrame_.get()))
     return false;
 
-  std::lock_guard lock(mutex_);
-  if (!videoCodecCtx_ || !videoFrame_)
+  return sendVideo(videoFrame_.get(), frame.timestamp, [&](AVPacket* packet) {
+    writePacket(packet, videoStream_, bytesWritten);
+  });
+}
+
+AVFramePtr VideoRecorderFFmpeg::allocVideoFrame() const {
+  if (!videoCodecCtx_)
+    return nullptr;
+
+  AVFramePtr frame(av_frame_alloc());
+  if (!frame)
+    return nullptr;
+  frame->format = swPixelFormat_;
+  frame->width = videoCodecCtx_->width;
+  frame->height = videoCodecCtx_->height;
+  if (av_frame_get_buffer(frame.get(), 0) < 0)
+    return nullptr;
+  return frame;
+}
+
+bool VideoRecorderFFmpeg::convertVideo(const GrabbedFrame& frame, AVFrame* dst) {
+  if (frame.empty() || !dst || !videoCodecCtx_)
     return false;
 
-  const u8* srcData[1] = {frame.data.data()};
-  int srcLinesize[1] = {static_cast<int>(frame.width * 4)};
+  // The encoder may still reference the previous frame's buffers
+  if (av_frame_make_writable(dst) < 0)
+    return false;
 
-  AVPixelFormat targetFmt = swPixelFormat_;
+  const int w = static_cast<int>(frame.width);
+  const int h = static_cast<int>(frame.height);
+
+  if (frame.format == FrameFormat::I420 && swPixelFormat_ == AV_PIX_FMT_YUV420P &&
+      w == videoCodecCtx_->width && h == videoCodecCtx_->height) {
+    // Already converted and flipped on the GPU: plain plane copy, no sws
+    const u8* src = frame.pixels();
+    const u8* srcData[3] = {src, src + w * h, src + w * h + (w / 2) * (h / 2)};
+    const int srcLinesize[3] = {w, w / 2, w / 2};
+    av_image_copy(dst->data,
+      dst->linesize,
+      srcData,
+      srcLinesize,
+      AV_PIX_FMT_YUV420P,
+      w,
+      h);
+  } else {
+    AVPixelFormat srcFmt = AV_PIX_FMT_RGBA;
+    const u8* srcData[3] = {frame.pixels(), nullptr, nullptr};
+    int srcLinesize[3] = {w * 4, 0, 0};
+
+    if (frame.format == FrameFormat::I420) {
+      srcFmt = AV_PIX_FMT_YUV420P;
+      srcData[1] = frame.pixels() + w * h;
+      srcData[2] = srcData[1] + (w / 2) * (h / 2);
+      srcLinesize[0] = w;
+      srcLinesize[1] = srcLinesize[2] = w / 2;
+    } else {
+      // GL readback is bottom-up: walk rows backwards instead of swapping
+      srcData[0] += static_cast<usize>(h - 1) * w * 4;
+      srcLinesize[0] = -w * 4;
+    }
 
-  if (!swsCtx_) {
-    swsCtx_.reset(sws_getContext(frame.width,
-      frame.height,
-      AV_PIX_FMT_RGBA,
+    swsCtx_.reset(sws_getCachedContext(swsCtx_.release(),
+      w,
+      h,
+      srcFmt,
       videoCodecCtx_->width,
       videoCodecCtx_->height,
-      targetFmt,
+      swPixelFormat_,
       SWS_BILINEAR,
       nullptr,
       nullptr,
       nullptr));
+    if (!swsCtx_)
+      return false;
+    // BT.709 like the GPU path (sws defaults to BT.601); cheap to repeat.
+    // RGBA is full range, GPU-converted I420 already limited.
+    const int* bt709 = sws_getCoefficients(SWS_CS_ITU709);
+    const int srcRange = srcFmt == AV_PIX_FMT_RGBA ? 1 : 0;
+    sws_setColorspaceDetails(swsCtx_.get(), bt709, srcRange, bt709, 0, 0, 1 << 16, 1 << 16);
+
+    sws_scale(swsCtx_.get(),
+      srcData,
+      srcLinesize,
+      0,
+      h,
+      dst->data,
+      dst->linesize);
   }
 
-  sws_scale(swsCtx_.get(),
-    srcData,
-    srcLinesize,
-    0,
-    frame.height,
-    videoFrame_->data,
-    videoFrame_->linesize);
+  return true;
+}
 
-  videoFrame_->pts = videoFrameCount_++;
+bool VideoRecorderFFmpeg::sendVideo(AVFrame* frame, i64 mediaUs, const PacketSink& sink) {
+  if (!videoCodecCtx_)
+    return false;
+  if (!frame)
+    return sendFrame(videoCodecCtx_.get(), nullptr, sink);
 
-  AVFrame* encodeFrame = videoFrame_.get();
+  const AVRational timeBase = videoCodecCtx_->time_base;
+  i64 pts = av_rescale_q_rnd(mediaUs, AV_TIME_BASE_Q, timeBase, AV_ROUND_NEAR_INF);
+  i64 repeats = 1;
+
+  if (variableFrameRate_) {
+    pts = std::max(pts, nextVideoPts_);
+  } else {
+    if (pts < nextVideoPts_) {
+      // A second capture inside an already encoded frame slot
+      framesSkipped_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    // Fill the slots a late frame missed with copies of it, up to a second;
+    // longer stalls leave a timestamp gap the player holds across
+    repeats = std::min<i64>(pts - nextVideoPts_, fps_) + 1;
+    framesDuplicated_.fetch_add(static_cast<u64>(repeats - 1), std::memory_order_relaxed);
+    pts -= repeats - 1;
+  }
+  videoSyncErrorUs_.store(
+    av_rescale_q(pts + repeats - 1, timeBase, AV_TIME_BASE_Q) - mediaUs,
+    std::memory_order_relaxed);
 
+  AVFrame* encodeFrame = frame;
   if (hwFramesCtx_ && hwFrame_) {
-    int ret = av_hwframe_transfer_data(hwFrame_.get(), videoFrame_.get(), 0);
-    if (ret < 0) {
+    int ret = av_hwframe_transfer_data(hwFrame_.get(), frame, 0);
+    if (ret < 0)
       LOG_WARN("HW frame transfer failed: {}", ffmpegError(ret));
-    } else {
-      hwFrame_->pts = videoFrame_->pts;
+    else
       encodeFrame = hwFrame_.get();
-    }
   }
 
-  return encodeVideoFrame(encodeFrame, bytesWritten);
+  bool ok = true;
+  for (i64 i = 0; i < repeats; ++i) {
+    encodeFrame->pts = pts + i;
+    ok = sendFrame(videoCodecCtx_.get(), encodeFrame, sink) && ok;
+  }
+  nextVideoPts_ = pts + repeats;
+  return ok;
 }
 
-bool VideoRecorderFFmpeg::encodeAudio(std::vector<f32>& buffer,
-                                      u32 channels,
+bool VideoRecorderFFmpeg::encodeAudio(std::span<const f32> samples,
                                       u64& bytesWritten) {
     std::lock_guard lock(mutex_);
-    if (!audioCodecCtx_ || !audioFrame_ || buffer.empty())
+    return sendAudio(samples, [&](AVPacket* packet) {
+        writePacket(packet, audioStream_, bytesWritten);
+    });
+}
+
+bool VideoRecorderFFmpeg::sendAudio(std::span<const f32> samples,
+                                    const PacketSink& sink) {
+    if (!audioCodecCtx_ || !audioFifo_)
         return false;
 
-    int frameSize = audioCodecCtx_->frame_size;
-    if (frameSize <= 0)
+    int inFrames = static_cast<int>(samples.size() / AUDIO_INPUT_CHANNELS);
+    if (inFrames == 0)
+        return true;
+
+    if (!resampleToFifo(reinterpret_cast<const u8*>(samples.data()), inFrames))
         return false;
+    return encodeFifo(sink, false);
+}
 
-    bool encodedAny = false;
+bool VideoRecorderFFmpeg::resampleToFifo(const u8* input, int inFrames) {
+    int outFrames = swr_get_out_samples(swrCtx_.get(), inFrames);
+    if (outFrames <= 0)
+        return outFrames == 0;
 
-    while (buffer.size() >= static_cast<usize>(frameSize * channels)) {
-        std::vector<f32> samples(buffer.begin(),
-                                 buffer.begin() + frameSize * channels);
-        buffer.erase(buffer.begin(), buffer.begin() + frameSize * channels);
+    if (outFrames > resampleFrame_->nb_samples) {
+        // Only when a caller hands over a bigger batch than ever before
+        AVFramePtr grown(av_frame_alloc());
+        if (!grown)
+            return false;
+        grown->format = audioCodecCtx_->sample_fmt;
+        av_channel_layout_copy(&grown->ch_layout, &audioCodecCtx_->ch_layout);
+        grown->nb_samples = outFrames;
+        if (av_frame_get_buffer(grown.get(), 0) < 0)
+            return false;
+        resampleFrame_ = std::move(grown);
+    }
 
-        const u8* srcData[1] = {reinterpret_cast<const u8*>(samples.data())};
+    const u8* srcData[1] = {input};
+    int converted = swr_convert(swrCtx_.get(),
+                                resampleFrame_->data,
+                                outFrames,
+                                input ? srcData : nullptr,
+                                input ? inFrames : 0);
+    if (converted < 0) {
+        LOG_WARN("Audio resample error: {}", ffmpegError(converted));
+        return false;
+    }
 
-        int ret = swr_convert(swrCtx_.get(),
-                              audioFrame_->data,
-                              frameSize,
-                              srcData,
-                              frameSize);
-        if (ret < 0) {
-            LOG_WARN("Audio resample error: {}", ffmpegError(ret));
-            continue;
-        }
+    // av_audio_fifo_write grows the FIFO itself if a stall let it fill up
+    if (converted > 0 &&
+        av_audio_fifo_write(audioFifo_.get(),
+                            reinterpret_cast<void**>(resampleFrame_->data),
+                            converted) < converted) {
+        LOG_WARN("Audio FIFO write failed, {} samples lost", converted);
+        return false;
+    }
+    return true;
+}
 
-        audioFrame_->pts = audioFrameCount_;
-        audioFrameCount_ += frameSize;
+bool VideoRecorderFFmpeg::encodeFifo(const PacketSink& sink, bool final) {
+    const int channels = audioCodecCtx_->ch_layout.nb_channels;
+    const bool shortLastFrame =
+            audioCodecCtx_->codec->capabilities &
+            (AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_VARIABLE_FRAME_SIZE);
+    bool ok = true;
+
+    while (true) {
+        int queued = av_audio_fifo_size(audioFifo_.get());
+        if (queued == 0 || (queued < audioFrameSize_ && !final))
+            break;
+
+        // The encoder may still reference the previous frame's buffers
+        if (av_frame_make_writable(audioFrame_.get()) < 0)
+            return false;
 
-        if (encodeAudioFrame(audioFrame_.get(), bytesWritten)) {
-            encodedAny = true;
+        int frames = std::min(queued, audioFrameSize_);
+        audioFrame_->nb_samples = frames;
+        av_audio_fifo_read(audioFifo_.get(),
+                           reinterpret_cast<void**>(audioFrame_->data),
+                           frames);
+
+        if (frames < audioFrameSize_ && !shortLastFrame) {
+            av_samples_set_silence(audioFrame_->data,
+                                   frames,
+                                   audioFrameSize_ - frames,
+                                   channels,
+                                   audioCodecCtx_->sample_fmt);
+            audioFrame_->nb_samples = audioFrameSize_;
         }
+
+        audioFrame_->pts = audioFrameCount_;
+        audioFrameCount_ += audioFrame_->nb_samples;
+        ok = sendFrame(audioCodecCtx_.get(), audioFrame_.get(), sink) && ok;
     }
-    return encodedAny;
+
+    audioFrame_->nb_samples = audioFrameSize_;
+    return ok;
+}
+
+bool VideoRecorderFFmpeg::flushAudio(const PacketSink& sink) {
+    if (!audioCodecCtx_)
+        return false;
+
+    // Drain swr's delay line and the FIFO tail before flushing the codec
+    bool ok = !audioFifo_ || (resampleToFifo(nullptr, 0) && encodeFifo(sink, true));
+    return sendFrame(audioCodecCtx_.get(), nullptr, sink) && ok;
 }
 
 void VideoRecorderFFmpeg::flush(u64& bytesWritten) {
     std::lock_guard lock(mutex_);
 
     if (videoCodecCtx_) {
-        avcodec_send_frame(videoCodecCtx_.get(), nullptr);
-        while (true) {
-            int ret =
-                    avcodec_receive_packet(videoCodecCtx_.get(), packet_.get());
-            if (ret < 0)
-                break;
-            writePacket(packet_.get(), videoStream_, bytesWritten);
-        }
-    }
-
-    if (audioCodecCtx_) {
-        avcodec_send_frame(audioCodecCtx_.get(), nullptr);
-        while (true) {
-            int ret =
-                    avcodec_receive_packet(audioCodecCtx_.get(), packet_.get());
-            if (ret < 0)
-                break;
-            writePacket(packet_.get(), audioStream_, bytesWritten);
-        }
+        sendVideo(nullptr, 0, [&](AVPacket* packet) {
+            writePacket(packet, videoStream_, bytesWritten);
+        });
     }
+    flushAudio([&](AVPacket* packet) {
+        writePacket(packet, audioStream_, bytesWritten);
+    });
 }
 
 Result<void> VideoRecorderFFmpeg::initVideoStream(
@@ -281,10 +450,17 @@ Result<void> VideoRecorderFFmpeg::initVideoStream(
   if (!videoCodecCtx_)
     return Result<void>::err("Failed to allocate video codec context");
 
+  fps_ = settings.video.fps;
+  variableFrameRate_ = settings.video.variableFrameRate;
+  framesDuplicated_ = 0;
+  framesSkipped_ = 0;
+  videoSyncErrorUs_ = 0;
+
   videoCodecCtx_->width = settings.video.width;
   videoCodecCtx_->height = settings.video.height;
-  videoCodecCtx_->time_base =
-    AVRational{1, static_cast<int>(settings.video.fps)};
+  videoCodecCtx_->time_base = variableFrameRate_
+    ? AVRational{1, VFR_TIME_BASE}
+    : AVRational{1, static_cast<int>(settings.video.fps)};
   videoCodecCtx_->framerate =
     AVRational{static_cast<int>(settings.video.fps), 1};
   videoCodecCtx_->gop_size = settings.video.gopSize > 0
@@ -301,6 +477,11 @@ Result<void> VideoRecorderFFmpeg::initVideoStream(
   } else {
     videoCodecCtx_->pix_fmt = AV_PIX_FMT_YUV420P;
   }
+  // What YuvConverter and the sws path below produce
+  videoCodecCtx_->color_range = AVCOL_RANGE_MPEG;
+  videoCodecCtx_->colorspace = AVCOL_SPC_BT709;
+  videoCodecCtx_->color_primaries = AVCOL_PRI_BT709;
+  videoCodecCtx_->color_trc = AVCOL_TRC_BT709;
 
   if (formatCtx_->oformat->flags & AVFMT_GLOBALHEADER) {
     videoCodecCtx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
@@ -394,15 +575,38 @@ Result<void> VideoRecorderFFmpeg::initAudioStream(
                                     audioCodecCtx_.get());
     audioStream_->time_base = audioCodecCtx_->time_base;
 
-    audioFrame_.reset(av_frame_alloc());
-    audioFrame_->format = audioCodecCtx_->sample_fmt;
-    av_channel_layout_copy(&audioFrame_->ch_layout, &audioCodecCtx_->ch_layout);
-    audioFrame_->sample_rate = audioCodecCtx_->sample_rate;
-    audioFrame_->nb_samples = audioCodecCtx_->frame_size;
+    // Variable-frame-size encoders (PCM) report 0; feed them in fixed chunks
+    audioFrameSize_ = audioCodecCtx_->frame_size > 0 ? audioCodecCtx_->frame_size
+                                                     : AUDIO_CHUNK_FRAMES;
 
-    if (audioFrame_->nb_samples > 0) {
-        av_frame_get_buffer(audioFrame_.get(), 0);
+    audioFrame_.reset(av_frame_alloc());
+    resampleFrame_.reset(av_frame_alloc());
+    if (!audioFrame_ || !resampleFrame_)
+        return Result<void>::err("Failed to allocate audio frame");
+    for (AVFrame* frame : {audioFrame_.get(), resampleFrame_.get()}) {
+        frame->format = audioCodecCtx_->sample_fmt;
+        av_channel_layout_copy(&frame->ch_layout, &audioCodecCtx_->ch_layout);
+        frame->sample_rate = audioCodecCtx_->sample_rate;
     }
+    audioFrame_->nb_samples = audioFrameSize_;
+    resampleFrame_->nb_samples = AUDIO_RESAMPLE_FRAMES;
+    if (av_frame_get_buffer(audioFrame_.get(), 0) < 0 ||
+        av_frame_get_buffer(resampleFrame_.get(), 0) < 0)
+        return Result<void>::err("Failed to allocate audio frame buffers");
+
+    // One second of headroom; holds at most frame_size - 1 between calls
+    audioFifo_.reset(av_audio_fifo_alloc(audioCodecCtx_->sample_fmt,
+                                         audioCodecCtx_->ch_layout.nb_channels,
+                                         audioCodecCtx_->sample_rate));
+    if (!audioFifo_)
+        return Result<void>::err("Failed to allocate audio FIFO");
+
+    return initResampler(settings.audio.sampleRate);
+}
+
+Result<void> VideoRecorderFFmpeg::initResampler(u32 inputRate) {
+    AVChannelLayout layout;
+    av_channel_layout_default(&layout, AUDIO_INPUT_CHANNELS);
 
     SwrContext* s = nullptr;
     swr_alloc_set_opts2(&s,
@@ -411,45 +615,71 @@ Result<void> VideoRecorderFFmpeg::initAudioStream(
                         audioCodecCtx_->sample_rate,
                         &layout,
                         AV_SAMPLE_FMT_FLT,
-                        settings.audio.sampleRate,
+                        static_cast<int>(inputRate),
                         0,
                         nullptr);
     swrCtx_.reset(s);
-    swr_init(swrCtx_.get());
-
+    // Keep the resampler in the path even at equal rates so drift
+    // compensation never has to re-init (and reset) it mid-recording
+    if (swrCtx_)
+        av_opt_set_int(swrCtx_.get(), "flags", SWR_FLAG_RESAMPLE, 0);
+    if (!swrCtx_ || swr_init(swrCtx_.get()) < 0)
+        return Result<void>::err("Failed to initialize audio resampler");
+
+    audioInputRate_ = inputRate;
     return Result<void>::ok();
 }
 
-bool VideoRecorderFFmpeg::encodeVideoFrame(AVFrame* frame, u64& bytesWritten) {
-    int ret = avcodec_send_frame(videoCodecCtx_.get(), frame);
-    if (ret < 0)
+bool VideoRecorderFFmpeg::setAudioInputRate(u32 rate) {
+    if (!audioCodecCtx_ || rate == 0)
         return false;
+    if (rate == audioInputRate_)
+        return true;
 
-    while (ret >= 0) {
-        ret = avcodec_receive_packet(videoCodecCtx_.get(), packet_.get());
-        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
-            break;
-        if (ret < 0)
-            return false;
+    bool drained = resampleToFifo(nullptr, 0);
+    if (auto result = initResampler(rate); !result) {
+        LOG_WARN("Audio input rate {} Hz rejected: {}", rate, result.error().message);
+        return false;
+    }
+    LOG_DEBUG("Recorder audio input now {} Hz -> {} Hz", rate, audioCodecCtx_->sample_rate);
+    return drained;
+}
 
-        writePacket(packet_.get(), videoStream_, bytesWritten);
+bool VideoRecorderFFmpeg::compensateAudio(i32 delta, i32 distance) {
+    if (!swrCtx_ || audioInputRate_ == 0 || distance <= 0)
+        return false;
+    // swr counts both in output samples
+    const i64 outRate = audioCodecCtx_->sample_rate;
+    const int outDelta = static_cast<int>(static_cast<i64>(delta) * outRate / audioInputRate_);
+    const int outDistance = static_cast<int>(static_cast<i64>(distance) * outRate / audioInputRate_);
+    int ret = swr_set_compensation(swrCtx_.get(), outDelta, outDistance);
+    if (ret < 0) {
+        LOG_WARN("Audio drift compensation failed: {}", ffmpegError(ret));
+        return false;
     }
     return true;
 }
 
-bool VideoRecorderFFmpeg::encodeAudioFrame(AVFrame* frame, u64& bytesWritten) {
-    int ret = avcodec_send_frame(audioCodecCtx_.get(), frame);
-    if (ret < 0)
+bool VideoRecorderFFmpeg::sendFrame(AVCodecContext* codec,
+                                    AVFrame* frame,
+                                    const PacketSink& sink) {
+    int ret = avcodec_send_frame(codec, frame);
+    if (ret < 0 && !(frame == nullptr && ret == AVERROR_EOF))
         return false;
 
-    while (ret >= 0) {
-        ret = avcodec_receive_packet(audioCodecCtx_.get(), packet_.get());
+    // Video and audio may be encoded on different threads
+    AVPacket* packet =
+            codec == audioCodecCtx_.get() ? audioPacket_.get() : packet_.get();
+
+    while (true) {
+        ret = avcodec_receive_packet(codec, packet);
         if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
             break;
         if (ret < 0)
             return false;
 
-        writePacket(packet_.get(), audioStream_, bytesWritten);
+        sink(packet);
+        av_packet_unref(packet);
     }
     return true;
 }
@@ -463,8 +693,10 @@ bool VideoRecorderFFmpeg::writePacket(AVPacket* packet,
     stream->time_base);
   packet->stream_index = stream->index;
 
+  // av_interleaved_write_frame() takes the packet's contents
+  const int size = packet->size;
   if (av_interleaved_write_frame(formatCtx_.get(), packet) >= 0) {
-    bytesWritten += packet->size;
+    bytesWritten += size;
     return true;
   }
   return false;
@@ -22,7 +22,10 @@
 */
 
 #pragma once
+#include <atomic>
+#include <functional>
 #include <mutex>
+#include <span>
 #include <vector>
 #include "EncoderSettings.hpp"
 #include "FFmpegUtils.hpp"
@@ -67,10 +70,60 @@ public:
 
   std::string getOutputPath() const { return currentOutputPath_; }
 
+  // Synchronous API: convert, encode and mux on the calling thread.
+  // encodeVideo() takes frame.timestamp as media time (µs from 0).
   bool encodeVideo(const GrabbedFrame& frame, u64& bytesWritten);
-  bool encodeAudio(std::vector<f32>& buffer, u32 channels, u64& bytesWritten);
+  bool encodeAudio(std::span<const f32> samples, u64& bytesWritten);
   void flush(u64& bytesWritten);
 
+  // Stage API for EncoderPipeline. Each group touches disjoint state and
+  // must only be called from one thread at a time; none of them lock.
+  using PacketSink = std::function<void(AVPacket*)>;
+
+  // Convert stage: a frame in the encoder's software format, and
+  // GrabbedFrame -> `dst` (GPU I420 plane copy or sws_scale)
+  AVFramePtr allocVideoFrame() const;
+  bool convertVideo(const GrabbedFrame& frame, AVFrame* dst);
+
+  // Video encode stage: stamp from `mediaUs`, upload (HW) and encode;
+  // nullptr flushes. Encoded packets are handed to `sink` and unreferenced
+  // afterwards. Constant frame rate output places each frame in the slot
+  // nearest its media time: a frame landing in an already filled slot is
+  // skipped, one arriving late repeats to fill the slots it missed.
+  // Variable frame rate output uses the media time as-is.
+  bool sendVideo(AVFrame* frame, i64 mediaUs, const PacketSink& sink);
+
+  // Audio encode stage: resample interleaved stereo float `samples` (any
+  // length) into the sample FIFO, converting to the configured channel
+  // count, and encode every whole codec frame it holds. The remainder stays
+  // queued for the next call; flushAudio() encodes it as a final short (or
+  // padded) frame.
+  bool sendAudio(std::span<const f32> samples, const PacketSink& sink);
+  bool flushAudio(const PacketSink& sink);
+  bool hasAudio() const { return audioCodecCtx_ != nullptr; }
+  u32 audioSampleRate() const {
+    return audioCodecCtx_ ? static_cast<u32>(audioCodecCtx_->sample_rate) : 0;
+  }
+
+  // Rate of the samples given to sendAudio(); defaults to the encoder rate.
+  // A change drains the old resampler into the FIFO, so nothing is lost.
+  bool setAudioInputRate(u32 rate);
+  u32 audioInputRate() const { return audioInputRate_; }
+
+  // Drift compensation: add (delta > 0) or drop `delta` input frames spread
+  // over the next `distance` input frames (swr_set_compensation)
+  bool compensateAudio(i32 delta, i32 distance);
+
+  // Sync metrics, readable from any thread
+  u64 framesDuplicated() const { return framesDuplicated_.load(std::memory_order_relaxed); }
+  u64 framesSkipped() const { return framesSkipped_.load(std::memory_order_relaxed); }
+  i64 videoSyncErrorUs() const { return videoSyncErrorUs_.load(std::memory_order_relaxed); }
+
+  // Mux stage: rescale timestamps and interleave-write
+  bool writePacket(AVPacket* packet, AVStream* stream, u64& bytesWritten);
+  AVStream* videoStream() const { return videoStream_; }
+  AVStream* audioStream() const { return audioStream_; }
+
 private:
   Result<void> initVideoStream(const EncoderSettings& settings);
   Result<void> initAudioStream(const EncoderSettings& settings);
@@ -80,9 +133,13 @@ private:
   Result<void> initHWFrames(const EncoderSettings& settings);
   AVPixelFormat getHWPixelFormat(const EncoderSettings& settings) const;
 
-  bool encodeVideoFrame(AVFrame* frame, u64& bytesWritten);
-  bool encodeAudioFrame(AVFrame* frame, u64& bytesWritten);
-  bool writePacket(AVPacket* packet, AVStream* stream, u64& bytesWritten);
+  bool sendFrame(AVCodecContext* codec, AVFrame* frame, const PacketSink& sink);
+
+  // swr_convert `inFrames` interleaved frames (nullptr drains swr) into
+  // audioFifo_, then encode whole frames; `final` also encodes the tail
+  bool resampleToFifo(const u8* input, int inFrames);
+  Result<void> initResampler(u32 inputRate);
+  bool encodeFifo(const PacketSink& sink, bool final);
 
   AVFormatContextPtr formatCtx_;
   AVCodecContextPtr videoCodecCtx_;
@@ -101,11 +158,22 @@ private:
   AVFramePtr videoFrame_;
   AVFramePtr hwFrame_;         // Hardware frame for encoding
   AVFramePtr audioFrame_;
-  AVPacketPtr packet_;
+  AVFramePtr resampleFrame_;   // swr output, grown on demand
+  AVAudioFifoPtr audioFifo_;   // encoder-format samples awaiting a full frame
+  int audioFrameSize_{0};
+  u32 audioInputRate_{0};
+  AVPacketPtr packet_;         // video encoder output
+  AVPacketPtr audioPacket_;    // audio encoder output
 
   std::mutex mutex_;
-  u64 videoFrameCount_{0};
+  i64 nextVideoPts_{0};
   u64 audioFrameCount_{0};
+  u32 fps_{60};
+  bool variableFrameRate_{false};
+
+  std::atomic<u64> framesDuplicated_{0};
+  std::atomic<u64> framesSkipped_{0};
+  std::atomic<i64> videoSyncErrorUs_{0};
 
   int fileLockFd_{-1};
   std::string currentOutputPath_;
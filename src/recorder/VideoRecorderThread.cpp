@@ -1,9 +1,9 @@
-// Version: 1.1.0
-// Last Edited: 2026-03-29 12:00:00
-// Description: Video recorder thread implementation with lock-free queue
+// Version: 1.2.0
+// Last Edited: 2026-10-15 12:00:00
+// Description: Recording session: owns the encoder pipeline, publishes stats
 
 #include "VideoRecorderThread.hpp"
-#include "audio/AudioQueue.hpp"
+#include <condition_variable>
 #include "core/Logger.hpp"
 
 namespace vc {
@@ -34,6 +34,12 @@ void VideoRecorderThread::start() {
         stats_ = RecordingStats{};
         stats_.currentFile = actualOutputPath_;
     }
+
+    if (auto res = pipeline_.start(); !res) {
+        LOG_ERROR("Failed to start encoder pipeline: {}", res.error().message);
+        parent_.error.emitSignal(res.error().message);
+        return;
+    }
     
     thread_ = std::jthread([this](std::stop_token st) { threadLoop(st); });
     LOG_INFO("Recording thread started: {}", settings_.outputPath.string());
@@ -42,20 +48,14 @@ void VideoRecorderThread::start() {
 void VideoRecorderThread::stop() {
     shouldStop_ = true;
     frameGrabber_.stop();
+
+    // Drains captured frames, flushes both encoders, writes the last packet
+    pipeline_.stop();
+
     thread_.request_stop();
     if (thread_.joinable())
         thread_.join();
 
-    // Final flush
-    u64 bytes = 0;
-    ffmpeg_.flush(bytes);
-    
-    // Update final stats
-    {
-        std::lock_guard<std::mutex> lock(statsMutex_);
-        stats_.bytesWritten += bytes;
-    }
-    
     ffmpeg_.cleanup();
     LOG_INFO("Recording thread stopped");
 }
@@ -70,74 +70,38 @@ RecordingStats VideoRecorderThread::getStats() const {
 }
 
 void VideoRecorderThread::threadLoop(std::stop_token stopToken) {
-    LOG_DEBUG("Encoding thread started");
+    // The pipeline stages do the work; this thread only publishes stats
+    LOG_DEBUG("Recording stats thread started");
     auto startTime = std::chrono::steady_clock::now();
     auto lastStatsUpdate = startTime;
     u64 lastFramesWritten = 0;
-    
-    while (!stopToken.stop_requested()) {
-        GrabbedFrame frame;
-        bool hasVideo = frameGrabber_.getNextFrame(frame, 10);
-
-        u64 bytesWritten = 0;
-        bool hadError = false;
-
-        if (hasVideo) {
-            if (ffmpeg_.encodeVideo(frame, bytesWritten)) {
-                std::lock_guard<std::mutex> lock(statsMutex_);
-                ++stats_.framesWritten;
-                stats_.bytesWritten += bytesWritten;
-            } else {
-                hadError = true;
-                LOG_WARN("Failed to encode video frame");
-        }
-    }
+    u64 lastErrors = 0;
 
-    // Pop audio from lock-free queue (no mutex)
-    if (audioQueue_) {
-        static constexpr usize AUDIO_BATCH_SIZE = 4096;
-        alignas(64) float audioBatch[AUDIO_BATCH_SIZE * 2];
-        u32 popped = audioQueue_->popRecBatch(audioBatch, AUDIO_BATCH_SIZE);
-        if (popped > 0) {
-            std::vector<f32> audioBuffer(audioBatch, audioBatch + popped * 2);
-            if (!ffmpeg_.encodeAudio(audioBuffer, 2, bytesWritten)) {
-                hadError = true;
-                LOG_WARN("Failed to encode audio samples");
-            } else {
-                std::lock_guard<std::mutex> statsLock(statsMutex_);
-                stats_.bytesWritten += bytesWritten;
-            }
-        }
-    }
+    std::mutex waitMutex;
+    std::condition_variable_any waitCond;
 
-    // Update dropped frames count
+    while (!stopToken.stop_requested()) {
         {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.framesDropped = frameGrabber_.droppedFrames();
+            std::unique_lock lock(waitMutex);
+            waitCond.wait_for(lock, stopToken, std::chrono::seconds(1), [] { return false; });
         }
-
-        // Stop condition: requested stop AND queues empty
-        if (shouldStop_ && !hasVideo && !frameGrabber_.hasFrames()) {
+        if (stopToken.stop_requested())
             break;
-        }
 
-        // Stats update every second
-        auto now = std::chrono::steady_clock::now();
-        if (now - lastStatsUpdate >= std::chrono::seconds(1)) {
-            updateStats(startTime, lastFramesWritten, lastStatsUpdate);
-            lastStatsUpdate = now;
-        }
-        
-        // Emit error signal if there were encoding issues
-        if (hadError) {
+        u64 errors = pipeline_.errorCount();
+        if (errors != lastErrors) {
+            lastErrors = errors;
             parent_.error.emitSignal("Encoding error occurred - check logs");
         }
+
+        updateStats(startTime, lastFramesWritten, lastStatsUpdate);
+        lastStatsUpdate = std::chrono::steady_clock::now();
     }
     
-    // Final stats update
+    // Final stats update (stop() drained the pipeline before stopping us)
     updateStats(startTime, lastFramesWritten, lastStatsUpdate, true);
     
-    LOG_DEBUG("Encoding thread finishing");
+    LOG_DEBUG("Recording stats thread finishing");
 }
 
 void VideoRecorderThread::updateStats(TimePoint startTime,
@@ -150,9 +114,21 @@ void VideoRecorderThread::updateStats(TimePoint startTime,
     
     // Calculate elapsed time
     stats_.elapsed = std::chrono::duration_cast<Duration>(now - startTime);
+    stats_.framesWritten = pipeline_.framesEncoded();
+    stats_.bytesWritten = pipeline_.bytesWritten();
+    stats_.framesDropped = frameGrabber_.droppedFrames();
+    if (auto pool = pipeline_.framePool()) {
+        stats_.poolSlots = pool->slotCount();
+        stats_.poolInUse = pool->inUse();
+        stats_.poolPeakInUse = pool->peakInUse();
+        stats_.poolExhausted = pool->exhaustedCount();
+        // Frames the capture side couldn't lease were never queued
+        stats_.framesDropped += stats_.poolExhausted;
+    }
     
     // Calculate FPS over the last interval
     auto intervalSecs = std::chrono::duration<f64>(now - lastUpdate).count();
+    pipeline_.sampleStats(stats_, intervalSecs);
     if (intervalSecs > 0) {
         u64 framesDelta = stats_.framesWritten - lastFramesWritten;
         stats_.avgFps = static_cast<f64>(framesDelta) / intervalSecs;
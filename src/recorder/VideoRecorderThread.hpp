@@ -4,15 +4,16 @@
  * @version 1.1.0
  * @last-edited 2026-03-29 12:00:00
  *
- * This file defines the VideoRecorderThread class which handles the
- * asynchronous encoding process. It consumes video frames from a
- * FrameGrabber and audio samples from a lock-free queue, feeding them to
- * VideoRecorderFFmpeg for encoding.
+ * This file defines the VideoRecorderThread class which owns one recording
+ * session: the FrameGrabber that capture pushes into, the
+ * VideoRecorderFFmpeg output and the EncoderPipeline whose stage threads
+ * convert, encode and mux. Its own thread only publishes RecordingStats
+ * once a second.
  *
  * @section Patterns
  * - Producer-Consumer: Consumes frames/samples produced by the main/audio
  * threads.
- * - RAII: Manages the lifecycle of the encoding thread using std::jthread.
+ * - RAII: Manages the lifecycle of the stats thread using std::jthread.
  * - Thread-Safe Stats: Uses mutex-protected stats for safe cross-thread access.
  */
 
@@ -21,6 +22,7 @@
 #include <mutex>
 #include <thread>
 #include <vector>
+#include "EncoderPipeline.hpp"
 #include "FrameGrabber.hpp"
 #include "VideoRecorderCore.hpp"
 #include "VideoRecorderFFmpeg.hpp"
@@ -41,7 +43,7 @@ public:
     void pushVideoFrame(GrabbedFrame frame);
 
     // Set audio queue for lock-free consumption
-    void setAudioQueue(AudioQueue* queue) { audioQueue_ = queue; }
+    void setAudioQueue(AudioQueue* queue) { pipeline_.setAudioQueue(queue); }
 
     // Thread-safe stats access
     RecordingStats getStats() const;
@@ -65,9 +67,7 @@ private:
 
     FrameGrabber frameGrabber_;
     VideoRecorderFFmpeg ffmpeg_;
-
-    // Lock-free audio queue (replaces mutex-protected buffer)
-    AudioQueue* audioQueue_{nullptr};
+    EncoderPipeline pipeline_{ffmpeg_, frameGrabber_};
 
     // Thread-safe stats
     mutable std::mutex statsMutex_;
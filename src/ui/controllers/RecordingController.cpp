@@ -44,25 +44,13 @@ void RecordingController::connectSignals() {
             visualizer,
             &VisualizerWindow::frameCaptured,
             this,
-            [this](std::vector<u8> data, u32 w, u32 h, i64 ts) {
+            [this](FrameRef frame, u32 w, u32 h, i64 ts) {
                 if (recorder_->isRecording()) {
-                    recorder_->submitVideoFrame(std::move(data), w, h, ts);
+                    recorder_->submitVideoFrame(std::move(frame), w, h, ts);
                 }
             },
             Qt::DirectConnection);
 
-	// Connect audio samples to recorder
-	connect(window_->audioEngine(), &AudioEngine::pcmReceived,
-		this, [this](const std::vector<f32>& pcm,
-			u32 frames,
-			u32 channels,
-			u32 sampleRate) {
-			if (recorder_->isRecording()) {
-				recorder_->submitAudioSamples(
-					pcm.data(), frames, channels, sampleRate);
-			}
-		}, Qt::DirectConnection);
-
 	// Auto-stop recording on track change
 	connect(window_->audioEngine(), &AudioEngine::trackChanged,
 		this, [this] {
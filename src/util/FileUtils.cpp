@@ -127,6 +127,17 @@ Result<std::vector<u8>> readBinary(const fs::path& path) {
     return Result<std::vector<u8>>::ok(std::move(data));
 }
 
+std::optional<std::pair<u64, i64>> stamp(const fs::path& path) {
+    std::error_code ec;
+    const u64 size = fs::file_size(path, ec);
+    if (ec)
+        return std::nullopt;
+    const auto mtime = fs::last_write_time(path, ec);
+    if (ec)
+        return std::nullopt;
+    return std::pair{size, static_cast<i64>(mtime.time_since_epoch().count())};
+}
+
 std::vector<fs::path> listFiles(const fs::path& dir,
                                 const std::set<std::string>& extensions,
                                 bool recursive) {
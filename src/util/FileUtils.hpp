@@ -29,6 +29,10 @@ Result<void> writeText(const fs::path& path, std::string_view content);
 // Read binary file
 Result<std::vector<u8>> readBinary(const fs::path& path);
 
+// Size and mtime (file clock ticks), or nullopt if the file is gone.
+// Cheap change detection for caches keyed by path.
+std::optional<std::pair<u64, i64>> stamp(const fs::path& path);
+
 // List files with extension filter
 std::vector<fs::path> listFiles(const fs::path& dir, 
                                  const std::set<std::string>& extensions = {},
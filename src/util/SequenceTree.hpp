@@ -0,0 +1,269 @@
+#pragma once
+// SequenceTree.hpp - Ordered sequence with O(log n) positional edits
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "Types.hpp"
+
+namespace vc {
+
+/**
+ * A list addressed by position, stored as an implicit treap: insert, erase
+ * and move anywhere, and lookup by position, are O(log n) expected, so a
+ * 100k-entry playlist edits as fast as a 10-entry one.
+ *
+ * Every element also gets a Handle that stays valid (and keeps naming the
+ * same element) across edits elsewhere and across move(), until the element
+ * is erased; indexOf(handle) finds its current position in O(log n). Handles
+ * are small dense integers and are reused after erase, so callers can index
+ * side tables by them.
+ *
+ * Iteration is in order, amortized O(1) per step. Not thread-safe.
+ */
+template<typename T>
+class SequenceTree {
+public:
+    using Handle = u32;
+    static constexpr Handle NONE = 0;
+
+    SequenceTree() : nodes_(1), values_(1) {}
+
+    usize size() const { return nodes_[root_].size; }
+    bool empty() const { return root_ == NONE; }
+    // One past the largest handle ever returned; for sizing side tables
+    usize handleBound() const { return nodes_.size(); }
+
+    void clear() {
+        nodes_.resize(1);
+        values_.resize(1);
+        free_.clear();
+        root_ = NONE;
+    }
+
+    void reserve(usize count) {
+        nodes_.reserve(count + 1);
+        values_.reserve(count + 1);
+    }
+
+    Handle insert(usize pos, T value) {
+        const Handle node = allocate(std::move(value));
+        Handle left, right;
+        split(root_, std::min(pos, size()), left, right);
+        setRoot(merge(merge(left, node), right));
+        return node;
+    }
+
+    Handle pushBack(T value) { return insert(size(), std::move(value)); }
+
+    T erase(usize pos) {
+        const Handle node = detach(pos);
+        T value = std::move(values_[node]);
+        values_[node] = T{};
+        nodes_[node].live = false;
+        free_.push_back(node);
+        return value;
+    }
+
+    T eraseHandle(Handle handle) { return erase(indexOf(handle)); }
+
+    // Element at `from` ends up at position `to`; its handle is kept
+    void move(usize from, usize to) {
+        if (from == to)
+            return;
+        const Handle node = detach(from);
+        Handle left, right;
+        split(root_, to, left, right);
+        setRoot(merge(merge(left, node), right));
+    }
+
+    Handle handleAt(usize pos) const {
+        Handle node = root_;
+        while (node != NONE) {
+            const usize leftSize = nodes_[nodes_[node].left].size;
+            if (pos < leftSize) {
+                node = nodes_[node].left;
+            } else if (pos == leftSize) {
+                return node;
+            } else {
+                pos -= leftSize + 1;
+                node = nodes_[node].right;
+            }
+        }
+        return NONE;
+    }
+
+    usize indexOf(Handle handle) const {
+        usize index = nodes_[nodes_[handle].left].size;
+        for (Handle node = handle; nodes_[node].parent != NONE; node = nodes_[node].parent) {
+            const Handle parent = nodes_[node].parent;
+            if (nodes_[parent].right == node)
+                index += nodes_[nodes_[parent].left].size + 1;
+        }
+        return index;
+    }
+
+    bool contains(Handle handle) const { return handle != NONE && handle < nodes_.size() && nodes_[handle].live; }
+
+    T& get(Handle handle) { return values_[handle]; }
+    const T& get(Handle handle) const { return values_[handle]; }
+    T& operator[](usize pos) { return values_[handleAt(pos)]; }
+    const T& operator[](usize pos) const { return values_[handleAt(pos)]; }
+
+    template<bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+        using Tree = std::conditional_t<Const, const SequenceTree, SequenceTree>;
+
+        Iterator() = default;
+        Iterator(Tree* tree, Handle node) : tree_(tree), node_(node) {}
+
+        reference operator*() const { return tree_->values_[node_]; }
+        pointer operator->() const { return &tree_->values_[node_]; }
+        Handle handle() const { return node_; }
+
+        Iterator& operator++() {
+            node_ = tree_->successor(node_);
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        bool operator==(const Iterator& other) const { return node_ == other.node_; }
+
+    private:
+        Tree* tree_{nullptr};
+        Handle node_{NONE};
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    iterator begin() { return {this, leftmost(root_)}; }
+    iterator end() { return {this, NONE}; }
+    const_iterator begin() const { return {this, leftmost(root_)}; }
+    const_iterator end() const { return {this, NONE}; }
+
+private:
+    struct Node {
+        Handle left{NONE};
+        Handle right{NONE};
+        Handle parent{NONE};
+        u32 size{0};
+        u32 priority{0};
+        bool live{false};
+    };
+
+    Handle allocate(T value) {
+        Handle node;
+        if (!free_.empty()) {
+            node = free_.back();
+            free_.pop_back();
+            values_[node] = std::move(value);
+        } else {
+            node = static_cast<Handle>(nodes_.size());
+            nodes_.emplace_back();
+            values_.push_back(std::move(value));
+        }
+        nodes_[node] = Node{NONE, NONE, NONE, 1, nextPriority(), true};
+        return node;
+    }
+
+    // Unlink the node at `pos` (still live, as a lone node)
+    Handle detach(usize pos) {
+        Handle left, middle, right;
+        split(root_, pos, left, middle);
+        split(middle, 1, middle, right);
+        setRoot(merge(left, right));
+        nodes_[middle].parent = NONE;
+        return middle;
+    }
+
+    // First `count` elements of `tree` into `left`, the rest into `right`
+    void split(Handle tree, usize count, Handle& left, Handle& right) {
+        if (tree == NONE) {
+            left = right = NONE;
+            return;
+        }
+        Node& node = nodes_[tree];
+        const usize leftSize = nodes_[node.left].size;
+        if (leftSize < count) {
+            split(node.right, count - leftSize - 1, node.right, right);
+            left = tree;
+        } else {
+            split(node.left, count, left, node.left);
+            right = tree;
+        }
+        update(tree);
+    }
+
+    Handle merge(Handle left, Handle right) {
+        if (left == NONE || right == NONE)
+            return left != NONE ? left : right;
+        if (nodes_[left].priority > nodes_[right].priority) {
+            const Handle merged = merge(nodes_[left].right, right);
+            nodes_[left].right = merged;
+            update(left);
+            return left;
+        }
+        const Handle merged = merge(left, nodes_[right].left);
+        nodes_[right].left = merged;
+        update(right);
+        return right;
+    }
+
+    void update(Handle tree) {
+        Node& node = nodes_[tree];
+        node.size = 1 + nodes_[node.left].size + nodes_[node.right].size;
+        if (node.left != NONE)
+            nodes_[node.left].parent = tree;
+        if (node.right != NONE)
+            nodes_[node.right].parent = tree;
+    }
+
+    void setRoot(Handle tree) {
+        root_ = tree;
+        if (tree != NONE)
+            nodes_[tree].parent = NONE;
+    }
+
+    Handle leftmost(Handle node) const {
+        if (node == NONE)
+            return NONE;
+        while (nodes_[node].left != NONE)
+            node = nodes_[node].left;
+        return node;
+    }
+
+    Handle successor(Handle node) const {
+        if (nodes_[node].right != NONE)
+            return leftmost(nodes_[node].right);
+        while (nodes_[node].parent != NONE && nodes_[nodes_[node].parent].right == node)
+            node = nodes_[node].parent;
+        return nodes_[node].parent;
+    }
+
+    u32 nextPriority() {
+        // xorshift32: balance only needs priorities independent of the edits
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 17;
+        rng_ ^= rng_ << 5;
+        return rng_;
+    }
+
+    // Slot 0 is the empty-tree sentinel (size 0)
+    std::vector<Node> nodes_;
+    std::vector<T> values_;
+    std::vector<Handle> free_;
+    Handle root_{NONE};
+    u32 rng_{0x9e3779b9u};
+};
+
+} // namespace vc
@@ -0,0 +1,96 @@
+#pragma once
+// SpscQueue.hpp - Bounded lock-free single-producer/single-consumer queue
+// plus a futex-backed wakeup for threads that block on one
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include "Types.hpp"
+
+namespace vc {
+
+/**
+ * Fixed-capacity ring of T (rounded up to a power of two).
+ *
+ * Exactly one thread calls tryPush(), exactly one calls tryPop(). Never
+ * allocates after construction and never blocks; pair with WakeSignal when
+ * a side needs to sleep until the other makes progress.
+ */
+template<typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(u32 capacity)
+        : capacity_(std::bit_ceil(std::max<u32>(capacity, 2)))
+        , mask_(capacity_ - 1)
+        , slots_(std::make_unique<T[]>(capacity_))
+    {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool tryPush(T value) {
+        u64 tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) >= capacity_)
+            return false;
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        u64 head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+            return false;
+        out = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate from any thread other than the two endpoints
+    u32 size() const {
+        return static_cast<u32>(tail_.load(std::memory_order_acquire) -
+                                head_.load(std::memory_order_acquire));
+    }
+    bool empty() const {
+        return size() == 0;
+    }
+    u32 capacity() const {
+        return capacity_;
+    }
+
+private:
+    const u32 capacity_;
+    const u32 mask_;
+    std::unique_ptr<T[]> slots_;
+
+    alignas(64) std::atomic<u64> head_{0};
+    alignas(64) std::atomic<u64> tail_{0};
+};
+
+/**
+ * Sleep/wake doorbell built on std::atomic wait/notify (a futex on Linux).
+ *
+ * Waiter: `u32 seen = sig.epoch();` re-check its condition, then
+ * `sig.wait(seen)`. Notifier: change the condition, then `sig.notify()`.
+ * A notify between epoch() and wait() makes wait() return immediately, so
+ * no wakeup is lost. notify() skips the syscall when nobody is waiting.
+ */
+class WakeSignal {
+public:
+    u32 epoch() const {
+        return seq_.load(std::memory_order_acquire);
+    }
+    void notify() {
+        seq_.fetch_add(1, std::memory_order_release);
+        seq_.notify_all();
+    }
+    void wait(u32 seen) const {
+        seq_.wait(seen, std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<u32> seq_{0};
+};
+
+} // namespace vc
@@ -0,0 +1,55 @@
+#pragma once
+// TripleBuffer.hpp - Lock-free latest-value handoff between two threads
+
+#include <array>
+#include <atomic>
+#include "Types.hpp"
+
+namespace vc {
+
+/**
+ * Three slots of T: the writer fills `back()` and publish()es it, the reader
+ * calls update() and reads `front()` in place. Neither side ever blocks,
+ * copies or allocates; the reader always sees the newest complete value and
+ * intermediate ones are simply skipped.
+ *
+ * Exactly one writer thread and one reader thread. A published slot comes
+ * back to the writer with stale contents, so write every field each time.
+ */
+template<typename T>
+class TripleBuffer {
+public:
+    // Writer side
+    T& back() {
+        return slots_[back_];
+    }
+    void publish() {
+        u8 previous = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel);
+        back_ = previous & INDEX;
+    }
+
+    // Reader side: take the newest published value, if any. Returns false
+    // (and keeps the current front) when nothing new was published.
+    bool update() {
+        if (!(middle_.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        u8 previous = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = previous & INDEX;
+        return true;
+    }
+    // Valid until the next update()
+    const T& front() const {
+        return slots_[front_];
+    }
+
+private:
+    static constexpr u8 INDEX = 0x3;
+    static constexpr u8 FRESH = 0x4;
+
+    std::array<T, 3> slots_{};
+    alignas(64) u8 back_{0};
+    alignas(64) std::atomic<u8> middle_{1};
+    alignas(64) u8 front_{2};
+};
+
+} // namespace vc
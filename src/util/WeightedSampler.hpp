@@ -0,0 +1,150 @@
+#pragma once
+// WeightedSampler.hpp - Weighted random choice with O(1) weight updates
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <optional>
+#include <random>
+#include <vector>
+#include "Types.hpp"
+
+namespace vc {
+
+/**
+ * Picks item i with probability weight(i) / total. Unlike an alias table,
+ * which must be rebuilt in O(n) when any weight changes, set() is O(1):
+ * items are kept in buckets by the binary exponent of their weight, a draw
+ * chooses a bucket by its running total (at most LEVELS of them, a
+ * constant), then an item in it uniformly and keeps it with probability
+ * weight / bucket ceiling. Every weight in a bucket is at least half its
+ * ceiling, so a draw takes under two tries on average.
+ *
+ * Weights outside [2^MIN_EXP, 2^MAX_EXP) are clamped; 0 removes the item.
+ * Not thread-safe.
+ */
+class WeightedSampler {
+public:
+    static constexpr int MIN_EXP = -30;
+    static constexpr int MAX_EXP = 30;
+
+    void resize(usize count) {
+        clear();
+        items_.resize(count);
+    }
+
+    void clear() {
+        items_.clear();
+        for (auto& level : levels_) {
+            level.members.clear();
+            level.total = 0.0;
+        }
+        live_ = 0;
+    }
+
+    usize size() const { return items_.size(); }
+    // Items with a non-zero weight
+    usize live() const { return live_; }
+    bool empty() const { return live_ == 0; }
+    f64 total() const {
+        f64 sum = 0.0;
+        for (const auto& level : levels_)
+            sum += level.total;
+        return sum;
+    }
+    f64 weight(usize index) const { return items_[index].weight; }
+
+    void set(usize index, f64 weight) {
+        Item& item = items_[index];
+        if (weight > 0.0)
+            weight = std::clamp(weight, std::ldexp(1.0, MIN_EXP), std::ldexp(1.0, MAX_EXP - 1));
+        else
+            weight = 0.0;
+        if (weight == item.weight)
+            return;
+
+        if (item.weight > 0.0)
+            unlink(index);
+        item.weight = weight;
+        if (weight > 0.0)
+            link(index);
+    }
+
+    template<typename Rng>
+    std::optional<usize> sample(Rng& rng) const {
+        if (live_ == 0)
+            return std::nullopt;
+
+        // Bucket by total; rounding may leave `pick` past the last one
+        f64 pick = std::uniform_real_distribution<f64>(0.0, total())(rng);
+        const Level* level = nullptr;
+        int exp = 0;
+        for (int e = 0; e < LEVELS; ++e) {
+            if (levels_[e].members.empty())
+                continue;
+            level = &levels_[e];
+            exp = e + MIN_EXP + 1;
+            if (pick < level->total)
+                break;
+            pick -= level->total;
+        }
+
+        // Uniform in the bucket, kept in proportion to its weight. Retry in
+        // the same bucket: redrawing the bucket would skew the odds toward
+        // buckets whose members sit near their ceiling.
+        const f64 ceiling = std::ldexp(1.0, exp);
+        std::uniform_int_distribution<usize> member(0, level->members.size() - 1);
+        for (;;) {
+            const u32 index = level->members[member(rng)];
+            if (std::uniform_real_distribution<f64>(0.0, ceiling)(rng) < items_[index].weight)
+                return index;
+        }
+    }
+
+private:
+    static constexpr int LEVELS = MAX_EXP - MIN_EXP;
+
+    struct Item {
+        f64 weight{0.0};
+        u32 slot{0};
+    };
+
+    struct Level {
+        std::vector<u32> members;
+        f64 total{0.0};
+    };
+
+    // Weight in [2^(e-1), 2^e) lives in level e - MIN_EXP - 1
+    static int levelOf(f64 weight) {
+        int exp = 0;
+        std::frexp(weight, &exp);
+        return std::clamp(exp - MIN_EXP - 1, 0, LEVELS - 1);
+    }
+
+    void link(usize index) {
+        Item& item = items_[index];
+        Level& level = levels_[levelOf(item.weight)];
+        item.slot = static_cast<u32>(level.members.size());
+        level.members.push_back(static_cast<u32>(index));
+        level.total += item.weight;
+        ++live_;
+    }
+
+    void unlink(usize index) {
+        Item& item = items_[index];
+        Level& level = levels_[levelOf(item.weight)];
+        const u32 moved = level.members.back();
+        level.members[item.slot] = moved;
+        items_[moved].slot = item.slot;
+        level.members.pop_back();
+        // Running sums drift; an empty bucket is an exact zero again
+        level.total = level.members.empty() ? 0.0 : level.total - item.weight;
+        --live_;
+    }
+
+    std::vector<Item> items_;
+    std::array<Level, LEVELS> levels_;
+    usize live_{0};
+};
+
+} // namespace vc
@@ -1,14 +1,50 @@
 #pragma once
 // PresetData.hpp - Preset data structures
 
+#include <algorithm>
 #include <filesystem>
 #include <string>
+#include <vector>
 #include "util/Types.hpp"
 
 namespace vc {
 
 namespace fs = std::filesystem;
 
+// Static features read from the preset text, for sorting, filtering and
+// guessing render cost without loading it into projectM
+struct PresetFeatures {
+    u32 perFrameEquations{0};
+    u32 perPixelEquations{0};
+    u32 warpShaderBytes{0}; // 0: no warp shader (fixed-function warp)
+    u32 compShaderBytes{0}; // 0: no composite shader
+    u32 customWaves{0};     // enabled wavecode_N blocks
+    u32 customShapes{0};    // enabled shapecode_N blocks
+    std::vector<std::string> textures; // sampler_ names beyond the built-ins
+
+    bool hasWarpShader() const { return warpShaderBytes > 0; }
+    bool hasCompShader() const { return compShaderBytes > 0; }
+};
+
+// Measured render cost, kept in the PresetIndex; see PresetProfiler
+struct PresetCost {
+    f32 loadMs{0.0f};  // switching to it, on the render thread
+    f32 cpuMs{0.0f};   // per frame, smoothed over plays
+    f32 gpuMs{0.0f};   // per frame, from GL timer queries (0: none)
+    f32 worstMs{0.0f}; // slowest play's mean frame time
+    u32 plays{0};      // plays the frame times cover
+    u32 width{0};      // resolution they were measured at
+    u32 height{0};
+    u32 strikes{0};    // plays in a row over the frame budget
+    bool quarantined{false};
+
+    f32 frameMs() const { return std::max(cpuMs, gpuMs); }
+    // A quarantine holds at the resolution it was earned at and above
+    bool blocks(u32 w, u32 h) const {
+        return quarantined && u64{w} * h >= u64{width} * height;
+    }
+};
+
 struct PresetInfo {
     fs::path path;
     std::string name;
@@ -17,6 +53,18 @@ struct PresetInfo {
     bool favorite{false};
     bool blacklisted{false};
     u32 playCount{0};
+    i64 lastPlayed{0}; // Unix seconds, 0 = never
+    // File stamp the features were read at (see file::stamp())
+    u64 fileSize{0};
+    i64 mtime{0};
+    PresetFeatures features;
+    PresetCost cost;
+};
+
+// What PresetPersistence keeps per preset name across scans
+struct PresetPlayStats {
+    u32 playCount{0};
+    i64 lastPlayed{0};
 };
 
 } // namespace vc
@@ -0,0 +1,191 @@
+#include "PresetIndex.hpp"
+#include <charconv>
+#include <format>
+#include "core/Logger.hpp"
+#include "util/FileUtils.hpp"
+
+namespace vc {
+
+namespace {
+constexpr std::string_view INDEX_HEADER = "# chadvis preset index v2";
+// v1 lines have no cost fields; still read, saved as v2
+constexpr std::string_view INDEX_HEADER_V1 = "# chadvis preset index v1";
+
+// Fields are tab-separated and lines newline-terminated
+std::string clean(std::string value) {
+    for (char& c : value) {
+        if (c == '\t' || c == '\n' || c == '\r')
+            c = ' ';
+    }
+    return value;
+}
+
+std::string_view takeField(std::string_view& line, bool& ok) {
+    const auto tab = line.find('\t');
+    if (tab == std::string_view::npos) {
+        ok = false;
+        return {};
+    }
+    const auto field = line.substr(0, tab);
+    line.remove_prefix(tab + 1);
+    return field;
+}
+
+template <typename T>
+void parseField(std::string_view& line, T& value, bool& ok) {
+    const auto field = takeField(line, ok);
+    if (ok && std::from_chars(field.data(), field.data() + field.size(), value).ec != std::errc{})
+        ok = false;
+}
+
+// size, mtime, per-frame, per-pixel, warp bytes, comp bytes, waves,
+// shapes, textures (comma-separated), load ms, CPU ms, GPU ms, worst ms,
+// plays, width, height, strikes, quarantined, author, category, path
+std::string indexLine(const PresetInfo& info) {
+    const auto& f = info.features;
+    const auto& c = info.cost;
+    std::string textures;
+    for (const auto& texture : f.textures) {
+        if (!textures.empty())
+            textures += ',';
+        textures += texture;
+    }
+    return std::format("{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t"
+                       "{:.2f}\t{:.2f}\t{:.2f}\t{:.2f}\t{}\t{}\t{}\t{}\t{}\t"
+                       "{}\t{}\t{}\n",
+                       info.fileSize, info.mtime, f.perFrameEquations, f.perPixelEquations,
+                       f.warpShaderBytes, f.compShaderBytes, f.customWaves, f.customShapes,
+                       clean(textures),
+                       c.loadMs, c.cpuMs, c.gpuMs, c.worstMs, c.plays, c.width, c.height,
+                       c.strikes, c.quarantined ? 1 : 0,
+                       clean(info.author), clean(info.category), info.path.string());
+}
+} // namespace
+
+Result<void> PresetIndex::load(const fs::path& file) {
+    file_ = file;
+    entries_.clear();
+    dirty_ = false;
+
+    auto text = file::readText(file_);
+    if (!text)
+        return Result<void>::ok(); // first run
+    std::string_view rest = text.value();
+    const bool v1 = rest.starts_with(INDEX_HEADER_V1);
+    if (!v1 && !rest.starts_with(INDEX_HEADER)) {
+        // Other version: rebuild from scratch
+        dirty_ = true;
+        return Result<void>::ok();
+    }
+    dirty_ = v1;
+
+    while (!rest.empty()) {
+        const auto end = rest.find('\n');
+        if (end == std::string_view::npos)
+            break;
+        std::string_view line = rest.substr(0, end);
+        rest.remove_prefix(end + 1);
+        if (line.empty() || line.front() == '#')
+            continue;
+
+        PresetInfo info;
+        auto& f = info.features;
+        bool ok = true;
+        parseField(line, info.fileSize, ok);
+        parseField(line, info.mtime, ok);
+        parseField(line, f.perFrameEquations, ok);
+        parseField(line, f.perPixelEquations, ok);
+        parseField(line, f.warpShaderBytes, ok);
+        parseField(line, f.compShaderBytes, ok);
+        parseField(line, f.customWaves, ok);
+        parseField(line, f.customShapes, ok);
+        std::string_view textures = takeField(line, ok);
+        if (!v1) {
+            auto& c = info.cost;
+            u32 quarantined = 0;
+            parseField(line, c.loadMs, ok);
+            parseField(line, c.cpuMs, ok);
+            parseField(line, c.gpuMs, ok);
+            parseField(line, c.worstMs, ok);
+            parseField(line, c.plays, ok);
+            parseField(line, c.width, ok);
+            parseField(line, c.height, ok);
+            parseField(line, c.strikes, ok);
+            parseField(line, quarantined, ok);
+            c.quarantined = quarantined != 0;
+        }
+        info.author = takeField(line, ok);
+        info.category = takeField(line, ok);
+        if (!ok || line.empty())
+            continue;
+
+        while (!textures.empty()) {
+            const auto comma = textures.find(',');
+            f.textures.emplace_back(textures.substr(0, comma));
+            textures.remove_prefix(comma == std::string_view::npos ? textures.size() : comma + 1);
+        }
+        info.path = fs::path(line);
+        info.name = info.path.stem().string();
+        entries_.emplace(std::string(line), std::move(info));
+    }
+
+    LOG_DEBUG("Preset index: {} entries from {}", entries_.size(), file_.string());
+    return Result<void>::ok();
+}
+
+Result<void> PresetIndex::save() {
+    if (!dirty_ || file_.empty())
+        return Result<void>::ok();
+
+    std::string out = std::string(INDEX_HEADER) + '\n';
+    out.reserve(entries_.size() * 128);
+    for (const auto& [path, info] : entries_) {
+        out += indexLine(info);
+    }
+
+    if (auto result = file::ensureDir(file_.parent_path()); !result)
+        return result;
+    if (auto result = file::writeText(file_, out); !result)
+        return result;
+    dirty_ = false;
+    return Result<void>::ok();
+}
+
+const PresetInfo* PresetIndex::find(const fs::path& path, u64 size, i64 mtime) const {
+    auto it = entries_.find(path.string());
+    if (it == entries_.end() || it->second.fileSize != size || it->second.mtime != mtime)
+        return nullptr;
+    return &it->second;
+}
+
+void PresetIndex::store(const PresetInfo& info) {
+    PresetInfo& entry = entries_[info.path.string()];
+    entry = info;
+    // Per-user state lives in PresetPersistence, not here
+    entry.favorite = false;
+    entry.blacklisted = false;
+    entry.playCount = 0;
+    entry.lastPlayed = 0;
+    dirty_ = true;
+}
+
+void PresetIndex::setCost(const fs::path& path, const PresetCost& cost) {
+    auto it = entries_.find(path.string());
+    if (it == entries_.end())
+        return;
+    it->second.cost = cost;
+    dirty_ = true;
+}
+
+void PresetIndex::retainOnly(const fs::path& root, const std::unordered_set<std::string>& paths) {
+    std::string prefix = root.string();
+    if (!prefix.empty() && prefix.back() != '/')
+        prefix += '/';
+    const usize erased = std::erase_if(entries_, [&](const auto& entry) {
+        return entry.first.starts_with(prefix) && !paths.contains(entry.first);
+    });
+    if (erased > 0)
+        dirty_ = true;
+}
+
+} // namespace vc
@@ -0,0 +1,54 @@
+/**
+ * @file PresetIndex.hpp
+ * @brief On-disk index of scanned presets.
+ *
+ * One tab-separated line per preset file: its size and mtime, author,
+ * category, the static features PresetScanner read from the .milk text
+ * and the render cost PresetProfiler measured (reset when the file
+ * changes). A file whose size and mtime still match its line is not opened
+ * again, so a rescan of an unchanged 50k-preset collection is a directory
+ * walk plus one stat() per file.
+ *
+ * The whole file is loaded at once and rewritten (atomically) by save()
+ * only if something changed. Entries are keyed by full path, so switching
+ * preset folders back and forth keeps both indexed.
+ *
+ * @section Threads
+ * Not thread-safe; PresetScanner reads it from its workers only while no
+ * one writes.
+ */
+
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "PresetData.hpp"
+#include "util/Result.hpp"
+
+namespace vc {
+
+class PresetIndex {
+public:
+    // Missing or unreadable index: starts empty
+    Result<void> load(const fs::path& file);
+    // No-op unless something changed since load()
+    Result<void> save();
+
+    // The stored entry for `path` if it was indexed at this stamp
+    const PresetInfo* find(const fs::path& path, u64 size, i64 mtime) const;
+    void store(const PresetInfo& info);
+    void setCost(const fs::path& path, const PresetCost& cost);
+    // Drop entries under `root` for files no longer found there
+    void retainOnly(const fs::path& root, const std::unordered_set<std::string>& paths);
+
+    usize size() const { return entries_.size(); }
+    bool dirty() const { return dirty_; }
+    const fs::path& file() const { return file_; }
+
+private:
+    fs::path file_;
+    std::unordered_map<std::string, PresetInfo> entries_;
+    bool dirty_{false};
+};
+
+} // namespace vc
@@ -2,20 +2,61 @@
 #include <algorithm>
 #include "PresetPersistence.hpp"
 #include "PresetScanner.hpp"
+#include "RatingManager.hpp"
 #include "core/Logger.hpp"
 
 namespace vc {
 
-PresetManager::PresetManager() = default;
+namespace {
+i64 unixNow() {
+    return chr::duration_cast<chr::seconds>(chr::system_clock::now().time_since_epoch()).count();
+}
+} // namespace
+
+PresetManager::PresetManager() {
+    writer_ = std::jthread([this](std::stop_token stop) { writeLoop(stop); });
+}
+
+PresetManager::~PresetManager() {
+    flushState();
+    writer_.request_stop();
+    writer_.join();
+}
+
+void PresetManager::setIndexFile(const fs::path& file) {
+    std::lock_guard lock(mutex_);
+    std::lock_guard indexLock(indexMutex_);
+    if (auto res = index_.load(file); !res)
+        LOG_WARN("PresetManager: {}", res.error().message);
+    indexed_ = true;
+}
 
 Result<void> PresetManager::scan(const fs::path& directory, bool recursive) {
+    std::lock_guard lock(mutex_);
+    // Costs still on their way to the index first, so the scan reads them
+    flushState();
+    std::unique_lock indexLock(indexMutex_);
     scanDirectory_ = directory;
     presets_.clear();
-
-    auto res = PresetScanner::scan(
-            directory, recursive, presets_, favoriteNames_, blacklistedNames_);
+    profiler_.cancel();
+
+    auto res = PresetScanner::scan(directory,
+                                   recursive,
+                                   presets_,
+                                   favoriteNames_,
+                                   blacklistedNames_,
+                                   indexed_ ? &index_ : nullptr);
+    indexLock.unlock();
     if (!res)
         return res;
+    search_.build(presets_);
+    for (auto& preset : presets_) {
+        if (auto it = playStats_.find(preset.name); it != playStats_.end()) {
+            preset.playCount = it->second.playCount;
+            preset.lastPlayed = it->second.lastPlayed;
+        }
+    }
+    rebuildShuffle();
 
     if (!pendingPresetName_.empty()) {
         if (selectByName(pendingPresetName_))
@@ -27,23 +68,30 @@ Result<void> PresetManager::scan(const fs::path& directory, bool recursive) {
 }
 
 void PresetManager::rescan() {
+    std::lock_guard lock(mutex_);
     if (!scanDirectory_.empty())
         scan(scanDirectory_);
 }
 
 void PresetManager::clear() {
+    std::lock_guard lock(mutex_);
     presets_.clear();
+    profiler_.cancel();
+    search_.clear();
+    shuffle_.clear();
     currentIndex_ = 0;
     listChanged.emitSignal();
 }
 
 usize PresetManager::activeCount() const {
+    std::lock_guard lock(mutex_);
     return std::count_if(presets_.begin(), presets_.end(), [](const auto& p) {
         return !p.blacklisted;
     });
 }
 
 std::vector<const PresetInfo*> PresetManager::activePresets() const {
+    std::lock_guard lock(mutex_);
     std::vector<const PresetInfo*> result;
     for (const auto& p : presets_)
         if (!p.blacklisted)
@@ -52,6 +100,7 @@ std::vector<const PresetInfo*> PresetManager::activePresets() const {
 }
 
 std::vector<const PresetInfo*> PresetManager::favoritePresets() const {
+    std::lock_guard lock(mutex_);
     std::vector<const PresetInfo*> result;
     for (const auto& p : presets_)
         if (p.favorite && !p.blacklisted)
@@ -60,6 +109,7 @@ std::vector<const PresetInfo*> PresetManager::favoritePresets() const {
 }
 
 std::vector<const PresetInfo*> PresetManager::blacklistedPresets() const {
+    std::lock_guard lock(mutex_);
     std::vector<const PresetInfo*> result;
     for (const auto& p : presets_)
         if (p.blacklisted)
@@ -67,20 +117,15 @@ std::vector<const PresetInfo*> PresetManager::blacklistedPresets() const {
     return result;
 }
 
-std::vector<std::string> PresetManager::categories() const {
-    std::set<std::string> cats;
-    for (const auto& p : presets_)
-        cats.insert(p.category);
-    return {cats.begin(), cats.end()};
-}
-
 const PresetInfo* PresetManager::current() const {
+    std::lock_guard lock(mutex_);
     if (currentIndex_ >= presets_.size())
         return nullptr;
     return &presets_[currentIndex_];
 }
 
 bool PresetManager::selectByIndex(usize index) {
+    std::lock_guard lock(mutex_);
     if (index >= presets_.size() || presets_[index].blacklisted)
         return false;
 
@@ -98,12 +143,13 @@ bool PresetManager::selectByIndex(usize index) {
     }
 
     currentIndex_ = index;
-    presets_[currentIndex_].playCount++;
+    recordPlay(currentIndex_);
     presetChanged.emitSignal(&presets_[currentIndex_]);
     return true;
 }
 
 bool PresetManager::selectByName(const std::string& name) {
+    std::lock_guard lock(mutex_);
     if (presets_.empty()) {
         pendingPresetName_ = name;
         return false;
@@ -139,6 +185,7 @@ bool PresetManager::selectByName(const std::string& name) {
 }
 
 bool PresetManager::selectByPath(const fs::path& path) {
+    std::lock_guard lock(mutex_);
     for (usize i = 0; i < presets_.size(); ++i) {
         if (presets_[i].path == path && !presets_[i].blacklisted)
             return selectByIndex(i);
@@ -147,24 +194,46 @@ bool PresetManager::selectByPath(const fs::path& path) {
 }
 
 bool PresetManager::selectRandom() {
-    auto active = activePresets();
-    if (active.empty())
-        return false;
-    std::uniform_int_distribution<usize> dist(0, active.size() - 1);
-    const auto* preset = active[dist(rng_)];
-    for (usize i = 0; i < presets_.size(); ++i)
-        if (&presets_[i] == preset)
-            return selectByIndex(i);
-    return false;
+    std::lock_guard lock(mutex_);
+    auto index = pickRandom();
+    return index && selectByIndex(*index);
+}
+
+std::optional<usize> PresetManager::pickRandom() {
+    std::lock_guard lock(mutex_);
+    return shuffle_.pick(rng_);
+}
+
+void PresetManager::setShuffleWindow(usize window) {
+    std::lock_guard lock(mutex_);
+    shuffle_.setWindow(window);
+}
+
+std::vector<usize> PresetManager::upcoming(usize depth, bool shuffled) {
+    std::lock_guard lock(mutex_);
+    std::vector<usize> result;
+    if (presets_.empty() || depth == 0)
+        return result;
+    if (shuffled) {
+        const auto& ahead = shuffle_.lookAhead(depth, rng_);
+        result.assign(ahead.begin(), ahead.end());
+        return result;
+    }
+    // Like the native playlist's next(): every entry, in order
+    const usize count = std::min(depth, presets_.size() - 1);
+    for (usize i = 1; i <= count; ++i)
+        result.push_back((currentIndex_ + i) % presets_.size());
+    return result;
 }
 
 bool PresetManager::selectNext() {
+    std::lock_guard lock(mutex_);
     if (presets_.empty())
         return false;
     if (!history_.empty() && historyPosition_ < history_.size() - 1) {
         historyPosition_++;
         currentIndex_ = history_[historyPosition_];
-        presets_[currentIndex_].playCount++;
+        recordPlay(currentIndex_);
         presetChanged.emitSignal(&presets_[currentIndex_]);
         return true;
     }
@@ -174,7 +243,7 @@ bool PresetManager::selectNext() {
     usize nextIndex = currentIndex_;
     do {
         nextIndex = (nextIndex + 1) % presets_.size();
-        if (!presets_[nextIndex].blacklisted) {
+        if (!skipped(presets_[nextIndex])) {
             if (!currentName.empty() && presets_[nextIndex].name == currentName)
                 continue;
             return selectByIndex(nextIndex);
@@ -184,12 +253,13 @@ bool PresetManager::selectNext() {
 }
 
 bool PresetManager::selectPrevious() {
+    std::lock_guard lock(mutex_);
     if (presets_.empty())
         return false;
     if (!history_.empty() && historyPosition_ > 0) {
         historyPosition_--;
         currentIndex_ = history_[historyPosition_];
-        presets_[currentIndex_].playCount++;
+        recordPlay(currentIndex_);
         presetChanged.emitSignal(&presets_[currentIndex_]);
         return true;
     }
@@ -199,7 +269,7 @@ bool PresetManager::selectPrevious() {
     usize prevIndex = currentIndex_;
     do {
         prevIndex = (prevIndex == 0) ? presets_.size() - 1 : prevIndex - 1;
-        if (!presets_[prevIndex].blacklisted) {
+        if (!skipped(presets_[prevIndex])) {
             if (!currentName.empty() && presets_[prevIndex].name == currentName)
                 continue;
             return selectByIndex(prevIndex);
@@ -209,6 +279,7 @@ bool PresetManager::selectPrevious() {
 }
 
 void PresetManager::setFavorite(usize index, bool favorite) {
+    std::lock_guard lock(mutex_);
     if (index >= presets_.size())
         return;
     presets_[index].favorite = favorite;
@@ -216,10 +287,14 @@ void PresetManager::setFavorite(usize index, bool favorite) {
         favoriteNames_.insert(presets_[index].name);
     else
         favoriteNames_.erase(presets_[index].name);
-    listChanged.emitSignal();
+    shuffle_.update(index, shuffleWeight(presets_[index]));
+    stateDirty_ = true;
+    noteChange();
+    presetUpdated.emitSignal(index);
 }
 
 void PresetManager::setBlacklisted(usize index, bool blacklisted) {
+    std::lock_guard lock(mutex_);
     if (index >= presets_.size())
         return;
     presets_[index].blacklisted = blacklisted;
@@ -227,55 +302,297 @@ void PresetManager::setBlacklisted(usize index, bool blacklisted) {
         blacklistedNames_.insert(presets_[index].name);
     else
         blacklistedNames_.erase(presets_[index].name);
-    listChanged.emitSignal();
+    shuffle_.update(index, shuffleWeight(presets_[index]));
+    stateDirty_ = true;
+    noteChange();
+    presetUpdated.emitSignal(index);
 }
 
 void PresetManager::toggleFavorite(usize index) {
+    std::lock_guard lock(mutex_);
     if (index < presets_.size())
         setFavorite(index, !presets_[index].favorite);
 }
 void PresetManager::toggleBlacklisted(usize index) {
+    std::lock_guard lock(mutex_);
     if (index < presets_.size())
         setBlacklisted(index, !presets_[index].blacklisted);
 }
 
+void PresetManager::setRating(usize index, int stars) {
+    std::lock_guard lock(mutex_);
+    if (index >= presets_.size())
+        return;
+    auto& ratings = RatingManager::instance();
+    ratings.setRating(presets_[index].name, stars);
+    shuffle_.update(index, shuffleWeight(presets_[index]));
+    if (ratings.dirty())
+        noteChange();
+}
+
 std::vector<const PresetInfo*> PresetManager::search(
         const std::string& query) const {
+    std::lock_guard lock(mutex_);
     std::vector<const PresetInfo*> result;
-    std::string lowerQuery = query;
-    std::transform(lowerQuery.begin(),
-                   lowerQuery.end(),
-                   lowerQuery.begin(),
-                   ::tolower);
-    for (const auto& p : presets_) {
-        std::string lowerName = p.name;
-        std::transform(lowerName.begin(),
-                       lowerName.end(),
-                       lowerName.begin(),
-                       ::tolower);
-        if (lowerName.find(lowerQuery) != std::string::npos)
+    if (PresetSearch::tokenize(query).empty()) {
+        for (const auto& p : presets_)
             result.push_back(&p);
+        return result;
     }
+    for (const auto& hit : search_.search(query))
+        result.push_back(&presets_[hit.preset]);
     return result;
 }
 
 std::vector<const PresetInfo*> PresetManager::byCategory(
         const std::string& category) const {
+    std::lock_guard lock(mutex_);
     std::vector<const PresetInfo*> result;
-    for (const auto& p : presets_)
-        if (p.category == category && !p.blacklisted)
-            result.push_back(&p);
+    for (u32 i : search_.inCategory(category))
+        if (!presets_[i].blacklisted)
+            result.push_back(&presets_[i]);
     return result;
 }
 
+void PresetManager::setFrameBudget(f32 ms) {
+    std::lock_guard lock(mutex_);
+    frameBudgetMs_ = ms;
+}
+
+void PresetManager::setRenderSize(u32 width, u32 height) {
+    std::lock_guard lock(mutex_);
+    if (width == renderWidth_ && height == renderHeight_)
+        return;
+    renderWidth_ = width;
+    renderHeight_ = height;
+    // Quarantines hold per resolution; nothing else depends on it
+    for (usize i = 0; i < presets_.size(); ++i)
+        if (presets_[i].cost.quarantined)
+            shuffle_.update(i, shuffleWeight(presets_[i]));
+}
+
+void PresetManager::beginProfile(usize index, f32 loadMs, u32 settleFrames) {
+    std::lock_guard lock(mutex_);
+    endProfile();
+    if (!offline_ && index < presets_.size())
+        profiler_.begin(index, loadMs, renderWidth_, renderHeight_, settleFrames);
+}
+
+void PresetManager::profileFrame(f32 cpuMs, f32 gpuMs) {
+    std::lock_guard lock(mutex_);
+    profiler_.addFrame(cpuMs, gpuMs);
+}
+
+void PresetManager::endProfile() {
+    std::lock_guard lock(mutex_);
+    auto index = profiler_.preset();
+    if (!index || *index >= presets_.size()) {
+        profiler_.cancel();
+        return;
+    }
+    auto& preset = presets_[*index];
+    if (profiler_.finish(preset.cost, frameBudgetMs_)) {
+        LOG_WARN("PresetManager: Quarantined '{}': {:.1f} ms per frame at {}x{} "
+                 "(budget {:.1f} ms)",
+                 preset.name,
+                 preset.cost.frameMs(),
+                 preset.cost.width,
+                 preset.cost.height,
+                 frameBudgetMs_);
+    }
+    updateCost(*index);
+}
+
+bool PresetManager::isQuarantined(usize index) const {
+    std::lock_guard lock(mutex_);
+    return index < presets_.size() && presets_[index].cost.blocks(renderWidth_, renderHeight_);
+}
+
+usize PresetManager::quarantinedCount() const {
+    std::lock_guard lock(mutex_);
+    return std::ranges::count_if(presets_, [](const PresetInfo& p) { return p.cost.quarantined; });
+}
+
+void PresetManager::releaseQuarantine(usize index) {
+    std::lock_guard lock(mutex_);
+    if (index >= presets_.size() || !presets_[index].cost.quarantined)
+        return;
+    presets_[index].cost.quarantined = false;
+    presets_[index].cost.strikes = 0;
+    LOG_INFO("PresetManager: Released '{}' from quarantine", presets_[index].name);
+    updateCost(index);
+}
+
+Result<void> PresetManager::exportCosts(const fs::path& path) const {
+    std::lock_guard lock(mutex_);
+    return PresetPersistence::exportCosts(path, presets_, frameBudgetMs_);
+}
+
+void PresetManager::updateCost(usize index) {
+    const auto& preset = presets_[index];
+    shuffle_.update(index, shuffleWeight(preset));
+    if (indexed_ && !offline_)
+        costUpdates_.emplace_back(preset.path, preset.cost);
+    noteChange();
+    costUpdated.emitSignal(index);
+}
+
 Result<void> PresetManager::loadState(const fs::path& path) {
-    return PresetPersistence::loadState(
+    std::lock_guard lock(mutex_);
+    stateFile_ = path;
+    auto res = PresetPersistence::loadState(
             path, favoriteNames_, blacklistedNames_, presets_);
+    rebuildShuffle();
+    return res;
 }
 
 Result<void> PresetManager::saveState(const fs::path& path) const {
+    std::lock_guard lock(mutex_);
     return PresetPersistence::saveState(
             path, favoriteNames_, blacklistedNames_);
 }
 
+void PresetManager::setStatsFile(const fs::path& file) {
+    std::lock_guard lock(mutex_);
+    statsFile_ = file;
+    playStats_.clear();
+    if (auto res = PresetPersistence::loadStats(file, playStats_); !res)
+        LOG_WARN("PresetManager: {}", res.error().message);
+}
+
+void PresetManager::flushState() {
+    std::unique_lock lock(mutex_);
+    PendingWrite write = snapshot();
+    lock.unlock();
+    post(std::move(write), true);
+}
+
+PresetManager::PendingWrite PresetManager::snapshot() {
+    PendingWrite write;
+    if (stateDirty_ && !stateFile_.empty()) {
+        write.stateFile = stateFile_;
+        write.favorites = favoriteNames_;
+        write.blacklisted = blacklistedNames_;
+        stateDirty_ = false;
+    }
+    if (statsDirty_ && !statsFile_.empty()) {
+        write.statsFile = statsFile_;
+        write.stats = playStats_;
+        statsDirty_ = false;
+    }
+    write.ratings = RatingManager::instance().dirty();
+    write.index = indexed_;
+    write.costs.swap(costUpdates_);
+    unsavedChanges_ = 0;
+    lastFlush_ = chr::steady_clock::now();
+    return write;
+}
+
+void PresetManager::post(PendingWrite write, bool wait) {
+    std::unique_lock lock(writeMutex_);
+    if (!pendingWrite_) {
+        pendingWrite_ = std::move(write);
+    } else {
+        // Not picked up yet: the newer copies win, costs add up
+        auto& pending = *pendingWrite_;
+        if (!write.stateFile.empty()) {
+            pending.stateFile = std::move(write.stateFile);
+            pending.favorites = std::move(write.favorites);
+            pending.blacklisted = std::move(write.blacklisted);
+        }
+        if (!write.statsFile.empty()) {
+            pending.statsFile = std::move(write.statsFile);
+            pending.stats = std::move(write.stats);
+        }
+        pending.ratings |= write.ratings;
+        pending.index |= write.index;
+        pending.costs.insert(pending.costs.end(),
+                             std::make_move_iterator(write.costs.begin()),
+                             std::make_move_iterator(write.costs.end()));
+    }
+    writeWake_.notify_all();
+    if (wait)
+        writeWake_.wait(lock, [&] { return !pendingWrite_ && !writing_; });
+}
+
+void PresetManager::writeLoop(std::stop_token stop) {
+    std::unique_lock lock(writeMutex_);
+    for (;;) {
+        writeWake_.wait(lock, stop, [&] { return pendingWrite_.has_value(); });
+        if (!pendingWrite_)
+            return;
+        PendingWrite write = std::move(*pendingWrite_);
+        pendingWrite_.reset();
+        writing_ = true;
+        lock.unlock();
+        save(write);
+        lock.lock();
+        writing_ = false;
+        writeWake_.notify_all();
+    }
+}
+
+void PresetManager::save(const PendingWrite& write) {
+    if (!write.stateFile.empty()) {
+        if (auto res = PresetPersistence::saveState(write.stateFile, write.favorites, write.blacklisted);
+            !res)
+            LOG_WARN("PresetManager: Failed to save preset state: {}", res.error().message);
+    }
+    if (write.ratings) {
+        if (auto res = RatingManager::instance().save(); !res)
+            LOG_WARN("PresetManager: Failed to save ratings: {}", res.error().message);
+    }
+    if (!write.statsFile.empty()) {
+        if (auto res = PresetPersistence::saveStats(write.statsFile, write.stats); !res)
+            LOG_WARN("PresetManager: Failed to save play stats: {}", res.error().message);
+    }
+    if (write.index) {
+        std::lock_guard lock(indexMutex_);
+        for (const auto& [path, cost] : write.costs)
+            index_.setCost(path, cost);
+        if (auto res = index_.save(); !res)
+            LOG_WARN("PresetManager: Failed to save preset index: {}", res.error().message);
+    }
+}
+
+void PresetManager::recordPlay(usize index) {
+    auto& preset = presets_[index];
+    ++preset.playCount;
+    preset.lastPlayed = unixNow();
+    playStats_[preset.name] = {preset.playCount, preset.lastPlayed};
+    if (!offline_)
+        statsDirty_ = true;
+
+    shuffle_.update(index, shuffleWeight(preset));
+    shuffle_.played(index);
+    noteChange();
+}
+
+void PresetManager::rebuildShuffle() {
+    const i64 now = unixNow();
+    shuffle_.rebuild(presets_, [&](const PresetInfo& p) { return shuffleWeight(p, now); });
+}
+
+f64 PresetManager::shuffleWeight(const PresetInfo& preset) const {
+    return shuffleWeight(preset, unixNow());
+}
+
+f64 PresetManager::shuffleWeight(const PresetInfo& preset, i64 now) const {
+    if (preset.cost.blocks(renderWidth_, renderHeight_))
+        return 0.0;
+    return PresetShuffle::weight(preset, RatingManager::instance().getRating(preset.name), now);
+}
+
+bool PresetManager::skipped(const PresetInfo& preset) const {
+    return preset.blacklisted || preset.cost.blocks(renderWidth_, renderHeight_);
+}
+
+void PresetManager::noteChange() {
+    // Write-behind: a preset switch every few seconds shouldn't mean a
+    // file rewrite every few seconds, and never one on the caller's thread
+    if (++unsavedChanges_ >= FLUSH_CHANGES ||
+        chr::steady_clock::now() - lastFlush_ >= FLUSH_INTERVAL)
+        post(snapshot(), false);
+}
+
 } // namespace vc
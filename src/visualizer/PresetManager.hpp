@@ -10,16 +10,41 @@
  * - PresetData
  * - PresetScanner
  * - PresetPersistence
+ * - PresetIndex
+ * - PresetSearch
+ * - PresetShuffle
+ * - PresetProfiler
  *
  * @section Patterns
  * - Manager: Central point of control for preset logic.
+ *
+ * @section Threads
+ * The render thread (pm::Bridge: switches, random picks, profiling) and
+ * the GUI thread (PresetBridge and its models) share one manager. Every
+ * member takes one recursive mutex, so signals are emitted with it held
+ * and their slots may call back in. What the reference and pointer
+ * readers (allPresets(), current(), activePresets(), search(), ...)
+ * return is only safe to use while holding lock().
+ *
+ * State, ratings, play stats and index costs are written behind on a
+ * writer thread of the manager's own, from copies taken under the lock;
+ * flushState() waits for them.
  */
 
 #pragma once
+#include <condition_variable>
+#include <mutex>
+#include <optional>
 #include <random>
 #include <set>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include "PresetData.hpp"
+#include "PresetIndex.hpp"
+#include "PresetProfiler.hpp"
+#include "PresetSearch.hpp"
+#include "PresetShuffle.hpp"
 #include "util/Result.hpp"
 #include "util/Signal.hpp"
 
@@ -28,18 +53,28 @@ namespace vc {
 class PresetManager {
 public:
     PresetManager();
+    ~PresetManager();
 
-    // Scanning
+    // Scanning. With an index file, unchanged presets are taken from it
+    // instead of being read again.
+    void setIndexFile(const fs::path& file);
     Result<void> scan(const fs::path& directory, bool recursive = true);
     void rescan();
     void clear();
 
+    // See Threads above
+    [[nodiscard]] std::unique_lock<std::recursive_mutex> lock() const {
+        return std::unique_lock(mutex_);
+    }
+
     // Access
     usize count() const {
+        std::lock_guard lock(mutex_);
         return presets_.size();
     }
     usize activeCount() const;
     bool empty() const {
+        std::lock_guard lock(mutex_);
         return presets_.empty();
     }
 
@@ -49,29 +84,42 @@ public:
     std::vector<const PresetInfo*> activePresets() const;
     std::vector<const PresetInfo*> favoritePresets() const;
     std::vector<const PresetInfo*> blacklistedPresets() const;
-    std::vector<std::string> categories() const;
+    const std::vector<std::string>& categories() const {
+        return search_.categories();
+    }
 
     // Selection
     const PresetInfo* current() const;
     usize currentIndex() const {
+        std::lock_guard lock(mutex_);
         return currentIndex_;
     }
 
     bool selectByIndex(usize index);
     bool selectByName(const std::string& name);
     bool selectByPath(const fs::path& path);
+    // Weighted by rating, favorite and recency; see PresetShuffle
     bool selectRandom();
+    std::optional<usize> pickRandom();
+    void setShuffleWindow(usize window);
+    // What the next `depth` switches will most likely load: the following
+    // presets in list order, or with `shuffled` the next random picks,
+    // drawn now so that pickRandom() returns them in this order
+    std::vector<usize> upcoming(usize depth, bool shuffled);
     bool selectNext();
     bool selectPrevious();
 
     // Pending preset
     void setPendingPreset(const std::string& name) {
+        std::lock_guard lock(mutex_);
         pendingPresetName_ = name;
     }
-    const std::string& pendingPreset() const {
+    std::string pendingPreset() const {
+        std::lock_guard lock(mutex_);
         return pendingPresetName_;
     }
     void clearPendingPreset() {
+        std::lock_guard lock(mutex_);
         pendingPresetName_.clear();
     }
 
@@ -80,24 +128,103 @@ public:
     void setBlacklisted(usize index, bool blacklisted);
     void toggleFavorite(usize index);
     void toggleBlacklisted(usize index);
+    // 1-5 stars, via RatingManager
+    void setRating(usize index, int stars);
+
+    // Offline (headless) renders: state, stats and costs are read but play
+    // stats and costs aren't written back, and no play is profiled
+    void setOffline(bool offline) {
+        std::lock_guard lock(mutex_);
+        offline_ = offline;
+    }
+
+    // Render cost, measured by pm::Bridge; see PresetProfiler. Quarantined
+    // presets are left out of shuffle and next/previous at the resolution
+    // they were quarantined at and above.
+    void setFrameBudget(f32 ms);
+    f32 frameBudget() const {
+        std::lock_guard lock(mutex_);
+        return frameBudgetMs_;
+    }
+    void setRenderSize(u32 width, u32 height);
+    // Finishes the previous play's profile
+    void beginProfile(usize index, f32 loadMs, u32 settleFrames);
+    void profileFrame(f32 cpuMs, f32 gpuMs);
+    void endProfile();
+    bool isQuarantined(usize index) const;
+    usize quarantinedCount() const;
+    void releaseQuarantine(usize index);
+    Result<void> exportCosts(const fs::path& path) const;
 
-    // Search
+    // Search. Results are ranked; an empty query returns every preset.
     std::vector<const PresetInfo*> search(const std::string& query) const;
     std::vector<const PresetInfo*> byCategory(
             const std::string& category) const;
+    // Index over the current list, rebuilt on every scan
+    const PresetSearch& searchIndex() const {
+        return search_;
+    }
 
-    // Persistence
+    // Persistence. Changes are written behind on the writer thread,
+    // FLUSH_CHANGES at a time or after FLUSH_INTERVAL; flushState() writes
+    // what is left and waits until it's on disk.
     Result<void> loadState(const fs::path& path);
     Result<void> saveState(const fs::path& path) const;
+    void setStatsFile(const fs::path& file);
+    void flushState();
 
     // Signals
     Signal<const PresetInfo*> presetChanged;
     Signal<> listChanged;
+    // Favorite/blacklist flag of one preset changed; the list is the same
+    Signal<usize> presetUpdated;
+    // Measured cost or quarantine of one preset changed
+    Signal<usize> costUpdated;
 
 private:
+    static constexpr u32 FLUSH_CHANGES = 16;
+    static constexpr auto FLUSH_INTERVAL = chr::minutes(2);
+
+    // One flush's worth of changes; empty files: unchanged
+    struct PendingWrite {
+        fs::path stateFile;
+        std::set<std::string> favorites;
+        std::set<std::string> blacklisted;
+        fs::path statsFile;
+        std::unordered_map<std::string, PresetPlayStats> stats;
+        std::vector<std::pair<fs::path, PresetCost>> costs;
+        bool ratings{false};
+        bool index{false};
+    };
+
+    void recordPlay(usize index);
+    void rebuildShuffle();
+    f64 shuffleWeight(const PresetInfo& preset) const;
+    f64 shuffleWeight(const PresetInfo& preset, i64 now) const;
+    // Blacklisted or quarantined
+    bool skipped(const PresetInfo& preset) const;
+    void updateCost(usize index);
+    void noteChange();
+    // Takes the dirty state, under mutex_
+    PendingWrite snapshot();
+    void post(PendingWrite write, bool wait);
+    void writeLoop(std::stop_token stop);
+    void save(const PendingWrite& write);
+
+    mutable std::recursive_mutex mutex_;
     std::vector<PresetInfo> presets_;
     usize currentIndex_{0};
     fs::path scanDirectory_;
+    PresetIndex index_; // under indexMutex_: the writer saves it
+    PresetSearch search_;
+    PresetShuffle shuffle_;
+    bool indexed_{false};
+
+    PresetProfiler profiler_;
+    f32 frameBudgetMs_{1000.0f / 60.0f};
+    u32 renderWidth_{0};
+    u32 renderHeight_{0};
+    bool offline_{false};
 
     std::vector<usize> history_;
     usize historyPosition_{0};
@@ -106,7 +233,25 @@ private:
     std::set<std::string> blacklistedNames_;
     std::string pendingPresetName_;
 
+    // By name, like favorites, so they survive switching preset folders
+    std::unordered_map<std::string, PresetPlayStats> playStats_;
+    fs::path statsFile_;
+    fs::path stateFile_;
+    bool statsDirty_{false};
+    bool stateDirty_{false};
+    u32 unsavedChanges_{0};
+    TimePoint lastFlush_{chr::steady_clock::now()};
+    std::vector<std::pair<fs::path, PresetCost>> costUpdates_; // for index_
+
     std::mt19937 rng_{std::random_device{}()};
+
+    std::mutex indexMutex_;
+    std::mutex writeMutex_;
+    std::condition_variable_any writeWake_;
+    std::optional<PendingWrite> pendingWrite_;
+    bool writing_{false};
+    // Last: stopped before what it writes goes away
+    std::jthread writer_;
 };
 
 } // namespace vc
@@ -1,8 +1,56 @@
 #include "PresetPersistence.hpp"
+#include <algorithm>
+#include <charconv>
+#include <format>
 #include <fstream>
+#include "util/FileUtils.hpp"
 
 namespace vc {
 
+namespace {
+constexpr std::string_view STATS_HEADER = "# chadvis preset stats v1";
+
+template <typename T>
+bool parseField(std::string_view& line, T& value) {
+    const auto tab = line.find('\t');
+    if (tab == std::string_view::npos)
+        return false;
+    const auto field = line.substr(0, tab);
+    line.remove_prefix(tab + 1);
+    return std::from_chars(field.data(), field.data() + field.size(), value).ec == std::errc{};
+}
+
+std::string csvField(const std::string& value) {
+    if (value.find_first_of(",\"\n\r") == std::string::npos)
+        return value;
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"')
+            out += '"';
+        out += c;
+    }
+    return out + '"';
+}
+
+std::string jsonString(const std::string& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                out += std::format("\\u{:04x}", static_cast<int>(c));
+            else
+                out += c;
+        }
+    }
+    return out + '"';
+}
+} // namespace
+
 Result<void> PresetPersistence::loadState(
         const fs::path& path,
         std::set<std::string>& favoriteNames,
@@ -53,4 +101,92 @@ Result<void> PresetPersistence::saveState(
     return Result<void>::ok();
 }
 
+Result<void> PresetPersistence::loadStats(
+        const fs::path& path,
+        std::unordered_map<std::string, PresetPlayStats>& stats) {
+    auto text = file::readText(path);
+    if (!text)
+        return Result<void>::ok();
+    std::string_view rest = text.value();
+    if (!rest.starts_with(STATS_HEADER))
+        return Result<void>::err("Unknown preset stats format: " + path.string());
+
+    while (!rest.empty()) {
+        const auto end = rest.find('\n');
+        std::string_view line = rest.substr(0, end);
+        rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+        if (line.empty() || line.front() == '#')
+            continue;
+
+        PresetPlayStats entry;
+        if (parseField(line, entry.playCount) && parseField(line, entry.lastPlayed) &&
+            !line.empty())
+            stats[std::string(line)] = entry;
+    }
+    return Result<void>::ok();
+}
+
+Result<void> PresetPersistence::saveStats(
+        const fs::path& path,
+        const std::unordered_map<std::string, PresetPlayStats>& stats) {
+    std::string out = std::string(STATS_HEADER) + '\n';
+    for (const auto& [name, entry] : stats) {
+        if (name.find_first_of("\t\n") != std::string::npos)
+            continue;
+        out += std::format("{}\t{}\t{}\n", entry.playCount, entry.lastPlayed, name);
+    }
+    if (auto result = file::ensureDir(path.parent_path()); !result)
+        return result;
+    return file::writeText(path, out);
+}
+
+Result<void> PresetPersistence::exportCosts(const fs::path& path,
+                                           const std::vector<PresetInfo>& presets,
+                                           f32 budgetMs) {
+    std::vector<const PresetInfo*> measured;
+    for (const auto& preset : presets) {
+        if (preset.cost.plays > 0 || preset.cost.loadMs > 0.0f)
+            measured.push_back(&preset);
+    }
+    std::ranges::stable_sort(measured, std::ranges::greater{}, [](const PresetInfo* p) {
+        return p->cost.frameMs();
+    });
+
+    std::string out;
+    const bool json = path.extension() == ".json";
+    if (json) {
+        out = std::format("{{\n  \"frameBudgetMs\": {:.2f},\n  \"presets\": [", budgetMs);
+        for (usize i = 0; i < measured.size(); ++i) {
+            const auto& p = *measured[i];
+            const auto& c = p.cost;
+            out += std::format(
+                    "{}\n    {{\"name\": {}, \"path\": {}, \"author\": {}, \"category\": {}, "
+                    "\"loadMs\": {:.2f}, \"cpuMs\": {:.2f}, \"gpuMs\": {:.2f}, "
+                    "\"frameMs\": {:.2f}, \"worstMs\": {:.2f}, \"plays\": {}, "
+                    "\"width\": {}, \"height\": {}, \"strikes\": {}, \"quarantined\": {}}}",
+                    i == 0 ? "" : ",",
+                    jsonString(p.name), jsonString(p.path.string()), jsonString(p.author),
+                    jsonString(p.category), c.loadMs, c.cpuMs, c.gpuMs, c.frameMs(),
+                    c.worstMs, c.plays, c.width, c.height, c.strikes, c.quarantined);
+        }
+        out += measured.empty() ? "]\n}\n" : "\n  ]\n}\n";
+    } else {
+        out = "name,path,author,category,load_ms,cpu_ms,gpu_ms,frame_ms,worst_ms,"
+              "plays,width,height,strikes,quarantined\n";
+        for (const auto* preset : measured) {
+            const auto& p = *preset;
+            const auto& c = p.cost;
+            out += std::format("{},{},{},{},{:.2f},{:.2f},{:.2f},{:.2f},{:.2f},{},{},{},{},{}\n",
+                               csvField(p.name), csvField(p.path.string()),
+                               csvField(p.author), csvField(p.category), c.loadMs,
+                               c.cpuMs, c.gpuMs, c.frameMs(), c.worstMs, c.plays,
+                               c.width, c.height, c.strikes, c.quarantined ? 1 : 0);
+        }
+    }
+
+    if (auto result = file::ensureDir(path.parent_path()); !result)
+        return result;
+    return file::writeText(path, out);
+}
+
 } // namespace vc
@@ -3,7 +3,9 @@
  * @brief Save/load preset state.
  *
  * This file defines the PresetPersistence class which handles saving and
- * loading user preferences for presets (favorites, blacklist) to/from disk.
+ * loading user preferences for presets (favorites, blacklist) and play
+ * statistics (count, last played) to/from disk, and exports measured
+ * render costs.
  *
  * @section Dependencies
  * - PresetData
@@ -12,6 +14,7 @@
 
 #pragma once
 #include <set>
+#include <unordered_map>
 #include <vector>
 #include "PresetData.hpp"
 #include "util/Result.hpp"
@@ -29,6 +32,20 @@ public:
             const fs::path& path,
             const std::set<std::string>& favoriteNames,
             const std::set<std::string>& blacklistedNames);
+
+    // One "count<TAB>last played<TAB>name" line per preset ever played
+    static Result<void> loadStats(
+            const fs::path& path,
+            std::unordered_map<std::string, PresetPlayStats>& stats);
+    static Result<void> saveStats(
+            const fs::path& path,
+            const std::unordered_map<std::string, PresetPlayStats>& stats);
+
+    // Presets with a measured cost, slowest first; JSON for a .json path,
+    // CSV otherwise
+    static Result<void> exportCosts(const fs::path& path,
+                                    const std::vector<PresetInfo>& presets,
+                                    f32 budgetMs);
 };
 
 } // namespace vc
@@ -0,0 +1,88 @@
+#include "PresetProfiler.hpp"
+
+namespace vc {
+
+namespace {
+f32 smooth(f32 current, f32 sample, bool first) {
+    return first ? sample : current + PresetProfiler::SMOOTHING * (sample - current);
+}
+} // namespace
+
+void PresetProfiler::begin(usize preset, f32 loadMs, u32 width, u32 height, u32 settleFrames) {
+    *this = {};
+    active_ = true;
+    preset_ = preset;
+    loadMs_ = loadMs;
+    width_ = width;
+    height_ = height;
+    settle_ = settleFrames;
+}
+
+void PresetProfiler::addFrame(f32 cpuMs, f32 gpuMs) {
+    if (!active_)
+        return;
+    if (settle_ > 0) {
+        --settle_;
+        return;
+    }
+    ++frames_;
+    cpuTotal_ += cpuMs;
+    if (gpuMs >= 0.0f) {
+        ++gpuFrames_;
+        gpuTotal_ += gpuMs;
+    }
+}
+
+bool PresetProfiler::finish(PresetCost& cost, f32 budgetMs) {
+    if (!active_)
+        return false;
+    active_ = false;
+
+    cost.loadMs = smooth(cost.loadMs, loadMs_, cost.loadMs == 0.0f);
+    if (frames_ < MIN_FRAMES)
+        return false;
+
+    if (cost.width != width_ || cost.height != height_) {
+        // Frame times scale with the resolution. A quarantine keeps the one
+        // it was earned at, since it holds there and above (see blocks()).
+        cost.cpuMs = 0.0f;
+        cost.gpuMs = 0.0f;
+        cost.worstMs = 0.0f;
+        cost.plays = 0;
+        if (!cost.quarantined) {
+            cost.strikes = 0;
+            cost.width = width_;
+            cost.height = height_;
+        }
+    }
+
+    const f32 cpuMs = static_cast<f32>(cpuTotal_ / frames_);
+    const f32 gpuMs = gpuFrames_ > 0 ? static_cast<f32>(gpuTotal_ / gpuFrames_) : 0.0f;
+    cost.cpuMs = smooth(cost.cpuMs, cpuMs, cost.plays == 0);
+    cost.gpuMs = smooth(cost.gpuMs, gpuMs, cost.plays == 0);
+    ++cost.plays;
+
+    const f32 playMs = std::max(cpuMs, gpuMs);
+    cost.worstMs = std::max(cost.worstMs, playMs);
+    // Below the quarantine's resolution: says nothing about it
+    if (cost.quarantined && u64{width_} * height_ < u64{cost.width} * cost.height)
+        return false;
+    if (playMs <= budgetMs) {
+        cost.strikes = 0;
+        cost.quarantined = false;
+        cost.width = width_;
+        cost.height = height_;
+        return false;
+    }
+    ++cost.strikes;
+    if (cost.quarantined || cost.strikes < QUARANTINE_STRIKES)
+        return false;
+    cost.quarantined = true;
+    return true;
+}
+
+void PresetProfiler::cancel() {
+    active_ = false;
+}
+
+} // namespace vc
@@ -0,0 +1,64 @@
+/**
+ * @file PresetProfiler.hpp
+ * @brief Per-preset render cost and slow-preset quarantine.
+ *
+ * One play of a preset is profiled at a time: begin() when it is switched
+ * to (with the load time), addFrame() for every frame pm::Engine timed
+ * while it was on screen, finish() when the next switch comes. The frames
+ * of the transition into it are skipped, since both presets draw then.
+ *
+ * finish() folds the play into the preset's PresetCost: frame times are
+ * smoothed over plays (SMOOTHING is the newest play's share) and reset
+ * when the resolution changes, since they scale with it. A play whose
+ * mean frame time, the larger of CPU and GPU time, is over the frame
+ * budget is a strike; QUARANTINE_STRIKES in a row quarantine the preset
+ * at that resolution and above, and one play within budget at it or
+ * above lifts it again. Plays below it leave the quarantine alone. Plays
+ * shorter than MIN_FRAMES only update the load time.
+ *
+ * @section Dependencies
+ * - PresetData
+ */
+
+#pragma once
+#include <optional>
+#include "PresetData.hpp"
+
+namespace vc {
+
+class PresetProfiler {
+public:
+    static constexpr u32 MIN_FRAMES = 60;
+    static constexpr u32 QUARANTINE_STRIKES = 3;
+    static constexpr f32 SMOOTHING = 0.25f;
+
+    // `settleFrames`: transition frames not to count
+    void begin(usize preset, f32 loadMs, u32 width, u32 height, u32 settleFrames);
+    // gpuMs < 0: no GPU time for this frame
+    void addFrame(f32 cpuMs, f32 gpuMs);
+    // Folds the play into `cost`; true if that quarantined the preset
+    bool finish(PresetCost& cost, f32 budgetMs);
+    void cancel();
+
+    // Preset of the play in progress
+    std::optional<usize> preset() const {
+        return active_ ? std::optional<usize>(preset_) : std::nullopt;
+    }
+    u32 frames() const {
+        return frames_;
+    }
+
+private:
+    bool active_{false};
+    usize preset_{0};
+    f32 loadMs_{0.0f};
+    u32 width_{0};
+    u32 height_{0};
+    u32 settle_{0};
+    u32 frames_{0};
+    u32 gpuFrames_{0};
+    f64 cpuTotal_{0.0};
+    f64 gpuTotal_{0.0};
+};
+
+} // namespace vc
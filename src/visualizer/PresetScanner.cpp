@@ -1,17 +1,93 @@
 #include "PresetScanner.hpp"
 #include <algorithm>
-#include <regex>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <unordered_set>
+#include "PresetIndex.hpp"
 #include "core/Logger.hpp"
 #include "util/FileUtils.hpp"
 
 namespace vc {
 
+namespace {
+// Below this many files per thread, spawning costs more than it saves
+constexpr usize FILES_PER_THREAD = 256;
+
+// Textures every preset can sample without shipping them
+constexpr std::array<std::string_view, 10> BUILTIN_SAMPLERS = {
+        "main", "noise_lq", "noise_lq_lite", "noise_mq", "noise_hq",
+        "noisevol_lq", "noisevol_hq", "blur1", "blur2", "blur3"};
+
+bool isIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// "per_pixel_12" for prefix "per_pixel_"
+bool isNumbered(std::string_view key, std::string_view prefix) {
+    if (!key.starts_with(prefix) || key.size() == prefix.size())
+        return false;
+    return std::ranges::all_of(key.substr(prefix.size()), [](char c) {
+        return std::isdigit(static_cast<unsigned char>(c));
+    });
+}
+
+void collectTextures(std::string_view code, std::vector<std::string>& textures) {
+    constexpr std::string_view SAMPLER = "sampler_";
+    for (auto at = code.find(SAMPLER); at != std::string_view::npos; at = code.find(SAMPLER, at + 1)) {
+        if (at > 0 && isIdentifierChar(code[at - 1]))
+            continue;
+        auto end = at + SAMPLER.size();
+        while (end < code.size() && isIdentifierChar(code[end]))
+            ++end;
+        std::string_view name = code.substr(at + SAMPLER.size(), end - at - SAMPLER.size());
+        // Filter/wrap mode prefixes name the same texture
+        for (std::string_view mode : {"fw_", "fc_", "pw_", "pc_"}) {
+            if (name.starts_with(mode)) {
+                name.remove_prefix(mode.size());
+                break;
+            }
+        }
+        if (name.empty() || std::ranges::find(BUILTIN_SAMPLERS, name) != BUILTIN_SAMPLERS.end())
+            continue;
+        if (std::ranges::find(textures, name) == textures.end())
+            textures.emplace_back(name);
+    }
+}
+
+// Fill everything but the user state; false if the file is gone
+bool readPreset(PresetInfo& info, const PresetIndex* index, bool& parsed) {
+    const auto stamp = file::stamp(info.path);
+    if (!stamp)
+        return false;
+    info.fileSize = stamp->first;
+    info.mtime = stamp->second;
+
+    if (index) {
+        if (const auto* known = index->find(info.path, info.fileSize, info.mtime)) {
+            info.author = known->author;
+            info.features = known->features;
+            info.cost = known->cost;
+            return true;
+        }
+    }
+
+    PresetScanner::parsePresetInfo(info);
+    if (auto text = file::readText(info.path))
+        info.features = PresetScanner::parseFeatures(text.value());
+    parsed = true;
+    return true;
+}
+} // namespace
+
 Result<void> PresetScanner::scan(
         const fs::path& directory,
         bool recursive,
         std::vector<PresetInfo>& presets,
         const std::set<std::string>& favoriteNames,
-        const std::set<std::string>& blacklistedNames) {
+        const std::set<std::string>& blacklistedNames,
+        PresetIndex* index,
+        u32 threads) {
     if (!fs::exists(directory)) {
         return Result<void>::err("Preset directory does not exist: " +
                                  directory.string());
@@ -20,21 +96,57 @@ Result<void> PresetScanner::scan(
     LOG_INFO("PresetScanner: Scanning directory '{}' (recursive={})",
              directory.string(),
              recursive);
+    const auto started = chr::steady_clock::now();
 
     auto files = file::listFiles(directory, file::presetExtensions, recursive);
     LOG_INFO("PresetScanner: Found {} potential preset files", files.size());
 
-    for (const auto& path : files) {
-        PresetInfo info;
-        info.path = path;
-        info.name = path.stem().string();
+    std::vector<PresetInfo> found(files.size());
+    std::vector<u8> present(files.size(), 0);
+    std::vector<u8> parsed(files.size(), 0);
+    std::atomic<usize> next{0};
+    auto work = [&] {
+        for (usize i = next++; i < files.size(); i = next++) {
+            PresetInfo& info = found[i];
+            info.path = std::move(files[i]);
+            info.name = info.path.stem().string();
+            // Lexical: listFiles() paths are under `directory` already
+            info.category = info.path.parent_path().lexically_relative(directory).string();
+            if (info.category == "." || info.category.empty())
+                info.category = "Uncategorized";
 
-        auto rel = fs::relative(path.parent_path(), directory);
-        info.category = rel.string();
-        if (info.category == ".")
-            info.category = "Uncategorized";
+            bool fresh = false;
+            present[i] = readPreset(info, index, fresh);
+            parsed[i] = fresh;
+        }
+    };
 
-        parsePresetInfo(info);
+    if (threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    const usize workers = std::min<usize>(threads, files.size() / FILES_PER_THREAD + 1);
+    {
+        std::vector<std::jthread> pool;
+        for (usize i = 1; i < workers; ++i)
+            pool.emplace_back(work);
+        work();
+    }
+
+    usize presentCount = 0;
+    usize parsedCount = 0;
+    std::unordered_set<std::string> seen;
+    seen.reserve(found.size());
+    presets.reserve(presets.size() + found.size());
+    for (usize i = 0; i < found.size(); ++i) {
+        if (!present[i])
+            continue;
+        PresetInfo& info = found[i];
+        ++presentCount;
+        if (index) {
+            seen.insert(info.path.string());
+            if (parsed[i])
+                index->store(info);
+        }
+        parsedCount += parsed[i];
 
         if (favoriteNames.contains(info.name))
             info.favorite = true;
@@ -48,15 +160,66 @@ Result<void> PresetScanner::scan(
         return a.name < b.name;
     });
 
+    if (index) {
+        // A flat scan doesn't see subfolders, so it can't tell what's gone
+        if (recursive)
+            index->retainOnly(directory, seen);
+        if (auto result = index->save(); !result)
+            LOG_WARN("PresetScanner: Failed to save index: {}", result.error().message);
+    }
+
+    const auto ms = chr::duration_cast<chr::milliseconds>(chr::steady_clock::now() - started).count();
+    LOG_INFO("PresetScanner: {} presets in {} ms ({} parsed on {} threads, {} from index)",
+             presentCount, ms, parsedCount, workers, presentCount - parsedCount);
     return Result<void>::ok();
 }
 
 void PresetScanner::parsePresetInfo(PresetInfo& info) {
-    std::regex authorPattern(R"(^(.+?)\s*-\s*(.+)$)");
-    std::smatch match;
-    if (std::regex_match(info.name, match, authorPattern)) {
-        info.author = match[1].str();
+    // "Author - Title"; the first dash with something on both sides
+    const auto dash = info.name.find('-', 1);
+    if (dash == std::string::npos || dash + 1 >= info.name.size())
+        return;
+    std::string_view author(info.name.data(), dash);
+    while (!author.empty() && std::isspace(static_cast<unsigned char>(author.back())))
+        author.remove_suffix(1);
+    if (!author.empty())
+        info.author = author;
+}
+
+PresetFeatures PresetScanner::parseFeatures(std::string_view text) {
+    PresetFeatures features;
+    while (!text.empty()) {
+        const auto end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+
+        const auto eq = line.find('=');
+        if (eq == std::string_view::npos)
+            continue;
+        const std::string_view key = line.substr(0, eq);
+        std::string_view value = line.substr(eq + 1);
+
+        if (isNumbered(key, "per_frame_")) {
+            ++features.perFrameEquations;
+        } else if (isNumbered(key, "per_pixel_")) {
+            ++features.perPixelEquations;
+        } else if (isNumbered(key, "warp_") || isNumbered(key, "comp_")) {
+            // Shader source lines are stored behind a backtick
+            if (value.starts_with('`'))
+                value.remove_prefix(1);
+            auto& bytes = key.front() == 'w' ? features.warpShaderBytes : features.compShaderBytes;
+            bytes += static_cast<u32>(value.size()) + 1;
+            collectTextures(value, features.textures);
+        } else if (key.ends_with("_enabled") && value != "0") {
+            if (key.starts_with("wavecode_"))
+                ++features.customWaves;
+            else if (key.starts_with("shapecode_"))
+                ++features.customShapes;
+        }
     }
+    return features;
 }
 
 } // namespace vc
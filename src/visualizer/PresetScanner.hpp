@@ -3,30 +3,45 @@
  * @brief Preset directory scanning and parsing.
  *
  * This file defines the PresetScanner class which handles the filesystem
- * operations to find preset files and parse their metadata (author, name).
+ * operations to find preset files and parse their metadata (author, name)
+ * and static features (equation counts, shader sizes, textures).
+ *
+ * With a PresetIndex, files whose size and mtime match their index entry
+ * are taken from it; the rest are read on a pool of worker threads and
+ * stored back.
  *
  * @section Dependencies
  * - PresetData
+ * - PresetIndex
  * - std::filesystem
  */
 
 #pragma once
 #include <set>
+#include <string_view>
 #include <vector>
 #include "PresetData.hpp"
 #include "util/Result.hpp"
 
 namespace vc {
 
+class PresetIndex;
+
 class PresetScanner {
 public:
+    // threads = 0: one per core
     static Result<void> scan(const fs::path& directory,
                              bool recursive,
                              std::vector<PresetInfo>& presets,
                              const std::set<std::string>& favoriteNames,
-                             const std::set<std::string>& blacklistedNames);
+                             const std::set<std::string>& blacklistedNames,
+                             PresetIndex* index = nullptr,
+                             u32 threads = 0);
 
+    // Author from an "Author - Title" file name
     static void parsePresetInfo(PresetInfo& info);
+    // Features of a .milk file's text
+    static PresetFeatures parseFeatures(std::string_view text);
 };
 
 } // namespace vc
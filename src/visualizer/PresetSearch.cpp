@@ -0,0 +1,314 @@
+#include "PresetSearch.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <map>
+#include <numeric>
+
+namespace vc {
+
+namespace {
+// Match quality before field weighting
+constexpr f32 EXACT = 1.0f;
+constexpr f32 PREFIX = 0.7f;  // plus up to 0.2 for covering more of the token
+constexpr f32 INFIX = 0.45f;
+constexpr f32 FUZZY = 0.4f;   // times the Dice coefficient
+
+u32 trigramAt(std::string_view s, usize i) {
+    return static_cast<u32>(static_cast<u8>(s[i])) << 16 |
+           static_cast<u32>(static_cast<u8>(s[i + 1])) << 8 |
+           static_cast<u32>(static_cast<u8>(s[i + 2]));
+}
+// Best first, scores within 1/1024 of each other tie
+u16 rankKey(f32 score) {
+    return static_cast<u16>(0xffff - static_cast<u32>(std::clamp(score * 1024.0f, 0.0f, 65535.0f)));
+}
+
+// Stable radix sort on rankKey(): two byte passes, where a comparison
+// sort of a one-letter query's 20k hits would take a millisecond itself
+void rankSort(std::vector<PresetSearch::Hit>& hits) {
+    std::vector<PresetSearch::Hit> sorted(hits.size());
+    for (u32 shift : {0u, 8u}) {
+        std::array<usize, 257> offsets{};
+        for (const auto& hit : hits)
+            ++offsets[((rankKey(hit.score) >> shift) & 0xff) + 1];
+        for (usize i = 1; i < offsets.size(); ++i)
+            offsets[i] += offsets[i - 1];
+        for (const auto& hit : hits)
+            sorted[offsets[(rankKey(hit.score) >> shift) & 0xff]++] = hit;
+        hits.swap(sorted);
+    }
+}
+} // namespace
+
+std::vector<std::string> PresetSearch::tokenize(std::string_view text) {
+    std::vector<std::string> tokens;
+    std::string current;
+    for (char c : text) {
+        const auto u = static_cast<unsigned char>(c);
+        if (std::isalnum(u) || u >= 0x80) {
+            current += static_cast<char>(u < 0x80 ? std::tolower(u) : u);
+        } else if (!current.empty()) {
+            tokens.push_back(std::move(current));
+            current.clear();
+        }
+    }
+    if (!current.empty())
+        tokens.push_back(std::move(current));
+    return tokens;
+}
+
+void PresetSearch::clear() {
+    presetCount_ = 0;
+    tokens_.clear();
+    postings_.clear();
+    trigrams_.clear();
+    categories_.clear();
+    categoryPresets_.clear();
+    termScore_.clear();
+    score_.clear();
+    matched_.clear();
+    tokenShared_.clear();
+}
+
+void PresetSearch::build(const std::vector<PresetInfo>& presets) {
+    clear();
+    presetCount_ = presets.size();
+
+    std::unordered_map<std::string, u32> ids;
+    std::vector<std::string> names;
+    std::vector<std::vector<Posting>> lists;
+    std::map<std::string, std::vector<u32>, std::less<>> byCategory;
+
+    auto add = [&](std::string_view text, u8 field, u32 preset) {
+        for (auto& token : tokenize(text)) {
+            auto [it, inserted] = ids.try_emplace(token, static_cast<u32>(names.size()));
+            if (inserted) {
+                names.push_back(std::move(token));
+                lists.emplace_back();
+            }
+            auto& list = lists[it->second];
+            if (!list.empty() && list.back().preset == preset)
+                list.back().fields |= field;
+            else
+                list.push_back({preset, field});
+        }
+    };
+
+    for (u32 p = 0; p < presets.size(); ++p) {
+        const auto& info = presets[p];
+        add(info.name, NAME, p);
+        add(info.author, AUTHOR, p);
+        add(info.category, CATEGORY, p);
+
+        const auto& f = info.features;
+        if (f.hasWarpShader())
+            add("shader warp", FEATURE, p);
+        if (f.hasCompShader())
+            add("shader comp", FEATURE, p);
+        if (f.customWaves > 0)
+            add("waves", FEATURE, p);
+        if (f.customShapes > 0)
+            add("shapes", FEATURE, p);
+        for (const auto& texture : f.textures)
+            add(texture, FEATURE, p);
+
+        byCategory[info.category].push_back(p);
+    }
+
+    // Sorted tokens make every prefix a contiguous range
+    std::vector<u32> order(names.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+        return names[a] < names[b];
+    });
+    tokens_.reserve(order.size());
+    postings_.reserve(order.size());
+    for (u32 id : order) {
+        tokens_.push_back(std::move(names[id]));
+        postings_.push_back(std::move(lists[id]));
+    }
+
+    for (u32 t = 0; t < tokens_.size(); ++t) {
+        const auto& token = tokens_[t];
+        for (usize i = 0; i + 3 <= token.size(); ++i) {
+            auto& list = trigrams_[trigramAt(token, i)];
+            if (list.empty() || list.back() != t)
+                list.push_back(t);
+        }
+    }
+
+    for (auto& [category, members] : byCategory) {
+        categories_.push_back(category);
+        categoryPresets_.push_back(std::move(members));
+    }
+
+    termScore_.assign(presetCount_, 0.0f);
+    score_.assign(presetCount_, 0.0f);
+    matched_.assign(presetCount_, 0);
+    tokenShared_.assign(tokens_.size(), 0);
+}
+
+const std::vector<u32>& PresetSearch::inCategory(std::string_view category) const {
+    static const std::vector<u32> none;
+    auto it = std::lower_bound(categories_.begin(), categories_.end(), category);
+    if (it == categories_.end() || *it != category)
+        return none;
+    return categoryPresets_[static_cast<usize>(it - categories_.begin())];
+}
+
+f32 PresetSearch::fieldWeight(u8 fields) {
+    if (fields & NAME)
+        return 1.0f;
+    if (fields & AUTHOR)
+        return 0.8f;
+    if (fields & CATEGORY)
+        return 0.6f;
+    return 0.4f;
+}
+
+void PresetSearch::addTokenMatch(u32 token, f32 quality, u16 k) const {
+    for (const auto& posting : postings_[token]) {
+        // Out already: missed an earlier term
+        if (matched_[posting.preset] != k)
+            continue;
+        const f32 score = quality * fieldWeight(posting.fields);
+        f32& best = termScore_[posting.preset];
+        if (best == 0.0f)
+            termTouched_.push_back(posting.preset);
+        best = std::max(best, score);
+    }
+}
+
+usize PresetSearch::prefixPostings(std::string_view term) const {
+    usize total = 0;
+    auto it = std::lower_bound(tokens_.begin(), tokens_.end(), term);
+    for (; it != tokens_.end() && it->starts_with(term); ++it)
+        total += postings_[static_cast<usize>(it - tokens_.begin())].size();
+    return total;
+}
+
+void PresetSearch::matchTerm(std::string_view term, u16 k) const {
+    // Exact and prefix: one contiguous range of the sorted tokens
+    auto it = std::lower_bound(tokens_.begin(), tokens_.end(), term);
+    for (; it != tokens_.end() && it->starts_with(term); ++it) {
+        const auto id = static_cast<u32>(it - tokens_.begin());
+        const f32 covered = static_cast<f32>(term.size()) / static_cast<f32>(it->size());
+        addTokenMatch(id, it->size() == term.size() ? EXACT : PREFIX + 0.2f * covered, k);
+    }
+
+    // Infix and fuzzy matches only for a term that no candidate has a token
+    // starting with: the trigram pass walks far more tokens than the range
+    if (term.size() < 3 || !termTouched_.empty())
+        return;
+
+    // Infix and fuzzy: count trigrams each token shares with the term
+    std::vector<u32> grams;
+    grams.reserve(term.size() - 2);
+    for (usize i = 0; i + 3 <= term.size(); ++i)
+        grams.push_back(trigramAt(term, i));
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+    for (u32 gram : grams) {
+        auto found = trigrams_.find(gram);
+        if (found == trigrams_.end())
+            continue;
+        for (u32 token : found->second) {
+            if (tokenShared_[token]++ == 0)
+                tokenTouched_.push_back(token);
+        }
+    }
+
+    for (u32 token : tokenTouched_) {
+        const u16 shared = tokenShared_[token];
+        tokenShared_[token] = 0;
+        const auto& text = tokens_[token];
+        if (text.starts_with(term))
+            continue; // scored above
+        if (shared == grams.size() && text.find(term) != std::string::npos) {
+            addTokenMatch(token, INFIX, k);
+            continue;
+        }
+        const f32 dice = 2.0f * shared / static_cast<f32>(grams.size() + text.size() - 2);
+        if (dice >= FUZZY_MIN)
+            addTokenMatch(token, FUZZY * dice, k);
+    }
+    tokenTouched_.clear();
+}
+
+std::vector<PresetSearch::Hit> PresetSearch::search(std::string_view query, usize limit) const {
+    auto terms = tokenize(query);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    if (terms.empty() || presetCount_ == 0 || terms.size() > 0xffff)
+        return {};
+
+    // Rarest term first: later terms only score what it left
+    std::vector<usize> postings(terms.size());
+    for (usize i = 0; i < terms.size(); ++i)
+        postings[i] = prefixPostings(terms[i]);
+    std::vector<usize> order(terms.size());
+    std::iota(order.begin(), order.end(), usize{0});
+    std::stable_sort(order.begin(), order.end(), [&](usize a, usize b) {
+        return postings[a] < postings[b];
+    });
+
+    // A preset stays a candidate while it has matched every term so far.
+    // touched_ keeps the first term's matches to reset afterwards.
+    const auto full = static_cast<u16>(terms.size());
+    std::vector<u32> survivors;
+    for (u16 k = 0; k < full; ++k) {
+        matchTerm(terms[order[k]], k);
+        for (u32 p : termTouched_) {
+            matched_[p] = static_cast<u16>(k + 1);
+            score_[p] += termScore_[p];
+            termScore_[p] = 0.0f;
+        }
+        if (k == 0)
+            touched_ = termTouched_;
+        survivors.swap(termTouched_);
+        termTouched_.clear();
+        if (survivors.empty())
+            break;
+    }
+
+    // Hits in preset order, so a stable sort by score leaves ties in preset
+    // order. A (branch-free) sweep is cheaper than sorting a large share.
+    if (survivors.size() * 8 > presetCount_) {
+        survivors.resize(presetCount_);
+        usize count = 0;
+        for (u32 p = 0; p < presetCount_; ++p) {
+            survivors[count] = p;
+            count += matched_[p] == full;
+        }
+        survivors.resize(count);
+    } else {
+        std::sort(survivors.begin(), survivors.end());
+    }
+
+    std::vector<Hit> hits;
+    hits.reserve(survivors.size());
+    for (u32 p : survivors)
+        hits.push_back({p, score_[p]});
+    for (u32 p : touched_) {
+        matched_[p] = 0;
+        score_[p] = 0.0f;
+    }
+    touched_.clear();
+
+    if (limit > 0 && limit < hits.size()) {
+        std::partial_sort(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(limit), hits.end(),
+                          [](const Hit& a, const Hit& b) {
+                              const u16 ka = rankKey(a.score);
+                              const u16 kb = rankKey(b.score);
+                              return ka != kb ? ka < kb : a.preset < b.preset;
+                          });
+        hits.resize(limit);
+    } else {
+        rankSort(hits);
+    }
+    return hits;
+}
+
+} // namespace vc
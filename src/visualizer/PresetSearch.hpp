@@ -0,0 +1,108 @@
+/**
+ * @file PresetSearch.hpp
+ * @brief Inverted index for type-ahead preset search.
+ *
+ * Names, authors, categories and a few feature words ("shader", "waves",
+ * texture names) are split into lowercase tokens. Each token keeps a
+ * posting list of the presets it occurs in and which fields it came from;
+ * each trigram of a token points back at the tokens containing it.
+ *
+ * A query is split the same way and every term must match. A term matches
+ * a token exactly, as a prefix, inside it (all trigrams shared) or
+ * fuzzily (trigram Dice coefficient above FUZZY_MIN), in falling order of
+ * score; the field it matched in weighs the score too. Infix and fuzzy
+ * matches are only tried for a term with no exact or prefix match. Results
+ * are ranked by summed score (to 1/1024), ties in preset order.
+ *
+ * Terms are matched rarest first, and each later term only scores the
+ * presets still in the running, so adding a word narrows the work.
+ *
+ * Built once per scan. Queries touch postings and flat per-preset arrays,
+ * never the presets themselves, so type-ahead over tens of thousands of
+ * presets stays under a millisecond.
+ *
+ * @section Threads
+ * search() reuses scratch buffers: one caller at a time.
+ */
+
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "PresetData.hpp"
+
+namespace vc {
+
+class PresetSearch {
+public:
+    struct Hit {
+        u32 preset; // index into the list build() saw
+        f32 score;
+    };
+
+    void build(const std::vector<PresetInfo>& presets);
+    void clear();
+
+    // Ranked best first; limit = 0 for all. An empty query matches nothing.
+    std::vector<Hit> search(std::string_view query, usize limit = 0) const;
+
+    // Sorted, unique
+    const std::vector<std::string>& categories() const {
+        return categories_;
+    }
+    // Presets in `category`, in preset order
+    const std::vector<u32>& inCategory(std::string_view category) const;
+
+    usize presetCount() const {
+        return presetCount_;
+    }
+    usize tokenCount() const {
+        return tokens_.size();
+    }
+
+    // Lowercase alphanumeric runs; bytes >= 0x80 count as letters so UTF-8
+    // names stay searchable
+    static std::vector<std::string> tokenize(std::string_view text);
+
+private:
+    enum Field : u8 {
+        NAME = 1 << 0,
+        AUTHOR = 1 << 1,
+        CATEGORY = 1 << 2,
+        FEATURE = 1 << 3,
+    };
+
+    struct Posting {
+        u32 preset;
+        u8 fields;
+    };
+
+    static constexpr f32 FUZZY_MIN = 0.5f;
+
+    // Presets listed under the tokens `term` is a prefix of, duplicates
+    // included: a cheap upper bound on its exact and prefix matches
+    usize prefixPostings(std::string_view term) const;
+    // Term `k` of the query, scored for presets that matched terms 0..k-1
+    void matchTerm(std::string_view term, u16 k) const;
+    void addTokenMatch(u32 token, f32 quality, u16 k) const;
+    static f32 fieldWeight(u8 fields);
+
+    usize presetCount_{0};
+    std::vector<std::string> tokens_;            // sorted
+    std::vector<std::vector<Posting>> postings_; // per token, by preset
+    std::unordered_map<u32, std::vector<u32>> trigrams_;
+    std::vector<std::string> categories_;
+    std::vector<std::vector<u32>> categoryPresets_;
+
+    // Query scratch, sized to presets/tokens and left zeroed between calls
+    mutable std::vector<f32> termScore_;
+    mutable std::vector<u32> termTouched_;
+    mutable std::vector<f32> score_;
+    mutable std::vector<u16> matched_;
+    mutable std::vector<u32> touched_;
+    mutable std::vector<u16> tokenShared_;
+    mutable std::vector<u32> tokenTouched_;
+};
+
+} // namespace vc
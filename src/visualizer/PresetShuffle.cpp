@@ -0,0 +1,116 @@
+#include "PresetShuffle.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace vc {
+
+f64 PresetShuffle::weight(const PresetInfo& info, int stars, i64 now) {
+    if (info.blacklisted)
+        return 0.0;
+
+    f64 w = stars > 0 ? std::exp2(std::clamp(stars, 1, 5) - 3) : 1.0;
+    if (info.favorite)
+        w *= FAVORITE_BOOST;
+    if (info.lastPlayed > 0) {
+        const f64 age = static_cast<f64>(std::max<i64>(now - info.lastPlayed, 0));
+        w *= 1.0 - RECENCY_PENALTY * std::exp2(-age / RECENCY_HALF_LIFE);
+    }
+    return w;
+}
+
+void PresetShuffle::setWindow(usize window) {
+    window_ = window;
+    while (recent_.size() > window_)
+        release();
+}
+
+void PresetShuffle::rebuild(const std::vector<PresetInfo>& presets,
+                            const std::function<f64(const PresetInfo&)>& weigh) {
+    clear();
+    sampler_.resize(presets.size());
+    weights_.resize(presets.size());
+    state_.assign(presets.size(), Drawable);
+    for (usize i = 0; i < presets.size(); ++i) {
+        weights_[i] = weigh(presets[i]);
+        sampler_.set(i, weights_[i]);
+    }
+}
+
+void PresetShuffle::clear() {
+    sampler_.clear();
+    weights_.clear();
+    state_.clear();
+    recent_.clear();
+    ahead_.clear();
+}
+
+void PresetShuffle::update(usize index, f64 weight) {
+    if (index >= weights_.size())
+        return;
+    weights_[index] = weight;
+    if (state_[index] == Ahead && weight <= 0.0)
+        dropAhead(index);
+    if (state_[index] == Drawable)
+        sampler_.set(index, weight);
+}
+
+void PresetShuffle::played(usize index) {
+    if (index >= weights_.size())
+        return;
+    // Shown out of turn: it is no longer coming up
+    if (state_[index] == Ahead)
+        dropAhead(index);
+    if (window_ == 0)
+        return;
+    if (state_[index] == InWindow) {
+        // Again: restart its time in the window
+        recent_.erase(std::find(recent_.begin(), recent_.end(), static_cast<u32>(index)));
+    } else {
+        state_[index] = InWindow;
+        sampler_.set(index, 0.0);
+    }
+    recent_.push_back(static_cast<u32>(index));
+    while (recent_.size() > window_)
+        release();
+}
+
+std::optional<usize> PresetShuffle::pick(std::mt19937& rng) {
+    if (!ahead_.empty()) {
+        const u32 index = ahead_.front();
+        dropAhead(index);
+        return index;
+    }
+    // Fewer candidates than the window: let the oldest back in
+    while (sampler_.empty() && !recent_.empty())
+        release();
+    return sampler_.sample(rng);
+}
+
+const std::deque<u32>& PresetShuffle::lookAhead(usize depth, std::mt19937& rng) {
+    while (ahead_.size() < depth) {
+        while (sampler_.empty() && !recent_.empty())
+            release();
+        auto index = sampler_.sample(rng);
+        if (!index)
+            break;
+        state_[*index] = Ahead;
+        sampler_.set(*index, 0.0);
+        ahead_.push_back(static_cast<u32>(*index));
+    }
+    return ahead_;
+}
+
+void PresetShuffle::release() {
+    const u32 index = recent_.front();
+    recent_.pop_front();
+    state_[index] = Drawable;
+    sampler_.set(index, weights_[index]);
+}
+
+void PresetShuffle::dropAhead(usize index) {
+    ahead_.erase(std::find(ahead_.begin(), ahead_.end(), static_cast<u32>(index)));
+    state_[index] = Drawable;
+    sampler_.set(index, weights_[index]);
+}
+
+} // namespace vc
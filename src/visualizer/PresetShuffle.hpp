@@ -0,0 +1,89 @@
+/**
+ * @file PresetShuffle.hpp
+ * @brief Weighted preset shuffle.
+ *
+ * Random picks favour what the user likes and avoid what they just saw:
+ * a preset's weight is 2^(stars - 3) if rated (so 3 stars is neutral and
+ * each star doubles it), times FAVORITE_BOOST for favorites, times a
+ * recency factor that starts at 1 - RECENCY_PENALTY right after it was
+ * played and recovers with a RECENCY_HALF_LIFE. Blacklisted presets weigh
+ * nothing.
+ *
+ * The last `window` presets played are out of the draw entirely until they
+ * fall out of the window (it shrinks on its own when fewer presets than
+ * that are left). Picks and weight changes are O(1), see WeightedSampler;
+ * only a rescan rebuilds.
+ *
+ * lookAhead() draws the next few picks early so they can be prepared
+ * (see pm::Prewarmer); they are out of the draw until pick() hands them
+ * out in order, or drop out if their weight goes to 0.
+ *
+ * @section Dependencies
+ * - PresetData
+ * - WeightedSampler
+ */
+
+#pragma once
+#include <deque>
+#include <functional>
+#include <optional>
+#include <random>
+#include <vector>
+#include "PresetData.hpp"
+#include "util/WeightedSampler.hpp"
+
+namespace vc {
+
+class PresetShuffle {
+public:
+    static constexpr f64 FAVORITE_BOOST = 3.0;
+    static constexpr f64 RECENCY_PENALTY = 0.8;
+    static constexpr i64 RECENCY_HALF_LIFE = 24 * 60 * 60; // seconds
+    static constexpr usize DEFAULT_WINDOW = 20;
+
+    // stars: 0 = unrated, 1-5
+    static f64 weight(const PresetInfo& info, int stars, i64 now);
+
+    void setWindow(usize window);
+    usize window() const {
+        return window_;
+    }
+
+    // Forgets the repeat window; weigh() gives each preset's weight,
+    // usually weight() with its rating
+    void rebuild(const std::vector<PresetInfo>& presets,
+                 const std::function<f64(const PresetInfo&)>& weigh);
+    void clear();
+
+    // New weight for one preset, e.g. after its rating or flags changed
+    void update(usize index, f64 weight);
+    // `index` was shown; it sits out the next `window` picks
+    void played(usize index);
+
+    std::optional<usize> pick(std::mt19937& rng);
+    // The next `depth` picks (fewer if there are not enough presets)
+    const std::deque<u32>& lookAhead(usize depth, std::mt19937& rng);
+
+    usize size() const {
+        return weights_.size();
+    }
+    // Picks are among these
+    usize candidates() const {
+        return sampler_.live();
+    }
+
+private:
+    enum State : u8 { Drawable, InWindow, Ahead };
+
+    void release();
+    void dropAhead(usize index);
+
+    WeightedSampler sampler_;
+    std::vector<f64> weights_; // as rated; the sampler has 0 unless Drawable
+    std::vector<State> state_;
+    std::deque<u32> recent_;   // oldest first
+    std::deque<u32> ahead_;    // drawn early, next first
+    usize window_{DEFAULT_WINDOW};
+};
+
+} // namespace vc
@@ -12,10 +12,17 @@ RatingManager& RatingManager::instance() {
 }
 
 void RatingManager::setRating(const std::string& name, int stars) {
-    ratings_[name] = std::clamp(stars, 0, 5);
+    stars = std::clamp(stars, 0, 5);
+    std::lock_guard lock(mutex_);
+    auto [it, inserted] = ratings_.try_emplace(name, stars);
+    if (inserted || it->second != stars) {
+        it->second = stars;
+        dirty_ = true;
+    }
 }
 
 int RatingManager::getRating(const std::string& name) const {
+    std::lock_guard lock(mutex_);
     auto it = ratings_.find(name);
     return (it != ratings_.end()) ? it->second : 0;
 }
@@ -27,6 +34,7 @@ Result<void> RatingManager::load() {
 
     try {
         auto tbl = toml::parse_file(path.string());
+        std::lock_guard lock(mutex_);
         for (auto&& [key, value] : tbl) {
             if (auto stars = value.as_integer()) {
                 ratings_[std::string(key.str())] =
@@ -44,13 +52,20 @@ Result<void> RatingManager::load() {
 Result<void> RatingManager::save() {
     auto path = file::configDir() / "ratings.toml";
     toml::table tbl;
-    for (auto const& [name, stars] : ratings_) {
-        tbl.insert(name, stars);
+    {
+        std::lock_guard lock(mutex_);
+        for (auto const& [name, stars] : ratings_) {
+            tbl.insert(name, stars);
+        }
+        dirty_ = false;
     }
 
     std::ofstream ofs(path);
-    if (!ofs)
+    if (!ofs) {
+        std::lock_guard lock(mutex_);
+        dirty_ = true;
         return Result<void>::err("Failed to open ratings file for writing");
+    }
     ofs << tbl;
     return Result<void>::ok();
 }
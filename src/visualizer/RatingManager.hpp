@@ -1,11 +1,13 @@
 #pragma once
 #include <map>
+#include <mutex>
 #include <string>
 #include "util/Result.hpp"
 #include "util/Types.hpp"
 
 namespace vc {
 
+// Saved from PresetManager's writer thread while the GUI rates: locked
 class RatingManager {
 public:
     static RatingManager& instance();
@@ -15,10 +17,17 @@ public:
 
     Result<void> load();
     Result<void> save();
+    // Changed since load()/save()
+    bool dirty() const {
+        std::lock_guard lock(mutex_);
+        return dirty_;
+    }
 
 private:
     RatingManager() = default;
+    mutable std::mutex mutex_;
     std::map<std::string, int> ratings_;
+    bool dirty_{false};
 };
 
 } // namespace vc
@@ -5,8 +5,10 @@
 #include "VisualizerRenderer.hpp"
 #include "audio/AudioQueue.hpp"
 #include <chrono>
+#include <cstring>
 #include "core/Config.hpp"
 #include "core/Logger.hpp"
+#include "recorder/FrameGrabber.hpp"
 
 
 namespace vc {
@@ -35,6 +37,9 @@ void VisualizerRenderer::initialize(u32 width, u32 height) {
     pmConfig.presetDuration = vizConfig.presetDuration;
     pmConfig.transitionDuration = vizConfig.smoothPresetDuration;
     pmConfig.shufflePresets = vizConfig.shufflePresets;
+    pmConfig.shuffleWindow = vizConfig.shuffleWindow;
+    pmConfig.prewarmDepth = vizConfig.prewarmDepth;
+    pmConfig.offline = offline_;
     pmConfig.useDefaultPreset = vizConfig.useDefaultPreset;
     pmConfig.texturePaths = vizConfig.texturePaths;
 
@@ -60,6 +65,7 @@ void VisualizerRenderer::initialize(u32 width, u32 height) {
 
 void VisualizerRenderer::cleanup() {
     destroyPBOs();
+    yuv_.destroy();
     projectM_.shutdown();
     renderTarget_.destroy();
 }
@@ -86,16 +92,19 @@ void VisualizerRenderer::renderFrame(u32 x, u32 y, u32 w, u32 h) {
     u32 renderW = recording_ ? recordWidth_ : w;
     u32 renderH = recording_ ? recordHeight_ : h;
 
-    // Pop audio from lock-free queue (no mutex)
+    // Feed audio straight from the broadcast ring (no mutex, no copy)
     if (audioQueue_) {
-        u32 framesToFeed = (audioSampleRate_ + targetFps_ - 1) / targetFps_;
-        static constexpr usize BATCH_BUFFER_SIZE = 4096;
-        alignas(64) float batchBuffer[BATCH_BUFFER_SIZE * 2];
-
-        u32 popped = audioQueue_->popVizBatch(batchBuffer, framesToFeed);
-        if (popped > 0) {
-            projectM_.engine().addPCMDataInterleaved(batchBuffer, popped, 2);
+        u32 framesToFeed = (audioQueue_->sampleRate() + targetFps_ - 1) / targetFps_;
+        auto spans = audioQueue_->peek(AudioConsumer::Viz, framesToFeed);
+        if (!spans.first.empty()) {
+            projectM_.engine().addPCMDataInterleaved(
+                    spans.first.data(), static_cast<u32>(spans.first.size() / 2), 2);
+        }
+        if (!spans.second.empty()) {
+            projectM_.engine().addPCMDataInterleaved(
+                    spans.second.data(), static_cast<u32>(spans.second.size() / 2), 2);
         }
+        audioQueue_->consume(AudioConsumer::Viz, spans.frames());
     }
 
 bool useFBO = recording_;
@@ -145,6 +154,56 @@ glDisable(GL_SCISSOR_TEST);
 }
 }
 
+bool VisualizerRenderer::renderOffline(const f32* pcm,
+                                       u32 frames,
+                                       f64 frameTime,
+                                       GrabbedFrame& frame) {
+    if (!initialized_ || !projectM_.isInitialized())
+        return false;
+
+    projectM_.syncState();
+
+    if (pcm && frames > 0)
+        projectM_.engine().addPCMDataInterleaved(pcm, frames, 2);
+
+    if (renderTarget_.width() != recordWidth_ ||
+        renderTarget_.height() != recordHeight_) {
+        if (auto result = renderTarget_.resize(recordWidth_, recordHeight_); !result) {
+            LOG_ERROR("VisualizerRenderer: Offline resize failed: {}",
+                      result.error().message);
+            return false;
+        }
+        projectM_.engine().resize(recordWidth_, recordHeight_);
+    }
+    if (!captureConfigured_)
+        setupCapture();
+
+    projectM_.engine().setFrameTime(frameTime);
+
+    if (presetLoading_) {
+        renderTarget_.bind();
+        glClearColor(0, 0, 0, 1);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderTarget_.unbind();
+    } else {
+        projectM_.engine().renderToTarget(renderTarget_);
+    }
+
+    frame.width = recordWidth_;
+    frame.height = recordHeight_;
+    frame.format = captureFormat_;
+    frame.data.resize(captureBytes());
+    if (captureFormat_ == FrameFormat::I420) {
+        yuv_.convert(renderTarget_.texture());
+        yuv_.readPlanes(frame.data.data());
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    } else {
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        renderTarget_.readPixels(frame.data.data());
+    }
+    return true;
+}
+
 void VisualizerRenderer::initBlitResources() {
     if (blitProgram_)
         return;
@@ -207,10 +266,39 @@ void VisualizerRenderer::drawTexture(GLuint textureId, u32 w, u32 h) {
     blitProgram_->release();
 }
 
+void VisualizerRenderer::setupCapture() {
+    captureConfigured_ = true;
+    captureFormat_ = FrameFormat::RGBA;
+    yuv_.destroy();
+    if (!CONFIG.recording().video.gpuConvert)
+        return;
+
+    if (!YuvConverter::supports(recordWidth_, recordHeight_)) {
+        LOG_WARN("VisualizerRenderer: {}x{} can't be converted to YUV 4:2:0 on the "
+                 "GPU, reading back RGBA",
+                 recordWidth_,
+                 recordHeight_);
+        return;
+    }
+    if (auto result = yuv_.init(recordWidth_, recordHeight_); !result) {
+        LOG_WARN("VisualizerRenderer: GPU YUV conversion unavailable ({}), "
+                 "reading back RGBA",
+                 result.error().message);
+        return;
+    }
+    captureFormat_ = FrameFormat::I420;
+}
+
+usize VisualizerRenderer::captureBytes() const {
+    return captureFormat_ == FrameFormat::I420
+                   ? YuvConverter::planarSize(recordWidth_, recordHeight_)
+                   : static_cast<usize>(recordWidth_) * recordHeight_ * 4;
+}
+
 void VisualizerRenderer::setupPBOs() {
     destroyPBOs();
     glGenBuffers(2, pbos_);
-    u32 size = recordWidth_ * recordHeight_ * 4;
+    usize size = captureBytes();
     for (int i = 0; i < 2; ++i) {
         glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[i]);
         glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
@@ -228,28 +316,40 @@ void VisualizerRenderer::destroyPBOs() {
 
 void VisualizerRenderer::captureAsync() {
     u32 nextIndex = (pboIndex_ + 1) % 2;
-    u32 size = recordWidth_ * recordHeight_ * 4;
+    usize size = captureBytes();
+    // Stamp the frame when it was rendered, not a frame later at mapping
+    pboTimestamps_[pboIndex_] =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count();
     glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[pboIndex_]);
-    glReadPixels(0,
-                 0,
-                 recordWidth_,
-                 recordHeight_,
-                 GL_RGBA,
-                 GL_UNSIGNED_BYTE,
-                 nullptr);
+    if (captureFormat_ == FrameFormat::I420) {
+        // Convert + flip on the GPU; only 1.5 B/px crosses the bus
+        yuv_.convert(renderTarget_.texture());
+        yuv_.readPlanes(nullptr);
+    } else {
+        glReadPixels(0,
+                     0,
+                     recordWidth_,
+                     recordHeight_,
+                     GL_RGBA,
+                     GL_UNSIGNED_BYTE,
+                     nullptr);
+    }
     if (pboAvailable_) {
         glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[nextIndex]);
-        u8* ptr = (u8*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        // Lease before mapping: if the encoder still holds every slot,
+        // drop this frame (the pool counts it) instead of allocating
+        FrameRef frame = framePool_ ? framePool_->acquire() : FrameRef{};
+        u8* ptr = frame ? (u8*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY)
+                        : nullptr;
         if (ptr) {
-            std::vector<u8> buffer(ptr, ptr + size);
+            std::memcpy(frame.data(), ptr, size);
             glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-            frameCaptured.emitSignal(
-                    std::move(buffer),
-                    recordWidth_,
-                    recordHeight_,
-                    std::chrono::duration_cast<std::chrono::microseconds>(
-                            std::chrono::steady_clock::now().time_since_epoch())
-                            .count());
+            frameCaptured.emitSignal(std::move(frame),
+                                     recordWidth_,
+                                     recordHeight_,
+                                     pboTimestamps_[nextIndex]);
         }
     }
     glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
@@ -258,6 +358,7 @@ void VisualizerRenderer::captureAsync() {
 }
 
 void VisualizerRenderer::setRecordingSize(u32 width, u32 height) {
+    captureConfigured_ &= width == recordWidth_ && height == recordHeight_;
     recordWidth_ = width;
     recordHeight_ = height;
 }
@@ -266,12 +367,16 @@ void VisualizerRenderer::startRecording() {
     recording_ = true;
     renderTarget_.resize(recordWidth_, recordHeight_);
     projectM_.engine().resize(recordWidth_, recordHeight_);
+    setupCapture();
     setupPBOs();
+    framePool_ = FramePool::create(captureBytes(), DEFAULT_FRAME_POOL_SLOTS, captureFormat_);
 }
 
 void VisualizerRenderer::stopRecording() {
     recording_ = false;
     destroyPBOs();
+    // Frames still queued keep the pool alive until the encoder drains them
+    framePool_.reset();
 }
 
 } // namespace vc
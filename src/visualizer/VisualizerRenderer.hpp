@@ -12,7 +12,7 @@
  * @section Dependencies
  * - projectM (via Bridge)
  * - Qt OpenGL (QOpenGLFunctions_3_3_Core)
- * - AudioQueue (lock-free SPSC)
+ * - AudioQueue (lock-free broadcast ring)
  *
  * @section Patterns
  * - Renderer: Encapsulates all rendering commands.
@@ -20,7 +20,9 @@
 
 #pragma once
 #include "RenderTarget.hpp"
+#include "YuvConverter.hpp"
 #include "projectm/Bridge.hpp"
+#include "recorder/FramePool.hpp"
 #include "util/GLIncludes.hpp"
 #include "util/Types.hpp"
 
@@ -40,6 +42,7 @@ class AudioQueue;
 
 namespace vc {
 class AudioQueue;
+struct GrabbedFrame;
 
 } // namespace vc
 
@@ -51,6 +54,10 @@ public:
     ~VisualizerRenderer();
 
     void initialize(u32 width, u32 height);
+    // Before initialize(); see pm::ProjectMConfig::offline
+    void setOffline(bool offline) {
+        offline_ = offline;
+    }
     void cleanup();
 
     void render(u32 width, u32 height, bool isExposed);
@@ -67,6 +74,13 @@ AudioQueue* audioQueue() const { return audioQueue_; }
         return recording_;
     }
 
+    // Offline (headless) rendering: feed `frames` of interleaved stereo PCM,
+    // render one frame at `frameTime` seconds into the record-sized target
+    // and read it back synchronously into `frame` (I420 when the GPU
+    // conversion is enabled, RGBA otherwise).
+    bool renderOffline(const f32* pcm, u32 frames, f64 frameTime,
+                       GrabbedFrame& frame);
+
     // ProjectM access
     pm::Bridge& projectM() {
         return projectM_;
@@ -79,14 +93,21 @@ AudioQueue* audioQueue() const { return audioQueue_; }
         return renderTarget_;
     }
 
+    // Pool captured frames are leased from while recording
+    const std::shared_ptr<FramePool>& framePool() const {
+        return framePool_;
+    }
+
 
     // Signals (proxied via parent window or custom)
-    Signal<std::vector<u8>, u32, u32, i64> frameCaptured;
+    Signal<FrameRef, u32, u32, i64> frameCaptured;
 
 private:
     void renderFrame(u32 x, u32 y, u32 w, u32 h);
     void initBlitResources();
     void drawTexture(GLuint textureId, u32 w, u32 h);
+    void setupCapture();
+    usize captureBytes() const;
     void setupPBOs();
     void destroyPBOs();
     void captureAsync();
@@ -102,14 +123,19 @@ private:
     u32 recordWidth_{1920};
     u32 recordHeight_{1080};
     GLuint pbos_[2]{0, 0};
+    i64 pboTimestamps_[2]{0, 0}; // steady_clock µs when each read was issued
     u32 pboIndex_{0};
     bool pboAvailable_{false};
+    std::shared_ptr<FramePool> framePool_;
+    YuvConverter yuv_;
+    FrameFormat captureFormat_{FrameFormat::RGBA};
+    bool captureConfigured_{false};
 
     AudioQueue* audioQueue_{nullptr};
-    u32 audioSampleRate_{48000};
     u32 targetFps_{60};
 
     bool initialized_{false};
+    bool offline_{false};
     bool presetLoading_{false};
 };
 
@@ -76,8 +76,8 @@ void VisualizerWindow::initialize() {
             });
 
     renderer_->frameCaptured.connect(
-            [this](std::vector<u8> data, u32 w, u32 h, i64 ts) {
-                emit frameCaptured(std::move(data), w, h, ts);
+            [this](FrameRef frame, u32 w, u32 h, i64 ts) {
+                emit frameCaptured(std::move(frame), w, h, ts);
             });
 
     updateSettings();
@@ -108,10 +108,10 @@ void VisualizerWindow::updateFPS() {
 void VisualizerWindow::loadPresetFromManager() {
     if (!initialized_)
         return;
-    const auto* preset = renderer_->projectM().presets().current();
-    if (preset) {
-        renderer_->projectM().presets().selectByName(preset->name);
-    }
+    auto& presets = renderer_->projectM().presets();
+    auto lock = presets.lock();
+    if (const auto* preset = presets.current())
+        presets.selectByName(preset->name);
 }
 
 void VisualizerWindow::updateSettings() {
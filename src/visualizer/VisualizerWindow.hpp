@@ -30,7 +30,7 @@ class VisualizerWindow : public QWindow {
 signals:
     void presetNameUpdated(const QString& name);
     void frameReady();
-    void frameCaptured(std::vector<u8> data,
+    void frameCaptured(vc::FrameRef frame,
                        u32 width,
                        u32 height,
                        i64 timestamp);
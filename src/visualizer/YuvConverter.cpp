@@ -0,0 +1,192 @@
+#include "YuvConverter.hpp"
+#include <QOpenGLContext>
+#include "core/Logger.hpp"
+
+namespace vc {
+
+namespace {
+
+const char* kVertexSource = R"(
+    #version 330 core
+    void main() {
+        // Fullscreen triangle, no vertex buffer
+        vec2 pos = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+        gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+    }
+)";
+
+// Output row r of the target is byte row r of a top-down I420 frame.
+// Coefficients: BT.709 limited range in 15-bit fixed point, rounded so
+// that grey stays at chroma 128 and white at luma 235.
+const char* kFragmentSource = R"(
+    #version 330 core
+    uniform sampler2D src;
+    uniform int width;
+    uniform int height;
+    out vec4 color;
+
+    ivec3 rgbAt(ivec2 p) {
+        // p is top-down; the source texture is bottom-up
+        vec3 c = texelFetch(src, ivec2(p.x, height - 1 - p.y), 0).rgb;
+        return ivec3(c * 255.0 + 0.5);
+    }
+
+    void main() {
+        ivec2 o = ivec2(gl_FragCoord.xy);
+        int v;
+        if (o.y < height) {
+            ivec3 c = rgbAt(o);
+            v = ((5983 * c.r + 20127 * c.g + 2032 * c.b + 16384) >> 15) + 16;
+        } else {
+            int cw = width / 2;
+            int planeSize = cw * (height / 2);
+            int idx = (o.y - height) * width + o.x;
+            int plane = idx / planeSize;
+            int i = idx - plane * planeSize;
+            ivec2 p = ivec2(i % cw, i / cw) * 2;
+            ivec3 s = rgbAt(p) + rgbAt(p + ivec2(1, 0)) +
+                      rgbAt(p + ivec2(0, 1)) + rgbAt(p + ivec2(1, 1));
+            // 2x2 sum: two extra bits of shift average the block
+            if (plane == 0)
+                v = ((-3298 * s.r - 11094 * s.g + 14392 * s.b + 65536) >> 17) + 128;
+            else
+                v = ((14392 * s.r - 13073 * s.g - 1319 * s.b + 65536) >> 17) + 128;
+        }
+        color = vec4(float(clamp(v, 0, 255)) / 255.0, 0.0, 0.0, 1.0);
+    }
+)";
+
+} // namespace
+
+YuvConverter::YuvConverter() = default;
+
+YuvConverter::~YuvConverter() {
+    destroy();
+}
+
+Result<void> YuvConverter::init(u32 width, u32 height) {
+    if (!supports(width, height)) {
+        return Result<void>::err("YUV 4:2:0 conversion needs even dimensions");
+    }
+    if (!QOpenGLContext::currentContext() || !this->initializeOpenGLFunctions()) {
+        return Result<void>::err("No OpenGL context current for YuvConverter::init()");
+    }
+
+    destroy();
+
+    program_ = std::make_unique<QOpenGLShaderProgram>();
+    if (!program_->addShaderFromSourceCode(QOpenGLShader::Vertex, kVertexSource) ||
+        !program_->addShaderFromSourceCode(QOpenGLShader::Fragment, kFragmentSource) ||
+        !program_->link()) {
+        auto log = program_->log().toStdString();
+        program_.reset();
+        return Result<void>::err("YUV shader failed: " + log);
+    }
+    vao_.create();
+
+    width_ = width;
+    height_ = height;
+
+    this->glGenTextures(1, &texture_);
+    this->glBindTexture(GL_TEXTURE_2D, texture_);
+    this->glTexImage2D(GL_TEXTURE_2D,
+                       0,
+                       GL_R8,
+                       width_,
+                       height_ + height_ / 2,
+                       0,
+                       GL_RED,
+                       GL_UNSIGNED_BYTE,
+                       nullptr);
+    this->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    this->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    this->glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint prevDraw = 0;
+    this->glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevDraw);
+    this->glGenFramebuffers(1, &fbo_);
+    this->glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    this->glFramebufferTexture2D(
+            GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_, 0);
+    GLenum status = this->glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    this->glBindFramebuffer(GL_FRAMEBUFFER, prevDraw);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        destroy();
+        return Result<void>::err("YUV framebuffer incomplete: " +
+                                 std::to_string(status));
+    }
+
+    LOG_DEBUG("YuvConverter: {}x{} -> I420 ({} bytes/frame)",
+              width_,
+              height_,
+              planarSize(width_, height_));
+    return Result<void>::ok();
+}
+
+void YuvConverter::destroy() {
+    if (!QOpenGLContext::currentContext()) {
+        fbo_ = texture_ = 0;
+        program_.reset();
+        return;
+    }
+    if (fbo_) {
+        this->glDeleteFramebuffers(1, &fbo_);
+        fbo_ = 0;
+    }
+    if (texture_) {
+        this->glDeleteTextures(1, &texture_);
+        texture_ = 0;
+    }
+    if (vao_.isCreated())
+        vao_.destroy();
+    program_.reset();
+}
+
+void YuvConverter::convert(GLuint texture) {
+    if (!isValid() || !texture)
+        return;
+
+    GLint prevDraw = 0;
+    GLint prevViewport[4];
+    this->glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevDraw);
+    this->glGetIntegerv(GL_VIEWPORT, prevViewport);
+
+    this->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo_);
+    this->glViewport(0, 0, width_, height_ + height_ / 2);
+    this->glDisable(GL_DEPTH_TEST);
+    this->glDisable(GL_BLEND);
+    this->glDisable(GL_SCISSOR_TEST);
+
+    program_->bind();
+    this->glActiveTexture(GL_TEXTURE0);
+    this->glBindTexture(GL_TEXTURE_2D, texture);
+    program_->setUniformValue("src", 0);
+    program_->setUniformValue("width", static_cast<int>(width_));
+    program_->setUniformValue("height", static_cast<int>(height_));
+    vao_.bind();
+    this->glDrawArrays(GL_TRIANGLES, 0, 3);
+    vao_.release();
+    this->glBindTexture(GL_TEXTURE_2D, 0);
+    program_->release();
+
+    this->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, prevDraw);
+    this->glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
+    this->glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+}
+
+void YuvConverter::readPlanes(void* dst) {
+    if (!isValid())
+        return;
+    this->glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+    this->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    this->glReadPixels(0,
+                       0,
+                       width_,
+                       height_ + height_ / 2,
+                       GL_RED,
+                       GL_UNSIGNED_BYTE,
+                       dst);
+}
+
+} // namespace vc
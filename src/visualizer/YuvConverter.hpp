@@ -0,0 +1,84 @@
+/**
+ * @file YuvConverter.hpp
+ * @brief GPU RGBA -> planar YUV 4:2:0 pass for recording readback.
+ *
+ * This file defines the YuvConverter class which renders a (bottom-up) RGBA
+ * texture into a single-channel R8 target laid out byte-for-byte as a
+ * top-down I420 frame: W x H luma rows followed by the U and V planes
+ * packed W bytes per row. Reading that target back yields 1.5 bytes per
+ * pixel that can be handed to the encoder without sws_scale, and the
+ * vertical flip comes for free because the shader addresses source rows
+ * bottom-up.
+ *
+ * The shader works on integer 8-bit values with BT.709 limited-range
+ * coefficients in 15-bit fixed point and averages each 2x2 block for
+ * chroma, so output depends only on the input bytes, not on GPU float
+ * precision, and stays within 1 LSB of the exact BT.709 values
+ * (tests/integration/test_YuvConverter.cpp). Only GLSL 3.30 core is
+ * required; it runs on llvmpipe.
+ *
+ * @section Dependencies
+ * - Qt OpenGL (QOpenGLFunctions_3_3_Core)
+ */
+
+#pragma once
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <memory>
+#include "util/Result.hpp"
+#include "util/Types.hpp"
+
+namespace vc {
+
+class YuvConverter : protected QOpenGLFunctions_3_3_Core {
+public:
+    YuvConverter();
+    ~YuvConverter();
+
+    YuvConverter(const YuvConverter&) = delete;
+    YuvConverter& operator=(const YuvConverter&) = delete;
+
+    // 4:2:0 needs even dimensions
+    static bool supports(u32 width, u32 height) {
+        return width >= 2 && height >= 2 && width % 2 == 0 && height % 2 == 0;
+    }
+
+    // Bytes of one packed I420 frame
+    static usize planarSize(u32 width, u32 height) {
+        return static_cast<usize>(width) * height * 3 / 2;
+    }
+
+    // Creates the shader and the W x 1.5H target. Requires a current context.
+    Result<void> init(u32 width, u32 height);
+    void destroy();
+
+    bool isValid() const {
+        return fbo_ != 0;
+    }
+    u32 width() const {
+        return width_;
+    }
+    u32 height() const {
+        return height_;
+    }
+
+    // Convert `texture` (width x height RGBA, GL bottom-up) into the target.
+    // Leaves the target bound as GL_READ_FRAMEBUFFER and restores the
+    // previous draw framebuffer and viewport.
+    void convert(GLuint texture);
+
+    // glReadPixels of the whole target into `dst` (or a bound PBO when
+    // `dst` is nullptr). Call after convert().
+    void readPlanes(void* dst);
+
+private:
+    std::unique_ptr<QOpenGLShaderProgram> program_;
+    QOpenGLVertexArrayObject vao_;
+    GLuint fbo_{0};
+    GLuint texture_{0};
+    u32 width_{0};
+    u32 height_{0};
+};
+
+} // namespace vc
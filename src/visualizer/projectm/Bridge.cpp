@@ -1,4 +1,5 @@
 #include "Bridge.hpp"
+#include <algorithm>
 #include "core/Config.hpp"
 #include "core/Logger.hpp"
 #include "util/FileUtils.hpp"
@@ -45,10 +46,26 @@ Result<void> Bridge::init(const ProjectMConfig& config) {
     auto res = engine_.init(eCfg);
     if (!res) return res;
 
+    // Per-preset render cost, see PresetProfiler. Offline frames don't run
+    // against the realtime budget, so they aren't judged by it.
+    presetManager_.setOffline(config.offline);
+    engine_.setProfiling(!config.offline);
+    presetManager_.setFrameBudget(1000.0f / std::max(config.fps, 1u));
+    settleFrames_ = config.transitionDuration * config.fps;
+
+    prewarmDepth_ = config.offline ? 0 : config.prewarmDepth;
+    if (prewarmDepth_ > 0) {
+        if (auto result = prewarmer_.start(eCfg); !result)
+            LOG_WARN("Bridge: Preset pre-warm unavailable: {}", result.error().message);
+    }
+
     if (!playlist_.init(engine_.handle())) {
         return Result<void>::err("Failed to initialize native playlist");
     }
+    // Native shuffle stays on for its history (previous); forward picks
+    // are PresetManager's weighted ones, see syncState()
     playlist_.setShuffle(config.shufflePresets);
+    shuffle_ = config.shufflePresets;
 
     projectm_set_preset_switch_requested_event_callback(
             engine_.handle(), &presetSwitchRequested, this);
@@ -57,6 +74,9 @@ Result<void> Bridge::init(const ProjectMConfig& config) {
         onPresetManagerChanged(p);
     });
 
+    presetManager_.setIndexFile(file::cacheDir() / "preset_index.tsv");
+    presetManager_.setStatsFile(file::dataDir() / "preset_stats.tsv");
+    presetManager_.setShuffleWindow(config.shuffleWindow);
     scanPresets(config.presetPath);
     presetManager_.loadState(file::configDir() / "preset_state.txt");
 
@@ -76,6 +96,21 @@ Result<void> Bridge::init(const ProjectMConfig& config) {
 }
 
 void Bridge::shutdown() {
+    if (prewarmer_.running()) {
+        const auto stats = prewarmer_.stats();
+        const u64 cold = stats.late + stats.misses;
+        if (stats.hits + cold > 0) {
+            LOG_INFO("Bridge: Preset pre-warm: {} of {} switches warm ({} late, {} missed), "
+                     "{:.1f} ms avg warm vs {:.1f} ms cold, worst {:.1f} ms",
+                     stats.hits, stats.hits + cold, stats.late, stats.misses,
+                     stats.hits ? stats.hitMs / stats.hits : 0.0,
+                     cold ? stats.missMs / cold : 0.0,
+                     stats.worstMs);
+        }
+        prewarmer_.stop();
+    }
+    presetManager_.endProfile();
+    presetManager_.flushState();
     playlist_.shutdown();
     engine_.shutdown();
 }
@@ -95,11 +130,17 @@ Result<void> Bridge::scanPresets(const fs::path& path) {
     }
 
     if (playlist_.handle() && (playlistEmpty || path != lastPresetPath_)) {
+        // From the manager's list, in its order: no second directory walk,
+        // and native indices match the manager's
         playlist_.clear();
-        u32 added = playlist_.addPath(path.string(), true);
-        if (added > 0) {
-            playlist_.sort();
+        std::vector<std::string> paths;
+        {
+            auto lock = presetManager_.lock();
+            paths.reserve(presetManager_.count());
+            for (const auto& preset : presetManager_.allPresets())
+                paths.push_back(preset.path.string());
         }
+        u32 added = playlist_.addPresets(paths);
         LOG_INFO("Bridge: Native playlist populated with {} items", added);
     }
 
@@ -110,10 +151,17 @@ Result<void> Bridge::scanPresets(const fs::path& path) {
 void Bridge::syncState() {
     if (!isInitialized()) return;
 
+    profileFrames();
+
+    // Loads happen right here, on this thread; time them for the pre-warm
+    // and the profiler
+    const bool smooth = pendingSmooth_;
+    const auto start = chr::steady_clock::now();
     {
         std::lock_guard<std::mutex> lock(loadMutex_);
         if (!pendingLoadPath_.empty()) {
             engine_.loadPreset(pendingLoadPath_, !pendingSmooth_);
+            switchedTo_ = std::move(pendingLoadPath_);
             pendingLoadPath_.clear();
         }
     }
@@ -130,18 +178,51 @@ void Bridge::syncState() {
         playlist_.previous(!pendingSmooth_);
     }
     if (pendingRandom_.exchange(false)) {
-        if (playlist_.size() > 0) {
-            std::uniform_int_distribution<u32> dist(0, playlist_.size() - 1);
-            playlist_.setPosition(dist(rng_), !pendingSmooth_);
-        }
+        // Native indices match the manager's (see scanPresets())
+        auto index = presetManager_.pickRandom();
+        if (index && *index < playlist_.size())
+            playlist_.setPosition(static_cast<u32>(*index), !pendingSmooth_);
     }
 
     if (pendingLockChange_.exchange(false)) {
         engine_.setPresetLocked(pendingLock_);
     }
+
+    if (!switchedTo_.empty()) {
+        const f64 ms = chr::duration<f64, std::milli>(chr::steady_clock::now() - start).count();
+        engine_.markPresetSwitch();
+        auto lock = presetManager_.lock();
+        const auto* current = presetManager_.current();
+        if (engine_.profiling() && current && current->path == fs::path(switchedTo_)) {
+            presetManager_.beginProfile(
+                    presetManager_.currentIndex(), static_cast<f32>(ms), smooth ? settleFrames_ : 0);
+        } else {
+            presetManager_.endProfile();
+        }
+        lock.unlock();
+        if (prewarmer_.running()) {
+            prewarmer_.recordSwitch(switchedTo_, ms);
+            prewarmUpcoming();
+        }
+        switchedTo_.clear();
+    }
+}
+
+void Bridge::profileFrames() {
+    presetManager_.setRenderSize(engine_.width(), engine_.height());
+    engine_.takeFrameTimings(timings_);
+    // Frames rendered before the last switch belong to no play
+    const u32 generation = engine_.presetGeneration();
+    for (const auto& timing : timings_)
+        if (timing.generation == generation)
+            presetManager_.profileFrame(timing.cpuMs, timing.gpuMs);
 }
 
 void Bridge::nextPreset(bool smooth) {
+    if (shuffle_) {
+        randomPreset(smooth);
+        return;
+    }
     pendingSmooth_ = smooth;
     pendingNext_ = true;
 }
@@ -163,6 +244,7 @@ void Bridge::lockPreset(bool locked) {
 }
 
 std::string Bridge::currentPresetName() const {
+    auto lock = presetManager_.lock();
     const auto* p = presetManager_.current();
     return p ? p->name : "None";
 }
@@ -171,6 +253,14 @@ void Bridge::onPresetManagerChanged(const PresetInfo* preset) {
     if (!preset || syncingFromNative_)
         return;
 
+    const usize index = presetManager_.currentIndex();
+    if (playlist_.handle() && index < playlist_.size() &&
+        fs::path(playlist_.itemAt(static_cast<u32>(index))) == preset->path) {
+        pendingPosition_ = static_cast<int>(index);
+        pendingSmooth_ = false;
+        return;
+    }
+
     if (playlist_.handle() && playlist_.size() > 0) {
         for (u32 i = 0; i < playlist_.size(); ++i) {
             if (fs::path(playlist_.itemAt(i)) == preset->path) {
@@ -193,11 +283,29 @@ void Bridge::onPlaylistSwitched(bool is_hard_cut, u32 index) {
     fs::path p(path);
     std::string name = p.stem().string();
 
+    switchedTo_ = path;
     syncingFromNative_ = true;
-    presetManager_.selectByName(name);
+    auto lock = presetManager_.lock();
+    const auto& presets = presetManager_.allPresets();
+    if (index >= presets.size() || presets[index].path != p ||
+        !presetManager_.selectByIndex(index)) {
+        presetManager_.selectByName(name);
+    }
+    lock.unlock();
     syncingFromNative_ = false;
 
     presetChanged.emitSignal(name);
 }
 
+void Bridge::prewarmUpcoming() {
+    std::vector<fs::path> paths;
+    {
+        auto lock = presetManager_.lock();
+        const auto& presets = presetManager_.allPresets();
+        for (usize index : presetManager_.upcoming(prewarmDepth_, shuffle_))
+            paths.push_back(presets[index].path);
+    }
+    prewarmer_.prepare(paths);
+}
+
 } // namespace vc::pm
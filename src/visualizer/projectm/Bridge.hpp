@@ -3,11 +3,11 @@
 #include "Config.hpp"
 #include "Engine.hpp"
 #include "Playlist.hpp"
+#include "Prewarmer.hpp"
 #include "visualizer/PresetManager.hpp"
 #include "util/Result.hpp"
 #include "util/Signal.hpp"
 #include <memory>
-#include <random>
 #include <atomic>
 #include <mutex>
 #include <optional>
@@ -40,6 +40,7 @@ public:
     void syncState();
 
     std::string currentPresetName() const;
+    PrewarmStats prewarmStats() const { return prewarmer_.stats(); }
 
     Signal<std::string> presetChanged;
     Signal<bool> presetLoading;
@@ -47,12 +48,20 @@ public:
 private:
     void onPresetManagerChanged(const PresetInfo* preset);
     void onPlaylistSwitched(bool is_hard_cut, u32 index);
+    void prewarmUpcoming();
+    void profileFrames();
 
     Engine engine_;
     Playlist playlist_;
     PresetManager presetManager_;
+    Prewarmer prewarmer_;
+    usize prewarmDepth_{0};
+    std::string switchedTo_; // loaded during this syncState()
+    std::vector<FrameTiming> timings_;
+    u32 settleFrames_{0}; // frames of a soft transition
 
     bool presetLocked_{false};
+    bool shuffle_{true};
     bool syncingFromNative_{false};
     fs::path lastPresetPath_;
     
@@ -67,7 +76,6 @@ private:
     std::mutex loadMutex_;
     std::string pendingLoadPath_;
     
-    std::mt19937 rng_{std::random_device{}()};
 };
 
 } // namespace vc::pm
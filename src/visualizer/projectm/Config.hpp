@@ -27,6 +27,11 @@ struct ProjectMConfig {
     f32 hardCutSensitivity{1.0f};
     bool aspectCorrection{true};
     bool shufflePresets{true};
+    u32 shuffleWindow{20}; // presets kept out of the shuffle after playing
+    u32 prewarmDepth{2};   // upcoming presets loaded ahead, see Prewarmer
+    // Headless export: faster than realtime and at recording size, so no
+    // profiling, pre-warm, play stats or preset costs
+    bool offline{false};
     std::string forcePreset{};
     bool useDefaultPreset{false};
     u32 meshX{32};
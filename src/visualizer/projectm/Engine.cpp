@@ -1,4 +1,5 @@
 #include "Engine.hpp"
+#include <QOpenGLContext>
 #include <algorithm>
 #include "core/Logger.hpp"
 
@@ -54,6 +55,9 @@ Result<void> Engine::init(const EngineConfig& config) {
 }
 
 void Engine::shutdown() {
+    destroyQueries();
+    profiling_ = false;
+    timings_.clear();
     if (handle_) {
         projectm_destroy(handle_);
         handle_ = nullptr;
@@ -62,17 +66,94 @@ void Engine::shutdown() {
 
 void Engine::render() {
     if (handle_)
-        projectm_opengl_render_frame(handle_);
+        renderFrame();
 }
 
 void Engine::renderToTarget(RenderTarget& target) {
     if (!handle_)
         return;
     target.bind();
-    projectm_opengl_render_frame(handle_);
+    renderFrame();
     target.unbind();
 }
 
+void Engine::setProfiling(bool enable) {
+    profiling_ = enable;
+    if (!enable || gpuTimers_)
+        return;
+    // Timer queries are core since GL 3.3; without them, CPU time only
+    if (!QOpenGLContext::currentContext() || !initializeOpenGLFunctions()) {
+        LOG_DEBUG("Engine: No GL timer queries, profiling CPU time only");
+        return;
+    }
+    for (auto& query : queries_)
+        glGenQueries(1, &query.id);
+    gpuTimers_ = true;
+}
+
+void Engine::takeFrameTimings(std::vector<FrameTiming>& out) {
+    out.clear();
+    out.swap(timings_);
+}
+
+void Engine::renderFrame() {
+    if (!profiling_) {
+        projectm_opengl_render_frame(handle_);
+        return;
+    }
+
+    collectQueries();
+    // A query still in flight after QUERY_RING frames: this frame goes
+    // without GPU time rather than waiting for it
+    TimerQuery* query = gpuTimers_ && !queries_[nextQuery_].pending ? &queries_[nextQuery_] : nullptr;
+    if (query)
+        glBeginQuery(GL_TIME_ELAPSED, query->id);
+    const auto start = chr::steady_clock::now();
+    projectm_opengl_render_frame(handle_);
+    const f32 cpuMs = chr::duration<f32, std::milli>(chr::steady_clock::now() - start).count();
+
+    if (!query) {
+        pushTiming({generation_, cpuMs, -1.0f});
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    query->pending = true;
+    query->timing = {generation_, cpuMs, -1.0f};
+    nextQuery_ = (nextQuery_ + 1) % QUERY_RING;
+}
+
+void Engine::collectQueries() {
+    for (auto& query : queries_) {
+        if (!query.pending)
+            continue;
+        GLint available = 0;
+        glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &ns);
+        query.timing.gpuMs = static_cast<f32>(static_cast<f64>(ns) / 1e6);
+        query.pending = false;
+        pushTiming(query.timing);
+    }
+}
+
+void Engine::pushTiming(const FrameTiming& timing) {
+    if (timings_.size() < MAX_TIMINGS)
+        timings_.push_back(timing);
+}
+
+void Engine::destroyQueries() {
+    // Without a current context they went with it
+    if (gpuTimers_ && QOpenGLContext::currentContext()) {
+        for (auto& query : queries_)
+            glDeleteQueries(1, &query.id);
+    }
+    queries_ = {};
+    nextQuery_ = 0;
+    gpuTimers_ = false;
+}
+
 void Engine::addPCMData(const f32* data, u32 samples, u32 channels) {
     if (handle_)
         projectm_pcm_add_float(handle_,
@@ -101,6 +182,16 @@ void Engine::setFPS(u32 fps) {
         projectm_set_fps(handle_, fps);
 }
 
+void Engine::setFrameTime(f64 seconds) {
+    if (!handle_)
+        return;
+#if PROJECTM_VERSION_MAJOR > 4 || (PROJECTM_VERSION_MAJOR == 4 && PROJECTM_VERSION_MINOR >= 1)
+    projectm_set_frame_time(handle_, seconds);
+#else
+    (void)seconds;
+#endif
+}
+
 void Engine::setBeatSensitivity(f32 sensitivity) {
     if (handle_)
         projectm_set_beat_sensitivity(handle_, sensitivity);
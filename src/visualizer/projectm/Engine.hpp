@@ -5,6 +5,9 @@
  */
 
 #include "projectM-4/projectM.h"
+#include "projectM-4/version.h"
+#include <QOpenGLFunctions_3_3_Core>
+#include <array>
 #include <filesystem>
 #include <string>
 #include <vector>
@@ -33,10 +36,19 @@ struct EngineConfig {
     std::vector<fs::path> texturePaths;
 };
 
+/**
+ * @brief Time one rendered frame took, see Engine::setProfiling().
+ */
+struct FrameTiming {
+    u32 generation{0}; // Engine::presetGeneration() when it was rendered
+    f32 cpuMs{0.0f};
+    f32 gpuMs{-1.0f};  // < 0: no GPU time (timer queries unavailable or busy)
+};
+
 /**
  * @brief Wraps the projectm_handle and provides low-level control.
  */
-class Engine {
+class Engine : protected QOpenGLFunctions_3_3_Core {
 public:
     Engine();
     ~Engine();
@@ -95,6 +107,24 @@ public:
      */
     void setFPS(u32 fps);
 
+    /**
+     * @brief Pin the animation clock to an explicit time.
+     *
+     * By default projectM animates against the wall clock. Offline rendering
+     * steps faster (or slower) than realtime, so it drives time explicitly.
+     * Pass a negative value to return to the wall clock. Does nothing
+     * before projectM 4.1; see hasFrameTime().
+     */
+    void setFrameTime(f64 seconds);
+
+    /**
+     * @brief Whether this projectM build can be stepped by setFrameTime().
+     */
+    static constexpr bool hasFrameTime() {
+        return PROJECTM_VERSION_MAJOR > 4 ||
+               (PROJECTM_VERSION_MAJOR == 4 && PROJECTM_VERSION_MINOR >= 1);
+    }
+
     /**
      * @brief Set beat detection sensitivity.
      */
@@ -133,6 +163,41 @@ public:
      */
     void loadPreset(const std::string& path, bool immediate = false);
 
+    /**
+     * @brief Time every rendered frame.
+     *
+     * CPU time is the render call itself; GPU time comes from GL timer
+     * queries, read back a few frames later without stalling. Needs the
+     * render context to be current when enabled.
+     */
+    void setProfiling(bool enable);
+    bool profiling() const {
+        return profiling_;
+    }
+
+    /**
+     * @brief Start a new preset generation, so frames can be told apart
+     * from those of the preset before.
+     */
+    void markPresetSwitch() {
+        ++generation_;
+    }
+    u32 presetGeneration() const {
+        return generation_;
+    }
+
+    /**
+     * @brief Move the frame timings collected so far into `out`.
+     */
+    void takeFrameTimings(std::vector<FrameTiming>& out);
+
+    u32 width() const {
+        return width_;
+    }
+    u32 height() const {
+        return height_;
+    }
+
     /**
      * @brief Get the underlying projectM handle.
      */
@@ -141,9 +206,32 @@ public:
     }
 
 private:
+    // Queries in flight; GPU results usually lag one or two frames
+    static constexpr usize QUERY_RING = 4;
+    // Cap for timings nobody takes
+    static constexpr usize MAX_TIMINGS = 1024;
+
+    struct TimerQuery {
+        GLuint id{0};
+        bool pending{false};
+        FrameTiming timing;
+    };
+
+    void renderFrame();
+    void collectQueries();
+    void pushTiming(const FrameTiming& timing);
+    void destroyQueries();
+
     projectm_handle handle_{nullptr};
     u32 width_{0};
     u32 height_{0};
+
+    bool profiling_{false};
+    bool gpuTimers_{false};
+    u32 generation_{0};
+    std::array<TimerQuery, QUERY_RING> queries_{};
+    usize nextQuery_{0};
+    std::vector<FrameTiming> timings_;
 };
 
 } // namespace vc::pm
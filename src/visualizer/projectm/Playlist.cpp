@@ -48,6 +48,16 @@ u32 Playlist::addPath(const std::string& path, bool recursive) {
     return projectm_playlist_add_path(handle_, path.c_str(), recursive, false);
 }
 
+u32 Playlist::addPresets(const std::vector<std::string>& paths) {
+    if (!handle_ || paths.empty())
+        return 0;
+    std::vector<const char*> names;
+    names.reserve(paths.size());
+    for (const auto& path : paths)
+        names.push_back(path.c_str());
+    return projectm_playlist_add_presets(handle_, names.data(), static_cast<u32>(names.size()), false);
+}
+
 void Playlist::sort() {
     if (!handle_)
         return;
@@ -47,6 +47,12 @@ public:
      */
     u32 addPath(const std::string& path, bool recursive = true);
 
+    /**
+     * @brief Append preset files in the given order, without touching the
+     * filesystem. Returns the number added.
+     */
+    u32 addPresets(const std::vector<std::string>& paths);
+
     /**
      * @brief Sort the playlist.
      */
@@ -0,0 +1,219 @@
+#include "Prewarmer.hpp"
+#include <QCoreApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QThread>
+#include <algorithm>
+#include "core/Logger.hpp"
+#include "visualizer/RenderTarget.hpp"
+
+namespace vc::pm {
+
+namespace {
+// Only the shaders matter, not the picture
+constexpr u32 WARM_SIZE = 64;
+
+void onWarmFailed(const char* preset, const char* message, void* userData) {
+    *static_cast<bool*>(userData) = true;
+    LOG_DEBUG("Prewarmer: {} failed to load: {}",
+              fs::path(preset ? preset : "").filename().string(),
+              message ? message : "");
+}
+} // namespace
+
+// QOffscreenSurface must be created and destroyed on the GUI thread, which
+// the render thread often is not; it is made there and handed over
+struct Prewarmer::SurfaceSlot {
+    std::mutex mutex;
+    std::condition_variable_any ready;
+    QOffscreenSurface* surface{nullptr};
+    bool done{false};
+    bool abandoned{false}; // stopped before the GUI thread got to it
+};
+
+Prewarmer::Prewarmer() = default;
+
+Prewarmer::~Prewarmer() {
+    stop();
+}
+
+Result<void> Prewarmer::start(const EngineConfig& config) {
+    stop();
+
+    shareContext_ = QOpenGLContext::currentContext();
+    auto* app = QCoreApplication::instance();
+    if (!shareContext_ || !app)
+        return Result<void>::err("No current OpenGL context to share");
+
+    {
+        std::lock_guard lock(mutex_);
+        warm_.clear();
+        stats_ = {};
+    }
+
+    surface_ = std::make_shared<SurfaceSlot>();
+    auto create = [slot = surface_, format = shareContext_->format()] {
+        std::lock_guard lock(slot->mutex);
+        if (!slot->abandoned) {
+            slot->surface = new QOffscreenSurface();
+            slot->surface->setFormat(format);
+            slot->surface->create();
+        }
+        slot->done = true;
+        slot->ready.notify_all();
+    };
+    if (QThread::currentThread() == app->thread())
+        create();
+    else
+        QMetaObject::invokeMethod(app, create, Qt::QueuedConnection);
+
+    thread_ = std::jthread([this, config](std::stop_token stop) { worker(stop, config); });
+    return Result<void>::ok();
+}
+
+void Prewarmer::stop() {
+    if (thread_.joinable()) {
+        thread_.request_stop();
+        wake_.notify_all();
+        thread_.join();
+    }
+    if (surface_) {
+        std::lock_guard lock(surface_->mutex);
+        surface_->abandoned = true;
+        if (surface_->surface)
+            surface_->surface->deleteLater();
+        surface_->surface = nullptr;
+    }
+    surface_.reset();
+    shareContext_ = nullptr;
+
+    std::lock_guard lock(mutex_);
+    queue_.clear();
+    loading_.clear();
+}
+
+void Prewarmer::prepare(const std::vector<fs::path>& presets) {
+    {
+        std::lock_guard lock(mutex_);
+        queue_.clear();
+        for (const auto& preset : presets) {
+            std::string key = preset.string();
+            if (key != loading_ && !isWarm(key))
+                queue_.push_back(std::move(key));
+        }
+    }
+    wake_.notify_one();
+}
+
+void Prewarmer::recordSwitch(const fs::path& preset, f64 ms) {
+    const std::string key = preset.string();
+    std::lock_guard lock(mutex_);
+    const char* outcome = "hit";
+    if (isWarm(key)) {
+        ++stats_.hits;
+        stats_.hitMs += ms;
+    } else {
+        const bool late = key == loading_ || std::ranges::find(queue_, key) != queue_.end();
+        ++(late ? stats_.late : stats_.misses);
+        stats_.missMs += ms;
+        outcome = late ? "late" : "miss";
+    }
+    stats_.worstMs = std::max(stats_.worstMs, ms);
+    std::erase(queue_, key);
+    LOG_DEBUG("Prewarmer: Switch to {} took {:.1f} ms ({})",
+              preset.filename().string(), ms, outcome);
+}
+
+PrewarmStats Prewarmer::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+bool Prewarmer::isWarm(const std::string& preset) const {
+    return std::ranges::find(warm_, preset) != warm_.end();
+}
+
+void Prewarmer::worker(std::stop_token stop, EngineConfig config) {
+    QOffscreenSurface* surface = nullptr;
+    {
+        std::unique_lock lock(surface_->mutex);
+        if (!surface_->ready.wait(lock, stop, [this] { return surface_->done; }))
+            return;
+        surface = surface_->surface;
+    }
+    if (!surface || !surface->isValid()) {
+        LOG_WARN("Prewarmer: No offscreen surface, presets will load cold");
+        return;
+    }
+
+    QOpenGLContext context;
+    context.setFormat(shareContext_->format());
+    context.setShareContext(shareContext_);
+    if (!context.create() || !context.makeCurrent(surface)) {
+        LOG_WARN("Prewarmer: Failed to create a shared OpenGL context, presets will load cold");
+        return;
+    }
+
+    config.width = WARM_SIZE;
+    config.height = WARM_SIZE;
+    config.presetDuration = 0;
+    Engine engine;
+    RenderTarget target;
+    bool failed = false;
+    if (auto result = engine.init(config); !result) {
+        LOG_WARN("Prewarmer: {}", result.error().message);
+        context.doneCurrent();
+        return;
+    }
+    engine.setPresetLocked(true);
+    projectm_set_preset_switch_failed_event_callback(engine.handle(), &onWarmFailed, &failed);
+    if (auto result = target.create(WARM_SIZE, WARM_SIZE); !result) {
+        LOG_WARN("Prewarmer: {}", result.error().message);
+        engine.shutdown();
+        context.doneCurrent();
+        return;
+    }
+    LOG_INFO("Prewarmer: Background context ready (GL {}.{})",
+             context.format().majorVersion(),
+             context.format().minorVersion());
+
+    while (!stop.stop_requested()) {
+        std::string preset;
+        {
+            std::unique_lock lock(mutex_);
+            if (!wake_.wait(lock, stop, [this] { return !queue_.empty(); }))
+                break;
+            preset = std::move(queue_.front());
+            queue_.pop_front();
+            loading_ = preset;
+        }
+
+        const auto start = chr::steady_clock::now();
+        failed = false;
+        engine.loadPreset(preset);
+        engine.renderToTarget(target);
+        // Drivers may put off compiling and linking until a draw needs it
+        context.functions()->glFinish();
+        const f64 ms = chr::duration<f64, std::milli>(chr::steady_clock::now() - start).count();
+
+        std::lock_guard lock(mutex_);
+        loading_.clear();
+        if (failed) {
+            ++stats_.failed;
+            continue;
+        }
+        ++stats_.warmed;
+        std::erase(warm_, preset);
+        warm_.push_front(preset);
+        if (warm_.size() > WARM_CAPACITY)
+            warm_.pop_back();
+        LOG_DEBUG("Prewarmer: {} warmed in {:.1f} ms", fs::path(preset).filename().string(), ms);
+    }
+
+    target.destroy();
+    engine.shutdown();
+    context.doneCurrent();
+}
+
+} // namespace vc::pm
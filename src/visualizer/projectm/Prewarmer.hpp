@@ -0,0 +1,95 @@
+#pragma once
+/**
+ * @file Prewarmer.hpp
+ * @brief Loads upcoming presets ahead of time on a background GL context.
+ *
+ * Loading a preset compiles its warp and composite shaders on the render
+ * thread, which can stall a frame for hundreds of milliseconds. projectM 4
+ * cannot hand a loaded preset from one instance to another, so the
+ * Prewarmer does the next-best thing: a second, tiny projectM instance on
+ * a worker thread, with its own context in the render context's share
+ * group, loads each upcoming preset and draws one frame. That reads the
+ * file and its textures into the page cache and compiles the very same
+ * GLSL, so when the render thread switches to it the driver's shader cache
+ * already has the programs.
+ *
+ * recordSwitch() classifies every real switch as a hit (warmed in time),
+ * late (queued or still loading) or miss (not predicted) and keeps the
+ * render-thread load time for each; stats() returns the totals.
+ *
+ * @section Threads
+ * - start()/stop(): render thread, with its context current.
+ * - prepare()/recordSwitch()/stats(): any thread.
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Engine.hpp"
+#include "util/Result.hpp"
+#include "util/Types.hpp"
+
+class QOpenGLContext;
+
+namespace vc::pm {
+
+struct PrewarmStats {
+    u64 warmed{0}; // loaded on the background context
+    u64 failed{0}; // projectM rejected the preset
+    u64 hits{0};
+    u64 late{0};
+    u64 misses{0};
+    f64 hitMs{0.0};  // render-thread load time, summed over hits
+    f64 missMs{0.0}; // ... and over late switches and misses
+    f64 worstMs{0.0};
+};
+
+class Prewarmer {
+public:
+    // Presets remembered as warm, most recent first
+    static constexpr usize WARM_CAPACITY = 64;
+
+    Prewarmer();
+    ~Prewarmer();
+
+    Prewarmer(const Prewarmer&) = delete;
+    Prewarmer& operator=(const Prewarmer&) = delete;
+
+    // `config` is the render instance's, so shaders come out identical
+    Result<void> start(const EngineConfig& config);
+    void stop();
+    bool running() const {
+        return thread_.joinable();
+    }
+
+    // Replaces the queue: warm these next, in this order
+    void prepare(const std::vector<fs::path>& presets);
+
+    // The render thread switched to `preset`, which took `ms`
+    void recordSwitch(const fs::path& preset, f64 ms);
+    PrewarmStats stats() const;
+
+private:
+    struct SurfaceSlot;
+
+    void worker(std::stop_token stop, EngineConfig config);
+    bool isWarm(const std::string& preset) const;
+
+    QOpenGLContext* shareContext_{nullptr};
+    std::shared_ptr<SurfaceSlot> surface_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable_any wake_;
+    std::deque<std::string> queue_;
+    std::string loading_;
+    std::deque<std::string> warm_;
+    PrewarmStats stats_;
+
+    std::jthread thread_;
+};
+
+} // namespace vc::pm
@@ -0,0 +1,98 @@
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <cmath>
+#include <fstream>
+#include <numbers>
+#include "recorder/EncoderSettings.hpp"
+#include "recorder/OfflineRenderer.hpp"
+
+using namespace vc;
+
+namespace {
+constexpr u32 RATE = 48000;
+
+// One second of a 440 Hz mono tone, 16-bit PCM
+fs::path writeWav(const fs::path& path) {
+    std::ofstream out(path, std::ios::binary);
+    auto put = [&](u32 value, int bytes) {
+        for (int i = 0; i < bytes; ++i)
+            out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    };
+    const u32 dataBytes = RATE * 2;
+    out.write("RIFF", 4);
+    put(36 + dataBytes, 4);
+    out.write("WAVEfmt ", 8);
+    put(16, 4);
+    put(1, 2); // PCM
+    put(1, 2);
+    put(RATE, 4);
+    put(RATE * 2, 4);
+    put(2, 2);
+    put(16, 2);
+    out.write("data", 4);
+    put(dataBytes, 4);
+    for (u32 i = 0; i < RATE; ++i) {
+        const f64 s = 0.5 * std::sin(2.0 * std::numbers::pi * 440.0 * i / RATE);
+        put(static_cast<u16>(static_cast<i16>(s * 32767.0)), 2);
+    }
+    return path;
+}
+
+bool haveGl() {
+    QOffscreenSurface surface;
+    surface.create();
+    QOpenGLContext context;
+    return context.create() && context.makeCurrent(&surface);
+}
+} // namespace
+
+class TestOfflineRenderer : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        if (!haveGl())
+            QSKIP("No offscreen OpenGL context");
+    }
+
+    // --headless end to end: decode, render with projectM, encode, mux
+    void testRendersAFile() {
+        QTemporaryDir dir;
+        const fs::path root(dir.path().toStdString());
+        // Keep preset stats and the index out of the user's directories
+        qputenv("XDG_DATA_HOME", QByteArray::fromStdString((root / "data").string()));
+        qputenv("XDG_CACHE_HOME", QByteArray::fromStdString((root / "cache").string()));
+
+        EncoderSettings settings;
+        settings.video.codec = VideoCodec::FFV1;
+        settings.video.width = 128;
+        settings.video.height = 72;
+        settings.video.fps = 30;
+        settings.audio.codec = AudioCodec::FLAC;
+        settings.container = Container::MKV;
+        settings.outputPath = root / "out.mkv";
+
+        OfflineRenderer renderer;
+        auto init = renderer.init(settings.video.width, settings.video.height);
+        QVERIFY2(init.isOk(), init.isOk() ? "" : init.error().message.c_str());
+
+        const auto input = writeWav(root / "tone.wav");
+        auto result = renderer.render(input, settings);
+        QVERIFY2(result.isOk(), result.isOk() ? "" : result.error().message.c_str());
+        QVERIFY(!renderer.isCancelled());
+        QVERIFY(fs::exists(settings.outputPath));
+        QVERIFY(fs::file_size(settings.outputPath) > 0);
+
+        // Offline renders leave play stats alone
+        QVERIFY(!fs::exists(root / "data" / "chadvis-projectm-qt" / "preset_stats.tsv"));
+    }
+};
+
+int runTestOfflineRenderer(int argc, char** argv) {
+    TestOfflineRenderer tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_OfflineRenderer.moc"
@@ -0,0 +1,57 @@
+#include <QTemporaryDir>
+#include <QtTest>
+#include <vector>
+#include "recorder/EncoderSettings.hpp"
+#include "recorder/VideoRecorderFFmpeg.hpp"
+
+using namespace vc;
+
+class TestVideoRecorderFFmpeg : public QObject {
+    Q_OBJECT
+
+private slots:
+    // Stereo input into a mono file, in batches shorter than a codec frame:
+    // the tail of each batch waits in the FIFO for the next one, and
+    // flushAudio() emits what is left, so every input frame comes out once
+    void testAudioTailCarriesOver() {
+        QTemporaryDir dir;
+        EncoderSettings settings;
+        settings.video.codec = VideoCodec::FFV1;
+        settings.video.width = 64;
+        settings.video.height = 32;
+        settings.video.fps = 30;
+        settings.audio.codec = AudioCodec::PCM; // no encoder delay, 1024-frame chunks
+        settings.audio.channels = 1;
+        settings.container = Container::MKV;
+        settings.outputPath = fs::path(dir.path().toStdString()) / "out.mkv";
+
+        VideoRecorderFFmpeg ffmpeg;
+        auto init = ffmpeg.init(settings);
+        QVERIFY2(init.isOk(), init.isOk() ? "" : init.error().message.c_str());
+        QVERIFY(ffmpeg.hasAudio());
+
+        // pcm_s16le mono: two bytes per frame
+        i64 emitted = 0;
+        auto sink = [&](AVPacket* packet) { emitted += packet->size / 2; };
+
+        constexpr usize BATCH = 700;
+        const std::vector<f32> stereo(BATCH * 2, 0.25f);
+        QVERIFY(ffmpeg.sendAudio(stereo, sink));
+        QCOMPARE(emitted, i64{0});
+        QVERIFY(ffmpeg.sendAudio(stereo, sink));
+        QVERIFY(ffmpeg.sendAudio(stereo, sink));
+        // Only whole frames go out before the flush
+        QVERIFY(emitted >= 1024);
+        QCOMPARE(emitted % 1024, i64{0});
+
+        QVERIFY(ffmpeg.flushAudio(sink));
+        QCOMPARE(emitted, static_cast<i64>(3 * BATCH));
+    }
+};
+
+int runTestVideoRecorderFFmpeg(int argc, char** argv) {
+    TestVideoRecorderFFmpeg tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_VideoRecorderFFmpeg.moc"
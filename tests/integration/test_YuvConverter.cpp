@@ -0,0 +1,145 @@
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QtTest>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "visualizer/YuvConverter.hpp"
+
+using namespace vc;
+
+namespace {
+constexpr u32 W = 64;
+constexpr u32 H = 32;
+
+// Top-down RGBA: a grey ramp, eight colour bars, then noise
+std::vector<u8> pattern() {
+    std::vector<u8> rgba(W * H * 4);
+    std::minstd_rand rng(7);
+    for (u32 y = 0; y < H; ++y) {
+        for (u32 x = 0; x < W; ++x) {
+            u8* p = &rgba[(y * W + x) * 4];
+            if (y < 8) {
+                p[0] = p[1] = p[2] = static_cast<u8>(x * 255 / (W - 1));
+            } else if (y < 16) {
+                const u32 bar = x / 8;
+                p[0] = bar & 1 ? 255 : 0;
+                p[1] = bar & 2 ? 255 : 0;
+                p[2] = bar & 4 ? 255 : 0;
+            } else {
+                p[0] = static_cast<u8>(rng());
+                p[1] = static_cast<u8>(rng());
+                p[2] = static_cast<u8>(rng());
+            }
+            p[3] = 255;
+        }
+    }
+    return rgba;
+}
+
+struct Yuv {
+    f64 y, u, v;
+};
+
+// Exact BT.709 limited range, in floating point
+Yuv bt709(f64 r, f64 g, f64 b) {
+    constexpr f64 kr = 0.2126;
+    constexpr f64 kb = 0.0722;
+    constexpr f64 kg = 1.0 - kr - kb;
+    const f64 luma = (kr * r + kg * g + kb * b) / 255.0;
+    return {16.0 + 219.0 * luma,
+            128.0 + 224.0 * (b / 255.0 - luma) / (2.0 * (1.0 - kb)),
+            128.0 + 224.0 * (r / 255.0 - luma) / (2.0 * (1.0 - kr))};
+}
+} // namespace
+
+class TestYuvConverter : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        QSurfaceFormat format;
+        format.setVersion(3, 3);
+        format.setProfile(QSurfaceFormat::CoreProfile);
+        surface_.setFormat(format);
+        surface_.create();
+        context_.setFormat(format);
+        if (!context_.create() || !context_.makeCurrent(&surface_) ||
+            context_.format().version() < qMakePair(3, 3))
+            QSKIP("No OpenGL 3.3 core context");
+    }
+
+    void cleanupTestCase() {
+        context_.doneCurrent();
+    }
+
+    void testMatchesBt709Reference() {
+        auto* gl = context_.functions();
+        const auto rgba = pattern();
+
+        // Bottom-up, as the record target holds it
+        std::vector<u8> bottomUp(rgba.size());
+        for (u32 y = 0; y < H; ++y)
+            std::memcpy(&bottomUp[(H - 1 - y) * W * 4], &rgba[y * W * 4], W * 4);
+        GLuint texture = 0;
+        gl->glGenTextures(1, &texture);
+        gl->glBindTexture(GL_TEXTURE_2D, texture);
+        gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, W, H, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                         bottomUp.data());
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        gl->glBindTexture(GL_TEXTURE_2D, 0);
+
+        YuvConverter yuv;
+        QVERIFY(yuv.init(W, H).isOk());
+        yuv.convert(texture);
+        std::vector<u8> planes(YuvConverter::planarSize(W, H));
+        yuv.readPlanes(planes.data());
+        gl->glDeleteTextures(1, &texture);
+
+        int worst = 0;
+        auto check = [&](u8 got, f64 want) {
+            worst = std::max(worst, std::abs(int(got) - int(std::lround(want))));
+        };
+        for (u32 y = 0; y < H; ++y) {
+            for (u32 x = 0; x < W; ++x) {
+                const u8* p = &rgba[(y * W + x) * 4];
+                check(planes[y * W + x], bt709(p[0], p[1], p[2]).y);
+            }
+        }
+        // Chroma of the 2x2 block average
+        const u8* u = planes.data() + W * H;
+        const u8* v = u + (W / 2) * (H / 2);
+        for (u32 cy = 0; cy < H / 2; ++cy) {
+            for (u32 cx = 0; cx < W / 2; ++cx) {
+                f64 sum[3] = {0.0, 0.0, 0.0};
+                for (u32 dy = 0; dy < 2; ++dy)
+                    for (u32 dx = 0; dx < 2; ++dx)
+                        for (u32 c = 0; c < 3; ++c)
+                            sum[c] += rgba[((2 * cy + dy) * W + 2 * cx + dx) * 4 + c];
+                const auto want = bt709(sum[0] / 4.0, sum[1] / 4.0, sum[2] / 4.0);
+                check(u[cy * (W / 2) + cx], want.u);
+                check(v[cy * (W / 2) + cx], want.v);
+            }
+        }
+        QVERIFY2(worst <= 1, qPrintable(QString("Off by %1 LSB").arg(worst)));
+
+        // Top row is the top of the picture: black to white, limited range
+        QCOMPARE(planes[0], u8{16});
+        QCOMPARE(planes[W - 1], u8{235});
+    }
+
+private:
+    QOffscreenSurface surface_;
+    QOpenGLContext context_;
+};
+
+int runTestYuvConverter(int argc, char** argv) {
+    TestYuvConverter tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_YuvConverter.moc"
@@ -1,7 +1,26 @@
-#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QSurfaceFormat>
 #include <QtTest>
 
+int runTestYuvConverter(int argc, char** argv);
+int runTestOfflineRenderer(int argc, char** argv);
+int runTestVideoRecorderFFmpeg(int argc, char** argv);
+
 int main(int argc, char* argv[]) {
-    QCoreApplication app(argc, argv);
-    return 0;
+    // GL tests need a GUI application but no display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    // What Application asks for
+    QSurfaceFormat format;
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    QSurfaceFormat::setDefaultFormat(format);
+    QGuiApplication app(argc, argv);
+
+    int status = 0;
+    status |= runTestYuvConverter(argc, argv);
+    status |= runTestOfflineRenderer(argc, argv);
+    status |= runTestVideoRecorderFFmpeg(argc, argv);
+
+    return status;
 }
@@ -0,0 +1,97 @@
+#include <QBuffer>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "audio/analysis/AlbumArtStore.hpp"
+
+using namespace vc;
+
+namespace {
+QByteArray encodedCover(int width, int height, QColor color) {
+    QImage image(width, height, QImage::Format_RGB32);
+    image.fill(color);
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+    return bytes;
+}
+} // namespace
+
+class TestAlbumArtStore : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testIdenticalCoversShareOneId() {
+        QTemporaryDir dir;
+        AlbumArtStore store(fs::path(dir.path().toStdString()));
+        const QByteArray red = encodedCover(600, 400, Qt::red);
+
+        const ArtId first = store.intern(red, "a.flac");
+        QVERIFY(first != 0);
+        QCOMPARE(store.intern(red, "b.flac"), first);
+        QVERIFY(store.intern(encodedCover(600, 400, Qt::blue), "c.flac") != first);
+        QCOMPARE(store.intern({}, "d.flac"), ArtId{0});
+        QCOMPARE(store.intern("not an image", "e.flac"), ArtId{0});
+    }
+
+    void testThumbnailIsDownscaledAndPersisted() {
+        QTemporaryDir dir;
+        const fs::path root(dir.path().toStdString());
+        const QByteArray cover = encodedCover(1200, 600, Qt::green);
+        ArtId id = 0;
+        {
+            AlbumArtStore store(root);
+            id = store.intern(cover, "a.flac");
+            // Ingest alone doesn't fill the memory cache
+            QCOMPARE(store.cachedThumbnails(), usize{0});
+            auto thumbnail = store.thumbnail(id);
+            QVERIFY(thumbnail.has_value());
+            QCOMPARE(thumbnail->width(), AlbumArtStore::THUMBNAIL_EDGE);
+            QCOMPARE(thumbnail->height(), AlbumArtStore::THUMBNAIL_EDGE / 2);
+            QCOMPARE(store.cachedThumbnails(), usize{1});
+        }
+
+        // A fresh store (next run) serves it from disk without the source
+        AlbumArtStore reopened(root);
+        auto thumbnail = reopened.thumbnail(id);
+        QVERIFY(thumbnail.has_value());
+        QCOMPARE(thumbnail->width(), AlbumArtStore::THUMBNAIL_EDGE);
+        QVERIFY(!reopened.thumbnail(id + 1).has_value());
+    }
+
+    void testLruRespectsBudget() {
+        QTemporaryDir dir;
+        AlbumArtStore store(fs::path(dir.path().toStdString()));
+        std::vector<ArtId> ids;
+        for (int i = 0; i < 4; ++i) {
+            ids.push_back(store.intern(encodedCover(512, 512, QColor(i * 40, 0, 0)), "x.flac"));
+            QVERIFY(store.thumbnail(ids.back()).has_value());
+        }
+        QCOMPARE(store.cachedThumbnails(), usize{4});
+
+        const usize one = store.cachedBytes() / 4;
+        store.setBudget(one * 2);
+        QCOMPARE(store.cachedThumbnails(), usize{2});
+        QVERIFY(store.cachedBytes() <= one * 2);
+
+        // Evicted entries reload from disk
+        QVERIFY(store.thumbnail(ids.front()).has_value());
+        QCOMPARE(store.cachedThumbnails(), usize{2});
+    }
+
+    void testFullSizeNeedsTheSourceTrack() {
+        QTemporaryDir dir;
+        AlbumArtStore store(fs::path(dir.path().toStdString()));
+        const ArtId id = store.intern(encodedCover(64, 64, Qt::white), "/nonexistent/track.flac");
+        QVERIFY(id != 0);
+        QVERIFY(!store.fullSize(id).has_value());
+        QVERIFY(!store.fullSize(0).has_value());
+    }
+};
+
+int runTestAlbumArtStore(int argc, char** argv) {
+    TestAlbumArtStore tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_AlbumArtStore.moc"
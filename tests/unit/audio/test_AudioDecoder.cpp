@@ -0,0 +1,152 @@
+#include <QTemporaryDir>
+#include <QtTest>
+#include <cmath>
+#include <fstream>
+#include <numbers>
+#include "audio/AudioDecoder.hpp"
+
+using namespace vc;
+
+namespace {
+constexpr u32 RATE = 22050;
+constexpr u32 FRAMES = RATE * 2;
+
+// 16-bit stereo PCM WAV; `sample(i)` gives the left channel, right is negated
+template<typename F>
+fs::path writeWav(const QTemporaryDir& dir, const char* name, F sample) {
+    fs::path path = fs::path(dir.path().toStdString()) / name;
+    std::ofstream out(path, std::ios::binary);
+    auto put = [&](u32 value, int bytes) {
+        for (int i = 0; i < bytes; ++i)
+            out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    };
+    const u32 dataBytes = FRAMES * 4;
+    out.write("RIFF", 4);
+    put(36 + dataBytes, 4);
+    out.write("WAVEfmt ", 8);
+    put(16, 4);
+    put(1, 2); // PCM
+    put(2, 2);
+    put(RATE, 4);
+    put(RATE * 4, 4);
+    put(4, 2);
+    put(16, 2);
+    out.write("data", 4);
+    put(dataBytes, 4);
+    for (u32 i = 0; i < FRAMES; ++i) {
+        const i16 value = sample(i);
+        put(static_cast<u16>(value), 2);
+        put(static_cast<u16>(static_cast<i16>(-value)), 2);
+    }
+    return path;
+}
+
+// Ramp that identifies each frame of the first 32768
+i16 ramp(u32 frame) {
+    return static_cast<i16>(frame % 32768);
+}
+
+f32 expected(u32 frame) {
+    return static_cast<f32>(ramp(frame)) / 32768.0f;
+}
+
+// Zero crossings per second of the left channel, halved: the tone frequency
+f32 measureHz(std::span<const f32> stereo, u32 rate) {
+    usize crossings = 0;
+    for (usize i = 2; i < stereo.size(); i += 2)
+        crossings += (stereo[i - 2] < 0.0f) != (stereo[i] < 0.0f);
+    return static_cast<f32>(crossings) * rate / (stereo.size() / 2) / 2.0f;
+}
+} // namespace
+
+class TestAudioDecoder : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase() {
+        QVERIFY(dir_.isValid());
+        rampPath_ = writeWav(dir_, "ramp.wav", ramp);
+    }
+
+    void testDecodesEveryFrame() {
+        AudioDecoder decoder;
+        QVERIFY(decoder.open(rampPath_, RATE, 2));
+        QCOMPARE(decoder.totalFrames(), static_cast<u64>(FRAMES));
+
+        std::vector<f32> pcm(static_cast<usize>(FRAMES) * 2 + 64);
+        const usize frames = decoder.read(pcm.data(), FRAMES + 32);
+        QCOMPARE(frames, static_cast<usize>(FRAMES));
+        QCOMPARE(decoder.position(), static_cast<u64>(FRAMES));
+        QVERIFY(decoder.atEnd());
+        for (u32 i : {0u, 1u, 1000u, 32767u, 32768u, FRAMES - 1}) {
+            QCOMPARE(pcm[i * 2], expected(i));
+            QCOMPARE(pcm[i * 2 + 1], -expected(i));
+        }
+    }
+
+    void testSeekIsSampleAccurate_data() {
+        QTest::addColumn<bool>("indexed");
+        QTest::addRow("container index") << false;
+        QTest::addRow("scanned index") << true;
+    }
+
+    void testSeekIsSampleAccurate() {
+        QFETCH(bool, indexed);
+
+        AudioDecoder decoder;
+        QVERIFY(decoder.open(rampPath_, RATE, 2));
+        if (indexed) {
+            while (!decoder.indexStep(16)) {}
+            QVERIFY(decoder.indexed());
+        }
+
+        std::vector<f32> pcm(512);
+        for (u32 target : {12345u, 30001u, 7u, 0u, 20000u}) {
+            QVERIFY(decoder.seek(target));
+            QCOMPARE(decoder.position(), static_cast<u64>(target));
+            QCOMPARE(decoder.read(pcm.data(), 256), static_cast<usize>(256));
+            QCOMPARE(pcm[0], expected(target));
+            QCOMPARE(pcm[255 * 2], expected(target + 255));
+            QCOMPARE(decoder.position(), static_cast<u64>(target + 256));
+        }
+
+        // Past the end: nothing left to read
+        QVERIFY(decoder.seek(FRAMES + 100));
+        QCOMPARE(decoder.read(pcm.data(), 256), static_cast<usize>(0));
+    }
+
+    void testResamplesToRequestedRate() {
+        const fs::path tone = writeWav(dir_, "tone.wav", [](u32 i) {
+            return static_cast<i16>(
+                    16000.0f * std::sin(2.0f * std::numbers::pi_v<f32> * 1000.0f * i / RATE));
+        });
+
+        AudioDecoder decoder;
+        QVERIFY(decoder.open(tone, 48000, 2));
+        QCOMPARE(decoder.totalFrames(), static_cast<u64>(FRAMES) * 48000 / RATE);
+
+        std::vector<f32> pcm(static_cast<usize>(decoder.totalFrames()) * 2 + 4096);
+        const usize frames = decoder.read(pcm.data(), pcm.size() / 2);
+        QVERIFY(frames > decoder.totalFrames() * 99 / 100 && frames <= decoder.totalFrames() + 64);
+        pcm.resize(frames * 2);
+        QVERIFY(std::abs(measureHz(std::span(pcm).subspan(2000), 48000) - 1000.0f) < 5.0f);
+    }
+
+    void testOpenMissingFileFails() {
+        AudioDecoder decoder;
+        QVERIFY(!decoder.open(fs::path(dir_.path().toStdString()) / "missing.wav"));
+        QVERIFY(!decoder.isOpen());
+        QVERIFY(!decoder.seek(0));
+    }
+
+private:
+    QTemporaryDir dir_;
+    fs::path rampPath_;
+};
+
+int runTestAudioDecoder(int argc, char** argv) {
+    TestAudioDecoder tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_AudioDecoder.moc"
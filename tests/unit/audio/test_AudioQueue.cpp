@@ -0,0 +1,136 @@
+#include <QtTest>
+#include <numeric>
+#include <thread>
+#include "audio/AudioQueue.hpp"
+
+using namespace vc;
+
+class TestAudioQueue : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testMonoIsWrittenAsStereo() {
+        AudioQueue queue(1024);
+        std::vector<f32> mono{0.25f, -0.5f};
+        queue.push(mono.data(), 2, 1, 44100);
+
+        f32 out[4]{};
+        QCOMPARE(queue.pop(AudioConsumer::Viz, out, 4), 2u);
+        QCOMPARE(out[0], 0.25f);
+        QCOMPARE(out[1], 0.25f);
+        QCOMPARE(out[3], -0.5f);
+        QCOMPARE(queue.sampleRate(), 44100u);
+    }
+
+    void testConsumersReadIndependently() {
+        AudioQueue queue(1024);
+        std::vector<f32> data(200);
+        std::iota(data.begin(), data.end(), 0.0f);
+        queue.push(data.data(), 100, 2, 48000);
+
+        f32 out[200]{};
+        QCOMPARE(queue.pop(AudioConsumer::Viz, out, 100), 100u);
+        QCOMPARE(queue.depth(AudioConsumer::Viz), 0u);
+        QCOMPARE(queue.depth(AudioConsumer::Rec), 100u);
+        QCOMPARE(queue.depth(AudioConsumer::Ana), 100u);
+
+        QCOMPARE(queue.pop(AudioConsumer::Rec, out, 30), 30u);
+        QCOMPARE(out[59], 59.0f);
+        QCOMPARE(queue.depth(AudioConsumer::Rec), 70u);
+    }
+
+    void testPeekSplitsAcrossWraparound() {
+        AudioQueue queue(1024);
+        std::vector<f32> data(1400 * 2);
+        std::iota(data.begin(), data.end(), 0.0f);
+
+        queue.push(data.data(), 700, 2, 48000);
+        f32 scratch[1400]{};
+        queue.pop(AudioConsumer::Viz, scratch, 700);
+
+        queue.push(data.data() + 1400, 600, 2, 48000);
+        auto spans = queue.peek(AudioConsumer::Viz, 600);
+        QCOMPARE(spans.frames(), 600u);
+        QCOMPARE(spans.first.size(), usize{(1024 - 700) * 2});
+        QCOMPARE(spans.second.size(), usize{(600 - 324) * 2});
+        QCOMPARE(spans.first[0], 1400.0f);
+        QCOMPARE(spans.second[0], data[(700 + 324) * 2]);
+        queue.consume(AudioConsumer::Viz, spans.frames());
+        QCOMPARE(queue.depth(AudioConsumer::Viz), 0u);
+    }
+
+    void testLaggingConsumerIsSkippedForward() {
+        AudioQueue queue(1024);
+        std::vector<f32> data(1000 * 2, 1.0f);
+        queue.push(data.data(), 1000, 2, 48000);
+        queue.push(data.data(), 1000, 2, 48000);
+
+        // 2000 frames behind a 1024 ring with a 256-frame guard
+        auto spans = queue.peek(AudioConsumer::Rec, 4096);
+        QCOMPARE(spans.frames(), 768u);
+        QCOMPARE(queue.dropCount(AudioConsumer::Rec), u64{2000 - 768});
+        QCOMPARE(queue.dropCount(AudioConsumer::Viz), u64{0});
+    }
+
+    void testSeekToLatestDiscardsBacklog() {
+        AudioQueue queue(1024);
+        std::vector<f32> data(100 * 2, 1.0f);
+        queue.push(data.data(), 100, 2, 48000);
+
+        queue.seekToLatest(AudioConsumer::Rec);
+        QCOMPARE(queue.depth(AudioConsumer::Rec), 0u);
+        QCOMPARE(queue.dropCount(AudioConsumer::Rec), u64{0});
+        QCOMPARE(queue.depth(AudioConsumer::Viz), 100u);
+    }
+
+    void testWaitReturnsOnceThresholdIsCrossed() {
+        AudioQueue queue(4096);
+        std::vector<f32> data(128 * 2, 0.5f);
+
+        std::atomic<u32> available{0};
+        std::jthread consumer([&] { available = queue.waitForFrames(AudioConsumer::Ana, 512); });
+        for (int i = 0; i < 16; ++i) {
+            queue.push(data.data(), 128, 2, 48000);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        consumer.join();
+
+        // 16 pushes, but the doorbell rings at most once: when 512 is crossed
+        QVERIFY(available >= 512u);
+        QVERIFY(queue.wakeupCount(AudioConsumer::Ana) <= 1u);
+    }
+
+    void testNoWakeupsWithoutWaiter() {
+        AudioQueue queue(1024);
+        std::vector<f32> data(64 * 2, 0.5f);
+        for (int i = 0; i < 100; ++i)
+            queue.push(data.data(), 64, 2, 48000);
+
+        for (auto consumer : {AudioConsumer::Viz, AudioConsumer::Rec, AudioConsumer::Ana})
+            QCOMPARE(queue.wakeupCount(consumer), u64{0});
+        // Enough is already queued: returns without sleeping
+        QVERIFY(queue.waitForFrames(AudioConsumer::Ana, 256) >= 256u);
+    }
+
+    void testWakeReleasesWaiter() {
+        AudioQueue queue(1024);
+        std::atomic<bool> returned{false};
+        std::jthread consumer([&] {
+            queue.waitForFrames(AudioConsumer::Ana, 512);
+            returned = true;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        queue.wake(AudioConsumer::Ana);
+        consumer.join();
+        QVERIFY(returned);
+        QCOMPARE(queue.depth(AudioConsumer::Ana), 0u);
+    }
+};
+
+int runTestAudioQueue(int argc, char** argv) {
+    TestAudioQueue tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_AudioQueue.moc"
@@ -0,0 +1,181 @@
+#include <QtTest>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include "audio/AudioAnalyzer.hpp"
+#include "audio/BeatTracker.hpp"
+#include "audio/FftEngine.hpp"
+
+using namespace vc;
+
+namespace {
+constexpr u32 RATE = 44100;
+constexpr u32 FFT_SIZE = 2048;
+constexpr u32 HOP = 512;
+constexpr f32 SECONDS = 12.0f;
+
+// Mono click track: a 10 ms decaying noise burst on every beat, starting
+// at 0.25 s, optionally over a sustained three-note pad
+std::vector<f32> clickTrack(f32 bpm, bool pad, std::vector<f32>& clickTimes) {
+    const usize frames = static_cast<usize>(SECONDS * RATE);
+    std::vector<f32> out(frames, 0.0f);
+
+    if (pad) {
+        for (usize i = 0; i < frames; ++i) {
+            f32 t = static_cast<f32>(i) / RATE;
+            for (f32 hz : {220.0f, 277.2f, 329.6f})
+                out[i] += 0.15f * std::sin(2.0f * std::numbers::pi_v<f32> * hz * t);
+        }
+    }
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<f32> noise(-1.0f, 1.0f);
+    const usize burst = RATE / 100;
+    for (f32 t = 0.25f; t < SECONDS - 0.1f; t += 60.0f / bpm) {
+        clickTimes.push_back(t);
+        usize start = static_cast<usize>(t * RATE);
+        for (usize i = 0; i < burst && start + i < frames; ++i)
+            out[start + i] += 0.6f * noise(rng) * std::exp(-static_cast<f32>(i) / (burst / 4));
+    }
+    return out;
+}
+
+struct TrackResult {
+    std::vector<f32> onsetTimes; // end of the hop that reported each onset
+    f32 bpm{0.0f};
+};
+
+// Drive the tracker hop by hop from FFT magnitudes, as AudioAnalyzer does
+TrackResult runTracker(const std::vector<f32>& pcm) {
+    FftEngine fft;
+    if (!fft.configure(FFT_SIZE, FftWindow::Hann))
+        return {};
+    BeatTracker tracker;
+    tracker.configure(static_cast<f32>(RATE) / HOP, fft.bins(), static_cast<f32>(RATE) / FFT_SIZE);
+
+    TrackResult result;
+    std::vector<f32> magnitudes(fft.bins());
+    for (usize end = FFT_SIZE; end <= pcm.size(); end += HOP) {
+        fft.magnitudes({}, std::span(pcm).subspan(end - FFT_SIZE, FFT_SIZE), magnitudes);
+        tracker.process(magnitudes);
+        if (tracker.onset())
+            result.onsetTimes.push_back(static_cast<f32>(end) / RATE);
+    }
+    result.bpm = tracker.bpm();
+    return result;
+}
+} // namespace
+
+class TestBeatTracker : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testClickTrack_data() {
+        QTest::addColumn<f32>("bpm");
+        QTest::addColumn<bool>("pad");
+
+        // 150 and up have a half-tempo peak as strong as their own
+        for (f32 bpm : {90.0f, 120.0f, 128.0f, 140.0f, 150.0f, 160.0f, 174.0f}) {
+            QTest::addRow("%d bpm", static_cast<int>(bpm)) << bpm << false;
+            QTest::addRow("%d bpm over pad", static_cast<int>(bpm)) << bpm << true;
+        }
+    }
+
+    void testClickTrack() {
+        QFETCH(f32, bpm);
+        QFETCH(bool, pad);
+
+        std::vector<f32> clicks;
+        TrackResult result = runTracker(clickTrack(bpm, pad, clicks));
+
+        // Each click is reported by a hop ending within 50 ms after it
+        usize hits = 0;
+        for (f32 click : clicks) {
+            hits += std::ranges::any_of(result.onsetTimes, [&](f32 onset) {
+                return onset >= click && onset <= click + 0.05f;
+            });
+        }
+        QVERIFY2(hits * 10 >= clicks.size() * 9,
+                 qPrintable(QString("recall %1/%2").arg(hits).arg(clicks.size())));
+        QVERIFY2(result.onsetTimes.size() <= clicks.size() + 2,
+                 qPrintable(QString("%1 onsets for %2 clicks")
+                                    .arg(result.onsetTimes.size())
+                                    .arg(clicks.size())));
+
+        QVERIFY2(std::abs(result.bpm - bpm) <= 2.0f,
+                 qPrintable(QString("tracked %1 bpm").arg(result.bpm)));
+    }
+
+    // Cost of process() alone over the whole track; divide by the hop
+    // count for the per-hop figure (the analyzer budget is 100 us)
+    void testProcessCost() {
+        std::vector<f32> clicks;
+        const std::vector<f32> pcm = clickTrack(128.0f, true, clicks);
+        FftEngine fft;
+        QVERIFY(fft.configure(FFT_SIZE, FftWindow::Hann));
+
+        std::vector<std::vector<f32>> hops;
+        for (usize end = FFT_SIZE; end <= pcm.size(); end += HOP) {
+            hops.emplace_back(fft.bins());
+            fft.magnitudes({}, std::span(pcm).subspan(end - FFT_SIZE, FFT_SIZE), hops.back());
+        }
+        qInfo("%zu hops", hops.size());
+
+        BeatTracker tracker;
+        tracker.configure(static_cast<f32>(RATE) / HOP, fft.bins(), static_cast<f32>(RATE) / FFT_SIZE);
+        QBENCHMARK {
+            tracker.reset();
+            for (const auto& magnitudes : hops)
+                tracker.process(magnitudes);
+        }
+        QVERIFY(std::abs(tracker.bpm() - 128.0f) <= 2.0f);
+
+        // The analyzer budgets 0.1 ms a hop; release builds take ~20 µs
+        // with the pad. The bound leaves room for debug and sanitizer
+        // builds and only catches an order-of-magnitude regression.
+        const auto start = chr::steady_clock::now();
+        tracker.reset();
+        for (const auto& magnitudes : hops)
+            tracker.process(magnitudes);
+        const f64 perHopUs =
+                chr::duration<f64, std::micro>(chr::steady_clock::now() - start).count() / hops.size();
+        qInfo("%.1f us per hop", perHopUs);
+        QVERIFY2(perHopUs < 1000.0, qPrintable(QString("%1 us per hop").arg(perHopUs)));
+    }
+
+    void testSilenceHasNoOnsets() {
+        TrackResult result = runTracker(std::vector<f32>(static_cast<usize>(SECONDS * RATE)));
+        QVERIFY(result.onsetTimes.empty());
+        QCOMPARE(result.bpm, 0.0f);
+    }
+
+    void testAnalyzerReportsTempo() {
+        std::vector<f32> clicks;
+        std::vector<f32> mono = clickTrack(120.0f, true, clicks);
+        std::vector<f32> stereo(mono.size() * 2);
+        for (usize i = 0; i < mono.size(); ++i)
+            stereo[i * 2] = stereo[i * 2 + 1] = mono[i];
+
+        AudioAnalyzer analyzer;
+        AudioSpectrum spectrum;
+        usize onsets = 0;
+        bool phaseInRange = true;
+        for (usize i = 0; i + HOP <= mono.size(); i += HOP) {
+            analyzer.analyze(std::span(stereo).subspan(i * 2, HOP * 2), RATE, 2, spectrum);
+            onsets += spectrum.onset;
+            phaseInRange &= spectrum.beatPhase >= 0.0f && spectrum.beatPhase < 1.0f;
+        }
+
+        QVERIFY(std::abs(spectrum.bpm - 120.0f) <= 2.0f);
+        QVERIFY(spectrum.tempoConfidence > 0.0f);
+        QVERIFY(phaseInRange);
+        QVERIFY(onsets * 10 >= clicks.size() * 9);
+    }
+};
+
+int runTestBeatTracker(int argc, char** argv) {
+    TestBeatTracker tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_BeatTracker.moc"
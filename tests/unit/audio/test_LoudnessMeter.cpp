@@ -0,0 +1,130 @@
+#include <QtTest>
+#include <cmath>
+#include <numbers>
+#include "audio/GainStage.hpp"
+#include "audio/analysis/LoudnessMeter.hpp"
+
+using namespace vc;
+
+namespace {
+constexpr u32 RATE = 48000;
+
+// Stereo sine, same signal in both channels
+std::vector<f32> sine(f32 hz, f32 amplitude, f32 seconds, f32 phase = 0.0f) {
+    const usize frames = static_cast<usize>(seconds * RATE);
+    std::vector<f32> pcm(frames * 2);
+    for (usize i = 0; i < frames; ++i) {
+        const f32 t = static_cast<f32>(i) / RATE;
+        pcm[i * 2] = pcm[i * 2 + 1] =
+                amplitude * std::sin(2.0f * std::numbers::pi_v<f32> * hz * t + phase);
+    }
+    return pcm;
+}
+
+f32 dbfs(f32 db) {
+    return std::pow(10.0f, db / 20.0f);
+}
+} // namespace
+
+class TestLoudnessMeter : public QObject {
+    Q_OBJECT
+
+private slots:
+    // EBU Tech 3341 case 1: stereo 1 kHz at -23 dBFS reads -23 LUFS
+    void testReferenceTone() {
+        LoudnessMeter meter(RATE);
+        const auto pcm = sine(1000.0f, dbfs(-23.0f), 20.0f);
+        meter.add(pcm.data(), pcm.size() / 2);
+        const auto result = meter.result();
+        QVERIFY(std::abs(result.integratedLufs - -23.0f) < 0.1f);
+        QVERIFY(std::abs(result.durationSec - 20.0f) < 0.01f);
+        QVERIFY(result.rangeLu < 0.1f);
+    }
+
+    void testOtherRatesMatch() {
+        for (u32 rate : {44100u, 96000u}) {
+            LoudnessMeter meter(rate);
+            const usize frames = rate * 10;
+            std::vector<f32> pcm(frames * 2);
+            for (usize i = 0; i < frames; ++i) {
+                pcm[i * 2] = pcm[i * 2 + 1] =
+                        dbfs(-20.0f) * std::sin(2.0f * std::numbers::pi_v<f32> * 1000.0f * i / rate);
+            }
+            meter.add(pcm.data(), frames);
+            QVERIFY(std::abs(meter.result().integratedLufs - -20.0f) < 0.1f);
+        }
+    }
+
+    // Silence is gated out instead of dragging the average down
+    void testSilenceIsGated() {
+        LoudnessMeter meter(RATE);
+        const auto tone = sine(1000.0f, dbfs(-18.0f), 10.0f);
+        const std::vector<f32> silence(RATE * 2 * 10, 0.0f);
+        meter.add(tone.data(), tone.size() / 2);
+        meter.add(silence.data(), silence.size() / 2);
+        QVERIFY(std::abs(meter.result().integratedLufs - -18.0f) < 0.1f);
+
+        LoudnessMeter empty(RATE);
+        empty.add(silence.data(), silence.size() / 2);
+        QCOMPARE(empty.result().integratedLufs, LOUDNESS_SILENCE_LUFS);
+    }
+
+    // EBU Tech 3342 case 1: 20 s at -20 then 20 s at -30 LUFS is 10 LU
+    void testLoudnessRange() {
+        LoudnessMeter meter(RATE);
+        const auto loud = sine(1000.0f, dbfs(-20.0f), 20.0f);
+        const auto quiet = sine(1000.0f, dbfs(-30.0f), 20.0f);
+        meter.add(loud.data(), loud.size() / 2);
+        meter.add(quiet.data(), quiet.size() / 2);
+        QVERIFY(std::abs(meter.result().rangeLu - 10.0f) < 1.0f);
+    }
+
+    // fs/4 sine 45 degrees off the sample grid: samples peak 3 dB low
+    void testTruePeakBetweenSamples() {
+        LoudnessMeter meter(RATE);
+        const auto pcm = sine(RATE / 4.0f, dbfs(-6.0f), 1.0f, std::numbers::pi_v<f32> / 4.0f);
+        f32 samplePeak = 0.0f;
+        for (f32 x : pcm)
+            samplePeak = std::max(samplePeak, std::abs(x));
+        QVERIFY(20.0f * std::log10(samplePeak) < -8.5f);
+
+        meter.add(pcm.data(), pcm.size() / 2);
+        QVERIFY(std::abs(meter.result().truePeakDbtp - -6.0f) < 0.3f);
+    }
+
+    // Chunked input gives the same answer as one call
+    void testChunkingIsTransparent() {
+        const auto pcm = sine(440.0f, dbfs(-12.0f), 5.0f);
+        LoudnessMeter whole(RATE);
+        whole.add(pcm.data(), pcm.size() / 2);
+        LoudnessMeter pieces(RATE);
+        for (usize offset = 0; offset < pcm.size() / 2; offset += 777)
+            pieces.add(pcm.data() + offset * 2, std::min<usize>(777, pcm.size() / 2 - offset));
+        QCOMPARE(pieces.result().integratedLufs, whole.result().integratedLufs);
+        QCOMPARE(pieces.result().truePeakDbtp, whole.result().truePeakDbtp);
+    }
+
+    void testGainRamp() {
+        // Odd length exercises the scalar tail after the vector loop
+        std::vector<f32> pcm(2 * 1001, 1.0f);
+        applyGain(pcm.data(), 1001, 2, 0.5f, 0.5f);
+        for (f32 x : pcm)
+            QVERIFY(std::abs(x - 0.5f) < 1e-6f);
+
+        std::fill(pcm.begin(), pcm.end(), 1.0f);
+        applyGain(pcm.data(), 1001, 2, 0.0f, 1.0f);
+        QVERIFY(std::abs(pcm.front()) < 1e-6f);
+        QVERIFY(std::abs(pcm.back() - 1.0f) < 1e-3f);
+        for (usize i = 1; i < pcm.size(); ++i)
+            QVERIFY(pcm[i] >= pcm[i - 1]);
+
+        QVERIFY(std::abs(dbToGain(-6.0f) - 0.501f) < 1e-3f);
+    }
+};
+
+int runTestLoudnessMeter(int argc, char** argv) {
+    TestLoudnessMeter tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_LoudnessMeter.moc"
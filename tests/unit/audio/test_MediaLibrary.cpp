@@ -0,0 +1,124 @@
+#include <QTemporaryDir>
+#include <QtTest>
+#include "audio/MediaLibrary.hpp"
+
+using namespace vc;
+
+namespace {
+LibraryTrack makeTrack(const std::string& path, const std::string& title) {
+    LibraryTrack track;
+    track.path = path;
+    track.size = 1234;
+    track.mtime = 42;
+    track.metadata.title = title;
+    track.metadata.artist = "Artist";
+    track.metadata.duration = Duration(180000);
+    track.metadata.artId = 0xfedcba9876543210ull; // above INT64_MAX
+    track.lyricsPath = path + ".lrc";
+    return track;
+}
+} // namespace
+
+class TestMediaLibrary : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testStoreAndFind() {
+        QTemporaryDir dir;
+        MediaLibrary library;
+        QVERIFY(library.open(fs::path(dir.path().toStdString()) / "library.db"));
+
+        std::vector<LibraryTrack> tracks{makeTrack("/music/a.flac", "A"), makeTrack("/music/b.flac", "B")};
+        QVERIFY(library.store(tracks));
+        QVERIFY(tracks[0].id != 0);
+        QVERIFY(tracks[1].id != tracks[0].id);
+        QCOMPARE(library.trackCount(), usize{2});
+
+        auto found = library.find({"/music/b.flac", "/music/missing.flac", "/music/a.flac"});
+        QCOMPARE(found.size(), usize{3});
+        QVERIFY(found[0].has_value());
+        QVERIFY(!found[1].has_value());
+        QCOMPARE(found[0]->id, tracks[1].id);
+        QCOMPARE(found[0]->metadata.title, std::string("B"));
+        QCOMPARE(found[0]->metadata.duration.count(), i64{180000});
+        QCOMPARE(found[0]->metadata.artId, ArtId{0xfedcba9876543210ull});
+        QCOMPARE(found[0]->size, u64{1234});
+        QCOMPARE(found[0]->mtime, i64{42});
+        QCOMPARE(found[2]->lyricsPath, std::string("/music/a.flac.lrc"));
+    }
+
+    void testStoreUpdatesInPlace() {
+        QTemporaryDir dir;
+        MediaLibrary library;
+        QVERIFY(library.open(fs::path(dir.path().toStdString()) / "library.db"));
+
+        std::vector<LibraryTrack> tracks{makeTrack("/music/a.flac", "Old")};
+        QVERIFY(library.store(tracks));
+        const i64 id = tracks[0].id;
+
+        std::vector<LibraryTrack> retagged{makeTrack("/music/a.flac", "New")};
+        retagged[0].mtime = 43;
+        QVERIFY(library.store(retagged));
+        QCOMPARE(retagged[0].id, id);
+        QCOMPARE(library.trackCount(), usize{1});
+        auto found = library.find({"/music/a.flac"});
+        QCOMPARE(found[0]->metadata.title, std::string("New"));
+        QCOMPARE(found[0]->mtime, i64{43});
+    }
+
+    void testPlaylistRoundTrip() {
+        QTemporaryDir dir;
+        const fs::path db = fs::path(dir.path().toStdString()) / "library.db";
+        i64 trackId = 0;
+        {
+            MediaLibrary library;
+            QVERIFY(library.open(db));
+            auto none = library.loadPlaylist("session");
+            QVERIFY(none);
+            QVERIFY(!none.value().has_value());
+
+            std::vector<LibraryTrack> tracks{makeTrack("/music/a.flac", "A")};
+            QVERIFY(library.store(tracks));
+            trackId = tracks[0].id;
+
+            std::vector<LibraryPlaylistEntry> entries(3);
+            entries[0].location = "https://example.com/stream";
+            entries[0].title = "Radio";
+            entries[1].trackId = trackId;
+            entries[1].location = "/music/a.flac";
+            entries[2].location = "/music/unindexed.mp3";
+            QVERIFY(library.savePlaylist("session", entries));
+            // Saving again replaces, not appends
+            QVERIFY(library.savePlaylist("session", entries));
+        }
+
+        MediaLibrary library;
+        QVERIFY(library.open(db));
+        auto loaded = library.loadPlaylist("session");
+        QVERIFY(loaded);
+        QVERIFY(loaded.value().has_value());
+        const auto& entries = *loaded.value();
+        QCOMPARE(entries.size(), usize{3});
+        QCOMPARE(entries[0].location, std::string("https://example.com/stream"));
+        QCOMPARE(entries[0].title, std::string("Radio"));
+        QVERIFY(!entries[0].track);
+        QVERIFY(entries[1].track.has_value());
+        QCOMPARE(entries[1].trackId, trackId);
+        QCOMPARE(entries[1].track->metadata.title, std::string("A"));
+        QCOMPARE(entries[1].track->path, fs::path("/music/a.flac"));
+        QVERIFY(!entries[2].track);
+        QCOMPARE(entries[2].location, std::string("/music/unindexed.mp3"));
+
+        // An empty playlist is still a saved one
+        QVERIFY(library.savePlaylist("empty", {}));
+        auto empty = library.loadPlaylist("empty");
+        QVERIFY(empty && empty.value().has_value() && empty.value()->empty());
+    }
+};
+
+int runTestMediaLibrary(int argc, char** argv) {
+    TestMediaLibrary tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_MediaLibrary.moc"
@@ -0,0 +1,159 @@
+#include <QtTest>
+#include <numeric>
+#include <thread>
+#include "audio/PcmRing.hpp"
+
+using namespace vc;
+
+namespace {
+// Interleaved stereo where frame i is (start + i, -(start + i))
+std::vector<f32> frames(u32 start, u32 count) {
+    std::vector<f32> out(static_cast<usize>(count) * 2);
+    for (u32 i = 0; i < count; ++i) {
+        out[i * 2] = static_cast<f32>(start + i);
+        out[i * 2 + 1] = -static_cast<f32>(start + i);
+    }
+    return out;
+}
+} // namespace
+
+class TestPcmRing : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testMarkersStopReadsAtTheirFrame() {
+        PcmRing ring(1000);
+        QCOMPARE(ring.capacity(), 1024u);
+
+        QVERIFY(ring.mark({PcmMarker::Kind::Open, 1, 0, 300}));
+        QCOMPARE(ring.write(frames(0, 300).data(), 300), 300u);
+        QVERIFY(ring.mark({PcmMarker::Kind::Next, 2, 0, 500}));
+        QCOMPARE(ring.write(frames(1000, 100).data(), 100), 100u);
+        QVERIFY(ring.mark({PcmMarker::Kind::End, 2}));
+
+        std::vector<f32> out(2048);
+        std::optional<PcmMarker> marker;
+        QCOMPARE(ring.read(out.data(), 1000, marker), 0u);
+        QVERIFY(marker && marker->kind == PcmMarker::Kind::Open && marker->track == 1);
+
+        // Audio up to the next marker only, then the marker on its own
+        QCOMPARE(ring.read(out.data(), 1000, marker), 300u);
+        QVERIFY(!marker);
+        QCOMPARE(out[299 * 2], 299.0f);
+        QCOMPARE(ring.read(out.data(), 1000, marker), 0u);
+        QVERIFY(marker && marker->kind == PcmMarker::Kind::Next && marker->trackFrames == 500u);
+
+        QCOMPARE(ring.read(out.data(), 1000, marker), 100u);
+        QCOMPARE(out[1], -1000.0f);
+        QCOMPARE(ring.read(out.data(), 1000, marker), 0u);
+        QVERIFY(marker && marker->kind == PcmMarker::Kind::End);
+        QCOMPARE(ring.read(out.data(), 1000, marker), 0u);
+        QVERIFY(!marker);
+    }
+
+    void testWriteStopsWhenFull() {
+        PcmRing ring(256);
+        QCOMPARE(ring.write(frames(0, 300).data(), 300), 256u);
+        QCOMPARE(ring.writable(), 0u);
+
+        std::vector<f32> out(200);
+        std::optional<PcmMarker> marker;
+        QCOMPARE(ring.read(out.data(), 100, marker), 100u);
+        QCOMPARE(ring.writable(), 100u);
+        QCOMPARE(ring.write(frames(256, 100).data(), 100), 100u);
+        QCOMPARE(ring.buffered(), 256u);
+    }
+
+    void testFlushDropsUnreadAudioAndMarkers() {
+        PcmRing ring(1024);
+        ring.write(frames(0, 500).data(), 500);
+        ring.mark({PcmMarker::Kind::Next, 2});
+        ring.write(frames(0, 100).data(), 100);
+
+        std::vector<f32> out(2048);
+        std::optional<PcmMarker> marker;
+        QCOMPARE(ring.read(out.data(), 200, marker), 200u);
+
+        // Seek: nothing written before the flush is played any more
+        ring.flush();
+        QVERIFY(ring.mark({PcmMarker::Kind::Seek, 1, 4000, 9000}));
+        ring.write(frames(4000, 50).data(), 50);
+
+        QCOMPARE(ring.read(out.data(), 1000, marker), 0u);
+        QVERIFY(marker && marker->kind == PcmMarker::Kind::Seek && marker->trackFrame == 4000u);
+        QCOMPARE(ring.read(out.data(), 1000, marker), 50u);
+        QCOMPARE(out[0], 4000.0f);
+        QCOMPARE(ring.buffered(), 0u);
+    }
+
+    void testZeroFrameReadOnlySyncs() {
+        PcmRing ring(1024);
+        ring.write(frames(0, 100).data(), 100);
+        ring.flush();
+        ring.mark({PcmMarker::Kind::Seek, 1, 10});
+        ring.write(frames(10, 100).data(), 100);
+
+        std::optional<PcmMarker> marker;
+        QCOMPARE(ring.read(nullptr, 0, marker), 0u);
+        QVERIFY(marker && marker->trackFrame == 10u);
+        QCOMPARE(ring.read(nullptr, 0, marker), 0u);
+        QVERIFY(!marker);
+        QCOMPARE(ring.buffered(), 100u);
+    }
+
+    void testConcurrentSeeksNeverMixAudio() {
+        PcmRing ring(256);
+        constexpr u32 total = 1u << 19;
+        constexpr u32 chunk = 64;
+
+        // Writer flushes now and then, like a decoder seeking; whatever the
+        // reader was in the middle of, it resumes exactly at the Seek marker
+        std::thread writer([&] {
+            for (u32 n = 0; n < total;) {
+                if (n % 65536 == 0) {
+                    ring.flush();
+                    while (!ring.mark({PcmMarker::Kind::Seek, 1, n}))
+                        std::this_thread::yield();
+                }
+                auto data = frames(n, chunk);
+                for (u32 done = 0; done < chunk;) {
+                    done += ring.write(data.data() + done * 2, chunk - done);
+                    std::this_thread::yield();
+                }
+                n += chunk;
+            }
+            while (!ring.mark({PcmMarker::Kind::End}))
+                std::this_thread::yield();
+        });
+
+        std::vector<f32> out(200);
+        std::optional<PcmMarker> marker;
+        u64 expected = 0;
+        bool contiguous = true;
+        usize seeks = 0;
+        while (true) {
+            const u32 n = ring.read(out.data(), 100, marker);
+            if (marker) {
+                if (marker->kind == PcmMarker::Kind::End)
+                    break;
+                expected = marker->trackFrame;
+                ++seeks;
+                continue;
+            }
+            for (u32 i = 0; i < n; ++i)
+                contiguous &= out[i * 2] == static_cast<f32>(expected++);
+        }
+        writer.join();
+
+        QVERIFY(contiguous);
+        QVERIFY(seeks >= 1);
+        QCOMPARE(expected, static_cast<u64>(total));
+    }
+};
+
+int runTestPcmRing(int argc, char** argv) {
+    TestPcmRing tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_PcmRing.moc"
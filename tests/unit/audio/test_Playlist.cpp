@@ -0,0 +1,314 @@
+#include <QTemporaryDir>
+#include <QtTest>
+#include <cmath>
+#include <fstream>
+#include <set>
+#include <thread>
+#include "audio/Playlist.hpp"
+
+using namespace vc;
+
+namespace {
+constexpr u32 RATE = 8000;
+
+// One second of silent 16-bit mono PCM
+fs::path writeWav(const QTemporaryDir& dir, const std::string& name) {
+    fs::path path = fs::path(dir.path().toStdString()) / name;
+    std::ofstream out(path, std::ios::binary);
+    auto put = [&](u32 value, int bytes) {
+        for (int i = 0; i < bytes; ++i)
+            out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    };
+    const u32 dataBytes = RATE * 2;
+    out.write("RIFF", 4);
+    put(36 + dataBytes, 4);
+    out.write("WAVEfmt ", 8);
+    put(16, 4);
+    put(1, 2); // PCM
+    put(1, 2);
+    put(RATE, 4);
+    put(RATE * 2, 4);
+    put(2, 2);
+    put(16, 2);
+    out.write("data", 4);
+    put(dataBytes, 4);
+    out << std::string(dataBytes, '\0');
+    return path;
+}
+
+// Publish batches until the loader has nothing left
+void drain(Playlist& playlist) {
+    for (int i = 0; i < 500; ++i) {
+        playlist.applyPendingMetadata();
+        if (playlist.metadataPending() == 0)
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+} // namespace
+
+class TestPlaylist : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testAddFilesInsertsPlaceholdersInOneBatch() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        std::vector<fs::path> paths;
+        for (int i = 0; i < 40; ++i)
+            paths.push_back(writeWav(dir, "track" + std::to_string(i) + ".wav"));
+        std::ofstream(fs::path(paths[3]).replace_extension(".lrc")) << "[00:00.00]hi\n";
+        paths.push_back(fs::path(dir.path().toStdString()) / "gone.wav");
+
+        Playlist playlist;
+        int addedSignals = 0;
+        int changedSignals = 0;
+        usize updatedRows = 0;
+        playlist.itemsAdded.connect([&](usize first, usize count) {
+            ++addedSignals;
+            QCOMPARE(first, usize{0});
+            QCOMPARE(count, usize{41});
+        });
+        playlist.changed.connect([&] { ++changedSignals; });
+        playlist.itemsUpdated.connect([&](const std::vector<usize>& rows) {
+            QVERIFY(std::is_sorted(rows.begin(), rows.end()));
+            updatedRows += rows.size();
+        });
+
+        playlist.addFiles(paths);
+        QCOMPARE(playlist.size(), usize{41});
+        QCOMPARE(addedSignals, 1);
+        QCOMPARE(changedSignals, 1);
+        QCOMPARE(playlist.itemAt(0)->title(), std::string("track0"));
+
+        drain(playlist);
+        QCOMPARE(updatedRows, usize{40});
+        // The missing file is dropped in one change
+        QCOMPARE(playlist.size(), usize{40});
+        QCOMPARE(changedSignals, 2);
+        for (const auto& item : playlist.items()) {
+            QVERIFY(!item.metadataPending);
+            QCOMPARE(item.metadata.duration.count(), i64{1000});
+        }
+        QVERIFY(!playlist.itemAt(3)->lyricsPath.empty());
+        QVERIFY(playlist.itemAt(4)->lyricsPath.empty());
+
+        // Ids stay unique
+        std::set<u64> ids;
+        for (const auto& item : playlist.items())
+            ids.insert(item.id);
+        QCOMPARE(ids.size(), usize{40});
+    }
+
+    void testCurrentItemIsLoadedImmediately() {
+        QTemporaryDir dir;
+        Playlist playlist;
+        playlist.addFile(writeWav(dir, "now.wav"));
+        QVERIFY(playlist.itemAt(0)->metadataPending);
+
+        QVERIFY(playlist.jumpTo(0));
+        QVERIFY(!playlist.currentItem()->metadataPending);
+        QCOMPARE(playlist.currentItem()->metadata.duration.count(), i64{1000});
+
+        // The worker's copy arrives later and changes nothing
+        drain(playlist);
+        QCOMPARE(playlist.size(), usize{1});
+    }
+
+    void testLibraryRestoresSessionWithoutReading() {
+        QTemporaryDir dir;
+        MediaLibrary library;
+        QVERIFY(library.open(fs::path(dir.path().toStdString()) / "library.db"));
+        std::vector<fs::path> paths;
+        for (int i = 0; i < 10; ++i)
+            paths.push_back(writeWav(dir, "lib" + std::to_string(i) + ".wav"));
+
+        {
+            Playlist playlist;
+            playlist.setLibrary(&library);
+            playlist.addFiles(paths);
+            playlist.addUrl("https://example.com/stream", "Radio");
+            drain(playlist);
+            QCOMPARE(library.trackCount(), usize{10});
+            QVERIFY(playlist.itemAt(0)->libraryId != 0);
+            QVERIFY(playlist.saveToLibrary("session"));
+        }
+
+        Playlist restored;
+        restored.setLibrary(&library);
+        int updates = 0;
+        restored.itemsUpdated.connect([&](const std::vector<usize>&) { ++updates; });
+        auto loaded = restored.loadFromLibrary("session");
+        QVERIFY(loaded && loaded.value());
+        QCOMPARE(restored.size(), usize{11});
+        // Tags are there before any file was read
+        QCOMPARE(restored.itemAt(0)->metadata.duration.count(), i64{1000});
+        QVERIFY(restored.itemAt(10)->isRemote);
+        QCOMPARE(restored.itemAt(10)->metadata.title, std::string("Radio"));
+
+        // Unchanged files are confirmed without an update
+        drain(restored);
+        QCOMPARE(updates, 0);
+        QVERIFY(!restored.itemAt(0)->metadataPending);
+
+        // A changed file is re-read and re-indexed
+        std::ofstream(paths[0], std::ios::app) << std::string(2 * RATE, '\0');
+        Playlist rescan;
+        rescan.setLibrary(&library);
+        rescan.addFiles({paths[0]});
+        drain(rescan);
+        QCOMPARE(library.trackCount(), usize{10});
+        QCOMPARE(library.find({paths[0]}).front()->size, fs::file_size(paths[0]));
+
+        Playlist none;
+        none.setLibrary(&library);
+        auto missing = none.loadFromLibrary("never-saved");
+        QVERIFY(missing && !missing.value());
+    }
+
+    void testLoudnessLookupAndAlbumSums() {
+        QTemporaryDir dir;
+        MediaLibrary library;
+        QVERIFY(library.open(fs::path(dir.path().toStdString()) / "library.db"));
+        // Tagged in the library under a stale stamp: listed with the album,
+        // then re-read without one
+        std::vector<LibraryTrack> tracks(3);
+        std::vector<fs::path> paths;
+        for (int i = 0; i < 3; ++i) {
+            paths.push_back(writeWav(dir, "album" + std::to_string(i) + ".wav"));
+            tracks[i].path = paths.back();
+            tracks[i].metadata.title = "Song " + std::to_string(i);
+            tracks[i].metadata.artist = "Artist";
+            tracks[i].metadata.album = i < 2 ? "Album" : "Other";
+        }
+        QVERIFY(library.store(tracks));
+
+        Playlist playlist;
+        playlist.setLibrary(&library);
+        playlist.addFiles(paths);
+        QVERIFY(playlist.findLocal(paths[1]) == playlist.itemAt(1));
+        QVERIFY(!playlist.findLocal(fs::path(dir.path().toStdString()) / "none.wav"));
+        QVERIFY(!playlist.albumLoudness(*playlist.itemAt(0)));
+
+        // -20 and -10 LUFS for equal time: the power mean, not the average
+        playlist.setLoudness(paths[0], {-20.0f, -8.0f, 0.0f, 60.0f});
+        auto album = playlist.albumLoudness(*playlist.itemAt(1));
+        QVERIFY(album);
+        QVERIFY(std::abs(album->integratedLufs + 20.0) < 1e-6);
+        playlist.setLoudness(paths[1], {-10.0f, -2.0f, 0.0f, 60.0f});
+        album = playlist.albumLoudness(*playlist.itemAt(0));
+        QVERIFY(album);
+        QVERIFY(std::abs(album->integratedLufs - 10.0 * std::log10((0.01 + 0.1) / 2.0)) < 1e-6);
+        QCOMPARE(album->truePeakDbtp, -2.0f);
+        // Silence doesn't pull it down
+        playlist.setLoudness(paths[2], {LOUDNESS_SILENCE_LUFS, -96.0f, 0.0f, 60.0f});
+        QVERIFY(!playlist.albumLoudness(*playlist.itemAt(2)));
+
+        // Removing a track updates its album
+        playlist.removeAt(1);
+        album = playlist.albumLoudness(*playlist.itemAt(0));
+        QVERIFY(album);
+        QVERIFY(std::abs(album->integratedLufs + 20.0) < 1e-6);
+        QVERIFY(!playlist.findLocal(paths[1]));
+
+        // The files carry no tags: once read, no album is left
+        drain(playlist);
+        QVERIFY(playlist.itemAt(0)->metadata.album.empty());
+        QVERIFY(!playlist.albumLoudness(*playlist.itemAt(0)));
+        QVERIFY(playlist.findLocal(paths[0])->metadata.loudness);
+    }
+
+    void testEditsKeepCurrentAndEmitRowSignals() {
+        Playlist playlist;
+        for (int i = 0; i < 5; ++i)
+            playlist.addUrl("https://example.com/" + std::to_string(i));
+        std::vector<std::pair<usize, usize>> moved;
+        std::vector<std::pair<usize, usize>> removed;
+        playlist.itemMoved.connect([&](usize from, usize to) { moved.emplace_back(from, to); });
+        playlist.itemsRemoved.connect([&](usize first, usize count) { removed.emplace_back(first, count); });
+
+        QVERIFY(playlist.jumpTo(2));
+        const u64 current = playlist.currentItem()->id;
+        playlist.move(2, 0);
+        QCOMPARE(moved.size(), usize{1});
+        QCOMPARE(moved[0], (std::pair<usize, usize>{2, 0}));
+        QCOMPARE(playlist.currentIndex(), std::optional<usize>{0});
+        QCOMPARE(playlist.currentItem()->id, current);
+
+        playlist.removeAt(4);
+        QCOMPARE(removed.back(), (std::pair<usize, usize>{4, 1}));
+        QCOMPARE(playlist.currentIndex(), std::optional<usize>{0});
+        playlist.move(0, 3);
+        QCOMPARE(playlist.currentIndex(), std::optional<usize>{3});
+        playlist.removeAt(3);
+        QVERIFY(!playlist.currentIndex());
+
+        playlist.clear();
+        QCOMPARE(removed.back(), (std::pair<usize, usize>{0, 3}));
+    }
+
+    void testShuffleOrderSurvivesEdits() {
+        Playlist playlist;
+        for (int i = 0; i < 20; ++i)
+            playlist.addUrl("https://example.com/" + std::to_string(i));
+        playlist.setShuffle(true);
+
+        std::vector<u64> played;
+        for (int i = 0; i < 5; ++i) {
+            QVERIFY(playlist.next());
+            played.push_back(playlist.currentItem()->id);
+        }
+
+        // Edits mid-round: drop an unplayed track, add two, reorder
+        usize unplayed = 0;
+        while (std::ranges::find(played, playlist.itemAt(unplayed)->id) != played.end())
+            ++unplayed;
+        const u64 dropped = playlist.itemAt(unplayed)->id;
+        playlist.removeAt(unplayed);
+        playlist.addUrl("https://example.com/new1");
+        playlist.addUrl("https://example.com/new2");
+        playlist.move(0, playlist.size() - 1);
+        QCOMPARE(playlist.currentItem()->id, played.back());
+
+        // Back through the history, then forward again
+        QVERIFY(playlist.previous());
+        QCOMPARE(playlist.currentItem()->id, played[3]);
+        QVERIFY(playlist.next());
+        QCOMPARE(playlist.currentItem()->id, played[4]);
+
+        // The rest of the round plays everything else exactly once
+        while (playlist.peekNext()) {
+            const usize expected = *playlist.peekNext();
+            QVERIFY(playlist.next());
+            QCOMPARE(playlist.currentIndex(), std::optional<usize>{expected});
+            played.push_back(playlist.currentItem()->id);
+        }
+        QVERIFY(!playlist.next());
+        QCOMPARE(played.size(), playlist.size());
+        std::set<u64> unique(played.begin(), played.end());
+        QCOMPARE(unique.size(), playlist.size());
+        QVERIFY(!unique.contains(dropped));
+    }
+
+    void testClearDropsQueuedWork() {
+        QTemporaryDir dir;
+        std::vector<fs::path> paths;
+        for (int i = 0; i < 20; ++i)
+            paths.push_back(writeWav(dir, std::to_string(i) + ".wav"));
+
+        Playlist playlist;
+        playlist.addFiles(paths);
+        playlist.clear();
+        playlist.addFile(paths[0]);
+        drain(playlist);
+        QCOMPARE(playlist.size(), usize{1});
+        QVERIFY(!playlist.itemAt(0)->metadataPending);
+    }
+};
+
+int runTestPlaylist(int argc, char** argv) {
+    TestPlaylist tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_Playlist.moc"
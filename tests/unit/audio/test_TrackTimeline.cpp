@@ -0,0 +1,100 @@
+#include <QTemporaryDir>
+#include <QtTest>
+#include <cmath>
+#include "audio/AudioAnalyzer.hpp"
+#include "audio/analysis/TrackTimeline.hpp"
+
+using namespace vc;
+
+namespace {
+constexpr u32 RATE = 44100;
+constexpr u32 HOP = 441; // 100 hops per second keeps the arithmetic readable
+
+// Stereo hop at a constant amplitude
+std::vector<f32> hopAt(f32 amplitude) {
+    return std::vector<f32>(HOP * 2, amplitude);
+}
+} // namespace
+
+class TestTrackTimeline : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testQuantizationRoundTrips() {
+        for (f32 db : {-96.0f, -60.0f, -12.3f, 0.0f}) {
+            QVERIFY(std::abs(dequantizeDb(quantizeDb(db)) - db) <= TIMELINE_DB_STEP / 2);
+        }
+        QCOMPARE(quantizeDb(-200.0f), u8{0});
+        QCOMPARE(quantizeDb(40.0f), u8{255});
+    }
+
+    void testWriteMapAndQuery() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const fs::path file = fs::path(dir.path().toStdString()) / "t.cvtl";
+
+        // 30 s quiet, 30 s loud: one section boundary at 30 s. A beat every
+        // half second, band 0 onset on each.
+        TimelineBuilder builder(RATE, HOP, 2048);
+        AudioSpectrum spectrum;
+        spectrum.bins = 1025;
+        spectrum.binHz = static_cast<f32>(RATE) / 2048;
+        spectrum.bpm = 120.0f;
+        const u32 hops = 6000;
+        for (u32 h = 0; h < hops; ++h) {
+            const bool beat = h % 50 == 0;
+            spectrum.beatDetected = spectrum.onset = beat;
+            spectrum.bandOnsets = {beat, false, false, false};
+            spectrum.beatPhase = static_cast<f32>(h % 50) / 50.0f;
+            spectrum.magnitudes.fill(h < 3000 ? 0.001f : 0.1f);
+            builder.addHop(spectrum, hopAt(h < 3000 ? 0.01f : 0.5f));
+        }
+        QVERIFY(builder.write(file, 0x1234, u64{hops} * HOP));
+
+        auto opened = TrackTimeline::open(file);
+        QVERIFY(opened);
+        TrackTimeline timeline = std::move(opened).value();
+        QCOMPARE(timeline.header().contentHash, u64{0x1234});
+        QCOMPARE(timeline.hops().size(), usize{hops});
+        QCOMPARE(timeline.duration(), Duration(60'000));
+        QCOMPARE(timeline.header().bpm, 120.0f);
+
+        // Loudness per hop: 0.01 -> -40 dBFS, 0.5 -> ~-6 dBFS
+        QVERIFY(std::abs(timeline.at(Duration(10'000)).loudnessDb + 40.0f) < 0.5f);
+        QVERIFY(std::abs(timeline.at(Duration(45'000)).loudnessDb + 6.0f) < 0.5f);
+        QVERIFY(timeline.at(Duration(45'000)).bandDb[1] > timeline.at(Duration(10'000)).bandDb[1]);
+
+        // Beats and onsets land on their hop, phase is kept
+        auto onBeat = timeline.at(Duration(20'000));
+        QVERIFY(onBeat.beat && onBeat.onset && onBeat.bandOnsets[0] && !onBeat.bandOnsets[1]);
+        auto offBeat = timeline.at(Duration(20'250));
+        QVERIFY(!offBeat.beat && !offBeat.onset);
+        QVERIFY(std::abs(offBeat.beatPhase - 0.5f) < 0.01f);
+
+        QCOMPARE(timeline.sections().size(), usize{2});
+        QCOMPARE(timeline.sections()[1].startHop, 3000u);
+        QCOMPARE(&timeline.sectionAt(Duration(5'000)), &timeline.sections()[0]);
+        QCOMPARE(&timeline.sectionAt(Duration(59'000)), &timeline.sections()[1]);
+        QVERIFY(timeline.sections()[1].loudnessDb > timeline.sections()[0].loudnessDb + 20.0f);
+        QCOMPARE(timeline.sections()[0].bpm, 120.0f);
+
+        // Past the end clamps to the last hop
+        QCOMPARE(timeline.hopIndex(u64{hops} * HOP * 2), hops - 1);
+    }
+
+    void testRejectsForeignFiles() {
+        QTemporaryDir dir;
+        const fs::path file = fs::path(dir.path().toStdString()) / "junk.cvtl";
+        QVERIFY(!TrackTimeline::open(file));
+
+        std::ofstream(file, std::ios::binary) << std::string(200, 'x');
+        QVERIFY(!TrackTimeline::open(file));
+    }
+};
+
+int runTestTrackTimeline(int argc, char** argv) {
+    TestTrackTimeline tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_TrackTimeline.moc"
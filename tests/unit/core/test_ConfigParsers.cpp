@@ -24,6 +24,47 @@ private slots:
         QCOMPARE(cfg.bufferSize, 1024u);
     }
 
+    void testParseAudioAnalysis() {
+        auto tbl = toml::parse(R"(
+            [audio]
+            fft_size = 3000
+            fft_hop = 8192
+            fft_window = "blackman-harris"
+            bass_fft_size = 0
+        )");
+
+        AudioConfig cfg;
+        ConfigParsers::parseAudio(tbl, cfg);
+
+        QCOMPARE(cfg.fftSize, 2048u);  // rounded down to a power of two
+        QCOMPARE(cfg.fftHop, 2048u);   // never more than one window
+        QCOMPARE(cfg.fftWindow, std::string("blackman-harris"));
+        QCOMPARE(cfg.bassFftSize, 0u);
+    }
+
+    void testParseAudioNormalization() {
+        auto tbl = toml::parse(R"(
+            [audio]
+            normalization = "album"
+            normalization_target = -60.0
+            loudness_threads = 4
+        )");
+
+        AudioConfig cfg;
+        ConfigParsers::parseAudio(tbl, cfg);
+
+        QCOMPARE(cfg.normalization, std::string("album"));
+        QCOMPARE(cfg.normalizationTarget, -40.0f); // clamped
+        QCOMPARE(cfg.loudnessThreads, 4u);
+
+        auto bad = toml::parse(R"(
+            [audio]
+            normalization = "loud"
+        )");
+        ConfigParsers::parseAudio(bad, cfg);
+        QCOMPARE(cfg.normalization, std::string("track"));
+    }
+
     void testParseVisualizer() {
         auto tbl = toml::parse(R"(
             [visualizer]
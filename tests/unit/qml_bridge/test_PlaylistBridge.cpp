@@ -0,0 +1,180 @@
+#include <QAbstractItemModelTester>
+#include <QSignalSpy>
+#include <QtTest>
+#include <memory>
+#include <string>
+#include "audio/Playlist.hpp"
+#include "qml_bridge/PlaylistBridge.hpp"
+
+using namespace vc;
+using qml_bridge::PlaylistBridge;
+
+namespace {
+// A bridge on its own playlist, checked by QAbstractItemModelTester after
+// every notification. Rows are remote items titled by insertion order, so
+// a row in the wrong place shows up as the wrong title.
+struct Fixture {
+    Playlist playlist;
+    PlaylistBridge bridge;
+    std::unique_ptr<QAbstractItemModelTester> tester;
+    int added{0};
+
+    Fixture() {
+        PlaylistBridge::setPlaylist(&playlist);
+        tester = std::make_unique<QAbstractItemModelTester>(
+                &bridge, QAbstractItemModelTester::FailureReportingMode::QtTest);
+    }
+
+    ~Fixture() {
+        PlaylistBridge::setPlaylist(nullptr);
+    }
+
+    void add(int count) {
+        for (int i = 0; i < count; ++i, ++added)
+            playlist.addUrl("http://example.com/" + std::to_string(added), "t" + std::to_string(added));
+    }
+
+    // What the frame timer would do
+    void flush() {
+        QMetaObject::invokeMethod(&bridge, "flushPending", Qt::DirectConnection);
+    }
+
+    // Every row views know about shows the playlist item at that row
+    bool shownRowsMatch() const {
+        if (bridge.rowCount() > static_cast<int>(playlist.size()))
+            return false;
+        for (int row = 0; row < bridge.rowCount(); ++row) {
+            const QString title =
+                    bridge.data(bridge.index(row), PlaylistBridge::TitleRole).toString();
+            if (title.toStdString() != playlist.items()[row].metadata.displayTitle())
+                return false;
+        }
+        return true;
+    }
+
+    bool matches() const {
+        return bridge.rowCount() == static_cast<int>(playlist.size()) && shownRowsMatch();
+    }
+};
+} // namespace
+
+class TestPlaylistBridge : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testTailInsertsWaitForTheFrame() {
+        Fixture f;
+        f.add(3);
+        f.flush();
+        QVERIFY(f.matches());
+
+        // A burst of appends is one insert on the next flush
+        QSignalSpy inserted(&f.bridge, &QAbstractItemModel::rowsInserted);
+        f.add(4);
+        QCOMPARE(f.bridge.rowCount(), 3);
+        QCOMPARE(inserted.count(), 0);
+        QVERIFY(f.shownRowsMatch());
+        f.flush();
+        QCOMPARE(inserted.count(), 1);
+        QCOMPARE(inserted[0][1].toInt(), 3);
+        QCOMPARE(inserted[0][2].toInt(), 6);
+        QVERIFY(f.matches());
+    }
+
+    void testMovesAcrossTheTail() {
+        Fixture f;
+        f.add(4);
+        f.flush();
+        f.add(2); // rows 4 and 5 are pending
+
+        // Out of the shown rows into the tail: removed now, shown on flush
+        f.playlist.move(1, 5);
+        QCOMPARE(f.bridge.rowCount(), 3);
+        QVERIFY(f.shownRowsMatch());
+
+        // Out of the tail into the shown rows: inserted now
+        f.playlist.move(4, 0);
+        QCOMPARE(f.bridge.rowCount(), 4);
+        QVERIFY(f.shownRowsMatch());
+
+        // Within the tail: nothing to tell views yet
+        QSignalSpy moved(&f.bridge, &QAbstractItemModel::rowsMoved);
+        f.playlist.move(5, 4);
+        QCOMPARE(f.bridge.rowCount(), 4);
+        QCOMPARE(moved.count(), 0);
+
+        // Among shown rows: a real move
+        f.playlist.move(0, 3);
+        QCOMPARE(moved.count(), 1);
+        QVERIFY(f.shownRowsMatch());
+
+        f.flush();
+        QVERIFY(f.matches());
+    }
+
+    void testRemovesFromTheTail() {
+        Fixture f;
+        f.add(3);
+        f.flush();
+        f.add(3); // rows 3..5 pending
+
+        // A pending row was never shown, so there's nothing to remove
+        QSignalSpy removed(&f.bridge, &QAbstractItemModel::rowsRemoved);
+        f.playlist.removeAt(4);
+        QCOMPARE(removed.count(), 0);
+        QCOMPARE(f.bridge.rowCount(), 3);
+
+        f.playlist.removeAt(1);
+        QCOMPARE(removed.count(), 1);
+        QCOMPARE(f.bridge.rowCount(), 2);
+        QVERIFY(f.shownRowsMatch());
+
+        f.flush();
+        QCOMPARE(f.bridge.rowCount(), 4);
+        QVERIFY(f.matches());
+
+        // Clearing with a pending tail removes only the shown rows
+        f.add(2);
+        f.playlist.clear();
+        QCOMPARE(f.bridge.rowCount(), 0);
+        f.flush();
+        QVERIFY(f.matches());
+    }
+
+    void testUpdatesMergeIntoRuns() {
+        Fixture f;
+        f.add(10);
+        f.flush();
+
+        QSignalSpy changed(&f.bridge, &QAbstractItemModel::dataChanged);
+        f.playlist.itemsUpdated.emitSignal({5, 3});
+        f.playlist.itemsUpdated.emitSignal({4, 9, 4});
+        QCOMPARE(changed.count(), 0);
+        f.flush();
+        QCOMPARE(changed.count(), 2);
+        QCOMPARE(changed[0][0].value<QModelIndex>().row(), 3);
+        QCOMPARE(changed[0][1].value<QModelIndex>().row(), 5);
+        QCOMPARE(changed[1][0].value<QModelIndex>().row(), 9);
+        QCOMPARE(changed[1][1].value<QModelIndex>().row(), 9);
+
+        // Queued rows follow structural edits; removed or pending ones drop
+        changed.clear();
+        f.add(1); // row 10, pending
+        f.playlist.itemsUpdated.emitSignal({2, 6, 7, 10});
+        f.playlist.removeAt(2);
+        f.playlist.move(0, 8);
+        f.flush();
+        // 6 and 7 became 5 and 6 after the remove, then 4 and 5 after the move
+        QCOMPARE(changed.count(), 1);
+        QCOMPARE(changed[0][0].value<QModelIndex>().row(), 4);
+        QCOMPARE(changed[0][1].value<QModelIndex>().row(), 5);
+        QVERIFY(f.matches());
+    }
+};
+
+int runTestPlaylistBridge(int argc, char** argv) {
+    TestPlaylistBridge tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_PlaylistBridge.moc"
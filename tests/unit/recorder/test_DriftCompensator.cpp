@@ -0,0 +1,108 @@
+#include <QtTest>
+#include <cmath>
+#include "recorder/RecordingClock.hpp"
+
+using namespace vc;
+
+namespace {
+constexpr u32 RATE = 48000;
+constexpr i64 STEP_US = 10'000;
+constexpr i64 START_US = 5'000'000;
+
+struct Run {
+    std::vector<i64> deltas; // one per update
+    i64 compensated{0};
+};
+
+// `seconds` of batches every STEP_US from a device running `ppm` slow
+// (negative: fast), `startFrames` already produced at the first report
+Run drive(DriftCompensator& compensator, f64 ppm, f64 seconds, u64 startFrames = 0) {
+    Run run;
+    const f64 rate = RATE * (1.0 - ppm * 1e-6);
+    for (i64 t = 0; t <= static_cast<i64>(seconds * 1e6); t += STEP_US) {
+        const auto frames = startFrames + static_cast<u64>(std::floor(rate * t / 1e6));
+        run.deltas.push_back(compensator.update(frames, START_US + t));
+    }
+    run.compensated = compensator.compensatedFrames();
+    return run;
+}
+} // namespace
+
+class TestDriftCompensator : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testNothingDuringWarmup() {
+        DriftCompensator compensator;
+        compensator.start(RATE);
+        const Run run = drive(compensator, 1000.0, 9.99);
+        QVERIFY(std::ranges::all_of(run.deltas, [](i64 delta) { return delta == 0; }));
+        QCOMPARE(run.compensated, i64{0});
+        QCOMPARE(compensator.ppm(), 0.0);
+    }
+
+    void testRateIsCapped() {
+        // 1000 ppm off falls behind faster than MAX_PPM catches up: once the
+        // error filter has ramped up (a few intervals past the warm-up)
+        // every interval adds (or drops) exactly the cap, and nothing
+        // happens between intervals
+        const auto limit = static_cast<i64>(DriftCompensator::MAX_PPM * 1e-6 * RATE);
+        constexpr usize PER_INTERVAL = DriftCompensator::INTERVAL_US / STEP_US;
+        for (f64 ppm : {1000.0, -1000.0}) {
+            DriftCompensator compensator;
+            compensator.start(RATE);
+            const Run run = drive(compensator, ppm, 70.0);
+            const i64 sign = ppm > 0.0 ? 1 : -1;
+            usize intervals = 0;
+            i64 previous = 0;
+            for (usize i = 0; i < run.deltas.size(); ++i) {
+                const i64 delta = run.deltas[i] * sign;
+                if (i % PER_INTERVAL != 0 || i < 10 * PER_INTERVAL) {
+                    QCOMPARE(delta, i64{0});
+                    continue;
+                }
+                QVERIFY(delta > 0 && delta <= limit);
+                QVERIFY(delta >= previous);
+                if (i >= 15 * PER_INTERVAL)
+                    QCOMPARE(delta, limit);
+                previous = delta;
+                ++intervals;
+            }
+            QCOMPARE(intervals, usize{61});
+            QCOMPARE(compensator.ppm(), sign * DriftCompensator::MAX_PPM);
+        }
+    }
+
+    void testConvergesOnTheSlope() {
+        // 100 ppm slow: 4.8 frames a second go missing
+        constexpr f64 PPM = 100.0;
+        constexpr f64 SECONDS = 600.0;
+        const f64 missing = RATE * PPM * 1e-6 * SECONDS;
+
+        DriftCompensator compensator;
+        compensator.start(RATE);
+        const Run run = drive(compensator, PPM, SECONDS);
+        // Filtering lags the slope by a few tens of seconds
+        QVERIFY2(std::abs(static_cast<f64>(run.compensated) - missing) < missing * 0.05,
+                 qPrintable(QString("%1 of %2 frames").arg(run.compensated).arg(missing)));
+        QVERIFY(compensator.ppm() > 0.0 && compensator.ppm() < 2.0 * PPM);
+
+        // Start-up latency already in the first report is not drift
+        DriftCompensator offset;
+        offset.start(RATE);
+        const Run late = drive(offset, PPM, SECONDS, RATE / 10);
+        QCOMPARE(late.compensated, run.compensated);
+
+        // A device on time gets nothing
+        DriftCompensator exact;
+        exact.start(RATE);
+        QCOMPARE(drive(exact, 0.0, SECONDS, RATE / 10).compensated, i64{0});
+    }
+};
+
+int runTestDriftCompensator(int argc, char** argv) {
+    TestDriftCompensator tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_DriftCompensator.moc"
@@ -0,0 +1,162 @@
+#include <QtTest>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "recorder/FramePool.hpp"
+
+using namespace vc;
+
+class TestFramePool : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testLeaseUntilExhausted() {
+        auto pool = FramePool::create(1000, 4, FrameFormat::I420);
+        QCOMPARE(pool->slotCount(), u32{4});
+
+        std::vector<FrameRef> leased;
+        for (int i = 0; i < 4; ++i) {
+            leased.push_back(pool->acquire());
+            QVERIFY(leased.back());
+            QCOMPARE(leased.back().size(), usize{1000});
+            QCOMPARE(leased.back().format(), FrameFormat::I420);
+            QCOMPARE(reinterpret_cast<uintptr_t>(leased.back().data()) % FRAME_POOL_ALIGNMENT,
+                     uintptr_t{0});
+        }
+        QCOMPARE(pool->inUse(), u32{4});
+
+        // Full: fails and counts instead of allocating
+        QVERIFY(!pool->acquire());
+        QCOMPARE(pool->exhaustedCount(), u64{1});
+
+        // A released slot is the next one handed out
+        u8* freed = leased[2].data();
+        leased[2].reset();
+        QVERIFY(!leased[2]);
+        QCOMPARE(pool->inUse(), u32{3});
+        auto again = pool->acquire();
+        QCOMPARE(again.data(), freed);
+
+        leased.clear();
+        again.reset();
+        QCOMPARE(pool->inUse(), u32{0});
+        QCOMPARE(pool->peakInUse(), u32{4});
+    }
+
+    void testCopiesShareOneSlot() {
+        auto pool = FramePool::create(64, 2);
+        auto a = pool->acquire();
+        a.data()[0] = 42;
+
+        FrameRef b = a;
+        QCOMPARE(b.data(), a.data());
+        QCOMPARE(pool->inUse(), u32{1});
+        a.reset();
+        // Still leased through the copy
+        QCOMPARE(pool->inUse(), u32{1});
+        QCOMPARE(b.data()[0], u8{42});
+
+        FrameRef c = std::move(b);
+        QVERIFY(!b);
+        QCOMPARE(pool->inUse(), u32{1});
+
+        // Assigning over a lease releases it
+        FrameRef d = pool->acquire();
+        QCOMPARE(pool->inUse(), u32{2});
+        d = c;
+        QCOMPARE(pool->inUse(), u32{1});
+        c = std::move(d);
+        QCOMPARE(pool->inUse(), u32{1});
+        c.reset();
+        QCOMPARE(pool->inUse(), u32{0});
+    }
+
+    void testLeaseKeepsPoolAlive() {
+        auto pool = FramePool::create(64, 1);
+        std::weak_ptr<FramePool> weak = pool;
+        auto frame = pool->acquire();
+        pool.reset();
+        QVERIFY(!weak.expired());
+        frame.data()[63] = 1;
+        frame.reset();
+        QVERIFY(weak.expired());
+    }
+
+    void testFailedSlotsArentInUse() {
+        // No allocator hands out 4 EiB
+        auto pool = FramePool::create(usize{1} << 62, 2);
+        QCOMPARE(pool->slotCount(), u32{0});
+        QCOMPARE(pool->inUse(), u32{0});
+        QVERIFY(!pool->acquire());
+        QCOMPARE(pool->exhaustedCount(), u64{1});
+    }
+
+    // Capture thread leases and fills, encoder thread checks and drops
+    void testProducerConsumerStress() {
+        constexpr u32 SLOTS = 4;
+        constexpr u32 FRAMES = 20000;
+        auto pool = FramePool::create(256, SLOTS);
+
+        std::deque<FrameRef> queue;
+        std::mutex mutex;
+        std::condition_variable ready;
+        bool done = false;
+        std::atomic<u32> corrupt{0};
+        u32 consumed = 0;
+
+        std::thread consumer([&] {
+            for (;;) {
+                std::unique_lock lock(mutex);
+                ready.wait(lock, [&] { return !queue.empty() || done; });
+                if (queue.empty())
+                    return;
+                FrameRef frame = std::move(queue.front());
+                queue.pop_front();
+                lock.unlock();
+                const u8 tag = frame.data()[0];
+                for (usize i = 1; i < frame.size(); ++i) {
+                    if (frame.data()[i] != tag)
+                        ++corrupt;
+                }
+                ++consumed;
+            }
+        });
+
+        u32 sent = 0;
+        while (sent < FRAMES) {
+            auto frame = pool->acquire();
+            if (!frame) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::memset(frame.data(), static_cast<int>(sent & 0xFF), frame.size());
+            {
+                std::lock_guard lock(mutex);
+                queue.push_back(std::move(frame));
+            }
+            ready.notify_one();
+            ++sent;
+        }
+        {
+            std::lock_guard lock(mutex);
+            done = true;
+        }
+        ready.notify_one();
+        consumer.join();
+
+        QCOMPARE(consumed, FRAMES);
+        QCOMPARE(corrupt.load(), u32{0});
+        QCOMPARE(pool->inUse(), u32{0});
+        QVERIFY(pool->peakInUse() <= SLOTS);
+    }
+};
+
+int runTestFramePool(int argc, char** argv) {
+    TestFramePool tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_FramePool.moc"
@@ -0,0 +1,87 @@
+#include <QtTest>
+#include <cmath>
+#include "recorder/RecordingClock.hpp"
+
+using namespace vc;
+
+namespace {
+constexpr u32 RATE = 48000;
+constexpr i64 START_US = 5'000'000;
+constexpr i64 PERIOD_US = 5'000; // audio stage poll interval
+constexpr u64 PERIOD_FRAMES = RATE * PERIOD_US / 1'000'000;
+} // namespace
+
+class TestRecordingClock : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testFollowsWallTimeUntilAnchored() {
+        RecordingClock clock;
+        clock.start(START_US);
+        QCOMPARE(clock.mediaTimeUs(START_US), i64{0});
+        QCOMPARE(clock.mediaTimeUs(START_US + 2'500'000), i64{2'500'000});
+        QCOMPARE(clock.audioDriftUs(), i64{0});
+
+        // A zero rate is ignored rather than taken as an anchor
+        clock.anchorAudio(RATE, 0, START_US + 1'000'000);
+        QCOMPARE(clock.mediaTimeUs(START_US + 2'500'000), i64{2'500'000});
+    }
+
+    void testFirstAnchorSnaps() {
+        RecordingClock clock;
+        clock.start(START_US);
+        // Audio reached 2 s only 50 ms late: no smoothing on the first anchor
+        clock.anchorAudio(2 * RATE, RATE, START_US + 2'050'000);
+        QCOMPARE(clock.mediaTimeUs(START_US + 2'050'000), i64{2'000'000});
+        QCOMPARE(clock.mediaTimeUs(START_US + 3'050'000), i64{3'000'000});
+        QCOMPARE(clock.audioDriftUs(), i64{50'000});
+    }
+
+    void testBurstyAnchorsAreSmoothed() {
+        RecordingClock clock;
+        clock.start(START_US);
+        u64 position = 0;
+        i64 wallUs = START_US;
+        clock.anchorAudio(position, RATE, wallUs);
+
+        // A single anchor 10 ms late nudges the offset by a small fraction
+        // of that, not all of it
+        position += PERIOD_FRAMES;
+        wallUs += PERIOD_US;
+        clock.anchorAudio(position, RATE, wallUs + 10'000);
+        const i64 moved = wallUs - START_US - clock.mediaTimeUs(wallUs);
+        QVERIFY(moved > 0 && moved < 1'000);
+
+        // Device-period bursts: anchors alternately 2 ms early and late
+        // around a steady clock settle on the mean
+        for (int i = 0; i < 2000; ++i) {
+            position += PERIOD_FRAMES;
+            wallUs += PERIOD_US;
+            clock.anchorAudio(position, RATE, wallUs + (i % 2 == 0 ? 2'000 : -2'000));
+            if (i >= 500)
+                QVERIFY(std::abs(clock.mediaTimeUs(wallUs) - (wallUs - START_US)) < 100);
+        }
+    }
+
+    void testDriftSign() {
+        // 1000 ppm slow: 10 s of wall time yields 9.99 s of audio
+        RecordingClock slow;
+        slow.start(START_US);
+        slow.anchorAudio(0, RATE, START_US);
+        slow.anchorAudio(RATE * 10 - RATE / 100, RATE, START_US + 10'000'000);
+        QCOMPARE(slow.audioDriftUs(), i64{10'000});
+
+        RecordingClock fast;
+        fast.start(START_US);
+        fast.anchorAudio(0, RATE, START_US);
+        fast.anchorAudio(RATE * 10 + RATE / 100, RATE, START_US + 10'000'000);
+        QCOMPARE(fast.audioDriftUs(), i64{-10'000});
+    }
+};
+
+int runTestRecordingClock(int argc, char** argv) {
+    TestRecordingClock tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_RecordingClock.moc"
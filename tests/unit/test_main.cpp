@@ -3,6 +3,27 @@
 
 int runTestLogger(int argc, char** argv);
 int runTestConfigParsers(int argc, char** argv);
+int runTestAudioQueue(int argc, char** argv);
+int runTestBeatTracker(int argc, char** argv);
+int runTestAudioDecoder(int argc, char** argv);
+int runTestPcmRing(int argc, char** argv);
+int runTestTrackTimeline(int argc, char** argv);
+int runTestLoudnessMeter(int argc, char** argv);
+int runTestPlaylist(int argc, char** argv);
+int runTestAlbumArtStore(int argc, char** argv);
+int runTestMediaLibrary(int argc, char** argv);
+int runTestFramePool(int argc, char** argv);
+int runTestDriftCompensator(int argc, char** argv);
+int runTestRecordingClock(int argc, char** argv);
+int runTestSequenceTree(int argc, char** argv);
+int runTestPresetIndex(int argc, char** argv);
+int runTestPresetSearch(int argc, char** argv);
+int runTestWeightedSampler(int argc, char** argv);
+int runTestSpscQueue(int argc, char** argv);
+int runTestTripleBuffer(int argc, char** argv);
+int runTestPresetShuffle(int argc, char** argv);
+int runTestPresetProfiler(int argc, char** argv);
+int runTestPlaylistBridge(int argc, char** argv);
 
 int main(int argc, char* argv[]) {
     QCoreApplication app(argc, argv);
@@ -10,6 +31,27 @@ int main(int argc, char* argv[]) {
     int status = 0;
     status |= runTestLogger(argc, argv);
     status |= runTestConfigParsers(argc, argv);
+    status |= runTestAudioQueue(argc, argv);
+    status |= runTestBeatTracker(argc, argv);
+    status |= runTestAudioDecoder(argc, argv);
+    status |= runTestPcmRing(argc, argv);
+    status |= runTestTrackTimeline(argc, argv);
+    status |= runTestLoudnessMeter(argc, argv);
+    status |= runTestPlaylist(argc, argv);
+    status |= runTestAlbumArtStore(argc, argv);
+    status |= runTestMediaLibrary(argc, argv);
+    status |= runTestFramePool(argc, argv);
+    status |= runTestDriftCompensator(argc, argv);
+    status |= runTestRecordingClock(argc, argv);
+    status |= runTestSequenceTree(argc, argv);
+    status |= runTestPresetIndex(argc, argv);
+    status |= runTestPresetSearch(argc, argv);
+    status |= runTestWeightedSampler(argc, argv);
+    status |= runTestSpscQueue(argc, argv);
+    status |= runTestTripleBuffer(argc, argv);
+    status |= runTestPresetShuffle(argc, argv);
+    status |= runTestPresetProfiler(argc, argv);
+    status |= runTestPlaylistBridge(argc, argv);
 
     return status;
 }
@@ -0,0 +1,101 @@
+#include <QtTest>
+#include <random>
+#include "util/SequenceTree.hpp"
+
+using namespace vc;
+
+class TestSequenceTree : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testPositionalEdits() {
+        SequenceTree<int> tree;
+        QVERIFY(tree.empty());
+        tree.pushBack(1);
+        tree.pushBack(3);
+        tree.insert(1, 2);
+        tree.insert(0, 0);
+        QCOMPARE(tree.size(), usize{4});
+
+        std::vector<int> seen(tree.begin(), tree.end());
+        QCOMPARE(seen, (std::vector<int>{0, 1, 2, 3}));
+
+        QCOMPARE(tree.erase(1), 1);
+        tree.move(0, 2);
+        seen.assign(tree.begin(), tree.end());
+        QCOMPARE(seen, (std::vector<int>{2, 3, 0}));
+        QCOMPARE(tree[2], 0);
+
+        tree.clear();
+        QVERIFY(tree.empty());
+        QVERIFY(tree.begin() == tree.end());
+    }
+
+    void testHandlesSurviveEdits() {
+        SequenceTree<int> tree;
+        const auto a = tree.pushBack(10);
+        const auto b = tree.pushBack(20);
+        const auto c = tree.pushBack(30);
+        QCOMPARE(tree.indexOf(c), usize{2});
+
+        tree.insert(0, 5);
+        QCOMPARE(tree.indexOf(a), usize{1});
+        tree.move(3, 0);
+        QCOMPARE(tree.indexOf(c), usize{0});
+        QCOMPARE(tree.get(c), 30);
+        QCOMPARE(tree.handleAt(tree.indexOf(b)), b);
+
+        QCOMPARE(tree.eraseHandle(a), 10);
+        QVERIFY(!tree.contains(a));
+        QVERIFY(tree.contains(b));
+        QCOMPARE(tree.indexOf(b), usize{2});
+    }
+
+    // Random edits mirrored on a std::vector of (value, handle)
+    void testMatchesVectorUnderRandomEdits() {
+        SequenceTree<int> tree;
+        std::vector<std::pair<int, SequenceTree<int>::Handle>> model;
+        std::mt19937 rng(1234);
+        int next = 0;
+
+        for (int step = 0; step < 20000; ++step) {
+            const u32 op = rng() % 4;
+            if (op < 2 || model.empty()) {
+                const usize pos = rng() % (model.size() + 1);
+                const auto handle = tree.insert(pos, next);
+                model.insert(model.begin() + static_cast<std::ptrdiff_t>(pos), {next, handle});
+                ++next;
+            } else if (op == 2) {
+                const usize pos = rng() % model.size();
+                QCOMPARE(tree.erase(pos), model[pos].first);
+                model.erase(model.begin() + static_cast<std::ptrdiff_t>(pos));
+            } else {
+                const usize from = rng() % model.size();
+                const usize to = rng() % model.size();
+                tree.move(from, to);
+                auto moved = model[from];
+                model.erase(model.begin() + static_cast<std::ptrdiff_t>(from));
+                model.insert(model.begin() + static_cast<std::ptrdiff_t>(to), moved);
+            }
+
+            if (step % 500 == 0) {
+                QCOMPARE(tree.size(), model.size());
+                usize i = 0;
+                for (auto it = tree.begin(); it != tree.end(); ++it, ++i) {
+                    QCOMPARE(*it, model[i].first);
+                    QCOMPARE(it.handle(), model[i].second);
+                    QCOMPARE(tree.indexOf(model[i].second), i);
+                    QCOMPARE(tree.handleAt(i), model[i].second);
+                }
+                QCOMPARE(i, model.size());
+            }
+        }
+    }
+};
+
+int runTestSequenceTree(int argc, char** argv) {
+    TestSequenceTree tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_SequenceTree.moc"
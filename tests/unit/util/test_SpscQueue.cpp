@@ -0,0 +1,109 @@
+#include <QtTest>
+#include <memory>
+#include <thread>
+#include "util/SpscQueue.hpp"
+
+using namespace vc;
+
+class TestSpscQueue : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testCapacityRoundsUp() {
+        QCOMPARE(SpscQueue<int>(5).capacity(), u32{8});
+        QCOMPARE(SpscQueue<int>(8).capacity(), u32{8});
+        QCOMPARE(SpscQueue<int>(0).capacity(), u32{2});
+    }
+
+    void testFullAndEmpty() {
+        SpscQueue<int> queue(4);
+        int value = -1;
+        QVERIFY(queue.empty());
+        QVERIFY(!queue.tryPop(value));
+        QCOMPARE(value, -1);
+
+        for (int i = 0; i < 4; ++i)
+            QVERIFY(queue.tryPush(i));
+        QVERIFY(!queue.tryPush(4));
+        QCOMPARE(queue.size(), u32{4});
+
+        for (int i = 0; i < 4; ++i) {
+            QVERIFY(queue.tryPop(value));
+            QCOMPARE(value, i);
+        }
+        QVERIFY(!queue.tryPop(value));
+        QVERIFY(queue.empty());
+    }
+
+    void testWraparound() {
+        SpscQueue<int> queue(4);
+        int next = 0;
+        int expected = 0;
+        // Uneven batches so head and tail land on every slot
+        for (int round = 0; round < 1000; ++round) {
+            const int batch = 1 + round % 4;
+            for (int i = 0; i < batch; ++i)
+                QVERIFY(queue.tryPush(next++));
+            if (batch == 4)
+                QVERIFY(!queue.tryPush(next));
+            for (int i = 0; i < batch; ++i) {
+                int value = -1;
+                QVERIFY(queue.tryPop(value));
+                QCOMPARE(value, expected++);
+            }
+            QVERIFY(queue.empty());
+        }
+    }
+
+    void testMoveOnlyValues() {
+        SpscQueue<std::unique_ptr<int>> queue(2);
+        QVERIFY(queue.tryPush(std::make_unique<int>(7)));
+        std::unique_ptr<int> out;
+        QVERIFY(queue.tryPop(out));
+        QVERIFY(out);
+        QCOMPARE(*out, 7);
+    }
+
+    // Producer spins when full; consumer sleeps on a WakeSignal when empty
+    void testProducerConsumerStress() {
+        constexpr u64 COUNT = 500000;
+        SpscQueue<u64> queue(64);
+        WakeSignal pushed;
+        u64 received = 0;
+        u64 outOfOrder = 0;
+
+        std::thread consumer([&] {
+            while (received < COUNT) {
+                u64 value = 0;
+                if (!queue.tryPop(value)) {
+                    const u32 seen = pushed.epoch();
+                    if (!queue.tryPop(value)) {
+                        pushed.wait(seen);
+                        continue;
+                    }
+                }
+                if (value != received)
+                    ++outOfOrder;
+                ++received;
+            }
+        });
+
+        for (u64 i = 0; i < COUNT; ++i) {
+            while (!queue.tryPush(i))
+                std::this_thread::yield();
+            pushed.notify();
+        }
+        consumer.join();
+
+        QCOMPARE(received, COUNT);
+        QCOMPARE(outOfOrder, u64{0});
+        QVERIFY(queue.empty());
+    }
+};
+
+int runTestSpscQueue(int argc, char** argv) {
+    TestSpscQueue tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_SpscQueue.moc"
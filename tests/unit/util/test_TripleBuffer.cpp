@@ -0,0 +1,112 @@
+#include <QtTest>
+#include <thread>
+#include "util/TripleBuffer.hpp"
+
+using namespace vc;
+
+namespace {
+// Torn reads show up as fields that disagree with seq
+struct Sample {
+    u64 seq{0};
+    u64 fields[7]{};
+
+    void fill(u64 n) {
+        seq = n;
+        for (u64 i = 0; i < 7; ++i)
+            fields[i] = n * (i + 1);
+    }
+    bool consistent() const {
+        for (u64 i = 0; i < 7; ++i) {
+            if (fields[i] != seq * (i + 1))
+                return false;
+        }
+        return true;
+    }
+};
+} // namespace
+
+class TestTripleBuffer : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testNothingPublishedYet() {
+        TripleBuffer<int> buffer;
+        QVERIFY(!buffer.update());
+        QCOMPARE(buffer.front(), 0);
+    }
+
+    void testNewestValueWins() {
+        TripleBuffer<int> buffer;
+        buffer.back() = 1;
+        buffer.publish();
+        buffer.back() = 2;
+        buffer.publish();
+        QVERIFY(buffer.update());
+        QCOMPARE(buffer.front(), 2);
+        // Nothing new: the front stays
+        QVERIFY(!buffer.update());
+        QCOMPARE(buffer.front(), 2);
+
+        buffer.back() = 3;
+        buffer.publish();
+        QCOMPARE(buffer.front(), 2);
+        QVERIFY(buffer.update());
+        QCOMPARE(buffer.front(), 3);
+    }
+
+    void testWriterNeverGetsTheFront() {
+        TripleBuffer<int> buffer;
+        for (int i = 0; i < 20; ++i) {
+            buffer.back() = i;
+            QVERIFY(&buffer.back() != &buffer.front());
+            buffer.publish();
+            QVERIFY(&buffer.back() != &buffer.front());
+            if (i % 3 == 0) {
+                QVERIFY(buffer.update());
+                QCOMPARE(buffer.front(), i);
+            }
+        }
+    }
+
+    void testWriterReaderStress() {
+        constexpr u64 COUNT = 200000;
+        TripleBuffer<Sample> buffer;
+        u64 updates = 0;
+        u64 torn = 0;
+        u64 backwards = 0;
+
+        std::thread reader([&] {
+            u64 last = 0;
+            while (last < COUNT) {
+                if (!buffer.update()) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const Sample& sample = buffer.front();
+                if (!sample.consistent())
+                    ++torn;
+                if (sample.seq <= last)
+                    ++backwards;
+                last = sample.seq;
+                ++updates;
+            }
+        });
+
+        for (u64 n = 1; n <= COUNT; ++n) {
+            buffer.back().fill(n);
+            buffer.publish();
+        }
+        reader.join();
+
+        QCOMPARE(torn, u64{0});
+        QCOMPARE(backwards, u64{0});
+        QVERIFY(updates > 0 && updates <= COUNT);
+    }
+};
+
+int runTestTripleBuffer(int argc, char** argv) {
+    TestTripleBuffer tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_TripleBuffer.moc"
@@ -0,0 +1,81 @@
+#include <QtTest>
+#include <random>
+#include "util/WeightedSampler.hpp"
+
+using namespace vc;
+
+class TestWeightedSampler : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testEmpty() {
+        WeightedSampler sampler;
+        std::mt19937 rng(1);
+        QVERIFY(!sampler.sample(rng));
+
+        sampler.resize(3);
+        QVERIFY(sampler.empty());
+        QVERIFY(!sampler.sample(rng));
+
+        sampler.set(1, 2.0);
+        QCOMPARE(sampler.live(), usize{1});
+        QCOMPARE(*sampler.sample(rng), usize{1});
+        sampler.set(1, 0.0);
+        QVERIFY(!sampler.sample(rng));
+    }
+
+    // Frequencies follow the weights, across buckets and after updates
+    void testFrequenciesMatchWeights() {
+        WeightedSampler sampler;
+        sampler.resize(4);
+        sampler.set(0, 1.0);
+        sampler.set(1, 3.0);
+        sampler.set(2, 0.01);
+        sampler.set(3, 6.0);
+        sampler.set(3, 4.0); // moves bucket
+        QCOMPARE(sampler.weight(3), 4.0);
+
+        std::mt19937 rng(42);
+        std::array<int, 4> counts{};
+        constexpr int DRAWS = 200000;
+        for (int i = 0; i < DRAWS; ++i)
+            ++counts[*sampler.sample(rng)];
+
+        const f64 total = 8.01;
+        const std::array<f64, 4> weights{1.0, 3.0, 0.01, 4.0};
+        for (usize i = 0; i < weights.size(); ++i) {
+            const f64 expected = DRAWS * weights[i] / total;
+            QVERIFY(std::abs(counts[i] - expected) < 5.0 * std::sqrt(expected) + 5.0);
+        }
+    }
+
+    void testManyUpdates() {
+        WeightedSampler sampler;
+        sampler.resize(1000);
+        std::mt19937 rng(7);
+        std::vector<f64> model(1000, 0.0);
+        for (int step = 0; step < 20000; ++step) {
+            const usize i = rng() % model.size();
+            const f64 w = (rng() % 4 == 0) ? 0.0 : std::ldexp(1.0, static_cast<int>(rng() % 20) - 10);
+            sampler.set(i, w);
+            model[i] = w;
+        }
+        f64 total = 0.0;
+        usize live = 0;
+        for (f64 w : model) {
+            total += w;
+            live += w > 0.0;
+        }
+        QCOMPARE(sampler.live(), live);
+        QVERIFY(std::abs(sampler.total() - total) < 1e-9 * total);
+        for (int i = 0; i < 1000; ++i)
+            QVERIFY(model[*sampler.sample(rng)] > 0.0);
+    }
+};
+
+int runTestWeightedSampler(int argc, char** argv) {
+    TestWeightedSampler tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_WeightedSampler.moc"
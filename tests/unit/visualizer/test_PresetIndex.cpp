@@ -0,0 +1,191 @@
+#include <QTemporaryDir>
+#include <QtTest>
+#include <fstream>
+#include "util/FileUtils.hpp"
+#include "visualizer/PresetIndex.hpp"
+#include "visualizer/PresetScanner.hpp"
+
+using namespace vc;
+
+namespace {
+constexpr std::string_view SAMPLE_PRESET = "[preset00]\n"
+                                           "fDecay=0.98\n"
+                                           "wavecode_0_enabled=1\n"
+                                           "wavecode_1_enabled=0\n"
+                                           "shapecode_0_enabled=1\n"
+                                           "per_frame_1=wave_r = 0.5;\n"
+                                           "per_frame_2=zoom = 1.01;\n"
+                                           "per_pixel_1=rot = rad*0.1;\n"
+                                           "warp_1=`shader_body {\n"
+                                           "warp_2=`ret = tex2D(sampler_fw_clouds, uv).xyz;\n"
+                                           "warp_3=`}\n"
+                                           "comp_1=`ret = tex2D(sampler_main, uv).xyz + GetBlur1(uv);\n";
+
+void writeFile(const fs::path& path, std::string_view content) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+}
+
+usize scanInto(const fs::path& dir, PresetIndex& index, std::vector<PresetInfo>& presets) {
+    presets.clear();
+    auto result = PresetScanner::scan(dir, true, presets, {}, {}, &index, 2);
+    return result ? presets.size() : 0;
+}
+} // namespace
+
+class TestPresetIndex : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testParseFeatures() {
+        auto features = PresetScanner::parseFeatures(SAMPLE_PRESET);
+        QCOMPARE(features.perFrameEquations, u32{2});
+        QCOMPARE(features.perPixelEquations, u32{1});
+        QCOMPARE(features.customWaves, u32{1});
+        QCOMPARE(features.customShapes, u32{1});
+        QVERIFY(features.hasWarpShader());
+        QVERIFY(features.hasCompShader());
+        // Built-in samplers are not textures the preset ships
+        QCOMPARE(features.textures, (std::vector<std::string>{"clouds"}));
+
+        QVERIFY(!PresetScanner::parseFeatures("[preset00]\nzoom=1\n").hasWarpShader());
+    }
+
+    void testUnchangedFilesComeFromIndex() {
+        QTemporaryDir dir;
+        const fs::path root(dir.path().toStdString());
+        const fs::path presetDir = root / "presets";
+        fs::create_directories(presetDir / "Sub");
+        writeFile(presetDir / "Author - One.milk", SAMPLE_PRESET);
+        writeFile(presetDir / "Sub" / "Two.milk", "[preset00]\nper_frame_1=zoom=1;\n");
+
+        PresetIndex index;
+        QVERIFY(index.load(root / "index.tsv").isOk());
+        std::vector<PresetInfo> presets;
+        QCOMPARE(scanInto(presetDir, index, presets), usize{2});
+        QCOMPARE(presets[0].author, std::string("Author"));
+        QCOMPARE(presets[0].features.perFrameEquations, u32{2});
+        QCOMPARE(presets[1].category, std::string("Sub"));
+        QVERIFY(!index.dirty());
+
+        // Same size and mtime: a fresh index trusts its stored features
+        const auto path = presetDir / "Author - One.milk";
+        const auto mtime = fs::last_write_time(path);
+        std::string same(SAMPLE_PRESET);
+        same.replace(same.find("per_frame_2"), 11, "xer_frame_2");
+        writeFile(path, same);
+        fs::last_write_time(path, mtime);
+
+        PresetIndex reloaded;
+        QVERIFY(reloaded.load(root / "index.tsv").isOk());
+        QCOMPARE(reloaded.size(), usize{2});
+        QCOMPARE(scanInto(presetDir, reloaded, presets), usize{2});
+        QCOMPARE(presets[0].features.perFrameEquations, u32{2});
+        QCOMPARE(presets[0].features.textures, (std::vector<std::string>{"clouds"}));
+        QVERIFY(!reloaded.dirty());
+
+        // A new stamp is read again
+        fs::last_write_time(path, mtime + std::chrono::seconds(5));
+        QCOMPARE(scanInto(presetDir, reloaded, presets), usize{2});
+        QCOMPARE(presets[0].features.perFrameEquations, u32{1});
+    }
+
+    void testRemovedFilesArePruned() {
+        QTemporaryDir dir;
+        const fs::path root(dir.path().toStdString());
+        const fs::path presetDir = root / "presets";
+        fs::create_directories(presetDir);
+        writeFile(presetDir / "a.milk", "[preset00]\n");
+        writeFile(presetDir / "b.milk", "[preset00]\n");
+
+        PresetIndex index;
+        QVERIFY(index.load(root / "index.tsv").isOk());
+        std::vector<PresetInfo> presets;
+        QCOMPARE(scanInto(presetDir, index, presets), usize{2});
+        QCOMPARE(index.size(), usize{2});
+
+        fs::remove(presetDir / "b.milk");
+        QCOMPARE(scanInto(presetDir, index, presets), usize{1});
+        QCOMPARE(index.size(), usize{1});
+
+        PresetIndex reloaded;
+        QVERIFY(reloaded.load(root / "index.tsv").isOk());
+        QCOMPARE(reloaded.size(), usize{1});
+    }
+
+    void testCostIsKeptUntilTheFileChanges() {
+        QTemporaryDir dir;
+        const fs::path root(dir.path().toStdString());
+        const fs::path presetDir = root / "presets";
+        fs::create_directories(presetDir);
+        const auto path = presetDir / "a.milk";
+        writeFile(path, SAMPLE_PRESET);
+
+        PresetIndex index;
+        QVERIFY(index.load(root / "index.tsv").isOk());
+        std::vector<PresetInfo> presets;
+        QCOMPARE(scanInto(presetDir, index, presets), usize{1});
+
+        PresetCost cost;
+        cost.loadMs = 42.5f;
+        cost.cpuMs = 3.25f;
+        cost.gpuMs = 21.75f;
+        cost.worstMs = 30.0f;
+        cost.plays = 4;
+        cost.width = 1920;
+        cost.height = 1080;
+        cost.strikes = 3;
+        cost.quarantined = true;
+        index.setCost(path, cost);
+        QVERIFY(index.dirty());
+        QVERIFY(index.save().isOk());
+
+        PresetIndex reloaded;
+        QVERIFY(reloaded.load(root / "index.tsv").isOk());
+        QCOMPARE(scanInto(presetDir, reloaded, presets), usize{1});
+        const auto& read = presets[0].cost;
+        QCOMPARE(read.loadMs, 42.5f);
+        QCOMPARE(read.gpuMs, 21.75f);
+        QCOMPARE(read.frameMs(), 21.75f);
+        QCOMPARE(read.plays, u32{4});
+        QCOMPARE(read.height, u32{1080});
+        QCOMPARE(read.strikes, u32{3});
+        QVERIFY(read.quarantined);
+        QVERIFY(read.blocks(1920, 1080));
+        QVERIFY(!read.blocks(1280, 720));
+
+        // Edited preset, new cost
+        fs::last_write_time(path, fs::last_write_time(path) + std::chrono::seconds(5));
+        QCOMPARE(scanInto(presetDir, reloaded, presets), usize{1});
+        QCOMPARE(presets[0].cost.plays, u32{0});
+        QVERIFY(!presets[0].cost.quarantined);
+    }
+
+    void testReadsVersion1() {
+        QTemporaryDir dir;
+        const fs::path root(dir.path().toStdString());
+        const fs::path path = root / "a.milk";
+        writeFile(root / "index.tsv",
+                  "# chadvis preset index v1\n"
+                  "10\t20\t1\t2\t3\t4\t5\t6\tclouds\tAuthor\tCat\t" +
+                          path.string() + "\n");
+
+        PresetIndex index;
+        QVERIFY(index.load(root / "index.tsv").isOk());
+        QCOMPARE(index.size(), usize{1});
+        // Rewritten as the current version on the next save
+        QVERIFY(index.dirty());
+        const auto* info = index.find(path, 10, 20);
+        QVERIFY(info);
+        QCOMPARE(info->features.customShapes, u32{6});
+        QCOMPARE(info->author, std::string("Author"));
+        QCOMPARE(info->cost.plays, u32{0});
+    }
+};
+
+int runTestPresetIndex(int argc, char** argv) {
+    TestPresetIndex tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_PresetIndex.moc"
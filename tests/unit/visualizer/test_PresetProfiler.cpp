@@ -0,0 +1,281 @@
+#include <QTemporaryDir>
+#include <QtTest>
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include "util/FileUtils.hpp"
+#include "visualizer/PresetManager.hpp"
+#include "visualizer/PresetPersistence.hpp"
+#include "visualizer/PresetProfiler.hpp"
+
+using namespace vc;
+
+namespace {
+constexpr f32 BUDGET = 16.0f;
+
+// One play of `frames` frames at a steady cost, at 1920x1080
+bool play(PresetCost& cost, f32 cpuMs, f32 gpuMs, u32 frames = PresetProfiler::MIN_FRAMES,
+          u32 settle = 0, f32 loadMs = 10.0f) {
+    PresetProfiler profiler;
+    profiler.begin(0, loadMs, 1920, 1080, settle);
+    for (u32 i = 0; i < settle + frames; ++i)
+        profiler.addFrame(cpuMs, gpuMs);
+    return profiler.finish(cost, BUDGET);
+}
+
+// A manager over `count` empty presets in `dir`, with its play stats there
+void setUpManager(PresetManager& manager, const fs::path& dir, usize count) {
+    fs::create_directories(dir / "presets");
+    for (usize i = 0; i < count; ++i)
+        std::ofstream(dir / "presets" / ("p" + std::to_string(i) + ".milk")) << "[preset00]\n";
+    manager.setStatsFile(dir / "stats.tsv");
+    QVERIFY(manager.scan(dir / "presets").isOk());
+    manager.setFrameBudget(BUDGET);
+    manager.setRenderSize(1920, 1080);
+}
+
+// The render loop's side of one play of preset 0, as pm::Bridge drives it
+void playSlow(PresetManager& manager) {
+    manager.selectByIndex(0);
+    manager.beginProfile(0, 10.0f, 0);
+    for (u32 i = 0; i < PresetProfiler::MIN_FRAMES; ++i)
+        manager.profileFrame(2.0f, 40.0f);
+    manager.endProfile();
+}
+} // namespace
+
+class TestPresetProfiler : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testTransitionFramesAreSkipped() {
+        PresetProfiler profiler;
+        profiler.begin(3, 5.0f, 1920, 1080, 2);
+        QCOMPARE(profiler.preset(), std::optional<usize>(3));
+        profiler.addFrame(100.0f, 100.0f);
+        profiler.addFrame(100.0f, 100.0f);
+        for (u32 i = 0; i < PresetProfiler::MIN_FRAMES; ++i)
+            profiler.addFrame(4.0f, i % 2 ? 8.0f : -1.0f);
+        QCOMPARE(profiler.frames(), PresetProfiler::MIN_FRAMES);
+
+        PresetCost cost;
+        QVERIFY(!profiler.finish(cost, BUDGET));
+        QVERIFY(!profiler.preset());
+        QCOMPARE(cost.cpuMs, 4.0f);
+        // Frames without GPU time don't count as zero
+        QCOMPARE(cost.gpuMs, 8.0f);
+        QCOMPARE(cost.frameMs(), 8.0f);
+        QCOMPARE(cost.worstMs, 8.0f);
+        QCOMPARE(cost.plays, u32{1});
+        QCOMPARE(cost.width, u32{1920});
+    }
+
+    void testShortPlaysOnlyTimeTheLoad() {
+        PresetCost cost;
+        QVERIFY(!play(cost, 50.0f, 50.0f, PresetProfiler::MIN_FRAMES - 1));
+        QCOMPARE(cost.loadMs, 10.0f);
+        QCOMPARE(cost.plays, u32{0});
+        QCOMPARE(cost.strikes, u32{0});
+
+        // Smoothed from then on
+        play(cost, 5.0f, 5.0f, PresetProfiler::MIN_FRAMES, 0, 30.0f);
+        QCOMPARE(cost.loadMs, 10.0f + PresetProfiler::SMOOTHING * 20.0f);
+        QCOMPARE(cost.cpuMs, 5.0f);
+        play(cost, 9.0f, 5.0f);
+        QCOMPARE(cost.cpuMs, 5.0f + PresetProfiler::SMOOTHING * 4.0f);
+        QCOMPARE(cost.worstMs, 9.0f);
+    }
+
+    void testQuarantineAfterStrikes() {
+        PresetCost cost;
+        for (u32 i = 1; i < PresetProfiler::QUARANTINE_STRIKES; ++i) {
+            QVERIFY(!play(cost, 2.0f, 25.0f));
+            QCOMPARE(cost.strikes, i);
+            QVERIFY(!cost.quarantined);
+        }
+        QVERIFY(play(cost, 2.0f, 25.0f));
+        QVERIFY(cost.quarantined);
+        QVERIFY(cost.blocks(1920, 1080));
+        QVERIFY(cost.blocks(3840, 2160));
+        QVERIFY(!cost.blocks(1280, 720));
+        // Reported once
+        QVERIFY(!play(cost, 2.0f, 25.0f));
+        QVERIFY(cost.quarantined);
+
+        // One play within budget lifts it
+        QVERIFY(!play(cost, 2.0f, 10.0f));
+        QVERIFY(!cost.quarantined);
+        QCOMPARE(cost.strikes, u32{0});
+    }
+
+    void testResolutionChangeResetsCost() {
+        PresetCost cost;
+        play(cost, 2.0f, 25.0f);
+        play(cost, 2.0f, 25.0f);
+        QCOMPARE(cost.strikes, u32{2});
+
+        PresetProfiler profiler;
+        profiler.begin(0, 10.0f, 1280, 720, 0);
+        for (u32 i = 0; i < PresetProfiler::MIN_FRAMES; ++i)
+            profiler.addFrame(2.0f, 12.0f);
+        QVERIFY(!profiler.finish(cost, BUDGET));
+        QCOMPARE(cost.width, u32{1280});
+        QCOMPARE(cost.plays, u32{1});
+        QCOMPARE(cost.gpuMs, 12.0f);
+        QCOMPARE(cost.worstMs, 12.0f);
+        QCOMPARE(cost.strikes, u32{0});
+        QCOMPARE(cost.loadMs, 10.0f);
+    }
+
+    void testQuarantineHoldsBelowItsResolution() {
+        PresetCost cost;
+        for (u32 i = 0; i < PresetProfiler::QUARANTINE_STRIKES; ++i)
+            play(cost, 2.0f, 25.0f);
+        QVERIFY(cost.quarantined);
+
+        // Fast at 720p says nothing about 1080p
+        PresetProfiler profiler;
+        profiler.begin(0, 10.0f, 1280, 720, 0);
+        for (u32 i = 0; i < PresetProfiler::MIN_FRAMES; ++i)
+            profiler.addFrame(2.0f, 8.0f);
+        QVERIFY(!profiler.finish(cost, BUDGET));
+        QVERIFY(cost.quarantined);
+        QCOMPARE(cost.width, u32{1920});
+        QCOMPARE(cost.height, u32{1080});
+        QVERIFY(cost.blocks(1920, 1080));
+        QVERIFY(!cost.blocks(1280, 720));
+        // Only the frame times start over
+        QCOMPARE(cost.plays, u32{1});
+        QCOMPARE(cost.gpuMs, 8.0f);
+
+        // Fast at a larger size lifts it for both
+        profiler.begin(0, 10.0f, 3840, 2160, 0);
+        for (u32 i = 0; i < PresetProfiler::MIN_FRAMES; ++i)
+            profiler.addFrame(2.0f, 12.0f);
+        QVERIFY(!profiler.finish(cost, BUDGET));
+        QVERIFY(!cost.quarantined);
+        QCOMPARE(cost.width, u32{3840});
+    }
+
+    void testOfflineRenderNeverQuarantines() {
+        QTemporaryDir dir;
+        const fs::path root(dir.path().toStdString());
+        {
+            PresetManager manager;
+            setUpManager(manager, root / "offline", 2);
+            manager.setOffline(true);
+            for (u32 i = 0; i < PresetProfiler::QUARANTINE_STRIKES + 1; ++i)
+                playSlow(manager);
+            QVERIFY(!manager.isQuarantined(0));
+            QCOMPARE(manager.allPresets()[0].cost.plays, u32{0});
+            QCOMPARE(manager.quarantinedCount(), usize{0});
+            manager.flushState();
+        }
+        QVERIFY(!fs::exists(root / "offline" / "stats.tsv"));
+
+        // The same plays live do
+        PresetManager manager;
+        setUpManager(manager, root / "live", 2);
+        for (u32 i = 0; i < PresetProfiler::QUARANTINE_STRIKES; ++i)
+            playSlow(manager);
+        QVERIFY(manager.isQuarantined(0));
+        manager.flushState();
+        QVERIFY(fs::exists(root / "live" / "stats.tsv"));
+    }
+
+    // Write-behind happens on the manager's writer thread, not the
+    // switching one; flushState() waits for what's left
+    void testWriteBehind() {
+        QTemporaryDir dir;
+        const fs::path root(dir.path().toStdString());
+        PresetManager manager;
+        setUpManager(manager, root, 2);
+
+        // FLUSH_CHANGES plays
+        for (u32 i = 0; i < 16; ++i)
+            manager.selectByIndex(i % 2);
+        QTRY_VERIFY(fs::exists(root / "stats.tsv"));
+
+        manager.selectByIndex(0);
+        manager.flushState();
+        std::unordered_map<std::string, PresetPlayStats> stats;
+        QVERIFY(PresetPersistence::loadStats(root / "stats.tsv", stats).isOk());
+        QCOMPARE(stats["p0"].playCount, u32{9});
+        QCOMPARE(stats["p1"].playCount, u32{8});
+    }
+
+    // The render loop picks, plays and profiles while the GUI flips flags,
+    // releases quarantines and reads costs; races show up under TSan
+    void testRenderAndGuiThreads() {
+        constexpr u32 PLAYS = 200;
+        constexpr usize COUNT = 8;
+        QTemporaryDir dir;
+        PresetManager manager;
+        setUpManager(manager, fs::path(dir.path().toStdString()), COUNT);
+
+        std::atomic<bool> done{false};
+        std::thread render([&] {
+            for (u32 i = 0; i < PLAYS; ++i) {
+                if (auto index = manager.pickRandom())
+                    manager.selectByIndex(*index);
+                manager.beginProfile(manager.currentIndex(), 10.0f, 0);
+                for (u32 f = 0; f < PresetProfiler::MIN_FRAMES; ++f)
+                    manager.profileFrame(2.0f, 40.0f);
+                manager.endProfile();
+            }
+            done = true;
+        });
+
+        for (usize i = 0; !done; ++i) {
+            manager.toggleFavorite(i % COUNT);
+            manager.releaseQuarantine(i % COUNT);
+            auto lock = manager.lock();
+            QVERIFY(manager.allPresets()[i % COUNT].cost.frameMs() >= 0.0f);
+        }
+        render.join();
+
+        // Every play landed in some preset's cost
+        u32 plays = 0;
+        for (const auto& preset : manager.allPresets())
+            plays += preset.cost.plays;
+        QCOMPARE(plays, PLAYS);
+    }
+
+    void testExportSlowestFirst() {
+        std::vector<PresetInfo> presets(3);
+        presets[0].name = "fast";
+        presets[0].path = "/p/fast.milk";
+        presets[0].cost = {5.0f, 2.0f, 3.0f, 3.0f, 2, 1920, 1080, 0, false};
+        presets[1].name = "never played";
+        presets[2].name = "slow, \"heavy\"";
+        presets[2].path = "/p/slow.milk";
+        presets[2].cost = {80.0f, 4.0f, 30.0f, 31.0f, 3, 1920, 1080, 3, true};
+
+        QTemporaryDir dir;
+        const fs::path root(dir.path().toStdString());
+        QVERIFY(PresetPersistence::exportCosts(root / "costs.csv", presets, BUDGET).isOk());
+        auto csv = file::readText(root / "costs.csv");
+        QVERIFY(csv.isOk());
+        const std::string& text = csv.value();
+        QVERIFY(text.starts_with("name,path,author,category,load_ms,cpu_ms,gpu_ms,frame_ms,"));
+        const auto slow = text.find("\"slow, \"\"heavy\"\"\"");
+        const auto fast = text.find("fast,");
+        QVERIFY(slow != std::string::npos && fast != std::string::npos);
+        QVERIFY(slow < fast);
+        QVERIFY(text.find("never played") == std::string::npos);
+
+        QVERIFY(PresetPersistence::exportCosts(root / "costs.json", presets, BUDGET).isOk());
+        auto json = file::readText(root / "costs.json");
+        QVERIFY(json.isOk());
+        QVERIFY(json.value().find("\"frameBudgetMs\"") != std::string::npos);
+        QVERIFY(json.value().find("\"name\": \"slow, \\\"heavy\\\"\"") != std::string::npos);
+        QVERIFY(json.value().find("\"quarantined\": true") != std::string::npos);
+    }
+};
+
+int runTestPresetProfiler(int argc, char** argv) {
+    TestPresetProfiler tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_PresetProfiler.moc"
@@ -0,0 +1,178 @@
+#include <QtTest>
+#include <random>
+#include "visualizer/PresetSearch.hpp"
+
+using namespace vc;
+
+namespace {
+PresetInfo makePreset(std::string name, std::string author, std::string category) {
+    PresetInfo info;
+    info.path = "/presets/" + category + "/" + name + ".milk";
+    info.name = std::move(name);
+    info.author = std::move(author);
+    info.category = std::move(category);
+    return info;
+}
+
+std::vector<u32> presetsOf(const std::vector<PresetSearch::Hit>& hits) {
+    std::vector<u32> result;
+    for (const auto& hit : hits)
+        result.push_back(hit.preset);
+    return result;
+}
+
+std::vector<PresetInfo> samplePresets() {
+    std::vector<PresetInfo> presets{
+            makePreset("Geiss - Spiral Dance", "Geiss", "Classic"),
+            makePreset("Martin - Liquid Spiral", "Martin", "Classic"),
+            makePreset("Flexi - Mindblob", "Flexi", "Shaders"),
+            makePreset("Rovastar - Harlequin's Spirals", "Rovastar", "Classic"),
+            makePreset("Unchained - Spiralling Geiss Tribute", "Unchained", "Tributes"),
+    };
+    presets[2].features.warpShaderBytes = 120;
+    presets[2].features.textures = {"clouds"};
+    return presets;
+}
+
+// A big library: random names from a few common words and many made-up
+// ones, half the presets with custom waves
+std::vector<PresetInfo> largeLibrary(usize count) {
+    static const char* common[] = {"wave", "waves", "shockwave", "orb", "orbit", "orbital",
+                                   "spiral", "spirals", "dance", "dancer", "dancing", "liquid",
+                                   "fractal", "tunnel", "star", "nebula", "geiss", "pulse"};
+    static const char* syllables[] = {"ka", "ro", "mi", "ve", "sta", "lu", "xi", "zo", "ne", "ba",
+                                      "tri", "fla", "qua", "or", "an", "el", "wa", "sp", "ra", "da"};
+    std::mt19937 rng(1);
+    auto word = [&] {
+        if (rng() % 3 == 0)
+            return std::string(common[rng() % std::size(common)]);
+        std::string made;
+        for (u32 i = 0, n = 2 + rng() % 3; i < n; ++i)
+            made += syllables[rng() % std::size(syllables)];
+        return made;
+    };
+    std::vector<std::string> authors(400);
+    std::vector<std::string> categories(30);
+    for (auto& author : authors)
+        author = word();
+    for (auto& category : categories)
+        category = word();
+
+    std::vector<PresetInfo> presets;
+    presets.reserve(count);
+    for (usize i = 0; i < count; ++i) {
+        std::string author = authors[rng() % authors.size()];
+        std::string name = author + " -";
+        for (u32 w = 0, n = 2 + rng() % 4; w < n; ++w)
+            name += " " + word();
+        presets.push_back(makePreset(std::move(name), std::move(author),
+                                     categories[rng() % categories.size()]));
+        presets.back().features.customWaves = rng() % 2;
+    }
+    return presets;
+}
+
+// Presets with a token starting with every term, the slow way
+std::vector<u32> prefixMatches(const std::vector<PresetInfo>& presets,
+                               const std::vector<std::string>& terms) {
+    std::vector<u32> result;
+    for (u32 p = 0; p < presets.size(); ++p) {
+        const auto& info = presets[p];
+        auto tokens = PresetSearch::tokenize(info.name + " " + info.author + " " + info.category);
+        if (info.features.customWaves > 0)
+            tokens.push_back("waves");
+        const bool all = std::ranges::all_of(terms, [&](const std::string& term) {
+            return std::ranges::any_of(tokens, [&](const std::string& token) {
+                return token.starts_with(term);
+            });
+        });
+        if (all)
+            result.push_back(p);
+    }
+    return result;
+}
+} // namespace
+
+class TestPresetSearch : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testTokenize() {
+        QCOMPARE(PresetSearch::tokenize("Geiss - Spiral_Dance 2!"),
+                 (std::vector<std::string>{"geiss", "spiral", "dance", "2"}));
+        QVERIFY(PresetSearch::tokenize(" - ").empty());
+    }
+
+    void testRankedMatches() {
+        PresetSearch search;
+        search.build(samplePresets());
+
+        // Exact name token beats prefix; ties keep preset order
+        QCOMPARE(presetsOf(search.search("spiral")), (std::vector<u32>{0, 1, 3, 4}));
+        // Every term must match
+        QCOMPARE(presetsOf(search.search("spiral geiss")), (std::vector<u32>{0, 4}));
+        // Prefix while typing
+        QCOMPARE(presetsOf(search.search("mindb")), (std::vector<u32>{2}));
+        // Inside a token
+        QCOMPARE(presetsOf(search.search("blob")), (std::vector<u32>{2}));
+        // Typo
+        QCOMPARE(presetsOf(search.search("harlequn")), (std::vector<u32>{3}));
+        QVERIFY(search.search("zzzz").empty());
+        QVERIFY(search.search("").empty());
+
+        QCOMPARE(search.search("spiral", 2).size(), usize{2});
+    }
+
+    void testFieldsAndFeatures() {
+        PresetSearch search;
+        search.build(samplePresets());
+
+        // A name hit outranks the same word as a category
+        QCOMPARE(presetsOf(search.search("classic spiral")), (std::vector<u32>{0, 1, 3}));
+        QVERIFY(search.search("tribute")[0].score > search.search("tributes")[0].score);
+        QCOMPARE(presetsOf(search.search("shader")), (std::vector<u32>{2}));
+        QCOMPARE(presetsOf(search.search("clouds")), (std::vector<u32>{2}));
+        QCOMPARE(presetsOf(search.search("tributes")), (std::vector<u32>{4}));
+    }
+
+    void testCategories() {
+        PresetSearch search;
+        search.build(samplePresets());
+
+        QCOMPARE(search.categories(), (std::vector<std::string>{"Classic", "Shaders", "Tributes"}));
+        QCOMPARE(search.inCategory("Classic"), (std::vector<u32>{0, 1, 3}));
+        QVERIFY(search.inCategory("Missing").empty());
+
+        search.clear();
+        QVERIFY(search.categories().empty());
+        QVERIFY(search.search("spiral").empty());
+    }
+
+    // Type-ahead at library scale. Timed with QBENCHMARK rather than
+    // asserted; pass -tickcounter or -callgrind for stable figures.
+    void testFiftyThousandPresets() {
+        const auto presets = largeLibrary(50000);
+        PresetSearch search;
+        search.build(presets);
+
+        // Every term has prefix matches here, so the hits are exactly the
+        // presets with a token starting with each
+        for (const char* query : {"wave orb", "spiral dan", "geiss spiral dance"}) {
+            auto hits = presetsOf(search.search(query));
+            std::sort(hits.begin(), hits.end());
+            QCOMPARE(hits, prefixMatches(presets, PresetSearch::tokenize(query)));
+        }
+
+        QBENCHMARK {
+            search.search("wave orb");
+            search.search("spiral dan");
+        }
+    }
+};
+
+int runTestPresetSearch(int argc, char** argv) {
+    TestPresetSearch tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_PresetSearch.moc"
@@ -0,0 +1,139 @@
+#include <QtTest>
+#include <set>
+#include "visualizer/PresetShuffle.hpp"
+
+using namespace vc;
+
+namespace {
+std::vector<PresetInfo> makePresets(usize count) {
+    std::vector<PresetInfo> presets(count);
+    for (usize i = 0; i < count; ++i)
+        presets[i].name = "preset" + std::to_string(i);
+    return presets;
+}
+
+f64 unrated(const PresetInfo& preset) {
+    return PresetShuffle::weight(preset, 0, 0);
+}
+} // namespace
+
+class TestPresetShuffle : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testWeights() {
+        constexpr i64 NOW = 1'700'000'000;
+        PresetInfo preset;
+        QCOMPARE(PresetShuffle::weight(preset, 0, NOW), 1.0);
+        QCOMPARE(PresetShuffle::weight(preset, 3, NOW), 1.0);
+        QCOMPARE(PresetShuffle::weight(preset, 5, NOW), 4.0);
+        QCOMPARE(PresetShuffle::weight(preset, 1, NOW), 0.25);
+
+        preset.favorite = true;
+        QCOMPARE(PresetShuffle::weight(preset, 0, NOW), PresetShuffle::FAVORITE_BOOST);
+
+        preset.favorite = false;
+        preset.lastPlayed = NOW;
+        QVERIFY(std::abs(PresetShuffle::weight(preset, 0, NOW) - (1.0 - PresetShuffle::RECENCY_PENALTY)) < 1e-9);
+        const f64 halfLife = PresetShuffle::weight(preset, 0, NOW + PresetShuffle::RECENCY_HALF_LIFE);
+        QVERIFY(std::abs(halfLife - (1.0 - PresetShuffle::RECENCY_PENALTY / 2)) < 1e-9);
+
+        preset.blacklisted = true;
+        QCOMPARE(PresetShuffle::weight(preset, 5, NOW), 0.0);
+    }
+
+    void testNoRepeatsWithinWindow() {
+        auto presets = makePresets(30);
+        presets[3].blacklisted = true;
+        PresetShuffle shuffle;
+        shuffle.setWindow(10);
+        shuffle.rebuild(presets, unrated);
+        QCOMPARE(shuffle.candidates(), usize{29});
+
+        std::mt19937 rng(3);
+        std::vector<usize> history;
+        for (int i = 0; i < 500; ++i) {
+            auto pick = shuffle.pick(rng);
+            QVERIFY(pick.has_value());
+            QVERIFY(*pick != 3);
+            const usize start = history.size() > 10 ? history.size() - 10 : 0;
+            for (usize h = start; h < history.size(); ++h)
+                QVERIFY(history[h] != *pick);
+            shuffle.played(*pick);
+            history.push_back(*pick);
+        }
+    }
+
+    void testWindowShrinksWhenFewPresetsLeft() {
+        auto presets = makePresets(3);
+        PresetShuffle shuffle;
+        shuffle.setWindow(10);
+        shuffle.rebuild(presets, unrated);
+
+        std::mt19937 rng(5);
+        std::set<usize> seen;
+        for (int i = 0; i < 9; ++i) {
+            auto pick = shuffle.pick(rng);
+            QVERIFY(pick.has_value());
+            seen.insert(*pick);
+            shuffle.played(*pick);
+        }
+        QCOMPARE(seen.size(), usize{3});
+    }
+
+    void testUpdatesShiftOdds() {
+        auto presets = makePresets(2);
+        PresetShuffle shuffle;
+        shuffle.setWindow(0);
+        shuffle.rebuild(presets, unrated);
+        shuffle.update(1, 0.0);
+
+        std::mt19937 rng(9);
+        for (int i = 0; i < 50; ++i)
+            QCOMPARE(*shuffle.pick(rng), usize{0});
+
+        shuffle.update(1, 9.0);
+        int ones = 0;
+        for (int i = 0; i < 1000; ++i)
+            ones += *shuffle.pick(rng) == 1;
+        QVERIFY(ones > 850);
+    }
+
+    void testLookAheadIsPickedInOrder() {
+        auto presets = makePresets(10);
+        PresetShuffle shuffle;
+        shuffle.setWindow(3);
+        shuffle.rebuild(presets, unrated);
+
+        std::mt19937 rng(11);
+        const auto& queued = shuffle.lookAhead(4, rng);
+        const std::vector<u32> ahead(queued.begin(), queued.end());
+        QCOMPARE(ahead.size(), usize{4});
+        QCOMPARE(std::set<u32>(ahead.begin(), ahead.end()).size(), usize{4});
+        QCOMPARE(shuffle.candidates(), usize{6});
+
+        // A queued preset that gets blacklisted drops out
+        shuffle.update(ahead[1], 0.0);
+        QCOMPARE(shuffle.lookAhead(0, rng).size(), usize{3});
+
+        for (u32 expected : {ahead[0], ahead[2], ahead[3]}) {
+            auto pick = shuffle.pick(rng);
+            QCOMPARE(*pick, usize{expected});
+            shuffle.played(*pick);
+        }
+        QVERIFY(shuffle.lookAhead(0, rng).empty());
+
+        // Nothing but queued presets left: they are still handed out
+        auto few = makePresets(2);
+        shuffle.rebuild(few, unrated);
+        QCOMPARE(shuffle.lookAhead(5, rng).size(), usize{2});
+        QVERIFY(shuffle.pick(rng).has_value());
+    }
+};
+
+int runTestPresetShuffle(int argc, char** argv) {
+    TestPresetShuffle tc;
+    return QTest::qExec(&tc, argc, argv);
+}
+
+#include "test_PresetShuffle.moc"